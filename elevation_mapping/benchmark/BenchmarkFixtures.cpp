@@ -0,0 +1,125 @@
+/*
+ * BenchmarkFixtures.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "BenchmarkFixtures.hpp"
+
+// PCL
+#include <pcl/io/pcd_io.h>
+
+// TF
+#include <tf_conversions/tf_eigen.h>
+
+// STL
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <random>
+
+namespace elevation_mapping {
+
+//! Height of the synthetic terrain.
+static float getTerrainHeight(const float x, const float y)
+{
+  return 0.1 * std::sin(2.0 * x) * std::cos(1.5 * y) + 0.02 * std::sin(9.0 * x + 4.0 * y);
+}
+
+void getBenchmarkSensorPose(Eigen::Affine3d& transformationBaseToMap, Eigen::Affine3d& transformationSensorToBase)
+{
+  transformationBaseToMap = Eigen::Translation3d(0.0, 0.0, 0.5);
+  Eigen::Matrix3d opticalToBase;
+  opticalToBase << 0.0, 0.0, 1.0, -1.0, 0.0, 0.0, 0.0, -1.0, 0.0;
+  transformationSensorToBase = Eigen::Translation3d(0.2, 0.0, 0.3)
+      * Eigen::AngleAxisd(M_PI / 6.0, Eigen::Vector3d::UnitY()) * opticalToBase;
+}
+
+void setBenchmarkTransforms(tf::Transformer& transformer, const ros::Time& time)
+{
+  Eigen::Affine3d transformationBaseToMap, transformationSensorToBase;
+  getBenchmarkSensorPose(transformationBaseToMap, transformationSensorToBase);
+  tf::Transform transform;
+  tf::transformEigenToTF(transformationBaseToMap, transform);
+  transformer.setTransform(tf::StampedTransform(transform, time, benchmarkMapFrameId, benchmarkBaseFrameId));
+  tf::transformEigenToTF(transformationSensorToBase, transform);
+  transformer.setTransform(tf::StampedTransform(transform, time, benchmarkBaseFrameId, benchmarkSensorFrameId));
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr createBenchmarkTerrainPointCloud(const size_t numberOfPoints,
+                                                                        const double length,
+                                                                        const unsigned int seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> coordinate(-0.5 * length, 0.5 * length);
+  std::normal_distribution<float> noise(0.0, 0.005);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  pointCloud->header.frame_id = benchmarkMapFrameId;
+  pointCloud->reserve(numberOfPoints);
+  for (size_t i = 0; i < numberOfPoints; ++i) {
+    pcl::PointXYZRGB point;
+    point.x = coordinate(generator);
+    point.y = coordinate(generator);
+    point.z = getTerrainHeight(point.x, point.y) + noise(generator);
+    point.r = point.g = point.b = 128;
+    pointCloud->push_back(point);
+  }
+  return pointCloud;
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr createBenchmarkDepthImagePointCloud(const unsigned int width,
+                                                                           const unsigned int height,
+                                                                           const ros::Time& time)
+{
+  Eigen::Affine3d transformationBaseToMap, transformationSensorToBase;
+  getBenchmarkSensorPose(transformationBaseToMap, transformationSensorToBase);
+  const Eigen::Affine3d transformationSensorToMap = transformationBaseToMap * transformationSensorToBase;
+  const Eigen::Affine3d transformationMapToSensor = transformationSensorToMap.inverse();
+
+  // Pinhole camera with a horizontal field of view of about 60 degrees.
+  const double focalLength = 0.87 * width;
+  const double centerU = 0.5 * width, centerV = 0.5 * height;
+
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud(new pcl::PointCloud<pcl::PointXYZRGB>(width, height));
+  pointCloud->header.frame_id = benchmarkSensorFrameId;
+  pointCloud->header.stamp = time.toNSec() / 1000; // In microseconds.
+  pointCloud->is_dense = false;
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  for (unsigned int v = 0; v < height; ++v) {
+    for (unsigned int u = 0; u < width; ++u) {
+      pcl::PointXYZRGB& point = pointCloud->at(u, v);
+      point.r = point.g = point.b = 128;
+      // Intersect the ray with the plane z = 0 and project the terrain point back.
+      const Eigen::Vector3d ray = transformationSensorToMap.linear()
+          * Eigen::Vector3d((u - centerU) / focalLength, (v - centerV) / focalLength, 1.0);
+      const Eigen::Vector3d origin = transformationSensorToMap.translation();
+      if (!(ray.z() < 0.0)) {
+        point.x = point.y = point.z = nan;
+        continue;
+      }
+      Eigen::Vector3d terrainPoint = origin - origin.z() / ray.z() * ray;
+      terrainPoint.z() = getTerrainHeight(terrainPoint.x(), terrainPoint.y());
+      const Eigen::Vector3f pointInSensorFrame = (transformationMapToSensor * terrainPoint).cast<float>();
+      point.x = pointInSensorFrame.x();
+      point.y = pointInSensorFrame.y();
+      point.z = pointInSensorFrame.z();
+    }
+  }
+  return pointCloud;
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr loadRecordedPointCloud(const ros::Time& time)
+{
+  const char* path = std::getenv("ELEVATION_MAPPING_BENCHMARK_CLOUD");
+  if (path == nullptr) return pcl::PointCloud<pcl::PointXYZRGB>::Ptr();
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  if (pcl::io::loadPCDFile(path, *pointCloud) != 0) {
+    ROS_ERROR("Could not load the recorded point cloud from %s.", path);
+    return pcl::PointCloud<pcl::PointXYZRGB>::Ptr();
+  }
+  pointCloud->header.frame_id = benchmarkSensorFrameId;
+  pointCloud->header.stamp = time.toNSec() / 1000; // In microseconds.
+  return pointCloud;
+}
+
+} /* namespace elevation_mapping */
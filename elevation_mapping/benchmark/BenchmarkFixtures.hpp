@@ -0,0 +1,89 @@
+/*
+ * BenchmarkFixtures.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// PCL
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+// Eigen
+#include <Eigen/Geometry>
+
+// ROS
+#include <ros/ros.h>
+#include <tf/tf.h>
+
+// STL
+#include <string>
+
+namespace elevation_mapping {
+
+//! Frames of the benchmark setup.
+static const std::string benchmarkMapFrameId = "map";
+static const std::string benchmarkBaseFrameId = "base";
+static const std::string benchmarkSensorFrameId = "sensor";
+
+/*!
+ * Gets the pose of the sensor in the benchmark setup: The robot base is 0.5 m above the
+ * map origin, the sensor (optical frame, z-axis forward) is mounted 0.3 m above the base
+ * and pitched down by 30 degrees.
+ * @param[out] transformationBaseToMap the pose of the base in the map frame.
+ * @param[out] transformationSensorToBase the pose of the sensor in the base frame.
+ */
+void getBenchmarkSensorPose(Eigen::Affine3d& transformationBaseToMap, Eigen::Affine3d& transformationSensorToBase);
+
+/*!
+ * Adds the transforms of the benchmark setup to a TF transformer.
+ * @param transformer the TF transformer.
+ * @param time the time of the transforms.
+ */
+void setBenchmarkTransforms(tf::Transformer& transformer, const ros::Time& time);
+
+/*!
+ * Creates a point cloud sampled uniformly from a smooth terrain in the map frame.
+ * @param numberOfPoints the number of points.
+ * @param length the side length of the square area around the map origin [m].
+ * @param seed the seed of the random number generator.
+ * @return the point cloud.
+ */
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr createBenchmarkTerrainPointCloud(const size_t numberOfPoints,
+                                                                        const double length,
+                                                                        const unsigned int seed = 0);
+
+/*!
+ * Creates an organized point cloud in the sensor frame of the benchmark setup, as seen by
+ * a depth camera looking at the terrain. Pixels not hitting the terrain are NaN.
+ * @param width the image width.
+ * @param height the image height.
+ * @param time the time stamp of the point cloud.
+ * @return the point cloud.
+ */
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr createBenchmarkDepthImagePointCloud(const unsigned int width,
+                                                                           const unsigned int height,
+                                                                           const ros::Time& time);
+
+/*!
+ * Loads the recorded point cloud given as PCD file by the environment variable
+ * ELEVATION_MAPPING_BENCHMARK_CLOUD. The points are expected in the sensor frame.
+ * @param time the time stamp to set for the point cloud.
+ * @return the point cloud or null if not available.
+ */
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr loadRecordedPointCloud(const ros::Time& time);
+
+/*!
+ * Registers the elevation map benchmarks with a recorded point cloud.
+ * @param pointCloud the recorded point cloud (in the sensor frame).
+ */
+void registerRecordedElevationMapBenchmarks(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr& pointCloud);
+
+/*!
+ * Registers the sensor processor benchmarks with a recorded point cloud.
+ * @param pointCloud the recorded point cloud (in the sensor frame).
+ */
+void registerRecordedSensorProcessorBenchmarks(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr& pointCloud);
+
+} /* namespace elevation_mapping */
@@ -0,0 +1,279 @@
+/*
+ * ElevationMapBenchmark.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "BenchmarkFixtures.hpp"
+
+// Elevation Mapping
+#include "elevation_mapping/ElevationMap.hpp"
+#include "elevation_mapping/RobotMotionMapUpdater.hpp"
+#include "elevation_mapping/sensor_processors/PerfectSensorProcessor.hpp"
+
+// Benchmark
+#include <benchmark/benchmark.h>
+
+// STL
+#include <cmath>
+#include <memory>
+
+using namespace elevation_mapping;
+
+namespace {
+
+/*!
+ * Creates an empty map from the first two benchmark arguments: side length [cm] and resolution [mm].
+ */
+std::unique_ptr<ElevationMap> createMap(const benchmark::State& state,
+                                        ElevationMap::Parameters parameters = ElevationMap::Parameters())
+{
+  const double length = state.range(0) / 100.0;
+  const double resolution = state.range(1) / 1000.0;
+  std::unique_ptr<ElevationMap> map(new ElevationMap());
+  parameters.minHorizontalVariance = std::pow(resolution / 2.0, 2);
+  map->setParameters(parameters);
+  map->setFrameId(benchmarkMapFrameId);
+  map->setGeometry(grid_map::Length(length, length), resolution, grid_map::Position::Zero());
+  return map;
+}
+
+size_t getNumberOfCells(ElevationMap& map)
+{
+  return map.getRawGridMap().getSize().prod();
+}
+
+void setCellsProcessed(benchmark::State& state, const size_t numberOfCells)
+{
+  state.counters["cells"] = benchmark::Counter(state.iterations() * numberOfCells, benchmark::Counter::kIsRate);
+}
+
+//! Pose of the sensor in the map frame, also used as origin of the visibility cleanup.
+Eigen::Affine3d getTransformationSensorToMap()
+{
+  Eigen::Affine3d transformationBaseToMap, transformationSensorToBase;
+  getBenchmarkSensorPose(transformationBaseToMap, transformationSensorToBase);
+  return transformationBaseToMap * transformationSensorToBase;
+}
+
+//! Adds a point cloud in the map frame with constant variances.
+void addPointCloud(ElevationMap& map, const pcl::PointCloud<pcl::PointXYZRGB>::Ptr& pointCloud,
+                   const ros::Time& time)
+{
+  Eigen::VectorXf variances = Eigen::VectorXf::Constant(pointCloud->size(), 1e-4);
+  map.add(pointCloud, variances, time, getTransformationSensorToMap());
+}
+
+//! Measures the repeated add of a point cloud in the map frame.
+void addPointCloudToMap(benchmark::State& state, ElevationMap& map,
+                        const pcl::PointCloud<pcl::PointXYZRGB>::Ptr& pointCloud)
+{
+  Eigen::VectorXf variances = Eigen::VectorXf::Constant(pointCloud->size(), 1e-4);
+  const Eigen::Affine3d transformationSensorToMap = getTransformationSensorToMap();
+  ros::Time time(1000.0);
+  for (auto _ : state) {
+    time += ros::Duration(0.1);
+    map.add(pointCloud, variances, time, transformationSensorToMap);
+  }
+  state.SetItemsProcessed(state.iterations() * pointCloud->size());
+  setCellsProcessed(state, getNumberOfCells(map));
+}
+
+/*!
+ * Add of a synthetic point cloud.
+ * Arguments: length [cm], resolution [mm], number of points, fast add, number of threads.
+ */
+void elevationMapAdd(benchmark::State& state)
+{
+  ElevationMap::Parameters parameters;
+  parameters.enableFastAdd = state.range(3);
+  parameters.addThreads = state.range(4);
+  auto map = createMap(state, parameters);
+  const auto pointCloud = createBenchmarkTerrainPointCloud(state.range(2), state.range(0) / 100.0);
+  addPointCloudToMap(state, *map, pointCloud);
+}
+
+/*!
+ * Add of a synthetic point cloud with many points per cell and the aggregation of the points per cell.
+ * Arguments: length [cm], resolution [mm], number of points, cell aggregation (see ElevationMap::CellAggregation).
+ */
+void elevationMapAddWithCellAggregation(benchmark::State& state)
+{
+  ElevationMap::Parameters parameters;
+  parameters.cellAggregation = static_cast<ElevationMap::CellAggregation>(state.range(3));
+  auto map = createMap(state, parameters);
+  const auto pointCloud = createBenchmarkTerrainPointCloud(state.range(2), state.range(0) / 100.0);
+  addPointCloudToMap(state, *map, pointCloud);
+}
+
+/*!
+ * Fusion of the entire map.
+ * Arguments: length [cm], resolution [mm], incremental fusion, number of threads.
+ * With the incremental fusion, a small point cloud is added before each fusion (not measured).
+ */
+void elevationMapFuseAll(benchmark::State& state)
+{
+  ElevationMap::Parameters parameters;
+  parameters.enableIncrementalFusion = state.range(2);
+  parameters.fusionThreads = state.range(3);
+  auto map = createMap(state, parameters);
+  const double length = state.range(0) / 100.0;
+  ros::Time time(1000.0);
+  addPointCloud(*map, createBenchmarkTerrainPointCloud(2 * getNumberOfCells(*map), length), time);
+  map->fuseAll();
+  const auto smallPointCloud = createBenchmarkTerrainPointCloud(1000, 0.1 * length, 1);
+
+  for (auto _ : state) {
+    if (parameters.enableIncrementalFusion) {
+      state.PauseTiming();
+      time += ros::Duration(0.1);
+      addPointCloud(*map, smallPointCloud, time);
+      state.ResumeTiming();
+    }
+    map->fuseAll();
+  }
+  setCellsProcessed(state, getNumberOfCells(*map));
+}
+
+/*!
+ * Visibility cleanup of the entire map, the map is refilled before each cleanup (not measured).
+ * Arguments: length [cm], resolution [mm].
+ */
+void elevationMapVisibilityCleanup(benchmark::State& state)
+{
+  auto map = createMap(state);
+  const auto pointCloud = createBenchmarkTerrainPointCloud(2 * getNumberOfCells(*map), state.range(0) / 100.0);
+  ros::Time time(1000.0);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    time += ros::Duration(10.0);
+    addPointCloud(*map, pointCloud, time);
+    state.ResumeTiming();
+    map->visibilityCleanup(time);
+  }
+  setCellsProcessed(state, getNumberOfCells(*map));
+}
+
+/*!
+ * Variance update from the robot motion.
+ * Arguments: length [cm], resolution [mm].
+ */
+void robotMotionMapUpdate(benchmark::State& state)
+{
+  auto map = createMap(state);
+  ros::Time time(1000.0);
+  addPointCloud(*map, createBenchmarkTerrainPointCloud(2 * getNumberOfCells(*map), state.range(0) / 100.0), time);
+  RobotMotionMapUpdater robotMotionMapUpdater;
+  const RobotMotionMapUpdater::PoseCovariance robotPoseCovariance = 1e-4 * RobotMotionMapUpdater::PoseCovariance::Identity();
+
+  double yaw = 0.0;
+  for (auto _ : state) {
+    time += ros::Duration(0.01);
+    yaw += 0.001;
+    const RobotMotionMapUpdater::Pose robotPose(kindr::Position3D(0.01 * yaw, 0.0, 0.5),
+                                                kindr::RotationQuaternionPD(kindr::AngleAxisPD(yaw, 0.0, 0.0, 1.0)));
+    robotMotionMapUpdater.update(*map, robotPose, robotPoseCovariance, time);
+  }
+  setCellsProcessed(state, getNumberOfCells(*map));
+}
+
+/*!
+ * Variance update from the robot motion of a large map of which only the center (a tenth of
+ * the side length) has been explored.
+ * Arguments: length [cm], resolution [mm], active tiles.
+ */
+void robotMotionMapUpdateOfExploredArea(benchmark::State& state)
+{
+  ElevationMap::Parameters parameters;
+  parameters.enableActiveTiles = state.range(2);
+  auto map = createMap(state, parameters);
+  ros::Time time(1000.0);
+  addPointCloud(*map, createBenchmarkTerrainPointCloud(getNumberOfCells(*map) / 50, state.range(0) / 1000.0), time);
+  RobotMotionMapUpdater robotMotionMapUpdater;
+  const RobotMotionMapUpdater::PoseCovariance robotPoseCovariance = 1e-4 * RobotMotionMapUpdater::PoseCovariance::Identity();
+
+  double yaw = 0.0;
+  for (auto _ : state) {
+    time += ros::Duration(0.01);
+    yaw += 0.001;
+    const RobotMotionMapUpdater::Pose robotPose(kindr::Position3D(0.01 * yaw, 0.0, 0.5),
+                                                kindr::RotationQuaternionPD(kindr::AngleAxisPD(yaw, 0.0, 0.0, 1.0)));
+    robotMotionMapUpdater.update(*map, robotPose, robotPoseCovariance, time);
+  }
+  setCellsProcessed(state, getNumberOfCells(*map));
+}
+
+}
+
+BENCHMARK(elevationMapAdd)
+    ->ArgNames({"length_cm", "resolution_mm", "points", "fast", "threads"})
+    ->Args({400, 20, 10000, 0, 1})->Args({400, 20, 10000, 1, 1})
+    ->Args({400, 20, 300000, 0, 1})->Args({400, 20, 300000, 1, 1})->Args({400, 20, 300000, 1, 4})
+    ->Args({600, 10, 300000, 1, 1})->Args({600, 10, 300000, 1, 4})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(elevationMapAddWithCellAggregation)
+    ->ArgNames({"length_cm", "resolution_mm", "points", "aggregation"})
+    ->Args({200, 10, 300000, 0})->Args({200, 10, 300000, 1})->Args({200, 10, 300000, 2})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(elevationMapFuseAll)
+    ->ArgNames({"length_cm", "resolution_mm", "incremental", "threads"})
+    ->Args({200, 20, 0, 1})->Args({200, 20, 1, 1})
+    ->Args({400, 20, 0, 1})->Args({400, 20, 0, 4})->Args({400, 20, 1, 1})
+    ->Args({400, 10, 0, 4})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(elevationMapVisibilityCleanup)
+    ->ArgNames({"length_cm", "resolution_mm"})
+    ->Args({200, 20})->Args({400, 20})->Args({400, 10})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(robotMotionMapUpdate)
+    ->ArgNames({"length_cm", "resolution_mm"})
+    ->Args({400, 20})->Args({600, 10})->Args({1000, 10})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(robotMotionMapUpdateOfExploredArea)
+    ->ArgNames({"length_cm", "resolution_mm", "active_tiles"})
+    ->Args({4000, 20, 0})->Args({4000, 20, 1})
+    ->Unit(benchmark::kMillisecond);
+
+namespace elevation_mapping {
+
+void registerRecordedElevationMapBenchmarks(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr& pointCloud)
+{
+  // Bring the recorded point cloud to the map frame with the perfect sensor.
+  const ros::Time time = ros::Time().fromNSec(pointCloud->header.stamp * 1000);
+  tf::Transformer transformer(true, ros::Duration(10.0));
+  setBenchmarkTransforms(transformer, time);
+  struct Processor : public PerfectSensorProcessor
+  {
+    explicit Processor(tf::Transformer& transformer)
+        : PerfectSensorProcessor(transformer)
+    {
+      mapFrameId_ = benchmarkMapFrameId;
+      robotBaseFrameId_ = benchmarkBaseFrameId;
+      sensorFrameId_ = benchmarkSensorFrameId;
+    }
+  } sensorProcessor(transformer);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloudMapFrame(new pcl::PointCloud<pcl::PointXYZRGB>);
+  Eigen::VectorXf variances;
+  if (!sensorProcessor.process(pointCloud, Eigen::Matrix<double, 6, 6>::Zero(), pointCloudMapFrame, variances)) {
+    ROS_ERROR("Could not process the recorded point cloud.");
+    return;
+  }
+
+  benchmark::RegisterBenchmark("elevationMapAdd/recorded", [=](benchmark::State& state) {
+    ElevationMap::Parameters parameters;
+    parameters.enableFastAdd = state.range(2);
+    parameters.addThreads = state.range(3);
+    auto map = createMap(state, parameters);
+    addPointCloudToMap(state, *map, pointCloudMapFrame);
+  })->ArgNames({"length_cm", "resolution_mm", "fast", "threads"})
+    ->Args({600, 10, 0, 1})->Args({600, 10, 1, 1})->Args({600, 10, 1, 4})
+    ->Unit(benchmark::kMillisecond);
+}
+
+} /* namespace elevation_mapping */
@@ -0,0 +1,64 @@
+/*
+ * FusionWeightsBenchmark.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/FusionWeights.hpp"
+
+// Benchmark
+#include <benchmark/benchmark.h>
+
+// STL
+#include <algorithm>
+#include <cmath>
+
+using namespace elevation_mapping;
+
+static const float halfResolution = 0.01;
+static const float minimalWeight = 1e-6;
+static const float maxStandardDeviation = 0.05;
+static const float minStandardDeviation = 0.02;
+
+static float cumulativeDistributionFunction(float x, float mean, float standardDeviation)
+{
+  return 0.5 * erfc(-(x - mean) / (standardDeviation * sqrt(2.0)));
+}
+
+//! Per cell computation of the weights with erfc (as the fusion did before).
+static void computeWeightsWithErfc(benchmark::State& state)
+{
+  const Eigen::ArrayXf distancesX = Eigen::ArrayXf::LinSpaced(state.range(0), 0.0, 0.2);
+  const Eigen::ArrayXf distancesY = Eigen::ArrayXf::LinSpaced(state.range(0), 0.1, 0.0);
+  Eigen::ArrayXf weights(distancesX.size());
+  for (auto _ : state) {
+    for (int i = 0; i < distancesX.size(); ++i) {
+      const float probability1 =
+            cumulativeDistributionFunction(distancesX(i) + halfResolution, 0.0, maxStandardDeviation)
+          - cumulativeDistributionFunction(distancesX(i) - halfResolution, 0.0, maxStandardDeviation);
+      const float probability2 =
+            cumulativeDistributionFunction(distancesY(i) + halfResolution, 0.0, minStandardDeviation)
+          - cumulativeDistributionFunction(distancesY(i) - halfResolution, 0.0, minStandardDeviation);
+      weights(i) = std::max(minimalWeight, probability1 * probability2);
+    }
+    benchmark::DoNotOptimize(weights.data());
+  }
+  state.SetItemsProcessed(state.iterations() * distancesX.size());
+}
+
+//! Batch computation of the weights with the error function approximation.
+static void computeWeightsInBatch(benchmark::State& state)
+{
+  const Eigen::ArrayXf distancesX = Eigen::ArrayXf::LinSpaced(state.range(0), 0.0, 0.2);
+  const Eigen::ArrayXf distancesY = Eigen::ArrayXf::LinSpaced(state.range(0), 0.1, 0.0);
+  Eigen::ArrayXf weights(distancesX.size()), bufferA(distancesX.size()), bufferB(distancesX.size());
+  for (auto _ : state) {
+    computeFusionWeights(distancesX, distancesY, maxStandardDeviation, minStandardDeviation, halfResolution,
+                         minimalWeight, weights, bufferA, bufferB);
+    benchmark::DoNotOptimize(weights.data());
+  }
+  state.SetItemsProcessed(state.iterations() * distancesX.size());
+}
+
+BENCHMARK(computeWeightsWithErfc)->Range(8, 1024);
+BENCHMARK(computeWeightsInBatch)->Range(8, 1024);
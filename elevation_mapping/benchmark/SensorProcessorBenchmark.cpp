@@ -0,0 +1,103 @@
+/*
+ * SensorProcessorBenchmark.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "BenchmarkFixtures.hpp"
+#include "../test/SensorModelParameters.hpp"
+
+// Benchmark
+#include <benchmark/benchmark.h>
+
+// STL
+#include <string>
+
+using namespace elevation_mapping;
+
+namespace {
+
+/*!
+ * Sensor processor with the parameters of the benchmark setup (instead of ROS parameters).
+ * The sensor model parameters are taken from the configurations in config/sensor_processors.
+ */
+template<typename Processor>
+class BenchmarkSensorProcessor : public Processor
+{
+ public:
+  explicit BenchmarkSensorProcessor(tf::Transformer& transformer)
+      : Processor(transformer)
+  {
+    this->mapFrameId_ = benchmarkMapFrameId;
+    this->robotBaseFrameId_ = benchmarkBaseFrameId;
+    this->sensorFrameId_ = benchmarkSensorFrameId;
+    setSensorModelParameters(*this);
+  }
+};
+
+template<typename Processor>
+void processPointCloud(benchmark::State& state, const pcl::PointCloud<pcl::PointXYZRGB>::Ptr& pointCloud,
+                       const ros::Time& time)
+{
+  tf::Transformer transformer(true, ros::Duration(10.0));
+  setBenchmarkTransforms(transformer, time);
+  BenchmarkSensorProcessor<Processor> sensorProcessor(transformer);
+  const Eigen::Matrix<double, 6, 6> robotPoseCovariance = 1e-4 * Eigen::Matrix<double, 6, 6>::Identity();
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloudMapFrame(new pcl::PointCloud<pcl::PointXYZRGB>);
+  Eigen::VectorXf variances;
+
+  for (auto _ : state) {
+    if (!sensorProcessor.process(pointCloud, robotPoseCovariance, pointCloudMapFrame, variances)) {
+      state.SkipWithError("Processing the point cloud failed.");
+      break;
+    }
+    benchmark::DoNotOptimize(variances.data());
+  }
+  state.SetItemsProcessed(state.iterations() * pointCloud->size());
+  state.counters["output_points"] = pointCloudMapFrame->size();
+}
+
+//! Processing of a synthetic depth image with the size width x height (arguments).
+template<typename Processor>
+void sensorProcessorProcess(benchmark::State& state)
+{
+  const ros::Time time(1000.0);
+  const auto pointCloud = createBenchmarkDepthImagePointCloud(state.range(0), state.range(1), time);
+  processPointCloud<Processor>(state, pointCloud, time);
+}
+
+}
+
+BENCHMARK_TEMPLATE(sensorProcessorProcess, StructuredLightSensorProcessor)
+    ->ArgNames({"width", "height"})->Args({320, 240})->Args({640, 480})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(sensorProcessorProcess, StereoSensorProcessor)
+    ->ArgNames({"width", "height"})->Args({320, 240})->Args({640, 480})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(sensorProcessorProcess, LaserSensorProcessor)
+    ->ArgNames({"width", "height"})->Args({320, 240})->Args({640, 480})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(sensorProcessorProcess, PerfectSensorProcessor)
+    ->ArgNames({"width", "height"})->Args({320, 240})->Args({640, 480})->Unit(benchmark::kMillisecond);
+
+namespace elevation_mapping {
+
+void registerRecordedSensorProcessorBenchmarks(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr& pointCloud)
+{
+  const ros::Time time = ros::Time().fromNSec(pointCloud->header.stamp * 1000);
+  benchmark::RegisterBenchmark("sensorProcessorProcess<StructuredLightSensorProcessor>/recorded",
+                               [=](benchmark::State& state) {
+    processPointCloud<StructuredLightSensorProcessor>(state, pointCloud, time);
+  })->Unit(benchmark::kMillisecond);
+  benchmark::RegisterBenchmark("sensorProcessorProcess<StereoSensorProcessor>/recorded",
+                               [=](benchmark::State& state) {
+    processPointCloud<StereoSensorProcessor>(state, pointCloud, time);
+  })->Unit(benchmark::kMillisecond);
+  benchmark::RegisterBenchmark("sensorProcessorProcess<LaserSensorProcessor>/recorded",
+                               [=](benchmark::State& state) {
+    processPointCloud<LaserSensorProcessor>(state, pointCloud, time);
+  })->Unit(benchmark::kMillisecond);
+  benchmark::RegisterBenchmark("sensorProcessorProcess<PerfectSensorProcessor>/recorded",
+                               [=](benchmark::State& state) {
+    processPointCloud<PerfectSensorProcessor>(state, pointCloud, time);
+  })->Unit(benchmark::kMillisecond);
+}
+
+} /* namespace elevation_mapping */
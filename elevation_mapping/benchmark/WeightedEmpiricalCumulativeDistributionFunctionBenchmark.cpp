@@ -0,0 +1,47 @@
+/*
+ * WeightedEmpiricalCumulativeDistributionFunctionBenchmark.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/WeightedEmpiricalCumulativeDistributionFunction.hpp"
+#include "elevation_mapping/FlatWeightedEmpiricalCumulativeDistributionFunction.hpp"
+
+// Benchmark
+#include <benchmark/benchmark.h>
+
+// STL
+#include <random>
+#include <vector>
+
+using namespace elevation_mapping;
+
+/*!
+ * Computes the 1% and the 99% quantile of a distribution as in the fusion of a cell,
+ * where the number of data points corresponds to the number of cells in the ellipse.
+ */
+template <typename Distribution>
+static void computeQuantiles(benchmark::State& state)
+{
+  const size_t size = state.range(0);
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> valueDistribution(0.0, 1.0);
+  std::vector<float> values(size), weights(size);
+  for (size_t i = 0; i < size; ++i) {
+    values[i] = valueDistribution(generator);
+    weights[i] = valueDistribution(generator);
+  }
+
+  Distribution distribution;
+  for (auto _ : state) {
+    distribution.clear();
+    for (size_t i = 0; i < size; ++i) distribution.add(values[i], weights[i]);
+    distribution.compute();
+    benchmark::DoNotOptimize(distribution.quantile(0.01));
+    benchmark::DoNotOptimize(distribution.quantile(0.99));
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+BENCHMARK_TEMPLATE(computeQuantiles, WeightedEmpiricalCumulativeDistributionFunction<float>)->Range(8, 1024);
+BENCHMARK_TEMPLATE(computeQuantiles, FlatWeightedEmpiricalCumulativeDistributionFunction<float>)->Range(8, 1024);
@@ -0,0 +1,26 @@
+/*
+ * benchmark_elevation_mapping.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "BenchmarkFixtures.hpp"
+
+// Benchmark
+#include <benchmark/benchmark.h>
+
+int main(int argc, char** argv)
+{
+  // The benchmarks run without a ROS master, only the time is needed.
+  ros::Time::init();
+  benchmark::Initialize(&argc, argv);
+
+  const auto recordedPointCloud = elevation_mapping::loadRecordedPointCloud(ros::Time(1000.0));
+  if (recordedPointCloud) {
+    elevation_mapping::registerRecordedSensorProcessorBenchmarks(recordedPointCloud);
+    elevation_mapping::registerRecordedElevationMapBenchmarks(recordedPointCloud);
+  }
+
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
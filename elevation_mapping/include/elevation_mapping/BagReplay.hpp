@@ -0,0 +1,153 @@
+/*
+ * BagReplay.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// Elevation Mapping
+#include "elevation_mapping/BoundedQueue.hpp"
+#include "elevation_mapping/ElevationMapping.hpp"
+
+// ROS
+#include <ros/ros.h>
+#include <sensor_msgs/PointCloud2.h>
+
+// Boost
+#include <boost/thread.hpp>
+
+// STL
+#include <map>
+#include <string>
+#include <utility>
+
+namespace elevation_mapping {
+
+/*!
+ * Offline replay of a ROS bag for building elevation maps faster than realtime. Reads the point
+ * cloud, robot pose and TF messages of a bag and drives the elevation mapping directly, without
+ * subscribers (no messages are dropped) and without timers. The time of the bag replaces the
+ * wall clock: The point clouds are processed in the order of their time stamps once the poses and
+ * transformations up to a lookahead after the time stamp have been read, and the motion updates
+ * without point clouds and the visibility cleanups are triggered at the rates of the node. The
+ * point clouds are processed in the reading thread and integrated in a separate thread (if the
+ * pipelined processing is enabled) in the same order on every run. The resulting map and the
+ * performance statistics are written at the end.
+ */
+class BagReplay
+{
+ public:
+
+  /*!
+   * Constructor.
+   * @param nodeHandle the ROS node handle with the parameters of the elevation mapping and the replay.
+   */
+  BagReplay(ros::NodeHandle& nodeHandle);
+
+  /*!
+   * Destructor.
+   */
+  virtual ~BagReplay();
+
+  /*!
+   * Replays the bag and writes the resulting map and the report.
+   * @return true if successful.
+   */
+  bool run();
+
+ private:
+
+  //! Task of the integration stage, in the order of the bag.
+  struct IntegrationTask
+  {
+    enum class Type
+    {
+      PointCloud,
+      MotionUpdate,
+      VisibilityCleanup
+    };
+
+    Type type;
+    ElevationMapping::ProcessedPointCloud processedPointCloud;
+    ros::Time time;
+  };
+
+  /*!
+   * Reads and verifies the ROS parameters.
+   * @return true if successful.
+   */
+  bool readParameters();
+
+  /*!
+   * Processes the point clouds that are pending up to a time and queues them for the integration,
+   * together with the motion updates and visibility cleanups that are due before them.
+   * @param time the time up to which the point clouds are processed.
+   */
+  void processPendingPointClouds(const ros::Time& time);
+
+  /*!
+   * Queues the motion updates without point clouds and the visibility cleanups up to a time.
+   * @param time the time of the replay.
+   */
+  void queueTimedUpdates(const ros::Time& time);
+
+  /*!
+   * Queues a task for the integration, or runs it directly if the processing is not pipelined.
+   * @param task the task.
+   */
+  void queueIntegrationTask(IntegrationTask&& task);
+
+  /*!
+   * Runs a task of the integration stage.
+   * @param task the task.
+   */
+  void runIntegrationTask(const IntegrationTask& task);
+
+  /*!
+   * Separate thread for the integration stage.
+   */
+  void runIntegrationThread();
+
+  /*!
+   * Writes the map files and the report.
+   * @param bagDuration the replayed duration of the bag.
+   * @param wallDuration the duration of the replay.
+   * @return true if successful.
+   */
+  bool writeResults(const ros::Duration& bagDuration, const ros::WallDuration& wallDuration);
+
+  //! ROS nodehandle.
+  ros::NodeHandle& nodeHandle_;
+
+  //! Elevation mapping without ROS interfaces and TF listener, driven by the replay through its offline interface.
+  ElevationMapping elevationMapping_;
+
+  //! Bag file to replay.
+  std::string bagFile_;
+
+  //! TF topics in the bag.
+  std::string tfTopic_;
+  std::string tfStaticTopic_;
+
+  //! Time after the time stamp of a point cloud until it is processed (time for the poses and TF).
+  ros::Duration lookahead_;
+
+  //! Output files (not written if empty).
+  std::string outputMapFile_;
+  std::string outputBagFile_;
+  std::string reportFile_;
+
+  //! Point clouds waiting for the lookahead, sorted by time stamp, with the index of their sensor input.
+  std::multimap<ros::Time, std::pair<sensor_msgs::PointCloud2ConstPtr, size_t>> pendingPointClouds_;
+
+  //! Time of the last point cloud or motion update, and of the last visibility cleanup.
+  ros::Time lastUpdateTime_;
+  ros::Time lastVisibilityCleanupTime_;
+
+  //! Queue and thread of the integration stage.
+  BoundedQueue<IntegrationTask> integrationQueue_;
+  boost::thread integrationThread_;
+};
+
+} /* namespace */
@@ -0,0 +1,212 @@
+/*
+ * BoundedQueue.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// Boost
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <utility>
+
+namespace elevation_mapping {
+
+/*!
+ * Policy of a bounded queue for new items when the queue is full.
+ */
+enum class QueueDropPolicy
+{
+  //! The oldest queued item is dropped.
+  DropOldest,
+  //! The new item is dropped.
+  DropNewest,
+  //! The new item is merged into the newest queued item (if not possible, the oldest item is dropped).
+  Coalesce,
+  //! The producer waits until an item has been taken from the queue, no item is dropped.
+  Block
+};
+
+/*!
+ * First-in first-out (or ordered, see setOrder(...)) queue with a bounded number of items
+ * between a producing and a consuming thread. If the queue is full, items are dropped or merged according
+ * to the drop policy, such that the producer never blocks (except for QueueDropPolicy::Block).
+ */
+template<typename Item>
+class BoundedQueue
+{
+ public:
+
+  /*!
+   * Function merging a new item into a queued item (for QueueDropPolicy::Coalesce). Returns
+   * false without modifying the items if they cannot be merged.
+   */
+  typedef std::function<bool(Item& queuedItem, Item&& newItem)> CoalesceFunction;
+
+  /*!
+   * Function returning true if an item has to be taken from the queue before another item.
+   */
+  typedef std::function<bool(const Item& item, const Item& otherItem)> OrderFunction;
+
+  /*!
+   * Constructor.
+   * @param capacity the maximal number of queued items (at least 1).
+   * @param dropPolicy the policy for new items when the queue is full.
+   * @param coalesceFunction the function merging items, required for QueueDropPolicy::Coalesce.
+   */
+  explicit BoundedQueue(const size_t capacity = 1, const QueueDropPolicy dropPolicy = QueueDropPolicy::DropOldest,
+                        const CoalesceFunction& coalesceFunction = CoalesceFunction())
+      : capacity_(capacity > 0 ? capacity : 1),
+        dropPolicy_(dropPolicy),
+        coalesceFunction_(coalesceFunction),
+        isStopped_(false),
+        isClosed_(false)
+  {
+  }
+
+  /*!
+   * Sets the capacity and the drop policy. Items beyond the new capacity are kept.
+   * @param capacity the maximal number of queued items (at least 1).
+   * @param dropPolicy the policy for new items when the queue is full.
+   * @param coalesceFunction the function merging items, required for QueueDropPolicy::Coalesce.
+   */
+  void configure(const size_t capacity, const QueueDropPolicy dropPolicy,
+                 const CoalesceFunction& coalesceFunction = CoalesceFunction())
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    capacity_ = capacity > 0 ? capacity : 1;
+    dropPolicy_ = dropPolicy;
+    coalesceFunction_ = coalesceFunction;
+  }
+
+  /*!
+   * Sets the order in which the items are taken from the queue. A new item is queued before
+   * the items it has to be taken before and after all others (the oldest item is the first
+   * in this order). Without order function, the items are taken in the order they were added.
+   * @param orderFunction the function ordering the items.
+   */
+  void setOrder(const OrderFunction& orderFunction)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    orderFunction_ = orderFunction;
+    if (orderFunction_) std::stable_sort(items_.begin(), items_.end(), orderFunction_);
+  }
+
+  /*!
+   * Adds an item to the queue, without blocking unless the drop policy is QueueDropPolicy::Block.
+   * @param item the item.
+   * @return false if an item was dropped or merged because the queue was full, or if the
+   * queue is stopped or closed.
+   */
+  bool push(Item item)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    if (dropPolicy_ == QueueDropPolicy::Block) {
+      while (items_.size() >= capacity_ && !isStopped_ && !isClosed_) notFullCondition_.wait(lock);
+    }
+    if (isStopped_ || isClosed_) return false;
+    const bool isFull = items_.size() >= capacity_;
+    if (isFull) {
+      if (dropPolicy_ == QueueDropPolicy::DropNewest) {
+        return false;
+      } else if (dropPolicy_ == QueueDropPolicy::Coalesce && coalesceFunction_
+                 && coalesceFunction_(items_.back(), std::move(item))) {
+        return false;
+      }
+      items_.pop_front();
+    }
+    if (orderFunction_) {
+      items_.insert(std::upper_bound(items_.begin(), items_.end(), item, orderFunction_), std::move(item));
+    } else {
+      items_.push_back(std::move(item));
+    }
+    lock.unlock();
+    condition_.notify_one();
+    return !isFull;
+  }
+
+  /*!
+   * Takes the oldest item from the queue. Blocks until an item is available or the
+   * queue is stopped (or closed and empty).
+   * @param[out] item the item.
+   * @return true if successful, false if the queue is stopped or closed and empty.
+   */
+  bool pop(Item& item)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    while (items_.empty() && !isStopped_ && !isClosed_) condition_.wait(lock);
+    if (isStopped_ || items_.empty()) return false;
+    item = std::move(items_.front());
+    items_.pop_front();
+    lock.unlock();
+    notFullCondition_.notify_one();
+    return true;
+  }
+
+  /*!
+   * Stops the queue. Wakes up all waiting consumers, queued items are discarded.
+   */
+  void stop()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    isStopped_ = true;
+    items_.clear();
+    lock.unlock();
+    condition_.notify_all();
+    notFullCondition_.notify_all();
+  }
+
+  /*!
+   * Closes the queue. No new items are accepted, the consumers still take the queued items.
+   */
+  void close()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    isClosed_ = true;
+    lock.unlock();
+    condition_.notify_all();
+    notFullCondition_.notify_all();
+  }
+
+  /*!
+   * Gets the number of queued items.
+   * @return the number of items.
+   */
+  size_t size() const
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    return items_.size();
+  }
+
+ private:
+  //! Queued items.
+  std::deque<Item> items_;
+
+  //! Maximal number of queued items.
+  size_t capacity_;
+
+  //! Policy for new items when the queue is full.
+  QueueDropPolicy dropPolicy_;
+  CoalesceFunction coalesceFunction_;
+
+  //! Order of the queued items (none for first-in first-out).
+  OrderFunction orderFunction_;
+
+  //! True if the queue is stopped or closed.
+  bool isStopped_;
+  bool isClosed_;
+
+  //! Protects the queue and signals new items (and taken items for QueueDropPolicy::Block).
+  mutable boost::mutex mutex_;
+  boost::condition_variable condition_;
+  boost::condition_variable notFullCondition_;
+};
+
+} /* namespace elevation_mapping */
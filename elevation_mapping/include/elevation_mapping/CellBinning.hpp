@@ -0,0 +1,110 @@
+/*
+ * CellBinning.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace elevation_mapping {
+
+/*!
+ * Groups points by the map cell they fall into. The points are sorted by their
+ * (linear) cell index with a stable radix sort, such that the points of a cell
+ * keep their original order. The buffers are reused between computations.
+ */
+class CellBinning
+{
+ public:
+
+  /*!
+   * Constructor.
+   */
+  CellBinning();
+
+  /*!
+   * Destructor.
+   */
+  virtual ~CellBinning();
+
+  /*!
+   * Sorts the points into bins of equal cells.
+   * @param pointCells the linear cell index for each point. Points with a cell index
+   * equal or larger than the number of cells are ignored.
+   * @param numberOfCells the number of cells of the map.
+   */
+  void compute(const std::vector<uint32_t>& pointCells, const uint32_t numberOfCells);
+
+  /*!
+   * Gets the number of bins (occupied cells).
+   * @return the number of bins.
+   */
+  size_t getNumberOfBins() const
+  {
+    return binCells_.size();
+  }
+
+  /*!
+   * Gets the linear cell index of a bin.
+   * @param bin the index of the bin.
+   * @return the linear cell index.
+   */
+  uint32_t getCell(const size_t bin) const
+  {
+    return binCells_[bin];
+  }
+
+  /*!
+   * Gets the position of the first point of a bin in the sorted point list.
+   * @param bin the index of the bin.
+   * @return the begin of the bin.
+   */
+  size_t getBegin(const size_t bin) const
+  {
+    return binStarts_[bin];
+  }
+
+  /*!
+   * Gets the position behind the last point of a bin in the sorted point list.
+   * @param bin the index of the bin.
+   * @return the end of the bin.
+   */
+  size_t getEnd(const size_t bin) const
+  {
+    return binStarts_[bin + 1];
+  }
+
+  /*!
+   * Gets the original index of a point in the sorted point list.
+   * @param position the position in the sorted point list.
+   * @return the index of the point in the input.
+   */
+  uint32_t getPointIndex(const size_t position) const
+  {
+    return points_[position];
+  }
+
+ private:
+  //! Number of bits sorted per radix sort pass.
+  static const unsigned int radixBits_ = 11;
+
+  //! Sorted cell indices and corresponding point indices (with buffers for sorting).
+  std::vector<uint32_t> cells_;
+  std::vector<uint32_t> points_;
+  std::vector<uint32_t> cellsBuffer_;
+  std::vector<uint32_t> pointsBuffer_;
+
+  //! Histogram for the radix sort.
+  std::vector<size_t> histogram_;
+
+  //! Cell index and start in the sorted lists for each bin (last entry marks the end).
+  std::vector<uint32_t> binCells_;
+  std::vector<size_t> binStarts_;
+};
+
+} /* namespace elevation_mapping */
@@ -0,0 +1,299 @@
+/*
+ * CompactLayers.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// Elevation Mapping
+#include "elevation_mapping/HostDevice.hpp"
+
+// Grid Map
+#include <grid_map_core/GridMap.hpp>
+
+// Eigen
+#include <Eigen/Core>
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace elevation_mapping {
+
+/*
+ * Compact layers of the raw map (see ElevationMap::Parameters::enableCompactLayers). As the
+ * color, each cell of a compact layer packs two 16-bit fields into the bits of a float:
+ *   'compact_horizontal_variance_x_y': horizontal_variance_x (low), horizontal_variance_y (high),
+ *   'compact_horizontal_variance_xy_time': time (low), horizontal_variance_xy (high).
+ * The variances are stored in scaled half precision, the time in ticks relative to a time base. The
+ * fields of a cell that has been cleared (NaN, e.g. by grid_map::GridMap::clear()) have no
+ * values, a packed cell is never NaN.
+ */
+
+//! Resolution of the compact time [ticks/s].
+constexpr double compactTimeTicksPerSecond = 100.0;
+
+//! Scale of the variances in half precision (a power of two, exact), such that variances down to
+//! 2.4e-7 m^2 are normal halves, variances beyond 255 m^2 become infinite.
+constexpr float compactVarianceScale = 256.0f;
+
+//! Max. number of ticks of a compact time after its time base (the code 0 is 'no time').
+constexpr int maxCompactTimeTick = 0xfffe;
+
+/*!
+ * Converts a float to half precision (IEEE 754 binary16), rounded to nearest even. Values
+ * beyond the largest half (65504) become infinite.
+ * @param value the value.
+ * @return the bits of the half.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline uint16_t floatToHalf(const float value)
+{
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint16_t sign = (bits >> 16) & 0x8000;
+  const uint32_t absoluteBits = bits & 0x7fffffff;
+  if (absoluteBits > 0x7f800000) return 0x7e00; // NaN.
+  if (absoluteBits >= 0x477ff000) return sign | 0x7c00; // Rounds to infinity.
+  if (absoluteBits < 0x38800000) {
+    // Subnormal half, in multiples of 2^-24 (the scaling is exact).
+    float absoluteValue;
+    std::memcpy(&absoluteValue, &absoluteBits, sizeof(absoluteValue));
+    return sign | static_cast<uint16_t>(std::nearbyint(absoluteValue * 16777216.0f));
+  }
+  // Normal half, the exponent is rebiased and the mantissa rounded from 23 to 10 bits.
+  const uint32_t roundedBits = absoluteBits + 0xfff + ((absoluteBits >> 13) & 1);
+  return sign | static_cast<uint16_t>((roundedBits - 0x38000000) >> 13);
+}
+
+/*!
+ * Converts a half precision value (IEEE 754 binary16) to float (exact).
+ * @param half the bits of the half.
+ * @return the value.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline float halfToFloat(const uint16_t half)
+{
+  const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  const uint32_t exponent = (half >> 10) & 0x1f;
+  const uint32_t mantissa = half & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0) {
+    // Zero or subnormal half.
+    const float value = static_cast<float>(mantissa) * 5.9604644775390625e-8f;
+    std::memcpy(&bits, &value, sizeof(bits));
+    bits |= sign;
+  } else if (exponent == 0x1f) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/*!
+ * Encodes a time as compact time.
+ * @param time the time since initialization of the map [s].
+ * @param timeBase the time base [ticks], times before it are stored as the time base.
+ * @return the compact time, 0 if the time is NaN.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline uint16_t encodeCompactTime(const float time, const int timeBase)
+{
+  if (std::isnan(time)) return 0;
+  const double tick = std::floor(time * compactTimeTicksPerSecond + 0.5) - timeBase;
+  if (!(tick > 0.0)) return 1;
+  if (tick > maxCompactTimeTick) return maxCompactTimeTick + 1;
+  return static_cast<uint16_t>(tick) + 1;
+}
+
+/*!
+ * Decodes a compact time (see encodeCompactTime(...)).
+ * @param time the compact time.
+ * @param timeBase the time base [ticks].
+ * @return the time since initialization of the map [s], NaN if there is no time.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline float decodeCompactTime(const uint16_t time, const int timeBase)
+{
+  if (time == 0) return std::numeric_limits<float>::quiet_NaN();
+  return static_cast<float>((static_cast<double>(timeBase) + (time - 1)) / compactTimeTicksPerSecond);
+}
+
+/*!
+ * Gets the time base for which a time is the latest time in the middle of the range of the
+ * compact times, such that the range covers the older times and the times to come.
+ * @param time the time since initialization of the map [s].
+ * @return the time base [ticks].
+ */
+inline int getCompactTimeBase(const float time)
+{
+  // Limited such that the ticks of the range are within int.
+  const double maxTimeBase = std::numeric_limits<int>::max() / 2;
+  const double timeBase = std::floor(time * compactTimeTicksPerSecond + 0.5) - maxCompactTimeTick / 2;
+  return static_cast<int>(std::max(-maxTimeBase, std::min(timeBase, maxTimeBase)));
+}
+
+/*!
+ * Packs two 16-bit fields into a cell of a compact layer.
+ * @param low the low field.
+ * @param high the high field.
+ * @return the packed cell.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline float packCompactFields(const uint16_t low, const uint16_t high)
+{
+  const uint32_t bits = low | (static_cast<uint32_t>(high) << 16);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/*!
+ * Unpacks the 16-bit fields of a cell of a compact layer.
+ * @param[in] value the packed cell.
+ * @param[out] low the low field.
+ * @param[out] high the high field.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline void unpackCompactFields(const float value, uint16_t& low, uint16_t& high)
+{
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  low = bits & 0xffff;
+  high = bits >> 16;
+}
+
+/*!
+ * Packs two variances in half precision (scaled by compactVarianceScale) into a cell (layer
+ * 'compact_horizontal_variance_x_y').
+ * @param low the value of the low field.
+ * @param high the value of the high field.
+ * @return the packed cell.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline float packHalfFloats(const float low, const float high)
+{
+  return packCompactFields(floatToHalf(low * compactVarianceScale), floatToHalf(high * compactVarianceScale));
+}
+
+/*!
+ * Unpacks the values of a cell packed by packHalfFloats(...).
+ * @param[in] value the packed cell.
+ * @param[out] low the value of the low field, NaN for a cleared cell.
+ * @param[out] high the value of the high field, NaN for a cleared cell.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline void unpackHalfFloats(const float value, float& low, float& high)
+{
+  if (std::isnan(value)) {
+    low = high = std::numeric_limits<float>::quiet_NaN();
+    return;
+  }
+  uint16_t lowField, highField;
+  unpackCompactFields(value, lowField, highField);
+  low = halfToFloat(lowField) / compactVarianceScale;
+  high = halfToFloat(highField) / compactVarianceScale;
+}
+
+/*!
+ * Packs a compact time and a variance in half precision (scaled by compactVarianceScale) into a
+ * cell (layer 'compact_horizontal_variance_xy_time').
+ * @param time the compact time (see encodeCompactTime(...)).
+ * @param high the value of the high field.
+ * @return the packed cell.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline float packTimeAndHalfFloat(const uint16_t time, const float high)
+{
+  return packCompactFields(time, floatToHalf(high * compactVarianceScale));
+}
+
+/*!
+ * Unpacks a cell packed by packTimeAndHalfFloat(...).
+ * @param[in] value the packed cell.
+ * @param[out] time the compact time, 0 (no time) for a cleared cell.
+ * @param[out] high the value of the high field, NaN for a cleared cell.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline void unpackTimeAndHalfFloat(const float value, uint16_t& time, float& high)
+{
+  if (std::isnan(value)) {
+    time = 0;
+    high = std::numeric_limits<float>::quiet_NaN();
+    return;
+  }
+  uint16_t highField;
+  unpackCompactFields(value, time, highField);
+  high = halfToFloat(highField) / compactVarianceScale;
+}
+
+/*!
+ * Gets the compact layer in which a layer of the raw map is stored.
+ * @param layer the layer (e.g. 'time').
+ * @return the compact layer, empty if the layer is not stored in a compact layer.
+ */
+const std::string& getCompactLayer(const std::string& layer);
+
+/*!
+ * Checks if a map stores the horizontal variances and the time in the compact layers.
+ * @param map the raw map (or a snapshot of it).
+ * @return true if the map has the compact layers.
+ */
+bool hasCompactLayers(const grid_map::GridMap& map);
+
+/*!
+ * Replaces the layers 'horizontal_variance_x/y/xy' and 'time' of a map by the compact layers.
+ * Missing layers are stored as NaN.
+ * @param map the map.
+ * @param timeBase the time base of the compact times [ticks].
+ */
+void packCompactLayers(grid_map::GridMap& map, const int timeBase);
+
+/*!
+ * Replaces the compact layers of a map by the layers 'horizontal_variance_x/y/xy' and 'time'.
+ * @param map the map.
+ * @param timeBase the time base of the compact times [ticks].
+ */
+void unpackCompactLayers(grid_map::GridMap& map, const int timeBase);
+
+/*!
+ * Decodes a layer that is stored in a compact layer.
+ * @param[in] map the map with the compact layers.
+ * @param[in] layer the layer (e.g. 'time').
+ * @param[in] timeBase the time base of the compact times [ticks].
+ * @param[out] data the values of the layer.
+ */
+void decodeCompactLayer(const grid_map::GridMap& map, const std::string& layer, const int timeBase,
+                        grid_map::Matrix& data);
+
+/*!
+ * Changes the time base of the compact times of a map. Times before the new base are stored as
+ * the new base.
+ * @param map the map with the compact layers.
+ * @param timeBase the time base of the compact times [ticks].
+ * @param newTimeBase the new time base [ticks].
+ */
+void rebaseCompactTime(grid_map::GridMap& map, const int timeBase, const int newTimeBase);
+
+/*!
+ * Gets the horizontal variances of a cell, stored as float or in the compact layers.
+ * @param[in] map the raw map (or a snapshot of it).
+ * @param[in] index the index of the cell.
+ * @param[out] varianceX the horizontal variance in x-direction.
+ * @param[out] varianceY the horizontal variance in y-direction.
+ * @param[out] varianceXY the horizontal covariance.
+ */
+void getHorizontalVariances(const grid_map::GridMap& map, const grid_map::Index& index, float& varianceX,
+                            float& varianceY, float& varianceXY);
+
+/*!
+ * Gets the horizontal variances of a block of cells (see getHorizontalVariances(...) for a cell).
+ * @param[in] map the raw map (or a snapshot of it).
+ * @param[in] startIndex the (buffer) index of the first cell of the block.
+ * @param[in] size the size of the block (within the buffer).
+ * @param[out] varianceX the horizontal variances in x-direction.
+ * @param[out] varianceY the horizontal variances in y-direction.
+ * @param[out] varianceXY the horizontal covariances.
+ */
+void getHorizontalVariances(const grid_map::GridMap& map, const grid_map::Index& startIndex, const grid_map::Size& size,
+                            Eigen::ArrayXXf& varianceX, Eigen::ArrayXXf& varianceY, Eigen::ArrayXXf& varianceXY);
+
+} /* namespace elevation_mapping */
@@ -8,6 +8,16 @@
 
 #pragma once
 
+// Elevation Mapping
+#include "elevation_mapping/CellBinning.hpp"
+#include "elevation_mapping/ElevationMapAddKernel.hpp"
+#include "elevation_mapping/ElevationMapFunctors.hpp"
+#include "elevation_mapping/PerformanceStatistics.hpp"
+#include "elevation_mapping/ThreadPool.hpp"
+#include "elevation_mapping/TileMask.hpp"
+#include "elevation_mapping/FlatWeightedEmpiricalCumulativeDistributionFunction.hpp"
+#include "elevation_mapping/RobotMotionMapUpdateKernel.hpp"
+
 // Grid Map
 #include <grid_map_ros/grid_map_ros.hpp>
 
@@ -23,7 +33,16 @@
 #include <kindr/Core>
 
 // Boost
-#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+// STL
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 // ROS
 #include <ros/ros.h>
@@ -37,16 +56,96 @@ class ElevationMap
 {
  public:
 
+  //! Aggregation of the points of a point cloud that fall into the same cell (see elevation_mapping::CellAggregation).
+  typedef elevation_mapping::CellAggregation CellAggregation;
+
+  /*!
+   * Parameters of the elevation map (see the README for a description). The
+   * defaults are the same as for the ROS parameters.
+   */
+  struct Parameters
+  {
+    double minVariance = 0.003 * 0.003;
+    double maxVariance = 0.03 * 0.03;
+    double mahalanobisDistanceThreshold = 2.5;
+    double multiHeightNoise = 0.003 * 0.003;
+    double minHorizontalVariance = 0.005 * 0.005;
+    double maxHorizontalVariance = 0.5;
+    bool enableVisibilityCleanup = true;
+    double visibilityCleanupDuration = 0.0;
+    double scanningDuration = 1.0;
+    bool enableFastAdd = true;
+    bool enableIncrementalFusion = true;
+    //! Skips the tiles without measurements in the passes over the entire raw map (an optimization of the
+    //! passes, the maps are still stored densely).
+    bool enableActiveTiles = true;
+    //! Stores the horizontal variances (half precision) and the time (16-bit ticks) of the raw map in
+    //! two compact layers instead of four float layers (see CompactLayers.hpp).
+    bool enableCompactLayers = false;
+    unsigned int addThreads = 1;
+    unsigned int fusionThreads = 1;
+    unsigned int visibilityCleanupThreads = 1;
+    CellAggregation cellAggregation = CellAggregation::None;
+    unsigned int fusedMapPyramidLevels = 0;
+    //! Published layers of the raw and the fused map, all layers if empty.
+    std::vector<std::string> rawMapPublishedLayers;
+    std::vector<std::string> fusedMapPublishedLayers;
+    unsigned int mapUpdatesKeyframeInterval = 10;
+  };
+
   /*!
-   * Constructor.
+   * Immutable copy of the basic layers of the fused map, for queries without locking the map.
+   */
+  struct FusedMapSnapshot
+  {
+    //! Copy of the layers 'elevation', 'upper_bound' and 'lower_bound' of the fused map.
+    grid_map::GridMap map;
+
+    //! Tiles of the map that were not up to date with the raw map when the snapshot was taken.
+    TileMask staleTiles;
+
+    //! Time when the snapshot was taken.
+    ros::WallTime time;
+
+    /*!
+     * Checks if a region of the snapshot was not up to date with the raw map.
+     * @param position the center of the region.
+     * @param length the side lengths of the region.
+     * @return true if any cell of the region is stale, false if the region is up to date or outside of the map.
+     */
+    bool isStale(const grid_map::Position& position, const grid_map::Length& length) const;
+  };
+
+  /*!
+   * Constructor. Advertises the map topics.
+   * @param nodeHandle the ROS node handle.
    */
   ElevationMap(ros::NodeHandle nodeHandle);
 
+  /*!
+   * Constructor without any ROS communication (no publishers and subscribers), such
+   * that the map can be used without a ROS master, e.g. in benchmarks. Only requires
+   * the ROS time to be initialized (ros::Time::init()).
+   */
+  ElevationMap();
+
   /*!
    * Destructor.
    */
   virtual ~ElevationMap();
 
+  /*!
+   * Sets the parameters.
+   * @param parameters the parameters.
+   */
+  void setParameters(const Parameters& parameters);
+
+  /*!
+   * Gets the parameters.
+   * @return the parameters.
+   */
+  const Parameters& getParameters() const;
+
   /*!
    * Set the geometry of the elevation map. Clears all the data.
    * @param length the side lengths in x, and y-direction of the elevation map [m].
@@ -60,7 +159,7 @@ class ElevationMap
    * Add new measurements to the elevation map.
    * @param pointCloud the point cloud data.
    * @param pointCloudVariances the corresponding variances of the point cloud data.
-   * @param timeStamp the time of the input point cloud.
+   * @param timeStamp the time of the input point cloud (older point clouds do not move the time of the last update back).
    * @param transformationSensorToMap
    * @return true if successful.
    */
@@ -81,6 +180,15 @@ class ElevationMap
               const grid_map::Matrix& horizontalVarianceUpdateY,
               const grid_map::Matrix& horizontalVarianceUpdateXY, const ros::Time& time);
 
+  /*!
+   * Update the elevation map with the variance update of the robot motion. The
+   * variances are clamped in the same pass (see clean()).
+   * @param motionUpdate the variance update of the robot motion.
+   * @param time the time of the update.
+   * @return true if successful.
+   */
+  bool update(RobotMotionMapUpdateKernel& motionUpdate, const ros::Time& time);
+
   /*!
    * Triggers the fusion of the entire elevation map.
    * @return true if successful.
@@ -88,7 +196,8 @@ class ElevationMap
   bool fuseAll();
 
   /*!
-   * Fuses the elevation map for a certain rectangular area.
+   * Fuses the elevation map for a certain rectangular area. The area is extended to the
+   * tiles (of 4 x 4 cells) in which the fused map keeps track of its out-dated cells.
    * @param position the center position of the area to fuse.
    * @param length the sides lengths of the area to fuse.
    * @return true if successful.
@@ -102,9 +211,30 @@ class ElevationMap
   bool clear();
 
   /*!
-   * Removes parts of the map based on visibility criterion with ray tracing.
-   * @param transformationSensorToMap
-   * @param updatedTime
+   * Replaces the raw map by a previously saved raw map (e.g. to continue mapping from a map
+   * file). The geometry and the start index of the circular buffer are taken from the loaded
+   * map, the fused map is reset and fused from the loaded data on the next fusion. The variances
+   * are clamped to the limits of the parameters (see clean()).
+   * @param map the loaded raw map with (at least) the persistent layers (see getPersistentLayers()),
+   * the layers of the lowest scan points are optional.
+   * @param initialTime the time the 'time' layer of the loaded map is relative to.
+   * @return true if successful, false if the map does not fit the elevation map.
+   */
+  bool loadRawMap(const grid_map::GridMap& map, const ros::Time& initialTime);
+
+  /*!
+   * Gets the layers of the raw map that are saved to map files. The sensor origins of the lowest
+   * scan points are saved by their coordinates (layers 'sensor_x/y/z_at_lowest_scan').
+   * @return the persistent layers.
+   */
+  static const std::vector<std::string>& getPersistentLayers();
+
+  /*!
+   * Removes parts of the map based on visibility criterion with ray tracing. Rays are traced
+   * from the sensor to the lowest scan points of the cells updated since the last cleanup,
+   * cells with a height above the rays that have not been updated within the scanning
+   * duration are removed.
+   * @param updatedTime the time of the cleanup.
    */
   void visibilityCleanup(const ros::Time& updatedTime);
 
@@ -115,18 +245,36 @@ class ElevationMap
   void move(const Eigen::Vector2d& position);
 
   /*!
-   * Publishes the (latest) raw elevation map.
+   * Publishes the (latest) raw elevation map, and the region that has changed since the
+   * last publication on the updates topic.
    * @return true if successful.
    */
   bool publishRawElevationMap();
 
   /*!
-   * Publishes the fused elevation map. Takes the latest available fused elevation
-   * map, does not trigger the fusion process.
+   * Takes the tiles of the raw map that have changed since they have last been taken, which
+   * are the tiles of the next update published by publishRawElevationMap(). The fusion keeps
+   * them. The tiles are reset, such that they are not published as updated.
+   * @return the changed tiles.
+   */
+  TileMask takeUnpublishedRawMapTiles();
+
+  /*!
+   * Publishes the fused elevation map, the region that has changed since the last
+   * publication on the updates topic and the levels of the fused map pyramid that have
+   * subscribers. Takes the latest available fused elevation map, does not trigger the fusion
+   * process.
    * @return true if successful.
    */
   bool publishFusedElevationMap();
 
+  /*!
+   * Advertises the topics of the levels of the fused map pyramid (see
+   * Parameters::fusedMapPyramidLevels).
+   * @param nodeHandle the ROS node handle.
+   */
+  void advertiseFusedMapPyramid(ros::NodeHandle nodeHandle);
+
   /*!
    * Publishes the (latest) visibility cleanup map.
    * @return true if successful.
@@ -134,17 +282,62 @@ class ElevationMap
   bool publishVisibilityCleanupMap();
 
   /*!
-   * Gets a reference to the raw grid map.
+   * Gets a reference to the raw grid map. Cells that are written directly are only considered
+   * by the passes over the entire map if their tile is active (see Parameters::enableActiveTiles).
+   * With Parameters::enableCompactLayers, the horizontal variances and the time are stored in the
+   * compact layers (see CompactLayers.hpp).
    * @return the raw grid map.
    */
   grid_map::GridMap& getRawGridMap();
 
+  /*!
+   * Registers the position of a sensor for the lowest scan points of the raw map. The cells only
+   * store the id of the sensor origin (layer 'sensor_origin_at_lowest_scan') instead of its three
+   * coordinates, the positions are kept until the next visibility cleanup.
+   * @param position the position of the sensor in the map frame.
+   * @return the id of the sensor origin.
+   */
+  float addSensorOrigin(const grid_map::Position3& position);
+
+  /*!
+   * Gets a snapshot of a subset of the layers of the raw grid map. The snapshot is not
+   * affected by later changes of the raw map. Snapshots are shared between callers as long
+   * as the requested layers do not change, and their memory is reused once no caller holds
+   * them anymore. The layers 'sensor_x/y/z_at_lowest_scan' contain the coordinates of the
+   * sensor origins of the lowest scan points, the layers that are stored in the compact layers
+   * (see Parameters::enableCompactLayers) are decoded.
+   * @param layers the layers to copy (must contain the basic layers 'elevation' and 'variance').
+   * @return the snapshot of the raw grid map.
+   */
+  std::shared_ptr<const grid_map::GridMap> getRawMapSnapshot(const std::vector<std::string>& layers);
+
   /*!
    * Gets a reference to the fused grid map.
    * @return the fused grid map.
    */
   grid_map::GridMap& getFusedGridMap();
 
+  /*!
+   * Gets a level of the fused map pyramid. Level n has a 2^n times coarser resolution than
+   * the fused map, its cells are aligned with multiples of the resolution in the map frame.
+   * The elevation of a cell is the mean of the fused elevations, the lower (upper) bound is
+   * the minimum (maximum) of the fused lower (upper) bounds. The level is computed from the
+   * latest available fused elevation map if it has changed since, this does not trigger the
+   * fusion process.
+   * @param[in] level the level, from 1 to Parameters::fusedMapPyramidLevels (0 is the fused map).
+   * @param[out] map the level of the fused map pyramid.
+   * @return true if successful, false if the level does not exist.
+   */
+  bool getFusedMapPyramidLevel(const unsigned int level, grid_map::GridMap& map);
+
+  /*!
+   * Gets the snapshot of the fused map as of the latest fusion, without locking the map. The
+   * snapshots are only taken by the fusion once they have been requested, the first call
+   * therefore returns null. The memory of the snapshots is reused once no caller holds them anymore.
+   * @return the latest snapshot of the fused map, null if there is none.
+   */
+  std::shared_ptr<const FusedMapSnapshot> getFusedMapSnapshot();
+
   /*!
    * Gets the time of last map update.
    * @return time of the last map update.
@@ -157,6 +350,19 @@ class ElevationMap
    */
   ros::Time getTimeOfLastFusion();
 
+  /*!
+   * Gets the time the 'time' layer of the raw map is relative to.
+   * @return the initial time.
+   */
+  ros::Time getInitialTime();
+
+  /*!
+   * Sets the time the 'time' layer of the raw map is relative to (the map is empty). If zero, the
+   * time of the first added point cloud is used.
+   * @param initialTime the initial time.
+   */
+  void setInitialTime(const ros::Time& initialTime);
+
   /*!
    * Get the pose of the elevation map frame w.r.t. the inertial parent frame of the robot (e.g. world, map etc.).
    * @return pose of the elevation map frame w.r.t. the parent frame of the robot.
@@ -173,16 +379,19 @@ class ElevationMap
   bool getPosition3dInRobotParentFrame(const Eigen::Array2i& index, kindr::Position3D& position);
 
   /*!
-   * Gets the fused data mutex.
+   * Gets the fused data mutex. Readers of the fused map lock it shared, writers exclusively.
+   * The mutex is not recursive, the methods of the map lock it themselves and must not be
+   * called while holding it.
    * @return reference to the fused data mutex.
    */
-  boost::recursive_mutex& getFusedDataMutex();
+  boost::shared_mutex& getFusedDataMutex();
 
   /*!
-   * Gets the raw data mutex.
+   * Gets the raw data mutex. Readers of the raw map lock it shared, writers exclusively.
+   * If both are locked, the fused data mutex has to be locked first.
    * @return reference to the raw data mutex.
    */
-  boost::recursive_mutex& getRawDataMutex();
+  boost::shared_mutex& getRawDataMutex();
 
   /*!
    * Set the frame id.
@@ -190,6 +399,12 @@ class ElevationMap
    */
   void setFrameId(const std::string& frameId);
 
+  /*!
+   * Sets the statistics to record the durations of the map operations to.
+   * @param statistics the statistics, nothing is recorded if null.
+   */
+  void setPerformanceStatistics(PerformanceStatistics* statistics);
+
   /*!
    * Get the frame id.
    * @return the frameId.
@@ -197,13 +412,13 @@ class ElevationMap
   const std::string& getFrameId();
 
   /*!
-   * If the raw elevation map has subscribers.
+   * If the raw elevation map or its updates have subscribers.
    * @return true if number of subscribers bigger then 0.
    */
   bool hasRawMapSubscribers() const;
 
   /*!
-   * If the fused elevation map has subscribers.
+   * If the fused elevation map, its updates or a level of the fused map pyramid have subscribers.
    * @return true if number of subscribers bigger then 0.
    */
   bool hasFusedMapSubscribers() const;
@@ -226,13 +441,191 @@ class ElevationMap
   bool readParameters();
 
   /*!
-   * Fuses a region of the map.
+   * Adds the points of a point cloud to the raw elevation map by looking up the
+   * layers for all points individually.
+   * @param pointCloud the point cloud data.
+   * @param pointCloudVariances the corresponding variances of the point cloud data.
+   * @param scanTimeSinceInitialization the time of the input point cloud since initialization [s].
+   * @param sensorOrigin the id of the sensor origin (see addSensorOrigin(...)).
+   */
+  void addPoints(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud, const Eigen::VectorXf& pointCloudVariances,
+                 const float scanTimeSinceInitialization, const float sensorOrigin);
+
+  /*!
+   * Adds the points of a point cloud to the raw elevation map with the add kernel
+   * (see ElevationMapAddKernel). The points are first grouped by cell and the cells
+   * are then updated in parallel, each with its points in the original order.
+   * Yields the same result as addPoints(...) if the points are not aggregated per cell.
+   * @param pointCloud the point cloud data.
+   * @param pointCloudVariances the corresponding variances of the point cloud data.
+   * @param scanTimeSinceInitialization the time of the input point cloud since initialization [s].
+   * @param sensorOrigin the id of the sensor origin (see addSensorOrigin(...)).
+   */
+  void addPointsWithKernel(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud,
+                           const Eigen::VectorXf& pointCloudVariances, const float scanTimeSinceInitialization,
+                           const float sensorOrigin);
+
+  /*!
+   * Resizes the raw and the fused map (see setGeometry(...)). The fused and the raw map mutex
+   * have to be locked exclusively.
+   * @param length the side lengths in x, and y-direction of the elevation map [m].
+   * @param resolution the cell size in [m/cell].
+   * @param position the 2d position of the elevation map in the elevation map frame [m].
+   */
+  void resizeMaps(const grid_map::Length& length, const double& resolution, const grid_map::Position& position);
+
+  /*!
+   * Registers a sensor origin (see addSensorOrigin(...)). The raw map mutex has to be locked exclusively.
+   * @param position the position of the sensor in the map frame.
+   * @return the id of the sensor origin.
+   */
+  float insertSensorOrigin(const grid_map::Position3& position);
+
+  /*!
+   * Removes the sensor origins that are not referenced by any cell anymore and renumbers the
+   * others. The raw map mutex has to be locked exclusively.
+   */
+  void compactSensorOrigins();
+
+  /*!
+   * Registers the sensor origins of the lowest scan points of a loaded map, which are saved by
+   * their coordinates. The raw map mutex has to be locked exclusively.
+   * @param map the loaded map with the layers of the lowest scan points.
+   */
+  void loadSensorOrigins(const grid_map::GridMap& map);
+
+  /*!
+   * Gets a snapshot of a subset of the layers of the raw grid map (see getRawMapSnapshot(...)).
+   * The raw map mutex has to be locked (shared or exclusively).
+   * @param layers the layers to copy (must contain the basic layers 'elevation' and 'variance').
+   * @return the snapshot of the raw grid map.
+   */
+  std::shared_ptr<const grid_map::GridMap> copyRawMapSnapshot(const std::vector<std::string>& layers);
+
+  /*!
+   * Gets a level of the fused map pyramid (see getFusedMapPyramidLevel(...)). The fused map
+   * mutex has to be locked (shared or exclusively).
+   * @param[in] level the level, from 0 to Parameters::fusedMapPyramidLevels.
+   * @param[out] map the level of the fused map pyramid.
+   * @return true if successful, false if the level does not exist.
+   */
+  bool copyFusedMapPyramidLevel(const unsigned int level, grid_map::GridMap& map);
+
+  /*!
+   * Fuses a region of the map. The fused map mutex has to be locked exclusively, the raw map
+   * is only locked (shared) to take the snapshot of its data.
    * @param topLeftIndex the top left index of the region.
    * @param size the size (in number of cells) of the region.
    * @return true if successful.
    */
   bool fuse(const grid_map::Index& topLeftIndex, const grid_map::Index& size);
 
+  /*!
+   * Scratch memory for the fusion of cells. The buffers only grow such that they
+   * can be reused for all cells.
+   */
+  struct FusionBuffers
+  {
+    /*!
+     * Makes sure the buffers can hold the data of a number of cells.
+     * @param size the number of cells.
+     */
+    void reserve(const size_t size);
+
+    Eigen::ArrayXf means;
+    Eigen::ArrayXf standardDeviations;
+    Eigen::ArrayXf distancesX;
+    Eigen::ArrayXf distancesY;
+    Eigen::ArrayXf weights;
+    Eigen::ArrayXf erfBufferA;
+    Eigen::ArrayXf erfBufferB;
+    FlatWeightedEmpiricalCumulativeDistributionFunction<float> lowerBoundDistribution;
+    FlatWeightedEmpiricalCumulativeDistributionFunction<float> upperBoundDistribution;
+  };
+
+  /*!
+   * Fuses a cell of the map if it has not been fused yet.
+   * @param rawMap the copy of the raw map.
+   * @param index the index of the cell.
+   * @param buffers the scratch memory of the calling thread.
+   * @return true if the cell has been fused, false if it had already been fused or has no data.
+   */
+  bool fuseCell(const grid_map::GridMap& rawMap, const grid_map::Index& index, FusionBuffers& buffers);
+
+  //! Sensor origin of the rays of the visibility cleanup.
+  struct VisibilityRayOrigin
+  {
+    grid_map::Position3 position;
+    grid_map::Index index;
+  };
+
+  //! Ray of the visibility cleanup from a sensor origin to the cell of a lowest scan point.
+  struct VisibilityRay
+  {
+    grid_map::Index index;
+    size_t origin;
+  };
+
+  /*!
+   * Traces a ray of the visibility cleanup from the sensor cell to the cell of the lowest scan
+   * point (with the same cells as grid_map::LineIterator) and lowers the max. height of the cells
+   * on the ray to the height of the ray. The cell positions along the ray are updated incrementally.
+   * @param map the copy of the raw map.
+   * @param origin the sensor origin of the ray.
+   * @param index the index of the cell with the lowest scan point.
+   * @param maxHeight the max. heights of the calling thread (+inf where not yet limited).
+   */
+  void traceVisibilityRay(const grid_map::GridMap& map, const VisibilityRayOrigin& origin,
+                          const grid_map::Index& index, grid_map::Matrix& maxHeight) const;
+
+  /*!
+   * Calls a function for each cell of the active tiles (see rawMapActiveTiles_).
+   * @param activeTiles the active tiles.
+   * @param function the function taking the index of the cell.
+   */
+  template<typename Function>
+  static void forEachActiveCell(const TileMask& activeTiles, Function function)
+  {
+    activeTiles.forEachMarkedTile([&](const grid_map::Index& startIndex, const grid_map::Size& size) {
+      for (int col = startIndex(1); col < startIndex(1) + size(1); ++col) {
+        for (int row = startIndex(0); row < startIndex(0) + size(0); ++row) function(grid_map::Index(row, col));
+      }
+    });
+  }
+
+  /*!
+   * Marks layers of the raw map as changed such that new snapshots are taken of them (the
+   * layers of the compact layers mark their compact layer). Has to be called with the raw map
+   * mutex locked.
+   * @param layers the changed layers.
+   */
+  void touchRawMapLayers(const std::vector<std::string>& layers);
+
+  /*!
+   * Marks all layers of the raw map as changed (see touchRawMapLayers(...)).
+   */
+  void touchRawMap();
+
+  /*!
+   * Gets the layers of which snapshots of the raw map can be taken (see copyRawMapSnapshot(...)),
+   * the layers of the raw map and the persistent layers. The raw map mutex has to be locked.
+   * @return the layers.
+   */
+  std::vector<std::string> getRawMapSnapshotLayers() const;
+
+  /*!
+   * Sets the time base of the compact times such that the latest time of the raw map (layer 'time',
+   * before it is packed) is in the middle of their range. The raw map mutex has to be locked exclusively.
+   */
+  void resetCompactTimeBase();
+
+  /*!
+   * Moves the time base of the compact times ahead if a time is beyond their range. The raw map
+   * mutex has to be locked exclusively.
+   * @param time the time since initialization of the map [s].
+   */
+  void updateCompactTimeBase(const float time);
+
   /*!
    * Cleans the elevation map data to stay within the specified bounds.
    * @return true if successful.
@@ -240,22 +633,85 @@ class ElevationMap
   bool clean();
 
   /*!
-   * Resets the fused map data.
-   * @return true if successful.
+   * Clamps the variances of all cells of the active tiles of the raw elevation map in one
+   * traversal (see clean()). The raw map mutex has to be locked.
+   */
+  void clampVariances();
+
+  /*!
+   * Resets the active tiles of the raw map after the raw map has been cleared or resized, marks
+   * all tiles if the active tiles are disabled. The raw map mutex has to be locked.
+   */
+  void resetActiveTiles();
+
+  /*!
+   * Gets the operator to clamp the variances of a cell with the current parameters.
+   * @return the variance clamp operator.
+   */
+  CellVarianceClampOperator getVarianceClampOperator() const;
+
+  /*!
+   * Resets the fused map data. The fused map mutex has to be locked exclusively.
    */
   void resetFusedData();
 
   /*!
-   * Cumulative distribution function.
-   * @param x the argument value.
-   * @param mean the mean of the distribution.
-   * @param standardDeviation the standardDeviation of the distribution.
-   * @return the function value.
+   * Resets the fused map data in the regions that are affected by changes of the raw map.
+   * The fused map mutex has to be locked exclusively.
+   * @param dirtyTiles the tiles of the raw map that have changed since the last fusion (dilated in place).
+   * @param maxEllipseRadius the largest radius of the ellipses used for the fusion [m].
    */
-  float cumulativeDistributionFunction(float x, float mean, float standardDeviation);
+  void invalidateFusedData(TileMask& dirtyTiles, const double maxEllipseRadius);
 
-  //! ROS nodehandle.
-  ros::NodeHandle nodeHandle_;
+  /*!
+   * Updates the upper bounds for the largest horizontal variance (eigenvalue) of the valid cells
+   * of the changed tiles, and gets the upper bound for the whole map.
+   * @param rawMap the raw elevation map.
+   * @param dirtyTiles the tiles of the raw map that have changed since the last update.
+   * @return the largest horizontal variance, infinity if undefined.
+   */
+  float updateMaxHorizontalVariance(const grid_map::GridMap& rawMap, const TileMask& dirtyTiles);
+
+  /*!
+   * Marks the levels of the fused map pyramid as out-dated. The fused map mutex has to be locked.
+   */
+  void touchFusedMap();
+
+  /*!
+   * Takes a snapshot of the fused map (see getFusedMapSnapshot()). The fused map mutex has to be locked.
+   */
+  void updateFusedMapSnapshot();
+
+  /*!
+   * Downsamples the fused map for the fused map pyramid.
+   * @param[in] fusedMap the fused map.
+   * @param[in] factor the number of cells of the fused map per cell of the downsampled map in each direction.
+   * @param[out] downsampledMap the downsampled map.
+   */
+  static void downsampleFusedMap(const grid_map::GridMap& fusedMap, const int factor, grid_map::GridMap& downsampledMap);
+
+  /*!
+   * Publishes the selected layers of a map on its topic and the regions of the map that have
+   * changed on its updates topic (or the entire map as keyframe). The derived layers are
+   * only computed for the published maps.
+   * @param map the map (raw or fused).
+   * @param layers the published layers.
+   * @param updatedTiles the tiles of the map that have changed since the last publication.
+   * @param publisher the publisher of the map.
+   * @param updatesPublisher the publisher of the updates.
+   * @param numberOfUpdates the number of published updates (incremented).
+   */
+  void publishMap(const grid_map::GridMap& map, const std::vector<std::string>& layers, const TileMask& updatedTiles,
+                  const ros::Publisher& publisher, const ros::Publisher& updatesPublisher, unsigned int& numberOfUpdates) const;
+
+  /*!
+   * Publishes the selected layers of a map. The map is only copied if derived layers have to be added.
+   * @param map the map.
+   * @param layers the published layers.
+   * @param publisher the publisher.
+   */
+  static void publishLayers(const grid_map::GridMap& map, const std::vector<std::string>& layers,
+                            const ros::Publisher& publisher);
 
   //! Raw elevation map as grid map.
   grid_map::GridMap rawMap_;
@@ -263,8 +719,8 @@ class ElevationMap
   //! Fused elevation map as grid map.
   grid_map::GridMap fusedMap_;
 
-  //! Visibility cleanup debug map.
-  grid_map::GridMap visibilityCleanupMap_;
+  //! Snapshot of the raw map used by the last visibility cleanup (for the debug map).
+  std::shared_ptr<const grid_map::GridMap> visibilityCleanupMap_;
 
   //! Underlying map, used for ground truth maps, multi-robot mapping etc.
   grid_map::GridMap underlyingMap_;
@@ -279,15 +735,121 @@ class ElevationMap
   ros::Publisher elevationMapRawPublisher_;
   ros::Publisher elevationMapFusedPublisher_;
   ros::Publisher visbilityCleanupMapPublisher_;
+  std::vector<ros::Publisher> fusedMapPyramidPublishers_;
+  ros::Publisher elevationMapRawUpdatesPublisher_;
+  ros::Publisher elevationMapFusedUpdatesPublisher_;
+
+  //! Tiles of the raw and the fused map that have changed since they have last been published.
+  TileMask rawMapUnpublishedTiles_;
+  TileMask fusedMapUnpublishedTiles_;
+
+  //! Number of published updates of the raw and the fused map (for the keyframes), guarded by the publishing mutexes.
+  unsigned int numberOfRawMapUpdates_;
+  unsigned int numberOfFusedMapUpdates_;
+
+  //! Reader/writer lock for fused map. Locked before the raw map if both are needed.
+  boost::shared_mutex fusedMapMutex_;
+
+  //! Reader/writer lock for raw map.
+  boost::shared_mutex rawMapMutex_;
+
+  //! Mutex lock for vsibility cleanup map. Locked before the fused and the raw map if needed.
+  boost::mutex visibilityCleanupMapMutex_;
+
+  //! Mutex lock for the dirty and the unpublished tiles of the raw map, which are consumed by
+  //! the fusion and the publishing with the raw map locked shared.
+  boost::mutex rawMapTilesMutex_;
+
+  //! Mutex locks held while publishing the raw and the fused map, such that the updates are
+  //! published in order.
+  boost::mutex rawMapPublishingMutex_;
+  boost::mutex fusedMapPublishingMutex_;
+
+  //! Snapshot of raw map layers with the version of the raw map when it was taken.
+  struct RawMapSnapshot
+  {
+    uint64_t version = 0;
+    std::shared_ptr<grid_map::GridMap> map;
+    //! Mutex lock for the update of the snapshot by concurrent readers of the raw map.
+    boost::mutex mutex;
+  };
 
-  //! Mutex lock for fused map.
-  boost::recursive_mutex fusedMapMutex_;
+  //! Snapshots of the raw map, by requested layers (entries are never removed).
+  std::map<std::vector<std::string>, RawMapSnapshot> rawMapSnapshots_;
 
-  //! Mutex lock for raw map.
-  boost::recursive_mutex rawMapMutex_;
+  //! Mutex lock for the lookup of the snapshots of the raw map.
+  boost::mutex rawMapSnapshotsMutex_;
 
-  //! Mutex lock for vsibility cleanup map.
-  boost::recursive_mutex visibilityCleanupMapMutex_;
+  //! Version of the raw map, and the versions at which the layers have last been changed.
+  uint64_t rawMapVersion_;
+  std::unordered_map<std::string, uint64_t> rawMapLayerVersions_;
+
+  //! Time base of the compact times of the raw map [ticks] (see Parameters::enableCompactLayers).
+  int compactTimeBase_;
+
+  //! Tiles of the raw map that have changed since the last fusion.
+  TileMask rawMapDirtyTiles_;
+
+  //! Tiles of the raw map that (may) contain cells with elevation, the passes over the entire
+  //! map skip the other tiles.
+  TileMask rawMapActiveTiles_;
+
+  //! Sensor origins of the lowest scan points of the raw map, by id.
+  std::vector<grid_map::Position3> sensorOrigins_;
+
+  //! Levels 1 to n of the fused map pyramid, with the versions of the fused map they have been computed from.
+  std::vector<grid_map::GridMap> fusedMapPyramid_;
+  std::vector<uint64_t> fusedMapPyramidVersions_;
+
+  //! Mutex lock for the update of the fused map pyramid by concurrent readers of the fused map.
+  boost::mutex fusedMapPyramidMutex_;
+
+  //! Version of the fused map.
+  uint64_t fusedMapVersion_;
+
+  //! Tiles of the fused map that are (possibly) not up to date with the raw map as of the last fusion.
+  //! The tiles are smaller than the tiles of the raw map, as fused areas are extended to them.
+  TileMask fusedMapStaleTiles_;
+
+  //! Latest snapshot of the fused map (only accessed atomically), and the previous snapshot for the reuse of its memory.
+  std::shared_ptr<const FusedMapSnapshot> fusedMapSnapshot_;
+  std::shared_ptr<FusedMapSnapshot> previousFusedMapSnapshot_;
+
+  //! If the fusion takes snapshots of the fused map.
+  std::atomic<bool> isFusedMapSnapshotRequested_;
+
+  //! Upper bound for the largest horizontal variance of the raw map per tile of the dirty tiles,
+  //! kept up to date by the incremental fusion (empty if it has to be recomputed).
+  Eigen::ArrayXXf tileMaxHorizontalVariances_;
+
+  //! Scratch memory for the fusion, one per fusion thread.
+  std::vector<FusionBuffers> fusionBuffers_;
+
+  //! Worker threads for the fusion.
+  ThreadPool fusionThreadPool_;
+
+  //! Max. heights of the visibility cleanup, one per visibility cleanup thread (the first one has the result).
+  std::vector<grid_map::Matrix> visibilityCleanupMaxHeights_;
+
+  //! Worker threads for the visibility cleanup.
+  ThreadPool visibilityCleanupThreadPool_;
+
+  //! 95.45% confidence ellipse which is 2.486-sigma for 2 dof problem.
+  //! http://www.reid.ai/2012/09/chi-squared-distribution-table-with.html
+  static constexpr double uncertaintyFactor_ = 2.486; // sqrt(6.18)
+
+  //! Grouping of the points by cell for the fast add.
+  std::vector<uint32_t> pointCells_;
+  CellBinning addBinning_;
+
+  //! Worker threads for the fast add.
+  ThreadPool addThreadPool_;
+
+  //! Number of points or cells processed at once by a thread.
+  const size_t addGrainSize_;
+
+  //! Performance statistics (not owned, may be null).
+  PerformanceStatistics* statistics_;
 
   //! Underlying map subscriber.
   ros::Subscriber underlyingMapSubscriber_;
@@ -295,17 +857,11 @@ class ElevationMap
   //! Initial ros time
   ros::Time initialTime_;
 
-  //! Parameters. Are set through the ElevationMapping class.
-  double minVariance_;
-  double maxVariance_;
-  double mahalanobisDistanceThreshold_;
-  double multiHeightNoise_;
-  double minHorizontalVariance_;
-  double maxHorizontalVariance_;
+  //! Underlying map topic. Is set through the ElevationMapping class.
   std::string underlyingMapTopic_;
-  bool enableVisibilityCleanup_;
-  double visibilityCleanupDuration_;
-  double scanningDuration_;
+
+  //! Parameters.
+  Parameters parameters_;
 };
 
 } /* namespace */
@@ -0,0 +1,211 @@
+/*
+ * ElevationMapAddKernel.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// Elevation Mapping
+#include "elevation_mapping/ElevationMapFunctors.hpp"
+#include "elevation_mapping/HostDevice.hpp"
+#include "elevation_mapping/RawMapLayers.hpp"
+
+// STL
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace elevation_mapping {
+
+/*!
+ * Aggregation of the points of a point cloud that fall into the same cell, before they
+ * are added to the map (see the README for a description).
+ */
+enum class CellAggregation
+{
+  None,
+  InverseVariance,
+  MinMax
+};
+
+/*!
+ * Fuses single height measurements into the raw elevation map. Operates directly on
+ * the layer data (see RawMapLayers) and computes exactly the same update as the
+ * layer lookup based implementation in ElevationMap::add(...).
+ */
+class ElevationMapAddKernel
+{
+ public:
+
+  /*!
+   * Constructor.
+   * @param layers the layers of the raw elevation map.
+   * @param scanTime the time of the point cloud since initialization of the map [s].
+   * @param sensorOrigin the id of the sensor origin (see ElevationMap::addSensorOrigin(...)).
+   * @param minHorizontalVariance the minimal horizontal variance.
+   * @param mahalanobisDistanceThreshold the threshold for the multi-height handling.
+   * @param multiHeightNoise the noise added for cells with multiple heights.
+   * @param scanningDuration the scanning duration of the sensor [s].
+   * @param varianceClamp the clamping of the variances of the cells (see ElevationMap::clean()).
+   */
+  ELEVATION_MAPPING_HOST_DEVICE ElevationMapAddKernel(const RawMapLayers& layers, const float scanTime, const float sensorOrigin,
+                        const double minHorizontalVariance, const double mahalanobisDistanceThreshold,
+                        const double multiHeightNoise, const double scanningDuration,
+                        const CellVarianceClampOperator& varianceClamp)
+      : layers_(layers),
+        scanTime_(scanTime),
+        sensorOrigin_(sensorOrigin),
+        minHorizontalVariance_(minHorizontalVariance),
+        mahalanobisDistanceThreshold_(mahalanobisDistanceThreshold),
+        multiHeightNoise_(multiHeightNoise),
+        scanningDuration_(scanningDuration),
+        varianceClamp_(varianceClamp)
+  {
+  }
+
+  /*!
+   * Adds a height measurement to a cell.
+   * @param cell the linear index of the cell.
+   * @param height the measured height.
+   * @param pointVariance the variance of the measured height.
+   * @param pointColor the color of the measurement (as grid map color value).
+   */
+  ELEVATION_MAPPING_HOST_DEVICE inline void addPoint(const size_t cell, const float height, const float pointVariance, const float pointColor) const
+  {
+    float& elevation = layers_.elevation[cell];
+    float& variance = layers_.variance[cell];
+
+    if (!std::isfinite(elevation) || !std::isfinite(variance)) {
+      // No prior information in elevation map, use measurement.
+      elevation = height;
+      variance = pointVariance;
+      layers_.setHorizontalVariances(cell, minHorizontalVariance_, minHorizontalVariance_, 0.0);
+      layers_.color[cell] = pointColor;
+      return;
+    }
+
+    // Deal with multiple heights in one cell.
+    const float time = layers_.getTime(cell);
+    const double mahalanobisDistance = std::fabs(height - elevation) / std::sqrt(variance);
+    if (mahalanobisDistance > mahalanobisDistanceThreshold_) {
+      if (scanTime_ - time <= scanningDuration_ && elevation > height) {
+        // Ignore point if measurement is from the same point cloud (time comparison) and
+        // if measurement is lower then the elevation in the map.
+      } else if (scanTime_ - time <= scanningDuration_) {
+        // If point is higher.
+        elevation = height;
+        variance = pointVariance;
+      } else {
+        variance += multiHeightNoise_;
+      }
+      return;
+    }
+
+    // Store lowest points from scan for visibility checking.
+    float& lowestScanPoint = layers_.lowestScanPoint[cell];
+    const float pointHeightPlusUncertainty = height + 3.0 * std::sqrt(pointVariance); // 3 sigma.
+    if (std::isnan(lowestScanPoint) || pointHeightPlusUncertainty < lowestScanPoint) {
+      lowestScanPoint = pointHeightPlusUncertainty;
+      layers_.sensorOriginAtLowestScan[cell] = sensorOrigin_;
+    }
+
+    // Fuse measurement with elevation map data.
+    elevation = (variance * height + pointVariance * elevation) / (variance + pointVariance);
+    variance = (pointVariance * variance) / (pointVariance + variance);
+    // TODO Add color fusion.
+    layers_.color[cell] = pointColor;
+    layers_.setTime(cell, scanTime_);
+
+    // Horizontal variances are reset.
+    layers_.setHorizontalVariances(cell, minHorizontalVariance_, minHorizontalVariance_, 0.0);
+  }
+
+  /*!
+   * Clamps the variances of a cell. To be called once all points of the cell are added.
+   * @param cell the linear index of the cell.
+   */
+  ELEVATION_MAPPING_HOST_DEVICE inline void clampVariances(const size_t cell) const
+  {
+    varianceClamp_(layers_, cell);
+  }
+
+  /*!
+   * Adds all points of a cell in their order, aggregated as requested, and clamps the variances
+   * of the cell.
+   * @param cell the linear index of the cell.
+   * @param numberOfPoints the number of points of the cell.
+   * @param cellAggregation the aggregation of the points.
+   * @param getPoint function (n, height, variance) getting the height and variance of the n-th point of the cell.
+   * @param getColor function (n) returning the color of the n-th point of the cell.
+   */
+  template<typename PointFunction, typename ColorFunction>
+  ELEVATION_MAPPING_HOST_DEVICE inline void addPoints(const size_t cell, const size_t numberOfPoints,
+                                                      const CellAggregation cellAggregation,
+                                                      const PointFunction& getPoint, const ColorFunction& getColor) const
+  {
+    float height, pointVariance;
+    if (cellAggregation == CellAggregation::InverseVariance && numberOfPoints > 1) {
+      // Single measurement as the inverse-variance weighted mean of the points.
+      const float minPointVariance = std::numeric_limits<float>::min();
+      double weightSum = 0.0, weightedHeightSum = 0.0;
+      for (size_t n = 0; n < numberOfPoints; ++n) {
+        getPoint(n, height, pointVariance);
+        const double weight = 1.0 / (pointVariance < minPointVariance ? minPointVariance : pointVariance);
+        weightSum += weight;
+        weightedHeightSum += weight * height;
+      }
+      addPoint(cell, weightedHeightSum / weightSum, 1.0 / weightSum, getColor(numberOfPoints - 1));
+    } else if (cellAggregation == CellAggregation::MinMax && numberOfPoints > 1) {
+      // Lowest and highest point, such that the multi-height handling keeps the highest.
+      size_t lowest = 0, highest = 0;
+      float lowestHeight, highestHeight;
+      getPoint(0, lowestHeight, pointVariance);
+      highestHeight = lowestHeight;
+      for (size_t n = 1; n < numberOfPoints; ++n) {
+        getPoint(n, height, pointVariance);
+        if (height < lowestHeight) {
+          lowest = n;
+          lowestHeight = height;
+        }
+        if (height > highestHeight) {
+          highest = n;
+          highestHeight = height;
+        }
+      }
+      getPoint(lowest, height, pointVariance);
+      addPoint(cell, height, pointVariance, getColor(lowest));
+      if (highest != lowest) {
+        getPoint(highest, height, pointVariance);
+        addPoint(cell, height, pointVariance, getColor(highest));
+      }
+    } else {
+      for (size_t n = 0; n < numberOfPoints; ++n) {
+        getPoint(n, height, pointVariance);
+        addPoint(cell, height, pointVariance, getColor(n));
+      }
+    }
+    clampVariances(cell);
+  }
+
+ private:
+  //! Layers of the raw elevation map.
+  const RawMapLayers layers_;
+
+  //! Time of the scan since initialization of the map.
+  const float scanTime_;
+
+  //! Id of the sensor origin.
+  const float sensorOrigin_;
+
+  //! Parameters.
+  const float minHorizontalVariance_;
+  const double mahalanobisDistanceThreshold_;
+  const double multiHeightNoise_;
+  const double scanningDuration_;
+
+  //! Clamping of the variances.
+  const CellVarianceClampOperator varianceClamp_;
+};
+
+} /* namespace elevation_mapping */
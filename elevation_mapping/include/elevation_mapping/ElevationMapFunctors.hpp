@@ -8,21 +8,52 @@
 
 #pragma once
 
+// Elevation Mapping
+#include "elevation_mapping/HostDevice.hpp"
+#include "elevation_mapping/RawMapLayers.hpp"
+
+// STL
+#include <cstddef>
+#include <limits>
+
 namespace elevation_mapping {
 
 template<typename Scalar>
 struct VarianceClampOperator
 {
-  VarianceClampOperator(const Scalar& minVariance, const Scalar& maxVariance)
+  ELEVATION_MAPPING_HOST_DEVICE VarianceClampOperator(const Scalar& minVariance, const Scalar& maxVariance)
       : minVariance_(minVariance),
         maxVariance_(maxVariance)
   {
   }
-  const Scalar operator()(const Scalar& x) const
+  ELEVATION_MAPPING_HOST_DEVICE const Scalar operator()(const Scalar& x) const
   {
     return x < minVariance_ ? minVariance_ : (x > maxVariance_ ? std::numeric_limits<float>::infinity() : x);
   }
   Scalar minVariance_, maxVariance_;
 };
 
+/*!
+ * Clamps the vertical and the horizontal variances of a cell of the raw elevation map
+ * (see VarianceClampOperator), such that all layers are handled in one traversal.
+ */
+struct CellVarianceClampOperator
+{
+  ELEVATION_MAPPING_HOST_DEVICE CellVarianceClampOperator(const float minVariance, const float maxVariance,
+                                                          const float minHorizontalVariance, const float maxHorizontalVariance)
+      : varianceClamp_(minVariance, maxVariance),
+        horizontalVarianceClamp_(minHorizontalVariance, maxHorizontalVariance)
+  {
+  }
+  ELEVATION_MAPPING_HOST_DEVICE void operator()(const RawMapLayers& layers, const size_t cell) const
+  {
+    layers.variance[cell] = varianceClamp_(layers.variance[cell]);
+    float horizontalVarianceX, horizontalVarianceY, horizontalVarianceXY;
+    layers.getHorizontalVariances(cell, horizontalVarianceX, horizontalVarianceY, horizontalVarianceXY);
+    layers.setHorizontalVariances(cell, horizontalVarianceClamp_(horizontalVarianceX),
+                                  horizontalVarianceClamp_(horizontalVarianceY), horizontalVarianceXY);
+  }
+  VarianceClampOperator<float> varianceClamp_, horizontalVarianceClamp_;
+};
+
 } /* namespace */
@@ -10,9 +10,14 @@
 
 // Elevation Mapping
 #include "elevation_mapping/ElevationMap.hpp"
+#include "elevation_mapping/BoundedQueue.hpp"
+#include "elevation_mapping/PerformanceStatistics.hpp"
 #include "elevation_mapping/RobotMotionMapUpdater.hpp"
+#include "elevation_mapping/RobotPoseHistory.hpp"
+#include "elevation_mapping/PointCloudBuffer.hpp"
 #include "elevation_mapping/sensor_processors/SensorProcessorBase.hpp"
 #include "elevation_mapping/WeightedEmpiricalCumulativeDistributionFunction.hpp"
+#include "elevation_mapping/QueryMap.h"
 
 // Grid Map
 #include <grid_map_msgs/GetGridMap.h>
@@ -29,15 +34,21 @@
 // ROS
 #include <ros/ros.h>
 #include <sensor_msgs/PointCloud2.h>
-#include <message_filters/cache.h>
-#include <message_filters/subscriber.h>
 #include <tf/transform_listener.h>
+#include <tf2_msgs/TFMessage.h>
 #include <geometry_msgs/PoseWithCovarianceStamped.h>
 #include <std_srvs/Empty.h>
+#include <std_srvs/Trigger.h>
 
 // Boost
 #include <boost/thread.hpp>
 
+// STL
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
 
 namespace elevation_mapping {
 
@@ -49,11 +60,29 @@ class ElevationMapping
 {
  public:
 
+  //! Processed point cloud in the processing pipeline, ready to be added to the map.
+  struct ProcessedPointCloud
+  {
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud;
+    Eigen::VectorXf variances;
+    ros::Time timeStamp;
+    size_t sensorInputIndex;
+    //! Not aligned, such that the processed point clouds can be stored in standard containers.
+    Eigen::Transform<double, 3, Eigen::Affine, Eigen::DontAlign> transformationSensorToMap;
+    Eigen::Transform<double, 3, Eigen::Affine, Eigen::DontAlign> transformationBaseToMap;
+    std::string robotBaseFrameId;
+    ros::WallTime receiveTime;
+    ros::WallTime processingStartTime;
+    ros::WallTime processingEndTime;
+  };
+
   /*!
    * Constructor.
    * @param nodeHandle the ROS node handle.
+   * @param isOffline if true, no subscribers, services and timers are set up and the map is
+   * driven directly through the offline interface (see BagReplay).
    */
-  ElevationMapping(ros::NodeHandle& nodeHandle);
+  ElevationMapping(ros::NodeHandle& nodeHandle, const bool isOffline = false);
 
   /*!
    * Destructor.
@@ -63,8 +92,9 @@ class ElevationMapping
   /*!
    * Callback function for new data to be added to the elevation map.
    * @param pointCloud the point cloud to be fused with the existing data.
+   * @param sensorInputIndex the index of the sensor input of the point cloud.
    */
-  void pointCloudCallback(const sensor_msgs::PointCloud2& pointCloud);
+  void pointCloudCallback(const sensor_msgs::PointCloud2ConstPtr& pointCloud, const size_t sensorInputIndex);
 
   /*!
    * Callback function for the update timer. Forces an update of the map from
@@ -74,6 +104,19 @@ class ElevationMapping
    */
   void mapUpdateTimerCallback(const ros::TimerEvent& timerEvent);
 
+  /*!
+   * Callback function for the robot pose, adds the pose to the pose history.
+   * @param pose the robot pose with covariance.
+   */
+  void robotPoseCallback(const geometry_msgs::PoseWithCovarianceStampedConstPtr& pose);
+
+  /*!
+   * Callback function for the static transformations (/tf_static), passes them to the sensor
+   * processors of all inputs (see SensorProcessorBase::addStaticTransformations(...)).
+   * @param message the static transformations.
+   */
+  void staticTransformCallback(const tf2_msgs::TFMessageConstPtr& message);
+
   /*!
    * Callback function for the fused map publish timer. Publishes the fused map
    * based on configurable duration.
@@ -88,6 +131,13 @@ class ElevationMapping
    */
   void visibilityCleanupCallback(const ros::TimerEvent& timerEvent);
 
+  /*!
+   * Callback function for the statistics publish timer. Publishes the performance statistics
+   * as diagnostics.
+   * @param timerEvent the timer event.
+   */
+  void publishStatisticsCallback(const ros::TimerEvent& timerEvent);
+
   /*!
    * ROS service callback function to trigger the fusion of the entire
    * elevation map.
@@ -97,6 +147,14 @@ class ElevationMapping
    */
   bool fuseEntireMap(std_srvs::Empty::Request& request, std_srvs::Empty::Response& response);
 
+  /*!
+   * ROS service callback function to get the performance statistics as text.
+   * @param request the ROS service request.
+   * @param response the ROS service response containing the statistics.
+   * @return true if successful.
+   */
+  bool getStatistics(std_srvs::Trigger::Request& request, std_srvs::Trigger::Response& response);
+
   /*!
    * ROS service callback function to return a submap of the elevation map.
    * @param request the ROS service request defining the location and size of the submap.
@@ -105,6 +163,26 @@ class ElevationMapping
    */
   bool getSubmap(grid_map_msgs::GetGridMap::Request& request, grid_map_msgs::GetGridMap::Response& response);
 
+  /*!
+   * ROS service callback function to return a submap of a level of the fused map pyramid.
+   * @param request the ROS service request defining the location and size of the submap.
+   * @param response the ROS service response containing the requested submap.
+   * @param level the level of the fused map pyramid (0 is the fused map).
+   * @return true if successful.
+   */
+  bool getSubmapOfPyramidLevel(grid_map_msgs::GetGridMap::Request& request, grid_map_msgs::GetGridMap::Response& response,
+                               const unsigned int level);
+
+  /*!
+   * ROS service callback function to query the elevation and its bounds at several points
+   * and in several regions of the fused map. The queries are answered from the latest snapshot
+   * of the fused map without locking the map, only stale regions are fused on demand.
+   * @param request the ROS service request defining the points and the regions.
+   * @param response the ROS service response containing the elevations and the submaps.
+   * @return true if successful.
+   */
+  bool queryMap(QueryMap::Request& request, QueryMap::Response& response);
+
   /*!
    * Clears all data of the elevation map.
    * @param request the ROS service request.
@@ -121,20 +199,150 @@ class ElevationMapping
    */
   bool saveMap(grid_map_msgs::ProcessFile::Request& request, grid_map_msgs::ProcessFile::Response& response);
 
+  /*!
+   * Saves the raw grid map to a binary map file (see MapFile). The file is written in the
+   * background from a snapshot of the raw map, the service returns once the snapshot is taken.
+   * @param request the ROS service request.
+   * @param response the ROS service response.
+   * @return true if successful, false if a map file is still being saved.
+   */
+  bool saveBinaryMap(grid_map_msgs::ProcessFile::Request& request, grid_map_msgs::ProcessFile::Response& response);
+
+  /*!
+   * Loads the raw grid map from a binary map file, replacing the current map.
+   * @param request the ROS service request.
+   * @param response the ROS service response.
+   * @return true if successful.
+   */
+  bool loadMap(grid_map_msgs::ProcessFile::Request& request, grid_map_msgs::ProcessFile::Response& response);
+
+  // Offline interface, driving the map without subscribers and timers (see BagReplay).
+
+  /*!
+   * Adds transformations to the TF buffer, which does not subscribe to TF in the offline mode.
+   * The static transformations are also passed to the sensor processors.
+   * @param message the transformations.
+   * @param isStatic if the transformations are static (/tf_static).
+   */
+  void addTransformations(const tf2_msgs::TFMessage& message, const bool isStatic);
+
+  /*!
+   * Gets the point cloud topics of the sensor inputs.
+   * @return the topics, in the order of the sensor input indices.
+   */
+  std::vector<std::string> getPointCloudTopics() const;
+
+  /*!
+   * Gets the robot pose topic.
+   * @return the topic (empty if the robot motion updates are ignored).
+   */
+  const std::string& getRobotPoseTopic() const;
+
+  /*!
+   * Checks if the point clouds are processed and integrated in separate threads.
+   * @return true if the processing is pipelined.
+   */
+  bool isPipelinedProcessingEnabled() const;
+
+  /*!
+   * Gets the duration without point clouds after which the map is updated from the robot motion.
+   * @return the duration (zero if the robot motion updates are ignored).
+   */
+  ros::Duration getMotionUpdateDuration() const;
+
+  /*!
+   * Gets the duration between two visibility cleanups.
+   * @return the duration (zero if the visibility cleanup is disabled).
+   */
+  ros::Duration getVisibilityCleanupDuration() const;
+
+  /*!
+   * Processing stage of a point cloud that is not received by the subscribers: Converts the point
+   * cloud message and processes it with the sensor processor. Does not access the map.
+   * @param[in] sensorInputIndex the index of the sensor input.
+   * @param[in] pointCloud the point cloud message.
+   * @param[out] processedPointCloud the processed point cloud in the map frame.
+   * @return true if successful.
+   */
+  bool processPointCloud(const size_t sensorInputIndex, const sensor_msgs::PointCloud2ConstPtr& pointCloud,
+                         ProcessedPointCloud& processedPointCloud);
+
+  /*!
+   * Integration stage of the point clouds: Updates the map location and the motion prediction,
+   * adds the processed point cloud to the map and publishes the raw map. Holds the integration
+   * lock until the point cloud has been added, the map only locks its raw data for each update.
+   * @param processedPointCloud the processed point cloud.
+   * @return true if successful.
+   */
+  bool integratePointCloud(const ProcessedPointCloud& processedPointCloud);
+
+  /*!
+   * Updates the map from the robot motion up to a time, without a point cloud.
+   * @param time the time to which the map is updated.
+   * @return true if successful.
+   */
+  bool updateMotionPrediction(const ros::Time& time);
+
+  /*!
+   * Saves the raw grid map to a binary map file (see MapFile), waiting until the file is written.
+   * @param path the path of the map file.
+   * @return true if successful.
+   */
+  bool saveBinaryMapFile(const std::string& path);
+
  private:
 
+  //! Point cloud message in the processing pipeline.
+  struct ReceivedPointCloud
+  {
+    sensor_msgs::PointCloud2ConstPtr message;
+    ros::WallTime receiveTime;
+  };
+
+  //! Point cloud input of a sensor with its own sensor processor and processing thread.
+  struct SensorInput
+  {
+    //! Name of the input (empty for the single input configured in the node namespace).
+    std::string name;
+    std::string pointCloudTopic;
+    ros::Subscriber pointCloudSubscriber;
+    SensorProcessorBase::Ptr sensorProcessor;
+    //! Point buffer for the direct ingestion of the point cloud messages.
+    PointCloudBuffer pointCloudBuffer;
+    //! Queue between the subscriber and the processing stage.
+    BoundedQueue<ReceivedPointCloud> receivedPointCloudQueue;
+    boost::thread processingThread;
+    //! Time stamp of the last integrated point cloud of the input (guarded by the integration mutex).
+    ros::Time lastPointCloudUpdateTime;
+  };
+
   /*!
    * Reads and verifies the ROS parameters.
    * @return true if successful.
    */
   bool readParameters();
 
+  /*!
+   * Reads the parameters of a sensor input and adds it.
+   * @param name the name of the input.
+   * @param nodeHandle the node handle in the namespace of the input parameters.
+   * @return true if successful.
+   */
+  bool addSensorInput(const std::string& name, ros::NodeHandle& nodeHandle);
+
   /*!
    * Performs the initialization procedure.
    * @return true if successful.
    */
   bool initialize();
 
+  /*!
+   * Loads the raw grid map from a binary map file.
+   * @param path the path of the map file.
+   * @return true if successful.
+   */
+  bool loadMapFromFile(const std::string& path);
+
   /*!
    * Separate thread for all fusion service calls.
    */
@@ -145,6 +353,45 @@ class ElevationMapping
    */
   void visibilityCleanupThread();
 
+  /*!
+   * Processing stage of the point clouds: Converts the point cloud message and processes it
+   * with the sensor processor (including the wait for the transformations). Does not access the map.
+   * @param[in] sensorInputIndex the index of the sensor input.
+   * @param[in] receivedPointCloud the received point cloud message.
+   * @param[out] processedPointCloud the processed point cloud in the map frame.
+   * @return true if successful.
+   */
+  bool processPointCloud(const size_t sensorInputIndex, const ReceivedPointCloud& receivedPointCloud,
+                         ProcessedPointCloud& processedPointCloud);
+
+  /*!
+   * Separate thread for the processing stage of the point clouds of a sensor input.
+   * @param sensorInputIndex the index of the sensor input.
+   */
+  void runPointCloudProcessingThread(const size_t sensorInputIndex);
+
+  /*!
+   * Separate thread for the integration stage of the point clouds.
+   */
+  void runPointCloudIntegrationThread();
+
+  /*!
+   * Merges a processed point cloud into a queued one of the same sensor input and sensor pose (for
+   * the coalescing queue policy). The merged point cloud has the time stamp of the newer point cloud.
+   * @param queuedPointCloud the queued point cloud.
+   * @param newPointCloud the newer point cloud.
+   * @return true if merged, false if the point clouds are from different sensor inputs or sensor poses.
+   */
+  static bool coalescePointClouds(ProcessedPointCloud& queuedPointCloud, ProcessedPointCloud&& newPointCloud);
+
+  /*!
+   * Gets the robot pose at a time from the pose history.
+   * @param[in] time the requested time.
+   * @param[out] pose the robot pose with covariance.
+   * @return true if successful.
+   */
+  bool getRobotPose(const ros::Time& time, RobotPoseHistory::Entry& pose) const;
+
   /*!
    * Update the elevation map from the robot motion up to a certain time.
    * @param time to which the map is updated to.
@@ -161,9 +408,20 @@ class ElevationMapping
   /*!
    * Updates the location of the map to follow the tracking point. Takes care
    * of the data handling the goes along with the relocalization.
+   * @param time the time of the tracking point to look up, the latest if zero.
    * @return true if successful.
    */
-  bool updateMapLocation();
+  bool updateMapLocation(const ros::Time& time);
+
+  /*!
+   * Updates the location of the map to follow the tracking point at the time of a processed
+   * point cloud. Uses the transformation of the point cloud if the tracking point is in the
+   * robot base frame, otherwise the tracking point is transformed with TF (offline at the time
+   * of the point cloud, such that the replay does not depend on the received transformations).
+   * @param processedPointCloud the processed point cloud.
+   * @return true if successful.
+   */
+  bool updateMapLocation(const ProcessedPointCloud& processedPointCloud);
 
   /*!
    * Reset and start the map update timer.
@@ -179,14 +437,19 @@ class ElevationMapping
   ros::NodeHandle& nodeHandle_;
 
   //! ROS subscribers.
-  ros::Subscriber pointCloudSubscriber_;
-  message_filters::Subscriber<geometry_msgs::PoseWithCovarianceStamped> robotPoseSubscriber_;
+  ros::Subscriber robotPoseSubscriber_;
+  ros::Subscriber staticTransformSubscriber_;
 
   //! ROS service servers.
   ros::ServiceServer fusionTriggerService_;
   ros::ServiceServer submapService_;
+  std::vector<ros::ServiceServer> pyramidSubmapServices_;
   ros::ServiceServer clearMapService_;
   ros::ServiceServer saveMapService_;
+  ros::ServiceServer saveBinaryMapService_;
+  ros::ServiceServer loadMapService_;
+  ros::ServiceServer statisticsService_;
+  ros::ServiceServer queryMapService_;
 
   //! Callback thread for the fusion services.
   boost::thread fusionServiceThread_;
@@ -194,28 +457,69 @@ class ElevationMapping
   //! Callback queue for fusion service thread.
   ros::CallbackQueue fusionServiceQueue_;
 
-  //! Cache for the robot pose messages.
-  message_filters::Cache<geometry_msgs::PoseWithCovarianceStamped> robotPoseCache_;
+  //! Callback queue and threads for the map queries.
+  ros::CallbackQueue queryServiceQueue_;
+  std::unique_ptr<ros::AsyncSpinner> queryServiceSpinner_;
+
+  //! Number of threads for the map queries.
+  int queryServiceThreads_;
+
+  //! Max. age of the snapshot of the fused map for the map queries [s].
+  double fusedMapSnapshotMaxAge_;
 
-  //! Size of the cache for the robot pose messages.
+  //! Thread writing the binary map file, and if a map file is being saved.
+  boost::thread mapSavingThread_;
+  std::atomic<bool> isSavingMap_;
+
+  //! Binary map file loaded at startup (none if empty).
+  std::string initialMapFile_;
+
+  //! If the binary map files are compressed.
+  bool isMapFileCompressed_;
+
+  //! History of the robot poses, read without blocking the pose subscriber.
+  RobotPoseHistory robotPoseHistory_;
+
+  //! Size of the history for the robot pose messages.
   int robotPoseCacheSize_;
 
-  //! TF listener and broadcaster.
-  tf::TransformListener transformListener_;
+  //! If true, the robot pose is interpolated between the poses before and after the requested time.
+  bool enableRobotPoseInterpolation_;
+
+  //! If the map is built offline (see ElevationMapping(...)).
+  const bool isOffline_;
+
+  //! TF transformer, a listener of the TF topics or (offline) a buffer filled by addTransformations(...).
+  std::unique_ptr<tf::Transformer> transformer_;
 
   //! Point which the elevation map follows.
   kindr::Position3D trackPoint_;
   std::string trackPointFrameId_;
 
   //! ROS topics for subscriptions.
-  std::string pointCloudTopic_;
   std::string robotPoseTopic_;
 
   //! Elevation map.
   ElevationMap map_;
 
-  //! Sensor processors.
-  SensorProcessorBase::Ptr sensorProcessor_;
+  //! Point cloud inputs of the sensors.
+  std::vector<std::unique_ptr<SensorInput>> sensorInputs_;
+
+  //! If true, the points are read directly from the point cloud message into the point buffer.
+  bool enableDirectPointCloudIngestion_;
+
+  //! If true, the point clouds are processed and integrated in separate threads.
+  bool enablePipelinedProcessing_;
+
+  //! Capacity and drop policy of the queues of the pipelined processing.
+  size_t pointCloudQueueSize_;
+  QueueDropPolicy pointCloudQueuePolicy_;
+
+  //! Bounded queue between the processing stage of all sensor inputs and the integration stage.
+  BoundedQueue<ProcessedPointCloud> processedPointCloudQueue_;
+
+  //! Thread for the integration stage.
+  boost::thread pointCloudIntegrationThread_;
 
   //! Robot motion elevation map updater.
   RobotMotionMapUpdater robotMotionMapUpdater_;
@@ -226,6 +530,10 @@ class ElevationMapping
   //! Time of the last point cloud update.
   ros::Time lastPointCloudUpdateTime_;
 
+  //! Mutex lock for the integration of point clouds and the motion updates of the map (map
+  //! location, motion prediction and add in sequence), and the time of the last point cloud update.
+  boost::mutex integrationMutex_;
+
   //! Timer for the robot motion update.
   ros::Timer mapUpdateTimer_;
 
@@ -256,6 +564,16 @@ class ElevationMapping
 
   //! Callback thread for raytracing cleanup.
   boost::thread visibilityCleanupThread_;
+
+  //! Latency histograms and counters of the processing stages.
+  PerformanceStatistics statistics_;
+
+  //! Publisher and timer for the performance statistics.
+  ros::Publisher statisticsPublisher_;
+  ros::Timer statisticsPublishTimer_;
+
+  //! Duration for publishing the performance statistics.
+  ros::Duration statisticsPublishTimerDuration_;
 };
 
 } /* namespace */
@@ -0,0 +1,164 @@
+/*
+ * FlatWeightedEmpiricalCumulativeDistributionFunction.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace elevation_mapping {
+
+/*!
+ * Weighted empirical cumulative distribution function with the same interface and
+ * results as WeightedEmpiricalCumulativeDistributionFunction, but the data is stored
+ * in contiguous buffers which are kept when clearing. Meant to be reused for many
+ * small distributions (e.g. one per fused cell).
+ */
+template <typename Type>
+class FlatWeightedEmpiricalCumulativeDistributionFunction
+{
+ public:
+  FlatWeightedEmpiricalCumulativeDistributionFunction()
+      : totalWeight_(0.0),
+        isComputed_(false)
+  {
+  }
+
+  virtual ~FlatWeightedEmpiricalCumulativeDistributionFunction()
+  {
+  }
+
+  void add(const Type value, const double weight = 1.0)
+  {
+    isComputed_ = false;
+    data_.emplace_back(value, weight);
+    totalWeight_ += weight;
+  }
+
+  /*!
+   * Removes all data points. The allocated memory is kept.
+   */
+  void clear()
+  {
+    isComputed_ = false;
+    totalWeight_ = 0.0;
+    data_.clear();
+    inverseDistribution_.clear();
+  }
+
+  /*!
+   * Reserves memory for a number of data points.
+   * @param size the number of data points.
+   */
+  void reserve(const size_t size)
+  {
+    data_.reserve(size);
+    inverseDistribution_.reserve(size);
+  }
+
+  bool compute()
+  {
+    if (data_.size() < 1) return false;
+    inverseDistribution_.clear();
+
+    // Sort by value and merge equal values (weights are summed up in the order they were added).
+    std::stable_sort(data_.begin(), data_.end(), [](const DataPoint& a, const DataPoint& b) {
+      return a.first < b.first;
+    });
+    size_t size = 0;
+    for (size_t i = 0; i < data_.size(); ++i) {
+      if (size > 0 && data_[size - 1].first == data_[i].first) {
+        data_[size - 1].second += data_[i].second;
+      } else {
+        data_[size++] = data_[i];
+      }
+    }
+    data_.resize(size);
+
+    if (data_.size() == 1) {
+      // Special treatment for size 1.
+      inverseDistribution_.emplace_back(0.0, data_.front().first);
+      inverseDistribution_.emplace_back(1.0, data_.front().first);
+      return isComputed_ = true;
+    }
+
+    double cumulativeWeight = -data_.front().second; // Smallest observation corresponds to a probability of 0.
+    const double adaptedTotalWeight = totalWeight_ - data_.front().second;
+    for (const auto& point : data_) {
+      cumulativeWeight += point.second;
+      const double probability = cumulativeWeight / adaptedTotalWeight;
+      // Keep the first value for equal probabilities.
+      if (!inverseDistribution_.empty() && inverseDistribution_.back().first == probability) continue;
+      inverseDistribution_.emplace_back(probability, point.first);
+    }
+
+    return isComputed_ = true;
+  }
+
+  /*!
+   * Returns the quantile corresponding to the given probability (inverse distribution function).
+   * The smallest observation corresponds to a probability of 0 and the largest to a probability of 1.
+   * Uses linear interpolation, see https://stat.ethz.ch/R-manual/R-devel/library/stats/html/quantile.html
+   * and "Sampling Quantiles in Statistical Packages", Hyndman et. al., 1996.
+   * @param probability the order of the quantile.
+   * @return the quantile for the given probability.
+   */
+  const Type quantile(const double probability) const
+  {
+    if (!isComputed_) throw std::runtime_error(
+          "FlatWeightedEmpiricalCumulativeDistributionFunction::quantile(...): The distribution functions needs to be computed (compute()) first.");
+    if (probability <= 0.0) return inverseDistribution_.front().second;
+    if (probability >= 1.0) return inverseDistribution_.back().second;
+    // First element that is not less than the probability.
+    const auto up = std::lower_bound(inverseDistribution_.begin(), inverseDistribution_.end(), probability,
+                                     [](const InverseDistributionPoint& point, const double value) {
+      return point.first < value;
+    });
+    const auto low = up - 1;
+    return low->second + (probability - low->first) * (up->second - low->second) / (up->first - low->first);
+  }
+
+  friend std::ostream& operator <<(std::ostream& out,
+                                   const FlatWeightedEmpiricalCumulativeDistributionFunction& wecdf)
+  {
+    unsigned int i = 0;
+    out << "Data points:" << std::endl;
+    for (const auto& point : wecdf.data_) {
+      out << "[" << i << "] Value: " << point.first << " Weight: " << point.second << std::endl;
+      ++i;
+    }
+
+    i = 0;
+    out << "Inverse distribution function:" << std::endl;
+    for (const auto& point : wecdf.inverseDistribution_) {
+      out << "[" << i << "] Prob.: " << point.first << " Value: " << point.second << std::endl;
+      ++i;
+    }
+
+    return out;
+  }
+
+ private:
+  typedef std::pair<Type, double> DataPoint;
+  typedef std::pair<double, Type> InverseDistributionPoint;
+
+  //! Data points stored as value/weight pair (sorted and merged after computation).
+  std::vector<DataPoint> data_;
+
+  //! Inverse distribution function stored as cumulative probability/value pair.
+  std::vector<InverseDistributionPoint> inverseDistribution_;
+
+  //! Total weight.
+  double totalWeight_;
+
+  //! True of computed.
+  bool isComputed_;
+};
+
+} /* namespace elevation_mapping */
@@ -0,0 +1,204 @@
+/*
+ * FusionWeights.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// Elevation Mapping
+#include "elevation_mapping/HostDevice.hpp"
+
+// Eigen
+#include <Eigen/Core>
+
+// STL
+#include <algorithm>
+#include <cmath>
+
+namespace elevation_mapping {
+
+/*!
+ * Computes the eigenvalues and the orientation of the principal axis of a symmetric
+ * 2x2 covariance matrix [varianceX, varianceXY; varianceXY, varianceY] in closed form.
+ * As with Eigen::EigenSolver, the absolute values of the eigenvalues are used.
+ * @param[in] varianceX the variance in x-direction.
+ * @param[in] varianceY the variance in y-direction.
+ * @param[in] varianceXY the covariance.
+ * @param[out] maxEigenvalue the larger (absolute) eigenvalue.
+ * @param[out] minEigenvalue the smaller (absolute) eigenvalue.
+ * @param[out] rotation the angle of the eigenvector of the larger eigenvalue w.r.t. the x-axis [rad].
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline void computeCovarianceEllipse(const double varianceX, const double varianceY,
+                                                                   const double varianceXY, double& maxEigenvalue,
+                                                                   double& minEigenvalue, double& rotation)
+{
+  const double mean = 0.5 * (varianceX + varianceY);
+  const double radius = std::sqrt(0.25 * (varianceX - varianceY) * (varianceX - varianceY) + varianceXY * varianceXY);
+  rotation = 0.5 * std::atan2(2.0 * varianceXY, varianceX - varianceY);
+  maxEigenvalue = std::fabs(mean + radius);
+  minEigenvalue = std::fabs(mean - radius);
+  if (minEigenvalue > maxEigenvalue) {
+    // Only for indefinite matrices.
+    const double eigenvalue = maxEigenvalue;
+    maxEigenvalue = minEigenvalue;
+    minEigenvalue = eigenvalue;
+    rotation += M_PI_2;
+  }
+}
+
+/*!
+ * Gets a coordinate of the center of a cell with the computation of grid_map::getPositionFromIndex(...).
+ * @param mapPosition the coordinate of the map position.
+ * @param mapLength the length of the map along the coordinate.
+ * @param resolution the resolution of the map.
+ * @param unwrappedIndex the index of the cell along the coordinate, relative to the start index.
+ * @return the coordinate of the cell center.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline double getCellCenterPosition(const double mapPosition, const double mapLength,
+                                                                  const double resolution, const int unwrappedIndex)
+{
+  return mapPosition + (0.5 * mapLength - 0.5 * resolution) + resolution * static_cast<double>(-unwrappedIndex);
+}
+
+/*!
+ * Error ellipse of the fusion of a cell, selecting the cells as grid_map::EllipseIterator does:
+ * A cell is in the ellipse if its center is. For iterating through the bounding box of the ellipse
+ * instead of the iterator, e.g. in device code, with the same cells as the iterator.
+ */
+struct FusionEllipse
+{
+  /*!
+   * Constructor.
+   * @param lengthX the length of the major axis.
+   * @param lengthY the length of the minor axis.
+   * @param rotation the angle of the major axis w.r.t. the x-axis of the map [rad].
+   */
+  ELEVATION_MAPPING_HOST_DEVICE FusionEllipse(const double lengthX, const double lengthY, const double rotation)
+      : semiAxisX(0.5 * lengthX),
+        semiAxisY(0.5 * lengthY),
+        cosRotation(std::cos(rotation)),
+        sinRotation(std::sin(rotation))
+  {
+  }
+
+  /*!
+   * Gets the half side lengths of the bounding box of the ellipse (aligned with the map).
+   * @param[out] halfLengthX the half length along the x-axis of the map.
+   * @param[out] halfLengthY the half length along the y-axis of the map.
+   */
+  ELEVATION_MAPPING_HOST_DEVICE void getBoundingBox(double& halfLengthX, double& halfLengthY) const
+  {
+    halfLengthX = std::sqrt(semiAxisX * semiAxisX * cosRotation * cosRotation + semiAxisY * semiAxisY * sinRotation * sinRotation);
+    halfLengthY = std::sqrt(semiAxisX * semiAxisX * sinRotation * sinRotation + semiAxisY * semiAxisY * cosRotation * cosRotation);
+  }
+
+  /*!
+   * Checks if a position is inside of the ellipse, with the operations of grid_map::EllipseIterator.
+   * @param offsetX, offsetY the position relative to the center of the ellipse (in the map frame).
+   * @return true if inside.
+   */
+  ELEVATION_MAPPING_HOST_DEVICE bool isInside(const double offsetX, const double offsetY) const
+  {
+#ifdef __CUDA_ARCH__
+    // Not contracted to fused multiply-adds, such that the device rounds as the host.
+    const double x = __dadd_rn(__dmul_rn(cosRotation, offsetX), __dmul_rn(sinRotation, offsetY));
+    const double y = __dsub_rn(__dmul_rn(sinRotation, offsetX), __dmul_rn(cosRotation, offsetY));
+    return __dadd_rn(__ddiv_rn(__dmul_rn(x, x), __dmul_rn(semiAxisX, semiAxisX)),
+                     __ddiv_rn(__dmul_rn(y, y), __dmul_rn(semiAxisY, semiAxisY))) <= 1.0;
+#else
+    const double x = cosRotation * offsetX + sinRotation * offsetY;
+    const double y = sinRotation * offsetX - cosRotation * offsetY;
+    return x * x / (semiAxisX * semiAxisX) + y * y / (semiAxisY * semiAxisY) <= 1.0;
+#endif
+  }
+
+  double semiAxisX;
+  double semiAxisY;
+  double cosRotation;
+  double sinRotation;
+};
+
+/*!
+ * Approximation of the error function for a single argument (see approximateErrorFunction(...)
+ * for arrays), with the same operations as the array version.
+ * @param x the argument.
+ * @return the approximated error function value.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline float approximateErrorFunction(const float x)
+{
+  const float p = 0.3275911;
+  const float a1 = 0.254829592, a2 = -0.284496736, a3 = 1.421413741, a4 = -1.453152027, a5 = 1.061405429;
+  float y = 1.0f / (1.0f + p * std::fabs(x)); // Is t in the formula.
+  y = 1.0f - (((((a5 * y + a4) * y) + a3) * y + a2) * y + a1) * y * std::exp(-(x * x));
+  return x < 0.0f ? -y : y;
+}
+
+/*!
+ * Approximation of the error function, see formula 7.1.26 in "Handbook of Mathematical
+ * Functions", Abramowitz and Stegun, 1964. The absolute error is below 1.5e-7 (plus the
+ * rounding errors of single precision). Written with Eigen arrays to be vectorized.
+ * @param[in] x the arguments.
+ * @param[out] y the approximated error function values (same size as x).
+ */
+template<typename Derived>
+void approximateErrorFunction(const Eigen::ArrayBase<Derived>& x, Eigen::Ref<Eigen::ArrayXf> y)
+{
+  const float p = 0.3275911;
+  const float a1 = 0.254829592, a2 = -0.284496736, a3 = 1.421413741, a4 = -1.453152027, a5 = 1.061405429;
+  y = 1.0f / (1.0f + p * x.abs()); // Is t in the formula.
+  y = 1.0f - (((((a5 * y + a4) * y) + a3) * y + a2) * y + a1) * y * (-x.square()).exp();
+  y = (x < 0.0f).select(-y, y);
+}
+
+/*!
+ * Computes the fusion weights of cells as the probability mass of a bivariate normal
+ * distribution (in its principal axes) covered by the cell.
+ * @param[in] distancesX the absolute distances of the cells to the center along the major axis.
+ * @param[in] distancesY the absolute distances of the cells to the center along the minor axis.
+ * @param[in] maxStandardDeviation the standard deviation along the major axis.
+ * @param[in] minStandardDeviation the standard deviation along the minor axis.
+ * @param[in] halfResolution half of the side length of a cell.
+ * @param[in] minimalWeight the weights are at least this large.
+ * @param[out] weights the weights of the cells (same size as the distances).
+ * @param[out] bufferA, bufferB scratch memory (same size as the distances).
+ */
+inline void computeFusionWeights(const Eigen::Ref<const Eigen::ArrayXf>& distancesX,
+                                 const Eigen::Ref<const Eigen::ArrayXf>& distancesY,
+                                 const float maxStandardDeviation, const float minStandardDeviation,
+                                 const float halfResolution, const float minimalWeight,
+                                 Eigen::Ref<Eigen::ArrayXf> weights, Eigen::Ref<Eigen::ArrayXf> bufferA,
+                                 Eigen::Ref<Eigen::ArrayXf> bufferB)
+{
+  // P(a < X < b) = 0.5 * (erf(b / (sigma * sqrt(2))) - erf(a / (sigma * sqrt(2)))).
+  const float scaleX = 1.0 / (maxStandardDeviation * M_SQRT2);
+  const float scaleY = 1.0 / (minStandardDeviation * M_SQRT2);
+  approximateErrorFunction((distancesX + halfResolution) * scaleX, bufferA);
+  approximateErrorFunction((distancesX - halfResolution) * scaleX, bufferB);
+  weights = 0.5f * (bufferA - bufferB);
+  approximateErrorFunction((distancesY + halfResolution) * scaleY, bufferA);
+  approximateErrorFunction((distancesY - halfResolution) * scaleY, bufferB);
+  weights *= 0.5f * (bufferA - bufferB);
+  // Written such that undefined probabilities (NaN) get the minimal weight.
+  weights = (weights > minimalWeight).select(weights, minimalWeight);
+}
+
+/*!
+ * Computes the fusion weight of a single cell (see computeFusionWeights(...) for the parameters).
+ * @return the weight of the cell.
+ */
+ELEVATION_MAPPING_HOST_DEVICE inline float computeFusionWeight(const float distanceX, const float distanceY,
+                                                               const float maxStandardDeviation,
+                                                               const float minStandardDeviation,
+                                                               const float halfResolution, const float minimalWeight)
+{
+  const float scaleX = 1.0 / (maxStandardDeviation * M_SQRT2);
+  const float scaleY = 1.0 / (minStandardDeviation * M_SQRT2);
+  float weight = 0.5f * (approximateErrorFunction((distanceX + halfResolution) * scaleX)
+      - approximateErrorFunction((distanceX - halfResolution) * scaleX));
+  weight *= 0.5f * (approximateErrorFunction((distanceY + halfResolution) * scaleY)
+      - approximateErrorFunction((distanceY - halfResolution) * scaleY));
+  return weight > minimalWeight ? weight : minimalWeight;
+}
+
+} /* namespace elevation_mapping */
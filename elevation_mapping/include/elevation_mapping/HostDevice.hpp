@@ -0,0 +1,18 @@
+/*
+ * HostDevice.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+/*!
+ * Marks the cell update functions as callable from CUDA device code, such that a device
+ * implementation computes the same cell updates as the CPU. Expands to nothing if not
+ * compiled by the CUDA compiler.
+ */
+#ifdef __CUDACC__
+#define ELEVATION_MAPPING_HOST_DEVICE __host__ __device__
+#else
+#define ELEVATION_MAPPING_HOST_DEVICE
+#endif
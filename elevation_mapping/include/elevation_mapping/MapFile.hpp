@@ -0,0 +1,55 @@
+/*
+ * MapFile.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// Grid Map
+#include <grid_map_core/GridMap.hpp>
+
+// ROS
+#include <ros/ros.h>
+
+// STL
+#include <string>
+#include <vector>
+
+namespace elevation_mapping {
+
+/*!
+ * Binary file format of elevation maps. The file starts with a header with the geometry of
+ * the map (including the start index of the circular buffer, such that the buffer is stored
+ * as is), followed by one contiguous block per layer. The blocks are either the raw
+ * (column-major) cell data or, if compressed, the runs of NaN cells are only stored by their
+ * length. The file is written to a temporary file first and renamed when complete, and it is
+ * memory-mapped for loading. The byte order is the one of the host.
+ */
+class MapFile
+{
+ public:
+
+  /*!
+   * Saves layers of a grid map to a file.
+   * @param path the path of the file.
+   * @param map the grid map.
+   * @param layers the layers to save (must exist in the map).
+   * @param initialTime the time the 'time' layer of the map is relative to.
+   * @param isCompressed if the runs of NaN cells are compressed.
+   * @return true if successful.
+   */
+  static bool save(const std::string& path, const grid_map::GridMap& map, const std::vector<std::string>& layers,
+                   const ros::Time& initialTime, const bool isCompressed);
+
+  /*!
+   * Loads a grid map from a file.
+   * @param[in] path the path of the file.
+   * @param[out] map the grid map with the saved layers.
+   * @param[out] initialTime the time the 'time' layer of the map is relative to.
+   * @return true if successful, false if the file cannot be read or is not a valid map file.
+   */
+  static bool load(const std::string& path, grid_map::GridMap& map, ros::Time& initialTime);
+};
+
+} /* namespace elevation_mapping */
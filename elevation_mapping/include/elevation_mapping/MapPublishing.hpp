@@ -0,0 +1,77 @@
+/*
+ * MapPublishing.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// Elevation Mapping
+#include "elevation_mapping/TileMask.hpp"
+
+// Grid Map
+#include <grid_map_core/GridMap.hpp>
+
+// STL
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace elevation_mapping {
+
+/*!
+ * Gets the layers to publish and the layers they are computed from.
+ * @param[in] map the map (raw or fused).
+ * @param[in] selectedLayers the selected layers, the default layers if empty.
+ * @param[in] defaultLayers the default layers.
+ * @param[out] sourceLayers the layers of the map which are required (starting with the basic layers).
+ * @return the layers to publish.
+ */
+std::vector<std::string> getPublishedLayers(const grid_map::GridMap& map, const std::vector<std::string>& selectedLayers,
+                                            const std::vector<std::string>& defaultLayers,
+                                            std::vector<std::string>& sourceLayers);
+
+/*!
+ * Gets the layers to publish from the layers that are available for a map (e.g. the layers of
+ * the snapshots of the raw map, which are not all layers of the raw map).
+ * @param[in] availableLayers the available layers.
+ * @param[in] basicLayers the basic layers of the map.
+ * @param[in] selectedLayers the selected layers, the default layers if empty.
+ * @param[in] defaultLayers the default layers.
+ * @param[out] sourceLayers the available layers which are required (starting with the basic layers).
+ * @return the layers to publish.
+ */
+std::vector<std::string> getPublishedLayers(const std::vector<std::string>& availableLayers,
+                                            const std::vector<std::string>& basicLayers,
+                                            const std::vector<std::string>& selectedLayers,
+                                            const std::vector<std::string>& defaultLayers,
+                                            std::vector<std::string>& sourceLayers);
+
+/*!
+ * Checks if a layer is computed for publishing (e.g. 'standard_deviation').
+ * @param layer the layer.
+ * @return true if the layer is a derived layer.
+ */
+bool isDerivedLayer(const std::string& layer);
+
+/*!
+ * Adds the requested derived layers (e.g. 'standard_deviation') to a map.
+ * @param map the map.
+ * @param layers the requested layers, layers that are no derived layers or exist already are ignored.
+ */
+void addDerivedLayers(grid_map::GridMap& map, const std::vector<std::string>& layers);
+
+/*!
+ * Gets submaps that together contain all updated tiles, one per rectangular region of updated
+ * tiles (see TileMask::getMarkedRegions(...)). If the updated tiles are split into too many
+ * regions, the smallest submap that contains all of them is used instead.
+ * @param[in] map the map.
+ * @param[in] updatedTiles the updated tiles.
+ * @param[in] maxNumberOfSubmaps the max. number of submaps.
+ * @param[out] submaps the submaps.
+ * @return false if no tile has been updated.
+ */
+bool getUpdatedSubmaps(const grid_map::GridMap& map, const TileMask& updatedTiles, const size_t maxNumberOfSubmaps,
+                       std::vector<grid_map::GridMap>& submaps);
+
+} /* namespace elevation_mapping */
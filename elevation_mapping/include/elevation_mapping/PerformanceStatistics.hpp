@@ -0,0 +1,253 @@
+/*
+ * PerformanceStatistics.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// STL
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace elevation_mapping {
+
+/*!
+ * Histogram of durations with bins of doubling width (starting at one microsecond). Adding
+ * a duration only updates relaxed atomic counters, such that it can be used from any thread on
+ * the hot path without locks.
+ */
+class LatencyHistogram
+{
+ public:
+  //! Number of bins, the last bin collects all durations above 2^(numberOfBins - 1) microseconds.
+  static const unsigned int numberOfBins = 24;
+
+  //! Summary of the recorded durations (in seconds).
+  struct Summary
+  {
+    uint64_t count;
+    double mean;
+    double max;
+    //! Percentiles, as upper limits of the bins containing them.
+    double percentile50;
+    double percentile90;
+    double percentile99;
+  };
+
+  /*!
+   * Constructor.
+   */
+  LatencyHistogram();
+
+  /*!
+   * Adds a duration.
+   * @param duration the duration in seconds.
+   */
+  void add(const double duration);
+
+  /*!
+   * Gets the summary of the recorded durations.
+   * @return the summary.
+   */
+  Summary getSummary() const;
+
+  /*!
+   * Gets the number of durations in a bin.
+   * @param bin the bin index.
+   * @return the number of durations.
+   */
+  uint64_t getBinCount(const unsigned int bin) const;
+
+  /*!
+   * Resets the histogram.
+   */
+  void reset();
+
+ private:
+  /*!
+   * Gets the upper limit of a bin.
+   * @param bin the bin index.
+   * @return the upper limit in seconds.
+   */
+  static double getBinUpperLimit(const unsigned int bin);
+
+  //! Number of durations per bin.
+  std::array<std::atomic<uint64_t>, numberOfBins> bins_;
+
+  //! Sum and maximum of the durations (in nanoseconds).
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> max_;
+};
+
+/*!
+ * Always-on performance statistics of the elevation mapping: Latency histograms of the
+ * processing stages and counters of points and point clouds.
+ */
+class PerformanceStatistics
+{
+ public:
+
+  //! Timed stages.
+  enum class Stage
+  {
+    Conversion,
+    TransformWait,
+    SensorProcessing,
+    MotionPrediction,
+    Add,
+    Clean,
+    Fusion,
+    VisibilityCleanup,
+    Serialization,
+    RawMapLockWait,
+    FusedMapLockWait,
+    NumberOfStages
+  };
+
+  //! Counted events.
+  enum class Counter
+  {
+    ReceivedPointClouds,
+    DroppedPointClouds,
+    DroppedProcessedPointClouds,
+    SensorProcessingInputPoints,
+    SensorProcessingOutputPoints,
+    AddedPoints,
+    VisibilityCleanupRemovedCells,
+    NumberOfCounters
+  };
+
+  static const size_t numberOfStages = static_cast<size_t>(Stage::NumberOfStages);
+  static const size_t numberOfCounters = static_cast<size_t>(Counter::NumberOfCounters);
+
+  /*!
+   * Constructor.
+   */
+  PerformanceStatistics();
+
+  /*!
+   * Adds the duration of a stage.
+   * @param stage the stage.
+   * @param duration the duration in seconds.
+   */
+  void addDuration(const Stage stage, const double duration);
+
+  /*!
+   * Increments a counter.
+   * @param counter the counter.
+   * @param value the increment.
+   */
+  void increment(const Counter counter, const uint64_t value = 1);
+
+  /*!
+   * Gets the histogram of a stage.
+   * @param stage the stage.
+   * @return the histogram.
+   */
+  const LatencyHistogram& getHistogram(const Stage stage) const;
+
+  /*!
+   * Gets the value of a counter.
+   * @param counter the counter.
+   * @return the value.
+   */
+  uint64_t getCounter(const Counter counter) const;
+
+  /*!
+   * Resets all histograms and counters.
+   */
+  void reset();
+
+  /*!
+   * Gets the name of a stage.
+   * @param stage the stage.
+   * @return the name (lower case with underscores).
+   */
+  static const char* getName(const Stage stage);
+
+  /*!
+   * Gets the name of a counter.
+   * @param counter the counter.
+   * @return the name (lower case with underscores).
+   */
+  static const char* getName(const Counter counter);
+
+  /*!
+   * Formats the statistics as text, one line per stage and counter.
+   * @return the text.
+   */
+  std::string toString() const;
+
+ private:
+  //! Histograms of the stages.
+  std::array<LatencyHistogram, numberOfStages> histograms_;
+
+  //! Counters.
+  std::array<std::atomic<uint64_t>, numberOfCounters> counters_;
+};
+
+/*!
+ * Measures the duration of a scope and adds it to the statistics (if any) of a stage.
+ */
+class ScopedTimer
+{
+ public:
+
+  /*!
+   * Constructor, starts the timer.
+   * @param statistics the statistics, nothing is recorded if null.
+   * @param stage the stage.
+   */
+  ScopedTimer(PerformanceStatistics* statistics, const PerformanceStatistics::Stage stage)
+      : statistics_(statistics),
+        stage_(stage),
+        startTime_(std::chrono::steady_clock::now())
+  {
+  }
+
+  /*!
+   * Destructor, records the duration if the timer has not been stopped.
+   */
+  ~ScopedTimer()
+  {
+    stop();
+  }
+
+  /*!
+   * Stops the timer and records the duration.
+   * @return the duration in seconds (zero if already stopped).
+   */
+  double stop()
+  {
+    if (statistics_ == nullptr) return 0.0;
+    const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime_).count();
+    statistics_->addDuration(stage_, duration);
+    statistics_ = nullptr;
+    return duration;
+  }
+
+  /*!
+   * Locks a (deferred) lock and records the wait time.
+   * @param statistics the statistics, nothing is recorded if null.
+   * @param stage the stage for the wait time.
+   * @param lock the lock.
+   */
+  template<typename Lock>
+  static void lock(PerformanceStatistics* statistics, const PerformanceStatistics::Stage stage, Lock& lock)
+  {
+    ScopedTimer timer(statistics, stage);
+    lock.lock();
+  }
+
+ private:
+  PerformanceStatistics* statistics_;
+  PerformanceStatistics::Stage stage_;
+  std::chrono::steady_clock::time_point startTime_;
+};
+
+} /* namespace elevation_mapping */
@@ -0,0 +1,191 @@
+/*
+ * PointCloudBuffer.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// ROS
+#include <ros/ros.h>
+#include <sensor_msgs/PointCloud2.h>
+
+// PCL
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace elevation_mapping {
+
+/*!
+ * Point cloud with the coordinates and colors stored in separate arrays (structure of arrays).
+ * It is filled directly from the byte buffer of a sensor_msgs/PointCloud2 message through the
+ * field offsets, without the intermediate pcl::PCLPointCloud2 and pcl::PointCloud conversions.
+ * Organized point clouds keep their width and height, invalid points are kept as NaN.
+ * The buffers are reused between messages.
+ */
+class PointCloudBuffer
+{
+ public:
+
+  /*!
+   * Constructor.
+   */
+  PointCloudBuffer();
+
+  /*!
+   * Destructor.
+   */
+  virtual ~PointCloudBuffer();
+
+  /*!
+   * Reads the points from a point cloud message. The message needs the fields x, y and z as
+   * FLOAT32, the color is read from the field rgb or rgba (FLOAT32 or UINT32) if present.
+   * All other fields (e.g. intensity) are skipped.
+   * @param message the point cloud message.
+   * @return true if successful, false if the message layout is not supported.
+   */
+  bool fromMessage(const sensor_msgs::PointCloud2& message);
+
+  /*!
+   * Reads the points from a PCL point cloud.
+   * @param pointCloud the point cloud.
+   */
+  void fromPointCloud(const pcl::PointCloud<pcl::PointXYZRGB>& pointCloud);
+
+  /*!
+   * Sets the points to every stride-th point in the rows and columns of another point cloud.
+   * @param pointCloud the point cloud to subsample.
+   * @param stride the pixel stride (1 copies the point cloud).
+   */
+  void subsample(const PointCloudBuffer& pointCloud, const uint32_t stride);
+
+  /*!
+   * Sets the points to the means of blocks of factor x factor points of another point cloud
+   * (image-space decimation). Invalid points are skipped, blocks without valid points are NaN.
+   * The color of a block is the color of its first valid point.
+   * @param pointCloud the point cloud to decimate.
+   * @param factor the decimation factor (1 copies the point cloud).
+   */
+  void decimate(const PointCloudBuffer& pointCloud, const uint32_t factor);
+
+  /*!
+   * Gets the number of points (width x height).
+   * @return the number of points.
+   */
+  size_t size() const
+  {
+    return x_.size();
+  }
+
+  /*!
+   * Gets the width of the point cloud (the number of points for unorganized point clouds).
+   * @return the width.
+   */
+  uint32_t getWidth() const
+  {
+    return width_;
+  }
+
+  /*!
+   * Gets the height of the point cloud (1 for unorganized point clouds).
+   * @return the height.
+   */
+  uint32_t getHeight() const
+  {
+    return height_;
+  }
+
+  /*!
+   * Checks if the point cloud is organized (image like with a height larger than 1).
+   * @return true if organized.
+   */
+  bool isOrganized() const
+  {
+    return height_ > 1;
+  }
+
+  /*!
+   * Checks if the point cloud has color information.
+   * @return true if the colors are valid.
+   */
+  bool hasColor() const
+  {
+    return hasColor_;
+  }
+
+  //! Coordinates of the points.
+  const std::vector<float>& getX() const { return x_; }
+  const std::vector<float>& getY() const { return y_; }
+  const std::vector<float>& getZ() const { return z_; }
+
+  /*!
+   * Gets the colors of the points (packed as in pcl::PointXYZRGB::rgba). Only valid if hasColor().
+   * @return the colors.
+   */
+  const std::vector<uint32_t>& getRgba() const
+  {
+    return rgba_;
+  }
+
+  /*!
+   * Gets the frame id of the point cloud.
+   * @return the frame id.
+   */
+  const std::string& getFrameId() const
+  {
+    return frameId_;
+  }
+
+  /*!
+   * Gets the time stamp of the point cloud.
+   * @return the time stamp.
+   */
+  const ros::Time& getTimeStamp() const
+  {
+    return timeStamp_;
+  }
+
+  /*!
+   * Sets the time stamp of the point cloud.
+   * @param timeStamp the time stamp.
+   */
+  void setTimeStamp(const ros::Time& timeStamp)
+  {
+    timeStamp_ = timeStamp;
+  }
+
+ private:
+
+  /*!
+   * Resizes the buffers.
+   * @param width the width of the point cloud.
+   * @param height the height of the point cloud.
+   * @param hasColor if the color buffer is needed.
+   */
+  void resize(const uint32_t width, const uint32_t height, const bool hasColor);
+
+  //! Coordinates and colors of the points.
+  std::vector<float> x_;
+  std::vector<float> y_;
+  std::vector<float> z_;
+  std::vector<uint32_t> rgba_;
+
+  //! Size of the point cloud.
+  uint32_t width_;
+  uint32_t height_;
+
+  //! True if the colors are valid.
+  bool hasColor_;
+
+  //! Frame id and time stamp of the point cloud.
+  std::string frameId_;
+  ros::Time timeStamp_;
+};
+
+} /* namespace elevation_mapping */
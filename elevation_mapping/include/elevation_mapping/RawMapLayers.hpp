@@ -0,0 +1,179 @@
+/*
+ * RawMapLayers.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// Elevation Mapping
+#include "elevation_mapping/CompactLayers.hpp"
+#include "elevation_mapping/HostDevice.hpp"
+
+// Grid Map
+#include <grid_map_core/GridMap.hpp>
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace elevation_mapping {
+
+/*!
+ * Direct access to the data of the raw elevation map layers. The layer names are
+ * resolved once and the cells are addressed with a linear (column-major) index
+ * into the underlying buffer. The pointers are only valid as long as the geometry
+ * and the layers of the grid map are unchanged. The horizontal variances and the time
+ * are accessed by the getters and setters, which handle the compact layers (see
+ * CompactLayers.hpp).
+ */
+struct RawMapLayers
+{
+  /*!
+   * Constructor. Resolves the layers of the raw elevation map.
+   * @param rawMap the raw elevation map.
+   * @param compactTimeBase the time base of the compact times [ticks], if the map has the compact layers.
+   */
+  RawMapLayers(grid_map::GridMap& rawMap, const int compactTimeBase)
+      : elevation(rawMap.get("elevation").data()),
+        variance(rawMap.get("variance").data()),
+        horizontalVarianceX(getData(rawMap, "horizontal_variance_x")),
+        horizontalVarianceY(getData(rawMap, "horizontal_variance_y")),
+        horizontalVarianceXY(getData(rawMap, "horizontal_variance_xy")),
+        color(rawMap.get("color").data()),
+        time(getData(rawMap, "time")),
+        lowestScanPoint(rawMap.get("lowest_scan_point").data()),
+        sensorOriginAtLowestScan(rawMap.get("sensor_origin_at_lowest_scan").data()),
+        compactHorizontalVariances(getData(rawMap, "compact_horizontal_variance_x_y")),
+        compactHorizontalVarianceXYAndTime(getData(rawMap, "compact_horizontal_variance_xy_time")),
+        compactTimeBase(compactTimeBase),
+        rows(rawMap.getSize()(0)),
+        cols(rawMap.getSize()(1))
+  {
+  }
+
+  /*!
+   * Gets the linear index of a cell.
+   * @param index the (buffer) index of the cell.
+   * @return the linear index of the cell.
+   */
+  size_t getLinearIndex(const grid_map::Index& index) const
+  {
+    return static_cast<size_t>(index(0)) + static_cast<size_t>(index(1)) * rows;
+  }
+
+  /*!
+   * Gets the number of cells of the map.
+   * @return the number of cells.
+   */
+  ELEVATION_MAPPING_HOST_DEVICE size_t getNumberOfCells() const
+  {
+    return rows * cols;
+  }
+
+  /*!
+   * Gets the horizontal variances of a cell.
+   * @param[in] cell the linear index of the cell.
+   * @param[out] x the horizontal variance in x-direction.
+   * @param[out] y the horizontal variance in y-direction.
+   * @param[out] xy the horizontal covariance.
+   */
+  ELEVATION_MAPPING_HOST_DEVICE void getHorizontalVariances(const size_t cell, float& x, float& y, float& xy) const
+  {
+    if (compactHorizontalVariances == nullptr) {
+      x = horizontalVarianceX[cell];
+      y = horizontalVarianceY[cell];
+      xy = horizontalVarianceXY[cell];
+      return;
+    }
+    uint16_t compactTime;
+    unpackHalfFloats(compactHorizontalVariances[cell], x, y);
+    unpackTimeAndHalfFloat(compactHorizontalVarianceXYAndTime[cell], compactTime, xy);
+  }
+
+  /*!
+   * Sets the horizontal variances of a cell.
+   * @param cell the linear index of the cell.
+   * @param x the horizontal variance in x-direction.
+   * @param y the horizontal variance in y-direction.
+   * @param xy the horizontal covariance.
+   */
+  ELEVATION_MAPPING_HOST_DEVICE void setHorizontalVariances(const size_t cell, const float x, const float y, const float xy) const
+  {
+    if (compactHorizontalVariances == nullptr) {
+      horizontalVarianceX[cell] = x;
+      horizontalVarianceY[cell] = y;
+      horizontalVarianceXY[cell] = xy;
+      return;
+    }
+    uint16_t compactTime;
+    float previousXY;
+    unpackTimeAndHalfFloat(compactHorizontalVarianceXYAndTime[cell], compactTime, previousXY);
+    compactHorizontalVariances[cell] = packHalfFloats(x, y);
+    compactHorizontalVarianceXYAndTime[cell] = packTimeAndHalfFloat(compactTime, xy);
+  }
+
+  /*!
+   * Gets the time of the last update of a cell.
+   * @param cell the linear index of the cell.
+   * @return the time since initialization of the map [s].
+   */
+  ELEVATION_MAPPING_HOST_DEVICE float getTime(const size_t cell) const
+  {
+    if (compactHorizontalVarianceXYAndTime == nullptr) return time[cell];
+    uint16_t compactTime;
+    float xy;
+    unpackTimeAndHalfFloat(compactHorizontalVarianceXYAndTime[cell], compactTime, xy);
+    return decodeCompactTime(compactTime, compactTimeBase);
+  }
+
+  /*!
+   * Sets the time of the last update of a cell.
+   * @param cell the linear index of the cell.
+   * @param value the time since initialization of the map [s].
+   */
+  ELEVATION_MAPPING_HOST_DEVICE void setTime(const size_t cell, const float value) const
+  {
+    if (compactHorizontalVarianceXYAndTime == nullptr) {
+      time[cell] = value;
+      return;
+    }
+    uint16_t compactTime;
+    float xy;
+    unpackTimeAndHalfFloat(compactHorizontalVarianceXYAndTime[cell], compactTime, xy);
+    compactHorizontalVarianceXYAndTime[cell] = packTimeAndHalfFloat(encodeCompactTime(value, compactTimeBase), xy);
+  }
+
+  float* elevation;
+  float* variance;
+  //! Horizontal variances and time, null if the raw map has the compact layers.
+  float* horizontalVarianceX;
+  float* horizontalVarianceY;
+  float* horizontalVarianceXY;
+  float* color;
+  float* time;
+  float* lowestScanPoint;
+  //! Id of the sensor origin of the lowest scan point (see ElevationMap::addSensorOrigin(...)).
+  float* sensorOriginAtLowestScan;
+  //! Compact layers (see CompactLayers.hpp), null if the raw map stores the layers as float.
+  float* compactHorizontalVariances;
+  float* compactHorizontalVarianceXYAndTime;
+  int compactTimeBase;
+  size_t rows;
+  size_t cols;
+
+ private:
+  /*!
+   * Gets the data of a layer.
+   * @param rawMap the raw elevation map.
+   * @param layer the layer.
+   * @return the data of the layer, null if the map does not have the layer.
+   */
+  static float* getData(grid_map::GridMap& rawMap, const std::string& layer)
+  {
+    return rawMap.exists(layer) ? rawMap.get(layer).data() : nullptr;
+  }
+};
+
+} /* namespace elevation_mapping */
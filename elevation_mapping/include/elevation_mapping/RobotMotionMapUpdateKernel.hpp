@@ -0,0 +1,106 @@
+/*
+ * RobotMotionMapUpdateKernel.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// Elevation Mapping
+#include "elevation_mapping/TileMask.hpp"
+
+// Grid Map
+#include <grid_map_core/GridMap.hpp>
+
+// Eigen
+#include <Eigen/Core>
+
+// STL
+#include <cstdint>
+
+namespace elevation_mapping {
+
+/*!
+ * Applies the variance update of the robot motion (see RobotMotionMapUpdater) to the
+ * raw elevation map. Since only the yaw uncertainty of the relative robot pose is
+ * considered, the rotation Jacobian (25) reduces to a lever arm per cell and the update
+ * is computed column by column with array expressions instead of matrix products per
+ * cell. Adding the update and clamping the variances (see ElevationMap::clean()) is done
+ * in the same pass. The buffers are kept between updates.
+ */
+class RobotMotionMapUpdateKernel
+{
+ public:
+
+  /*!
+   * Constructor.
+   */
+  RobotMotionMapUpdateKernel();
+
+  /*!
+   * Destructor.
+   */
+  virtual ~RobotMotionMapUpdateKernel();
+
+  /*!
+   * Sets the update.
+   * @param translationVarianceUpdate the variance update from the translation uncertainty (same for all cells).
+   * @param yawVariance the variance of the relative rotation about the z-axis.
+   * @param positionRobotToMap the position of the map w.r.t. the previous robot pose (in map frame).
+   * @param rotationAxis the last column of the rotation from the previous robot pose to the map.
+   */
+  void setUpdate(const Eigen::Vector3f& translationVarianceUpdate, const double yawVariance,
+                 const Eigen::Vector3d& positionRobotToMap, const Eigen::Vector3d& rotationAxis);
+
+  /*!
+   * Checks if the update changes the variances of valid cells.
+   * @return true if the update is all zero.
+   */
+  bool isZero() const;
+
+  /*!
+   * Adds the update to the variance layers of the raw elevation map and clamps the
+   * variances. Cells without elevation get infinite variances.
+   * @param rawMap the raw elevation map (with float or compact layers, see CompactLayers.hpp).
+   * @param minVariance the minimal variance.
+   * @param maxVariance the maximal variance (larger variances are set to infinity).
+   * @param minHorizontalVariance the minimal horizontal variance.
+   * @param maxHorizontalVariance the maximal horizontal variance (larger variances are set to infinity).
+   * @param activeTiles if not null, only the cells of the marked tiles are updated.
+   */
+  void apply(grid_map::GridMap& rawMap, const float minVariance, const float maxVariance,
+             const float minHorizontalVariance, const float maxHorizontalVariance,
+             const TileMask* activeTiles = nullptr);
+
+ private:
+
+  //! Translation variance update.
+  Eigen::Vector3f translationVarianceUpdate_;
+
+  //! Variance of the yaw rotation.
+  double yawVariance_;
+
+  //! Position of the map w.r.t. the previous robot pose.
+  Eigen::Vector3d positionRobotToMap_;
+
+  //! Rotation axis of the yaw rotation in map frame.
+  Eigen::Vector3d rotationAxis_;
+
+  //! Lever arm components in x of the cells of a column and in y of the cells of a row (without the height part).
+  Eigen::ArrayXd leverArmsX_;
+  Eigen::ArrayXd leverArmsY_;
+
+  //! Buffers for the cells of a column.
+  Eigen::ArrayXd heights_;
+  Eigen::ArrayXd rotationJacobiansX_;
+  Eigen::ArrayXd rotationJacobiansY_;
+  Eigen::Array<bool, Eigen::Dynamic, 1> isValid_;
+
+  //! Buffers for the horizontal variances and the times of a column of the compact layers.
+  Eigen::ArrayXf horizontalVariancesX_;
+  Eigen::ArrayXf horizontalVariancesY_;
+  Eigen::ArrayXf horizontalVariancesXY_;
+  Eigen::Array<uint16_t, Eigen::Dynamic, 1> compactTimes_;
+};
+
+} /* namespace elevation_mapping */
@@ -10,6 +10,7 @@
 
 // Elevation Mapping
 #include "elevation_mapping/ElevationMap.hpp"
+#include "elevation_mapping/RobotMotionMapUpdateKernel.hpp"
 
 // Eigen
 #include <Eigen/Core>
@@ -38,7 +39,7 @@ class RobotMotionMapUpdater
   /*!
    * Constructor.
    */
-  RobotMotionMapUpdater(ros::NodeHandle nodeHandle);
+  RobotMotionMapUpdater();
 
   /*!
    * Destructor.
@@ -47,9 +48,10 @@ class RobotMotionMapUpdater
 
   /*!
    * Reads and verifies the ROS parameters.
+   * @param nodeHandle the ROS node handle.
    * @return true if successful.
    */
-  bool readParameters();
+  bool readParameters(ros::NodeHandle& nodeHandle);
 
   /*!
    * Computes the model update for the elevation map based on the pose covariance and
@@ -85,9 +87,6 @@ class RobotMotionMapUpdater
   bool computeRelativeCovariance(const Pose& robotPose, const ReducedCovariance& reducedCovariance,
                                  ReducedCovariance& relativeCovariance);
 
-  //! ROS nodehandle.
-  ros::NodeHandle nodeHandle_;
-
   //! Time of the previous update.
   ros::Time previousUpdateTime_;
 
@@ -99,6 +98,9 @@ class RobotMotionMapUpdater
 
   //! Scaling factor for the covariance matrix (default 1).
   double covarianceScale_;
+
+  //! Kernel for the map update (keeps its buffers between updates).
+  RobotMotionMapUpdateKernel motionUpdateKernel_;
 };
 
 } /* namespace */
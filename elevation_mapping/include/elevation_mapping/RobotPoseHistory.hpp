@@ -0,0 +1,157 @@
+/*
+ * RobotPoseHistory.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// Eigen
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+// ROS
+#include <ros/ros.h>
+
+// STL
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace elevation_mapping {
+
+/*!
+ * Fixed capacity history of the robot poses with covariance for one writing and several
+ * reading threads. The poses are stored inline in a ring buffer where each slot is guarded
+ * by a sequence counter (seqlock): The writer never waits for the readers, and the readers
+ * never block the writer but retry if the slot was overwritten while being read. Lookups by
+ * time are binary searches over the ring buffer.
+ */
+class RobotPoseHistory
+{
+ public:
+
+  //! Robot pose with covariance at a point in time.
+  struct Entry
+  {
+    ros::Time time;
+    Eigen::Vector3d position;
+    Eigen::Quaterniond orientation;
+    //! Covariance of the pose (position, orientation).
+    Eigen::Matrix<double, 6, 6> covariance;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
+  /*!
+   * Constructor.
+   * @param capacity the maximal number of stored poses (at least 1).
+   */
+  explicit RobotPoseHistory(const size_t capacity = 200);
+
+  /*!
+   * Destructor.
+   */
+  virtual ~RobotPoseHistory();
+
+  /*!
+   * Sets the capacity and clears the history. Must not be called concurrently with other methods.
+   * @param capacity the maximal number of stored poses (at least 1).
+   */
+  void setCapacity(const size_t capacity);
+
+  /*!
+   * Gets the capacity.
+   * @return the maximal number of stored poses.
+   */
+  size_t getCapacity() const;
+
+  /*!
+   * Adds a pose, replacing the oldest pose if the history is full. Must only be called
+   * from a single thread.
+   * @param entry the pose.
+   * @return false if the pose is older than the latest pose and has not been added.
+   */
+  bool add(const Entry& entry);
+
+  /*!
+   * Gets the latest pose at or before a time.
+   * @param[in] time the requested time.
+   * @param[out] entry the pose.
+   * @return true if successful, false if there is no pose at or before the time.
+   */
+  bool getEntryBeforeTime(const ros::Time& time, Entry& entry) const;
+
+  /*!
+   * Gets the pose at a time, interpolated between the poses before and after the time
+   * (linear for the position and the covariance, spherical linear for the orientation). If
+   * there is no newer pose, the latest pose before the time is returned.
+   * @param[in] time the requested time.
+   * @param[out] entry the pose.
+   * @return true if successful, false if there is no pose at or before the time.
+   */
+  bool getEntryAtTime(const ros::Time& time, Entry& entry) const;
+
+  /*!
+   * Gets the time of the latest pose.
+   * @return the time of the latest pose, zero if the history is empty.
+   */
+  ros::Time getLatestTime() const;
+
+  /*!
+   * Gets the number of stored poses.
+   * @return the number of poses.
+   */
+  size_t size() const;
+
+ private:
+
+  //! Slot of the ring buffer.
+  struct Slot
+  {
+    //! Sequence counter, 2n+1 while the n-th pose is written and 2n+2 when it is complete.
+    std::atomic<uint64_t> sequence;
+    Entry entry;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
+  /*!
+   * Reads the time of the n-th pose.
+   * @param[in] index the number n of the pose since the start.
+   * @param[out] time the time of the pose.
+   * @return false if the pose has been overwritten meanwhile.
+   */
+  bool readTime(const uint64_t index, ros::Time& time) const;
+
+  /*!
+   * Reads the n-th pose.
+   * @param[in] index the number n of the pose since the start.
+   * @param[out] entry the pose.
+   * @return false if the pose has been overwritten meanwhile.
+   */
+  bool readEntry(const uint64_t index, Entry& entry) const;
+
+  /*!
+   * Finds the poses before and after a time.
+   * @param[in] time the requested time.
+   * @param[out] entryBefore the latest pose at or before the time.
+   * @param[out] entryAfter the first pose after the time (if requested and available).
+   * @param[in, out] hasEntryAfter request the pose after the time, true if it is available.
+   * @return true if successful, false if there is no pose at or before the time.
+   */
+  bool find(const ros::Time& time, Entry& entryBefore, Entry& entryAfter, bool& hasEntryAfter) const;
+
+  //! Ring buffer of the poses.
+  std::unique_ptr<Slot[]> slots_;
+  size_t capacity_;
+
+  //! Number of poses added since the start.
+  std::atomic<uint64_t> numberOfEntries_;
+
+  //! Time of the latest pose (only accessed by the writer).
+  ros::Time latestTime_;
+};
+
+} /* namespace elevation_mapping */
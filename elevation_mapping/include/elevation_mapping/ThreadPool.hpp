@@ -0,0 +1,119 @@
+/*
+ * ThreadPool.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// Boost
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+// STL
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace elevation_mapping {
+
+/*!
+ * Fixed size pool of worker threads to distribute index ranges over several threads.
+ * The calling thread participates in the work, such that a pool with one thread
+ * runs everything in the calling thread.
+ */
+class ThreadPool
+{
+ public:
+
+  /*!
+   * Function processing the index range [begin, end). The thread index is in
+   * [0, getNumberOfThreads()) and can be used to address per-thread data.
+   */
+  typedef std::function<void(size_t begin, size_t end, unsigned int threadIndex)> RangeFunction;
+
+  /*!
+   * Constructor.
+   * @param numberOfThreads the number of threads (including the calling thread).
+   */
+  explicit ThreadPool(unsigned int numberOfThreads = 1);
+
+  /*!
+   * Destructor. Stops and joins the worker threads.
+   */
+  virtual ~ThreadPool();
+
+  /*!
+   * Sets the number of threads. Must not be called while work is processed.
+   * @param numberOfThreads the number of threads (including the calling thread), 0 for the
+   * number of hardware threads.
+   */
+  void setNumberOfThreads(unsigned int numberOfThreads);
+
+  /*!
+   * Gets the number of threads.
+   * @return the number of threads (including the calling thread).
+   */
+  unsigned int getNumberOfThreads() const;
+
+  /*!
+   * Processes the range [0, size) in chunks of grainSize indices on all threads and
+   * blocks until all chunks are done. Calls from different threads are serialized.
+   * @param size the number of indices.
+   * @param grainSize the number of indices processed at once.
+   * @param function the function processing a chunk.
+   */
+  void parallelFor(size_t size, size_t grainSize, const RangeFunction& function);
+
+ private:
+
+  /*!
+   * Starts the worker threads.
+   * @param numberOfThreads the number of threads (including the calling thread).
+   */
+  void start(unsigned int numberOfThreads);
+
+  /*!
+   * Stops and joins the worker threads.
+   */
+  void stop();
+
+  /*!
+   * Main loop of the worker threads.
+   * @param threadIndex the index of the worker thread.
+   * @param generation the job generation at the start of the thread.
+   */
+  void runWorker(unsigned int threadIndex, unsigned long generation);
+
+  /*!
+   * Processes chunks of the current job until no chunks are left.
+   * @param threadIndex the index of the processing thread.
+   */
+  void processChunks(unsigned int threadIndex);
+
+  //! Worker threads.
+  std::vector<std::unique_ptr<boost::thread>> workers_;
+  unsigned int numberOfThreads_;
+
+  //! Serializes calls to parallelFor(...).
+  boost::mutex callMutex_;
+
+  //! Protects the job state and signals new jobs and their completion.
+  boost::mutex mutex_;
+  boost::condition_variable jobCondition_;
+  boost::condition_variable finishedCondition_;
+
+  //! Current job.
+  const RangeFunction* function_;
+  size_t size_;
+  size_t grainSize_;
+  std::atomic<size_t> nextIndex_;
+  unsigned int numberOfActiveWorkers_;
+  unsigned long generation_;
+  bool isStopping_;
+};
+
+} /* namespace elevation_mapping */
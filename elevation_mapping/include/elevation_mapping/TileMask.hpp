@@ -0,0 +1,232 @@
+/*
+ * TileMask.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+// Grid Map
+#include <grid_map_core/TypeDefs.hpp>
+
+// Eigen
+#include <Eigen/Core>
+
+// STL
+#include <cstdint>
+#include <vector>
+
+namespace elevation_mapping {
+
+/*!
+ * Marks square tiles of a grid map, e.g. to keep track of the regions of the map
+ * that have changed. The tiles are defined in the (circular) buffer index space
+ * of the grid map, such that moving the map does not affect the marked cells.
+ */
+class TileMask
+{
+ public:
+
+  //! Region of cells of the (unwrapped) grid map, relative to the buffer start index.
+  struct Region
+  {
+    grid_map::Index startIndex;
+    grid_map::Size size;
+  };
+
+  /*!
+   * Constructor.
+   * @param tileSize the side length of a tile in number of cells.
+   */
+  explicit TileMask(const unsigned int tileSize = 16);
+
+  /*!
+   * Destructor.
+   */
+  virtual ~TileMask();
+
+  /*!
+   * Sets the size of the grid map. Marks all tiles.
+   * @param size the size of the grid map (in number of cells).
+   */
+  void setSize(const grid_map::Size& size);
+
+  /*!
+   * Marks all tiles.
+   */
+  void markAll();
+
+  /*!
+   * Unmarks all tiles.
+   */
+  void reset();
+
+  /*!
+   * Marks the tile containing a cell.
+   * @param index the buffer index of the cell.
+   */
+  void markCell(const grid_map::Index& index)
+  {
+    marks_[getTile(index(0) / tileSize_, index(1) / tileSize_)] = 1;
+  }
+
+  /*!
+   * Marks the tiles overlapping with a region of cells.
+   * @param startIndex the buffer index of the first cell of the region.
+   * @param size the size of the region (the region wraps around the buffer border).
+   */
+  void markRegion(const grid_map::Index& startIndex, const grid_map::Size& size);
+
+  /*!
+   * Unmarks the tiles that lie entirely within a region of cells.
+   * @param startIndex the buffer index of the first cell of the region.
+   * @param size the size of the region (the region wraps around the buffer border).
+   */
+  void unmarkRegion(const grid_map::Index& startIndex, const grid_map::Size& size);
+
+  /*!
+   * Checks if any tile overlapping with a region of cells is marked.
+   * @param startIndex the buffer index of the first cell of the region.
+   * @param size the size of the region (the region wraps around the buffer border).
+   * @return true if at least one of the tiles is marked.
+   */
+  bool isRegionMarked(const grid_map::Index& startIndex, const grid_map::Size& size) const;
+
+  /*!
+   * Extends a region of cells to the borders of the tiles it overlaps with.
+   * @param[in, out] startIndex the buffer index of the first cell of the region.
+   * @param[in, out] size the size of the region (the region wraps around the buffer border).
+   */
+  void extendRegionToTiles(grid_map::Index& startIndex, grid_map::Size& size) const;
+
+  /*!
+   * Marks all tiles marked in another mask of the same size.
+   * @param other the other mask.
+   */
+  void merge(const TileMask& other);
+
+  /*!
+   * Additionally marks all tiles whose cells are closer than a radius to the cells of a
+   * marked tile. The dilation wraps around the buffer border and is conservative.
+   * @param radius the radius in number of cells.
+   */
+  void dilate(const unsigned int radius);
+
+  /*!
+   * Checks if any tile is marked.
+   * @return true if at least one tile is marked.
+   */
+  bool isAnyMarked() const;
+
+  /*!
+   * Gets the number of tiles in each direction.
+   * @return the number of tiles.
+   */
+  const grid_map::Size& getNumberOfTiles() const
+  {
+    return numberOfTiles_;
+  }
+
+  /*!
+   * Checks if a tile is marked.
+   * @param tileIndex the index of the tile.
+   * @return true if marked.
+   */
+  bool isMarked(const grid_map::Index& tileIndex) const
+  {
+    return marks_[getTile(tileIndex(0), tileIndex(1))] != 0;
+  }
+
+  /*!
+   * Checks if the tile containing a cell is marked.
+   * @param index the buffer index of the cell.
+   * @return true if marked.
+   */
+  bool isCellMarked(const grid_map::Index& index) const
+  {
+    return marks_[getTile(index(0) / tileSize_, index(1) / tileSize_)] != 0;
+  }
+
+  /*!
+   * Unmarks the marked tiles in which all cells of a layer are NaN.
+   * @param layer the layer with the size of the grid map.
+   */
+  void unmarkEmptyTiles(const grid_map::Matrix& layer);
+
+  /*!
+   * Calls a function for the region of cells of each marked tile.
+   * @param function the function taking the buffer index of the first cell and the size of the region.
+   */
+  template<typename Function>
+  void forEachMarkedTile(Function function) const
+  {
+    for (int tileCol = 0; tileCol < numberOfTiles_(1); ++tileCol) {
+      for (int tileRow = 0; tileRow < numberOfTiles_(0); ++tileRow) {
+        if (!marks_[getTile(tileRow, tileCol)]) continue;
+        grid_map::Index startIndex;
+        grid_map::Size size;
+        getTileRegion(grid_map::Index(tileRow, tileCol), startIndex, size);
+        function(startIndex, size);
+      }
+    }
+  }
+
+  /*!
+   * Gets the region of cells of a tile.
+   * @param[in] tileIndex the index of the tile.
+   * @param[out] startIndex the buffer index of the first cell of the tile.
+   * @param[out] size the size of the tile (smaller at the buffer border).
+   */
+  void getTileRegion(const grid_map::Index& tileIndex, grid_map::Index& startIndex, grid_map::Size& size) const;
+
+  /*!
+   * Gets the smallest region of the (unwrapped) grid map that contains all marked tiles.
+   * @param[in] bufferStartIndex the start index of the circular buffer of the grid map.
+   * @param[out] startIndex the first cell of the region, relative to the buffer start index.
+   * @param[out] size the size of the region.
+   * @return false if no tile is marked.
+   */
+  bool getBoundingRegion(const grid_map::Index& bufferStartIndex, grid_map::Index& startIndex, grid_map::Size& size) const;
+
+  /*!
+   * Gets rectangular regions of the (unwrapped) grid map that together cover exactly the cells of
+   * the marked tiles. Adjacent marked tiles are merged into the same region where possible.
+   * @param bufferStartIndex the start index of the circular buffer of the grid map.
+   * @return the regions (empty if no tile is marked).
+   */
+  std::vector<Region> getMarkedRegions(const grid_map::Index& bufferStartIndex) const;
+
+ private:
+
+  /*!
+   * Gets the storage index of a tile.
+   */
+  size_t getTile(const int tileRow, const int tileCol) const
+  {
+    return static_cast<size_t>(tileRow) + static_cast<size_t>(tileCol) * numberOfTiles_(0);
+  }
+
+  /*!
+   * Gets the tile rows and columns of a region of cells, taking care of the wrapping.
+   * @param[in] startIndex the buffer index of the first cell of the region.
+   * @param[in] size the size of the region.
+   * @param[in] isCoveredOnly only the tiles that lie entirely within the region if true, else all overlapping tiles.
+   * @param[out] tiles the tile rows and the tile columns.
+   */
+  void getRegionTiles(const grid_map::Index& startIndex, const grid_map::Size& size, const bool isCoveredOnly,
+                      std::vector<int> tiles[2]) const;
+
+  //! Side length of a tile in number of cells.
+  const int tileSize_;
+
+  //! Size of the grid map.
+  grid_map::Size size_;
+
+  //! Number of tiles in each direction.
+  grid_map::Size numberOfTiles_;
+
+  //! Tile marks (column-major).
+  std::vector<uint8_t> marks_;
+};
+
+} /* namespace elevation_mapping */
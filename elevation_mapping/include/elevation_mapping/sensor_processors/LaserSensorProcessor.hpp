@@ -20,25 +20,48 @@ class LaserSensorProcessor : public SensorProcessorBase
 
 public:
 
+  /*!
+   * Parameters of the laser sensor model (see the README for a description).
+   * The defaults are the same as for the ROS parameters.
+   */
+  struct Parameters
+  {
+    double minRadius = 0.0;
+    double beamAngle = 0.0;
+    double beamConstant = 0.0;
+  };
+
   /*!
    * Constructor.
-   * @param nodeHandle the ROS node handle.
-   * @param transformListener the ROS transform listener.
+   * @param transformer the TF transformer (usually the ROS transform listener).
    */
-  LaserSensorProcessor(ros::NodeHandle& nodeHandle, tf::TransformListener& transformListener);
+  LaserSensorProcessor(tf::Transformer& transformer);
 
   /*!
    * Destructor.
    */
 	virtual ~LaserSensorProcessor();
 
+  /*!
+   * Sets the sensor model parameters.
+   * @param parameters the parameters.
+   */
+  void setParameters(const Parameters& parameters);
+
+  /*!
+   * Gets the sensor model parameters.
+   * @return the parameters.
+   */
+  const Parameters& getParameters() const;
+
 private:
 
   /*!
    * Reads and verifies the parameters.
+   * @param nodeHandle the ROS node handle.
    * @return true if successful.
    */
-	bool readParameters();
+	bool readParameters(ros::NodeHandle& nodeHandle);
 
 	/*!
 	 * Clean the point cloud. Points below the minimal and above the maximal sensor
@@ -48,6 +71,16 @@ private:
 	 */
 	virtual bool cleanPointCloud(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud);
 
+  /*!
+   * Processes the points in a single pass with the processing kernel and the sensor model.
+   * @param[in] pointCloud the input points.
+   * @param[in] kernel the processing kernel.
+   * @param[out] pointCloudMapFrame the accepted points in the map frame.
+   * @param[out] variances the elevation map height variances of the accepted points.
+   */
+  virtual void processPoints(const PointCloudBuffer& pointCloud, const SensorProcessingKernel& kernel,
+                             pcl::PointCloud<pcl::PointXYZRGB>& pointCloudMapFrame, Eigen::VectorXf& variances);
+
   /*!
    * Computes the elevation map height variances for each point in a point cloud with the
    * sensor model and the robot pose covariance.
@@ -60,6 +93,9 @@ private:
 			const pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr pointCloud,
 			const Eigen::Matrix<double, 6, 6>& robotPoseCovariance,
 			Eigen::VectorXf& variances);
+
+  //! Sensor model parameters.
+  Parameters parameters_;
 };
 
 
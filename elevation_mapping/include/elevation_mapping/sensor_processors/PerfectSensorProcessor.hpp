@@ -22,10 +22,9 @@ public:
 
   /*!
    * Constructor.
-   * @param nodeHandle the ROS node handle.
-   * @param transformListener the ROS transform listener.
+   * @param transformer the TF transformer (usually the ROS transform listener).
    */
-  PerfectSensorProcessor(ros::NodeHandle& nodeHandle, tf::TransformListener& transformListener);
+  PerfectSensorProcessor(tf::Transformer& transformer);
 
   /*!
    * Destructor.
@@ -36,9 +35,10 @@ private:
 
   /*!
    * Reads and verifies the parameters.
+   * @param nodeHandle the ROS node handle.
    * @return true if successful.
    */
-	bool readParameters();
+	bool readParameters(ros::NodeHandle& nodeHandle);
 
 	/*!
 	 * Clean the point cloud. Points below the minimal and above the maximal sensor
@@ -48,6 +48,16 @@ private:
 	 */
 	virtual bool cleanPointCloud(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud);
 
+  /*!
+   * Processes the points in a single pass with the processing kernel and the sensor model.
+   * @param[in] pointCloud the input points.
+   * @param[in] kernel the processing kernel.
+   * @param[out] pointCloudMapFrame the accepted points in the map frame.
+   * @param[out] variances the elevation map height variances of the accepted points.
+   */
+  virtual void processPoints(const PointCloudBuffer& pointCloud, const SensorProcessingKernel& kernel,
+                             pcl::PointCloud<pcl::PointXYZRGB>& pointCloudMapFrame, Eigen::VectorXf& variances);
+
   /*!
    * Computes the elevation map height variances for each point in a point cloud with the
    * sensor model and the robot pose covariance.
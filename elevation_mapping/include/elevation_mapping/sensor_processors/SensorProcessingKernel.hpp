@@ -0,0 +1,222 @@
+/*
+ * SensorProcessingKernel.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+#include "elevation_mapping/PointCloudBuffer.hpp"
+
+// PCL
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+// Eigen
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+// Kindr
+#include <kindr/Core>
+
+// STL
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace elevation_mapping {
+
+/*!
+ * Processes the points of a point cloud in a single pass: Each point is transformed to the
+ * sensor and the map frame, rejected if invalid (NaN, outside of the sensor range or of the
+ * height limits) and written compacted to the output. The height variances of the accepted
+ * points are computed in batches of fixed size with the sensor model, such that the sensor
+ * model and the error propagation are vectorized.
+ *
+ * The sensor model is a policy with the methods
+ *   bool isValid(const Eigen::Vector3f& pointSensorFrame) const;
+ *   void computeSensorVariances(const SensorProcessingKernel::PointBatch& points,
+ *                               SensorProcessingKernel::BatchArray& varianceLateral,
+ *                               SensorProcessingKernel::BatchArray& varianceNormal) const;
+ */
+class SensorProcessingKernel
+{
+ public:
+  //! Number of points per batch.
+  static const int batchSize = 64;
+
+  //! Values of the points of a batch.
+  typedef Eigen::Array<float, batchSize, 1> BatchArray;
+
+  //! Batch of accepted points, in the sensor frame (S_r_SP) with their column and row in the input.
+  struct PointBatch
+  {
+    BatchArray x;
+    BatchArray y;
+    BatchArray z;
+    BatchArray u;
+    BatchArray v;
+  };
+
+  /*!
+   * Constructor.
+   * @param transformationInputToSensor the transformation from the input to the sensor frame.
+   * @param transformationSensorToMap the transformation from the sensor to the map frame.
+   * @param heightLowerLimit points below this height in map frame are rejected.
+   * @param heightUpperLimit points above this height in map frame are rejected.
+   * @param rotationMapToBase the rotation from the map to the base frame (C_BM).
+   * @param rotationBaseToSensor the rotation from the base to the sensor frame (C_SB).
+   * @param translationBaseToSensorInBaseFrame the translation from the base to the sensor (B_r_BS).
+   * @param rotationVariance the robot rotation covariance matrix (Sigma_q).
+   */
+  SensorProcessingKernel(const Eigen::Affine3f& transformationInputToSensor,
+                         const Eigen::Affine3f& transformationSensorToMap,
+                         const float heightLowerLimit, const float heightUpperLimit,
+                         const kindr::RotationMatrixD& rotationMapToBase,
+                         const kindr::RotationMatrixD& rotationBaseToSensor,
+                         const kindr::Position3D& translationBaseToSensorInBaseFrame,
+                         const Eigen::Matrix3f& rotationVariance)
+      : transformationInputToSensor_(transformationInputToSensor),
+        transformationSensorToMap_(transformationSensorToMap),
+        heightLowerLimit_(heightLowerLimit),
+        heightUpperLimit_(heightUpperLimit)
+  {
+    // Projection vector (P).
+    const Eigen::RowVector3f projectionVector = Eigen::RowVector3f::UnitZ();
+    // Sensor Jacobian (J_s), the sensor covariance matrix is diagonal (lateral, lateral, normal).
+    const Eigen::RowVector3f sensorJacobian = projectionVector * (rotationMapToBase.transposed() * rotationBaseToSensor.transposed()).toImplementation().cast<float>();
+    sensorJacobianLateral_ = sensorJacobian(0) * sensorJacobian(0) + sensorJacobian(1) * sensorJacobian(1);
+    sensorJacobianNormal_ = sensorJacobian(2) * sensorJacobian(2);
+    // Preparations for robot rotation Jacobian (J_q) to minimize computation for every point in point cloud.
+    const Eigen::Matrix3f C_BM_transpose = rotationMapToBase.transposed().toImplementation().cast<float>();
+    P_mul_C_BM_transpose_ = projectionVector * C_BM_transpose;
+    C_SB_transpose_ = rotationBaseToSensor.transposed().toImplementation().cast<float>();
+    const Eigen::Matrix3f B_r_BS_skew = kindr::getSkewMatrixFromVector(Eigen::Vector3f(translationBaseToSensorInBaseFrame.toImplementation().cast<float>()));
+    rotationJacobianOffset_ = P_mul_C_BM_transpose_ * B_r_BS_skew;
+    rotationVarianceSymmetric_ = 0.5f * (rotationVariance + rotationVariance.transpose());
+  }
+
+  /*!
+   * Computes the height variances of a batch of points in the map (error propagation law).
+   * @param[in] points the points in the sensor frame.
+   * @param[in] varianceLateral the lateral variances of the sensor model.
+   * @param[in] varianceNormal the normal variances of the sensor model.
+   * @param[out] heightVariances the height variances.
+   */
+  void computeHeightVariances(const PointBatch& points, const BatchArray& varianceLateral,
+                              const BatchArray& varianceNormal, BatchArray& heightVariances) const
+  {
+    // Point in the base frame orientation (C_SB^T * S_r_SP).
+    const BatchArray qx = C_SB_transpose_(0, 0) * points.x + C_SB_transpose_(0, 1) * points.y + C_SB_transpose_(0, 2) * points.z;
+    const BatchArray qy = C_SB_transpose_(1, 0) * points.x + C_SB_transpose_(1, 1) * points.y + C_SB_transpose_(1, 2) * points.z;
+    const BatchArray qz = C_SB_transpose_(2, 0) * points.x + C_SB_transpose_(2, 1) * points.y + C_SB_transpose_(2, 2) * points.z;
+
+    // Robot rotation Jacobian (J_q = P * C_BM^T * (skew(C_SB^T * S_r_SP) + skew(B_r_BS))).
+    const Eigen::RowVector3f& a = P_mul_C_BM_transpose_;
+    const BatchArray j0 = a(1) * qz - a(2) * qy + rotationJacobianOffset_(0);
+    const BatchArray j1 = a(2) * qx - a(0) * qz + rotationJacobianOffset_(1);
+    const BatchArray j2 = a(0) * qy - a(1) * qx + rotationJacobianOffset_(2);
+
+    // Measurement variance for map (J_q * Sigma_q * J_q^T + J_s * Sigma_S * J_s^T).
+    const Eigen::Matrix3f& S = rotationVarianceSymmetric_;
+    heightVariances = S(0, 0) * j0.square() + S(1, 1) * j1.square() + S(2, 2) * j2.square()
+        + 2.0f * (S(0, 1) * j0 * j1 + S(0, 2) * j0 * j2 + S(1, 2) * j1 * j2)
+        + sensorJacobianLateral_ * varianceLateral + sensorJacobianNormal_ * varianceNormal;
+  }
+
+  /*!
+   * Processes the points.
+   * @param[in] input the input points.
+   * @param[in] sensorModel the sensor model.
+   * @param[out] output the accepted points in the map frame.
+   * @param[out] variances the height variances of the accepted points.
+   */
+  template<typename SensorModel>
+  void process(const PointCloudBuffer& input, const SensorModel& sensorModel,
+               pcl::PointCloud<pcl::PointXYZRGB>& output, Eigen::VectorXf& variances) const
+  {
+    output.clear();
+    output.resize(input.size());
+    variances.resize(input.size());
+    const float* x = input.getX().data();
+    const float* y = input.getY().data();
+    const float* z = input.getZ().data();
+    const uint32_t* rgba = input.hasColor() ? input.getRgba().data() : nullptr;
+
+    PointBatch batch;
+    BatchArray varianceLateral, varianceNormal, heightVariances;
+    int batchCount = 0;
+    size_t n = 0;
+    size_t i = 0;
+    for (uint32_t v = 0; v < input.getHeight(); ++v) {
+      for (uint32_t u = 0; u < input.getWidth(); ++u, ++i) {
+        if (!std::isfinite(x[i]) || !std::isfinite(y[i]) || !std::isfinite(z[i])) continue;
+        const Eigen::Vector3f pointSensorFrame = transformationInputToSensor_ * Eigen::Vector3f(x[i], y[i], z[i]);
+        if (!sensorModel.isValid(pointSensorFrame)) continue;
+        const Eigen::Vector3f pointMapFrame = transformationSensorToMap_ * pointSensorFrame;
+        if (pointMapFrame.z() < heightLowerLimit_ || pointMapFrame.z() > heightUpperLimit_) continue;
+
+        pcl::PointXYZRGB& point = output.points[n];
+        point.getVector3fMap() = pointMapFrame;
+        if (rgba != nullptr) point.rgba = rgba[i];
+        ++n;
+
+        batch.x(batchCount) = pointSensorFrame.x();
+        batch.y(batchCount) = pointSensorFrame.y();
+        batch.z(batchCount) = pointSensorFrame.z();
+        batch.u(batchCount) = u;
+        batch.v(batchCount) = v;
+        if (++batchCount < batchSize) continue;
+        sensorModel.computeSensorVariances(batch, varianceLateral, varianceNormal);
+        computeHeightVariances(batch, varianceLateral, varianceNormal, heightVariances);
+        variances.segment<batchSize>(n - batchSize) = heightVariances.matrix();
+        batchCount = 0;
+      }
+    }
+
+    // Last batch, filled up with copies of its first point.
+    if (batchCount > 0) {
+      const int rest = batchSize - batchCount;
+      batch.x.tail(rest).setConstant(batch.x(0));
+      batch.y.tail(rest).setConstant(batch.y(0));
+      batch.z.tail(rest).setConstant(batch.z(0));
+      batch.u.tail(rest).setConstant(batch.u(0));
+      batch.v.tail(rest).setConstant(batch.v(0));
+      sensorModel.computeSensorVariances(batch, varianceLateral, varianceNormal);
+      computeHeightVariances(batch, varianceLateral, varianceNormal, heightVariances);
+      variances.segment(n - batchCount, batchCount) = heightVariances.head(batchCount).matrix();
+    }
+
+    output.resize(n);
+    output.width = n;
+    output.height = 1;
+    output.is_dense = true;
+    variances.conservativeResize(n);
+  }
+
+ private:
+  //! Transformations of the points.
+  Eigen::Affine3f transformationInputToSensor_;
+  Eigen::Affine3f transformationSensorToMap_;
+
+  //! Height limits in map frame.
+  float heightLowerLimit_;
+  float heightUpperLimit_;
+
+  //! Robot rotation covariance matrix (Sigma_q), symmetrized.
+  Eigen::Matrix3f rotationVarianceSymmetric_;
+
+  //! Factors of the lateral and normal sensor variance in the height variance (from J_s).
+  float sensorJacobianLateral_;
+  float sensorJacobianNormal_;
+
+  //! Constant parts of the robot rotation Jacobian (J_q).
+  Eigen::RowVector3f P_mul_C_BM_transpose_;
+  Eigen::Matrix3f C_SB_transpose_;
+  Eigen::RowVector3f rotationJacobianOffset_;
+
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+} /* namespace elevation_mapping */
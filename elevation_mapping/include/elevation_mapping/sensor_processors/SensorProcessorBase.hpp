@@ -8,9 +8,14 @@
 
 #pragma once
 
+#include "elevation_mapping/PerformanceStatistics.hpp"
+#include "elevation_mapping/PointCloudBuffer.hpp"
+#include "elevation_mapping/sensor_processors/SensorProcessingKernel.hpp"
+
 // ROS
 #include <ros/ros.h>
 #include <tf/transform_listener.h>
+#include <geometry_msgs/TransformStamped.h>
 
 // PCL
 #include <pcl/point_cloud.h>
@@ -22,10 +27,17 @@
 // Kindr
 #include <kindr/Core>
 
+// Boost
+#include <boost/thread/mutex.hpp>
+
 // STL
-#include <unordered_map>
+#include <cstdint>
+#include <map>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace elevation_mapping {
 
@@ -43,10 +55,9 @@ public:
 
   /*!
    * Constructor.
-   * @param nodeHandle the ROS node handle.
-   * @param transformListener the ROS transform listener.
+   * @param transformer the TF transformer (usually the ROS transform listener).
    */
-	SensorProcessorBase(ros::NodeHandle& nodeHandle, tf::TransformListener& transformListener);
+	SensorProcessorBase(tf::Transformer& transformer);
 
 	/*!
 	 * Destructor.
@@ -65,6 +76,34 @@ public:
                const Eigen::Matrix<double, 6, 6>& robotPoseCovariance,
                const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloudOutput, Eigen::VectorXf& variances);
 
+  /*!
+   * Processes the point cloud from a point buffer (as read from the point cloud message).
+   * With the single pass processing, all steps are done per point with the processing kernel.
+   * Otherwise, the points are transformed to the sensor frame while they are copied from the
+   * buffer and processed step by step as point clouds.
+   * @param[in] pointCloudInput the input point buffer.
+   * @param[in] robotPoseCovariance the robot pose covariance matrix.
+   * @param[out] pointCloudOutput the processed point cloud.
+   * @param[out] variances the measurement variances expressed in the target frame.
+   * @return true if successful.
+   */
+  bool process(const PointCloudBuffer& pointCloudInput,
+               const Eigen::Matrix<double, 6, 6>& robotPoseCovariance,
+               const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloudOutput, Eigen::VectorXf& variances);
+
+  /*!
+   * Sets the statistics to record the transform waits and the processing durations to.
+   * @param statistics the statistics, nothing is recorded if null.
+   */
+  void setPerformanceStatistics(PerformanceStatistics* statistics);
+
+  /*!
+   * Adds static transformations (as published on /tf_static). Records the static frames and
+   * invalidates the cached static transformations.
+   * @param transforms the static transformations.
+   */
+  void addStaticTransformations(const std::vector<geometry_msgs::TransformStamped>& transforms);
+
   typedef std::unique_ptr<SensorProcessorBase> Ptr;
 
 	friend class ElevationMapping;
@@ -73,9 +112,10 @@ public:
 
   /*!
    * Reads and verifies the parameters.
+   * @param nodeHandle the ROS node handle.
    * @return true if successful.
    */
-  virtual bool readParameters();
+  virtual bool readParameters(ros::NodeHandle& nodeHandle);
 
   /*!
    * Cleans the point cloud.
@@ -84,6 +124,16 @@ public:
    */
   virtual bool cleanPointCloud(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud) = 0;
 
+  /*!
+   * Processes the points in a single pass with the processing kernel and the sensor model.
+   * @param[in] pointCloud the input points.
+   * @param[in] kernel the processing kernel (transformations, height limits and error propagation).
+   * @param[out] pointCloudMapFrame the accepted points in the map frame.
+   * @param[out] variances the elevation map height variances of the accepted points.
+   */
+  virtual void processPoints(const PointCloudBuffer& pointCloud, const SensorProcessingKernel& kernel,
+                             pcl::PointCloud<pcl::PointXYZRGB>& pointCloudMapFrame, Eigen::VectorXf& variances) = 0;
+
   /*!
    * Computes the elevation map height variances for each point in a point cloud with the
    * sensor model and the robot pose covariance.
@@ -97,12 +147,64 @@ public:
 
 
   /*!
-   * Update the transformations for a given time stamp.
+   * Update the transformations for a given time stamp. Waits once for the transformation
+   * from the sensor to the map frame, the transformation from the base to the map frame is
+   * derived from it and the (usually static) transformation from the sensor to the base frame.
    * @param timeStamp the time stamp for the transformation.
    * @return true if successful.
    */
   bool updateTransformations(const ros::Time& timeStamp);
 
+  /*!
+   * Checks if the transformation between two frames consists of static transformations only.
+   * The static transformation mutex must be locked.
+   * @param targetFrameId the target frame (without leading slash).
+   * @param sourceFrameId the source frame (without leading slash).
+   * @return true if the transformation is static.
+   */
+  bool isStaticTransformation(const std::string& targetFrameId, const std::string& sourceFrameId) const;
+
+  /*!
+   * Adds the number of input and output points of a processed point cloud to the statistics.
+   * @param numberOfInputPoints the number of points of the input point cloud.
+   * @param numberOfOutputPoints the number of points of the processed point cloud.
+   */
+  void countPoints(const size_t numberOfInputPoints, const size_t numberOfOutputPoints);
+
+  /*!
+   * Processes the point cloud after it has been transformed to the sensor frame.
+   * @param[in] pointCloudSensorFrame the point cloud in the sensor frame (is cleaned).
+   * @param[in] robotPoseCovariance the robot pose covariance matrix.
+   * @param[out] pointCloudMapFrame the processed point cloud in the map frame.
+   * @param[out] variances the measurement variances expressed in the map frame.
+   * @return true if successful.
+   */
+  bool processSensorFrame(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloudSensorFrame,
+                          const Eigen::Matrix<double, 6, 6>& robotPoseCovariance,
+                          const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloudMapFrame, Eigen::VectorXf& variances);
+
+  /*!
+   * Creates the processing kernel for the current transformations.
+   * @param transformationInputToSensor the transformation from the input to the sensor frame.
+   * @param robotPoseCovariance the robot pose covariance matrix.
+   * @return the processing kernel.
+   */
+  SensorProcessingKernel createProcessingKernel(const Eigen::Affine3d& transformationInputToSensor,
+                                                const Eigen::Matrix<double, 6, 6>& robotPoseCovariance) const;
+
+  /*!
+   * Looks up the transformation between two frames. The transformation from the sensor to
+   * the map frame of the current transformations and static transformations are not
+   * looked up again, other transformations are waited for up to the transform listener timeout.
+   * @param[in] targetFrame the target frame.
+   * @param[in] sourceFrame the source frame.
+   * @param[in] timeStamp the time stamp for the transformation.
+   * @param[out] transformation the transformation from the source to the target frame.
+   * @return true if successful.
+   */
+  bool lookupTransformation(const std::string& targetFrame, const std::string& sourceFrame,
+                            const ros::Time& timeStamp, Eigen::Affine3d& transformation);
+
   /*!
    * Transforms the point cloud the a target frame.
    * @param[in] pointCloud the point cloud to be transformed.
@@ -121,11 +223,8 @@ public:
   void removePointsOutsideLimits(pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr reference,
                                  std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr>& pointClouds);
 
-  //! ROS nodehandle.
-  ros::NodeHandle& nodeHandle_;
-
-  //! TF transform listener.
-  tf::TransformListener& transformListener_;
+  //! TF transformer.
+  tf::Transformer& transformListener_;
 
   //! The timeout duration for the lookup of the transformation between sensor frame and target frame.
   ros::Duration transformListenerTimeout_;
@@ -145,6 +244,24 @@ public:
   //! Transformation from Sensor to Map frame
   Eigen::Affine3d transformationSensorToMap_;
 
+  //! Transformation from Base to Map frame
+  Eigen::Affine3d transformationBaseToMap_;
+
+  //! Time stamp of the current transformations (zero if not valid).
+  ros::Time transformationTimeStamp_;
+
+  //! Parent frame ids of the frames with a static transformation, by child frame id (without leading slashes).
+  std::unordered_map<std::string, std::string> staticParentFrameIds_;
+
+  //! Cached static transformations, by target and source frame id.
+  std::map<std::pair<std::string, std::string>, Eigen::Transform<double, 3, Eigen::Affine, Eigen::DontAlign>> staticTransformations_;
+
+  //! Version of the static transformations, incremented when they change.
+  uint64_t staticTransformationsVersion_;
+
+  //! Protects the static transformations.
+  mutable boost::mutex staticTransformationsMutex_;
+
   //! TF frame id of the map.
   std::string mapFrameId_;
 
@@ -160,8 +277,14 @@ public:
   //! Ignore points below this height in map frame.
   double ignorePointsLowerThreshold_;
 
-  //! Sensor parameters.
-  std::unordered_map<std::string, double> sensorParameters_;
+  //! If true, the points are processed in a single pass with the processing kernel.
+  bool enableSinglePassProcessing_;
+
+  //! Point buffer for the single pass processing of PCL point clouds.
+  PointCloudBuffer inputBuffer_;
+
+  //! Performance statistics (not owned, may be null).
+  PerformanceStatistics* statistics_;
 };
 
 } /* namespace elevation_mapping */
@@ -24,25 +24,55 @@ class StereoSensorProcessor: public SensorProcessorBase
 {
 public:
 
+  /*!
+   * Parameters of the stereo sensor model (see the README for a description).
+   * The defaults are the same as for the ROS parameters.
+   */
+  struct Parameters
+  {
+    double p1 = 0.0;
+    double p2 = 0.0;
+    double p3 = 0.0;
+    double p4 = 0.0;
+    double p5 = 0.0;
+    double lateralFactor = 0.0;
+    double depthToDisparityFactor = 0.0;
+    double imageCenterRow = -1.0;
+    int pixelStride = 1;
+    int decimationFactor = 1;
+  };
+
   /*!
    * Constructor.
-   * @param nodeHandle the ROS node handle.
-   * @param transformListener the ROS transform listener.
+   * @param transformer the TF transformer (usually the ROS transform listener).
    */
-  StereoSensorProcessor(ros::NodeHandle& nodeHandle, tf::TransformListener& transformListener);
+  StereoSensorProcessor(tf::Transformer& transformer);
 
   /*!
    * Destructor.
    */
   virtual ~StereoSensorProcessor();
 
+  /*!
+   * Sets the sensor model parameters.
+   * @param parameters the parameters.
+   */
+  void setParameters(const Parameters& parameters);
+
+  /*!
+   * Gets the sensor model parameters.
+   * @return the parameters.
+   */
+  const Parameters& getParameters() const;
+
 private:
 
   /*!
    * Reads and verifies the parameters.
+   * @param nodeHandle the ROS node handle.
    * @return true if successful.
    */
-  bool readParameters();
+  bool readParameters(ros::NodeHandle& nodeHandle);
 
   /*!
    * Clean the point cloud. Points below the minimal and above the maximal sensor
@@ -52,6 +82,16 @@ private:
    */
   virtual bool cleanPointCloud(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud);
 
+  /*!
+   * Processes the points in a single pass with the processing kernel and the sensor model.
+   * @param[in] pointCloud the input points.
+   * @param[in] kernel the processing kernel.
+   * @param[out] pointCloudMapFrame the accepted points in the map frame.
+   * @param[out] variances the elevation map height variances of the accepted points.
+   */
+  virtual void processPoints(const PointCloudBuffer& pointCloud, const SensorProcessingKernel& kernel,
+                             pcl::PointCloud<pcl::PointXYZRGB>& pointCloudMapFrame, Eigen::VectorXf& variances);
+
   /*!
    * Computes the elevation map height variances for each point in a point cloud with the
    * sensor model and the robot pose covariance.
@@ -65,6 +105,14 @@ private:
       const Eigen::Matrix<double, 6, 6>& robotPoseCovariance,
       Eigen::VectorXf& variances);
 
+  /*!
+   * Gets the image row of the optical center for the sensor model. If not set by the
+   * parameters, it is the center of the organized point cloud.
+   * @param height the height of the organized point cloud (image).
+   * @return the image center row.
+   */
+  float getImageCenterRow(const uint32_t height) const;
+
   //! Helper functions to get i-j indices out of a single index.
   int getI(int index);
   int getJ(int index);
@@ -72,6 +120,14 @@ private:
   //! Stores 'original' point cloud indices of the cleaned point cloud.
   std::vector<int> indices_;
   int originalWidth_;
+  int originalHeight_;
+
+  //! Subsampled and decimated points for the single pass processing.
+  PointCloudBuffer subsampledPointCloud_;
+  PointCloudBuffer decimatedPointCloud_;
+
+  //! Sensor model parameters.
+  Parameters parameters_;
 };
 
 } /* namespace */
@@ -10,6 +10,9 @@
 
 #include <elevation_mapping/sensor_processors/SensorProcessorBase.hpp>
 
+// STL
+#include <limits>
+
 namespace elevation_mapping {
 
 /*!
@@ -20,25 +23,53 @@ class StructuredLightSensorProcessor : public SensorProcessorBase
 
 public:
 
+  /*!
+   * Parameters of the structured light sensor model (see the README for a description).
+   * The defaults are the same as for the ROS parameters.
+   */
+  struct Parameters
+  {
+    double cutoffMinDepth = std::numeric_limits<float>::min();
+    double cutoffMaxDepth = std::numeric_limits<float>::max();
+    double normalFactorA = 0.0;
+    double normalFactorB = 0.0;
+    double normalFactorC = 0.0;
+    double normalFactorD = 0.0;
+    double normalFactorE = 0.0;
+    double lateralFactor = 0.0;
+  };
+
   /*!
    * Constructor.
-   * @param nodeHandle the ROS node handle.
-   * @param transformListener the ROS transform listener.
+   * @param transformer the TF transformer (usually the ROS transform listener).
    */
-  StructuredLightSensorProcessor(ros::NodeHandle& nodeHandle, tf::TransformListener& transformListener);
+  StructuredLightSensorProcessor(tf::Transformer& transformer);
 
   /*!
    * Destructor.
    */
 	virtual ~StructuredLightSensorProcessor();
 
+  /*!
+   * Sets the sensor model parameters.
+   * @param parameters the parameters.
+   */
+  void setParameters(const Parameters& parameters);
+
+  /*!
+   * Gets the sensor model parameters.
+   * @return the parameters.
+   */
+  const Parameters& getParameters() const;
+
 private:
 
   /*!
    * Reads and verifies the parameters.
+   * @param nodeHandle the ROS node handle.
    * @return true if successful.
    */
-	bool readParameters();
+	bool readParameters(ros::NodeHandle& nodeHandle);
 
 	/*!
 	 * Clean the point cloud. Points below the minimal and above the maximal sensor
@@ -48,6 +79,16 @@ private:
 	 */
 	virtual bool cleanPointCloud(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud);
 
+  /*!
+   * Processes the points in a single pass with the processing kernel and the sensor model.
+   * @param[in] pointCloud the input points.
+   * @param[in] kernel the processing kernel.
+   * @param[out] pointCloudMapFrame the accepted points in the map frame.
+   * @param[out] variances the elevation map height variances of the accepted points.
+   */
+  virtual void processPoints(const PointCloudBuffer& pointCloud, const SensorProcessingKernel& kernel,
+                             pcl::PointCloud<pcl::PointXYZRGB>& pointCloudMapFrame, Eigen::VectorXf& variances);
+
   /*!
    * Computes the elevation map height variances for each point in a point cloud with the
    * sensor model and the robot pose covariance.
@@ -60,6 +101,9 @@ private:
 			const pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr pointCloud,
 			const Eigen::Matrix<double, 6, 6>& robotPoseCovariance,
 			Eigen::VectorXf& variances);
+
+  //! Sensor model parameters.
+  Parameters parameters_;
 };
 
 
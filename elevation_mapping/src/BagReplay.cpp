@@ -0,0 +1,243 @@
+/*
+ * BagReplay.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+#include "elevation_mapping/BagReplay.hpp"
+
+// ROS
+#include <geometry_msgs/PoseWithCovarianceStamped.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <tf2_msgs/TFMessage.h>
+
+// Boost
+#include <boost/bind.hpp>
+
+// STL
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+using namespace ros;
+
+namespace elevation_mapping {
+
+namespace {
+
+//! Topic name without the leading slashes, such that the topics of the bag and the parameters can be compared.
+std::string normalizeTopic(const std::string& topic)
+{
+  const size_t start = topic.find_first_not_of('/');
+  return start == std::string::npos ? std::string() : topic.substr(start);
+}
+
+} // namespace
+
+BagReplay::BagReplay(ros::NodeHandle& nodeHandle)
+    : nodeHandle_(nodeHandle),
+      elevationMapping_(nodeHandle, true)
+{
+  readParameters();
+}
+
+BagReplay::~BagReplay()
+{
+  integrationQueue_.stop();
+  integrationThread_.join();
+}
+
+bool BagReplay::readParameters()
+{
+  nodeHandle_.param("replay/bag_file", bagFile_, string());
+  if (bagFile_.empty()) {
+    ROS_ERROR("The bag file to replay (replay/bag_file) is not set.");
+    return false;
+  }
+  double lookahead;
+  nodeHandle_.param("replay/lookahead", lookahead, 0.1);
+  ROS_ASSERT(lookahead >= 0.0);
+  lookahead_.fromSec(lookahead);
+  nodeHandle_.param("replay/tf_topic", tfTopic_, string("/tf"));
+  nodeHandle_.param("replay/tf_static_topic", tfStaticTopic_, string("/tf_static"));
+  int queueSize;
+  nodeHandle_.param("replay/queue_size", queueSize, 4);
+  ROS_ASSERT(queueSize >= 1);
+  // The replay waits for the integration instead of dropping point clouds.
+  integrationQueue_.configure(queueSize, QueueDropPolicy::Block);
+  nodeHandle_.param("replay/output_map_file", outputMapFile_, string());
+  nodeHandle_.param("replay/output_bag_file", outputBagFile_, string());
+  nodeHandle_.param("replay/report_file", reportFile_, string());
+  return true;
+}
+
+bool BagReplay::run()
+{
+  if (bagFile_.empty()) return false;
+  rosbag::Bag bag;
+  try {
+    bag.open(bagFile_, rosbag::bagmode::Read);
+  } catch (const rosbag::BagException& exception) {
+    ROS_ERROR("Could not open the bag file %s: %s", bagFile_.c_str(), exception.what());
+    return false;
+  }
+
+  std::map<std::string, size_t> pointCloudTopics;
+  const std::vector<std::string> sensorInputTopics = elevationMapping_.getPointCloudTopics();
+  for (size_t i = 0; i < sensorInputTopics.size(); ++i) pointCloudTopics[normalizeTopic(sensorInputTopics[i])] = i;
+  const std::string robotPoseTopic = normalizeTopic(elevationMapping_.getRobotPoseTopic());
+  const std::string tfTopic = normalizeTopic(tfTopic_);
+  const std::string tfStaticTopic = normalizeTopic(tfStaticTopic_);
+
+  if (elevationMapping_.isPipelinedProcessingEnabled()) {
+    integrationThread_ = boost::thread(boost::bind(&BagReplay::runIntegrationThread, this));
+  }
+
+  ROS_INFO("Replaying bag file %s.", bagFile_.c_str());
+  const WallTime startTime = WallTime::now();
+  Time startBagTime, time;
+  rosbag::View view(bag);
+  for (const rosbag::MessageInstance& message : view) {
+    if (!ros::ok()) break;
+    time = message.getTime();
+    if (startBagTime.isZero()) startBagTime = time;
+    const std::string topic = normalizeTopic(message.getTopic());
+
+    if (topic == tfTopic || topic == tfStaticTopic) {
+      const tf2_msgs::TFMessageConstPtr transforms = message.instantiate<tf2_msgs::TFMessage>();
+      if (transforms) elevationMapping_.addTransformations(*transforms, topic == tfStaticTopic);
+    } else if (!robotPoseTopic.empty() && topic == robotPoseTopic) {
+      const geometry_msgs::PoseWithCovarianceStampedConstPtr pose = message.instantiate<geometry_msgs::PoseWithCovarianceStamped>();
+      if (pose) elevationMapping_.robotPoseCallback(pose);
+    } else {
+      const auto pointCloudTopic = pointCloudTopics.find(topic);
+      if (pointCloudTopic == pointCloudTopics.end()) continue;
+      const sensor_msgs::PointCloud2ConstPtr pointCloud = message.instantiate<sensor_msgs::PointCloud2>();
+      if (pointCloud) pendingPointClouds_.emplace(pointCloud->header.stamp, std::make_pair(pointCloud, pointCloudTopic->second));
+    }
+
+    // Everything up to the lookahead before the bag time has been read.
+    if (time >= startBagTime + lookahead_) processPendingPointClouds(time - lookahead_);
+  }
+
+  // The remaining point clouds are processed with the data of the entire bag.
+  Time endTime = time;
+  if (!pendingPointClouds_.empty()) endTime = std::max(endTime, pendingPointClouds_.rbegin()->first);
+  processPendingPointClouds(endTime);
+  integrationQueue_.close();
+  integrationThread_.join();
+  bag.close();
+
+  return writeResults(time - startBagTime, WallTime::now() - startTime);
+}
+
+void BagReplay::processPendingPointClouds(const ros::Time& time)
+{
+  while (!pendingPointClouds_.empty() && pendingPointClouds_.begin()->first <= time) {
+    queueTimedUpdates(pendingPointClouds_.begin()->first);
+    const sensor_msgs::PointCloud2ConstPtr pointCloud = pendingPointClouds_.begin()->second.first;
+    const size_t sensorInputIndex = pendingPointClouds_.begin()->second.second;
+    pendingPointClouds_.erase(pendingPointClouds_.begin());
+
+    IntegrationTask task;
+    task.type = IntegrationTask::Type::PointCloud;
+    if (!elevationMapping_.processPointCloud(sensorInputIndex, pointCloud, task.processedPointCloud)) continue;
+    task.time = task.processedPointCloud.timeStamp;
+    lastUpdateTime_ = task.time;
+    if (lastVisibilityCleanupTime_.isZero()) lastVisibilityCleanupTime_ = task.time;
+    queueIntegrationTask(std::move(task));
+  }
+  queueTimedUpdates(time);
+}
+
+void BagReplay::queueTimedUpdates(const ros::Time& time)
+{
+  // The timers start with the first point cloud, as in the node.
+  if (lastUpdateTime_.isZero()) return;
+
+  const ros::Duration motionUpdateDuration = elevationMapping_.getMotionUpdateDuration();
+  if (!motionUpdateDuration.isZero()) {
+    while (lastUpdateTime_ + motionUpdateDuration <= time) {
+      lastUpdateTime_ += motionUpdateDuration;
+      IntegrationTask task;
+      task.type = IntegrationTask::Type::MotionUpdate;
+      task.time = lastUpdateTime_;
+      queueIntegrationTask(std::move(task));
+    }
+  }
+
+  const ros::Duration visibilityCleanupDuration = elevationMapping_.getVisibilityCleanupDuration();
+  if (!visibilityCleanupDuration.isZero()) {
+    while (lastVisibilityCleanupTime_ + visibilityCleanupDuration <= time) {
+      lastVisibilityCleanupTime_ += visibilityCleanupDuration;
+      IntegrationTask task;
+      task.type = IntegrationTask::Type::VisibilityCleanup;
+      task.time = lastVisibilityCleanupTime_;
+      queueIntegrationTask(std::move(task));
+    }
+  }
+}
+
+void BagReplay::queueIntegrationTask(IntegrationTask&& task)
+{
+  if (!elevationMapping_.isPipelinedProcessingEnabled()) {
+    runIntegrationTask(task);
+    return;
+  }
+  integrationQueue_.push(std::move(task));
+}
+
+void BagReplay::runIntegrationTask(const IntegrationTask& task)
+{
+  switch (task.type) {
+    case IntegrationTask::Type::PointCloud:
+      elevationMapping_.integratePointCloud(task.processedPointCloud);
+      break;
+    case IntegrationTask::Type::MotionUpdate:
+      elevationMapping_.updateMotionPrediction(task.time);
+      break;
+    case IntegrationTask::Type::VisibilityCleanup:
+      elevationMapping_.visibilityCleanupCallback(ros::TimerEvent());
+      break;
+  }
+}
+
+void BagReplay::runIntegrationThread()
+{
+  IntegrationTask task;
+  while (integrationQueue_.pop(task)) runIntegrationTask(task);
+}
+
+bool BagReplay::writeResults(const ros::Duration& bagDuration, const ros::WallDuration& wallDuration)
+{
+  bool isSuccess = true;
+  if (!outputMapFile_.empty() && !elevationMapping_.saveBinaryMapFile(outputMapFile_)) isSuccess = false;
+  if (!outputBagFile_.empty()) {
+    grid_map_msgs::ProcessFile::Request request;
+    grid_map_msgs::ProcessFile::Response response;
+    request.file_path = outputBagFile_;
+    if (!elevationMapping_.saveMap(request, response)) isSuccess = false;
+  }
+
+  std::ostringstream report;
+  report << "Replayed " << bagDuration.toSec() << " s of the bag in " << wallDuration.toSec() << " s";
+  if (wallDuration.toSec() > 0.0) report << " (" << bagDuration.toSec() / wallDuration.toSec() << " times realtime)";
+  std_srvs::Trigger::Request statisticsRequest;
+  std_srvs::Trigger::Response statisticsResponse;
+  elevationMapping_.getStatistics(statisticsRequest, statisticsResponse);
+  report << ".\n" << statisticsResponse.message;
+  ROS_INFO_STREAM(report.str());
+  if (!reportFile_.empty()) {
+    std::ofstream file(reportFile_.c_str());
+    file << report.str();
+    if (!file) {
+      ROS_ERROR("Could not write the report file %s.", reportFile_.c_str());
+      isSuccess = false;
+    }
+  }
+  return isSuccess;
+}
+
+} /* namespace */
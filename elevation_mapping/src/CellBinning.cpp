@@ -0,0 +1,66 @@
+/*
+ * CellBinning.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/CellBinning.hpp"
+
+namespace elevation_mapping {
+
+CellBinning::CellBinning()
+{
+}
+
+CellBinning::~CellBinning()
+{
+}
+
+void CellBinning::compute(const std::vector<uint32_t>& pointCells, const uint32_t numberOfCells)
+{
+  cells_.clear();
+  points_.clear();
+  binCells_.clear();
+  binStarts_.clear();
+
+  // Collect the points inside the map.
+  for (size_t i = 0; i < pointCells.size(); ++i) {
+    if (pointCells[i] >= numberOfCells) continue;
+    cells_.push_back(pointCells[i]);
+    points_.push_back(static_cast<uint32_t>(i));
+  }
+  const size_t numberOfPoints = cells_.size();
+
+  // Stable LSD radix sort by cell index (only as many passes as the number of cells requires).
+  const uint32_t radixSize = 1u << radixBits_;
+  const uint32_t radixMask = radixSize - 1;
+  cellsBuffer_.resize(numberOfPoints);
+  pointsBuffer_.resize(numberOfPoints);
+  for (unsigned int shift = 0; shift < 32 && ((numberOfCells - 1) >> shift) > 0; shift += radixBits_) {
+    histogram_.assign(radixSize, 0);
+    for (size_t i = 0; i < numberOfPoints; ++i) ++histogram_[(cells_[i] >> shift) & radixMask];
+    size_t sum = 0;
+    for (auto& count : histogram_) {
+      const size_t value = count;
+      count = sum;
+      sum += value;
+    }
+    for (size_t i = 0; i < numberOfPoints; ++i) {
+      const size_t position = histogram_[(cells_[i] >> shift) & radixMask]++;
+      cellsBuffer_[position] = cells_[i];
+      pointsBuffer_[position] = points_[i];
+    }
+    cells_.swap(cellsBuffer_);
+    points_.swap(pointsBuffer_);
+  }
+
+  // Find the bins of equal cells.
+  for (size_t i = 0; i < numberOfPoints; ++i) {
+    if (i > 0 && cells_[i] == cells_[i - 1]) continue;
+    binCells_.push_back(cells_[i]);
+    binStarts_.push_back(i);
+  }
+  binStarts_.push_back(numberOfPoints);
+}
+
+} /* namespace elevation_mapping */
@@ -0,0 +1,165 @@
+/*
+ * CompactLayers.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/CompactLayers.hpp"
+
+// STL
+#include <algorithm>
+#include <map>
+
+using namespace grid_map;
+
+namespace elevation_mapping {
+
+namespace {
+
+//! Compact layers of the raw map.
+const std::string horizontalVariancesLayer("compact_horizontal_variance_x_y");
+const std::string horizontalVarianceXYAndTimeLayer("compact_horizontal_variance_xy_time");
+
+//! Layers that are stored in the compact layers, with their compact layer.
+const std::map<std::string, std::string> compactLayerSources{
+    {"horizontal_variance_x", horizontalVariancesLayer},
+    {"horizontal_variance_y", horizontalVariancesLayer},
+    {"horizontal_variance_xy", horizontalVarianceXYAndTimeLayer},
+    {"time", horizontalVarianceXYAndTimeLayer}};
+
+/*!
+ * Gets a layer of a map or NaN for all cells if the map does not have the layer.
+ * @param map the map.
+ * @param layer the layer.
+ * @return the values of the layer.
+ */
+Matrix getLayerOrNaN(const GridMap& map, const std::string& layer)
+{
+  if (map.exists(layer)) return map.get(layer);
+  return Matrix::Constant(map.getSize()(0), map.getSize()(1), NAN);
+}
+
+} // namespace
+
+const std::string& getCompactLayer(const std::string& layer)
+{
+  static const std::string noLayer;
+  const auto compactLayer = compactLayerSources.find(layer);
+  return compactLayer == compactLayerSources.end() ? noLayer : compactLayer->second;
+}
+
+bool hasCompactLayers(const grid_map::GridMap& map)
+{
+  return map.exists(horizontalVariancesLayer);
+}
+
+void packCompactLayers(grid_map::GridMap& map, const int timeBase)
+{
+  const Matrix varianceX = getLayerOrNaN(map, "horizontal_variance_x");
+  const Matrix varianceY = getLayerOrNaN(map, "horizontal_variance_y");
+  map.add(horizontalVariancesLayer, varianceX.binaryExpr(varianceY, [](const float x, const float y) {
+    return packHalfFloats(x, y);
+  }));
+  const Matrix varianceXY = getLayerOrNaN(map, "horizontal_variance_xy");
+  const Matrix time = getLayerOrNaN(map, "time");
+  map.add(horizontalVarianceXYAndTimeLayer, time.binaryExpr(varianceXY, [timeBase](const float t, const float xy) {
+    return packTimeAndHalfFloat(encodeCompactTime(t, timeBase), xy);
+  }));
+  for (const auto& layer : compactLayerSources) {
+    if (map.exists(layer.first)) map.erase(layer.first);
+  }
+}
+
+void unpackCompactLayers(grid_map::GridMap& map, const int timeBase)
+{
+  for (const auto& layer : compactLayerSources) {
+    Matrix data;
+    decodeCompactLayer(map, layer.first, timeBase, data);
+    map.add(layer.first, data);
+  }
+  map.erase(horizontalVariancesLayer);
+  map.erase(horizontalVarianceXYAndTimeLayer);
+}
+
+void decodeCompactLayer(const grid_map::GridMap& map, const std::string& layer, const int timeBase,
+                        grid_map::Matrix& data)
+{
+  const Matrix& compactLayer = map.get(getCompactLayer(layer));
+  if (layer == "horizontal_variance_x" || layer == "horizontal_variance_y") {
+    const bool isLow = layer == "horizontal_variance_x";
+    data = compactLayer.unaryExpr([isLow](const float value) {
+      float x, y;
+      unpackHalfFloats(value, x, y);
+      return isLow ? x : y;
+    });
+  } else if (layer == "horizontal_variance_xy") {
+    data = compactLayer.unaryExpr([](const float value) {
+      uint16_t time;
+      float xy;
+      unpackTimeAndHalfFloat(value, time, xy);
+      return xy;
+    });
+  } else {
+    data = compactLayer.unaryExpr([timeBase](const float value) {
+      uint16_t time;
+      float xy;
+      unpackTimeAndHalfFloat(value, time, xy);
+      return decodeCompactTime(time, timeBase);
+    });
+  }
+}
+
+void rebaseCompactTime(grid_map::GridMap& map, const int timeBase, const int newTimeBase)
+{
+  const int shift = newTimeBase - timeBase;
+  Matrix& compactLayer = map.get(horizontalVarianceXYAndTimeLayer);
+  compactLayer = compactLayer.unaryExpr([shift](const float value) {
+    if (std::isnan(value)) return value;
+    uint16_t time, xy;
+    unpackCompactFields(value, time, xy);
+    if (time != 0) time = std::max(1, std::min(time - shift, maxCompactTimeTick + 1));
+    return packCompactFields(time, xy);
+  });
+}
+
+void getHorizontalVariances(const grid_map::GridMap& map, const grid_map::Index& index, float& varianceX,
+                            float& varianceY, float& varianceXY)
+{
+  if (!hasCompactLayers(map)) {
+    varianceX = map.at("horizontal_variance_x", index);
+    varianceY = map.at("horizontal_variance_y", index);
+    varianceXY = map.at("horizontal_variance_xy", index);
+    return;
+  }
+  uint16_t time;
+  unpackHalfFloats(map.at(horizontalVariancesLayer, index), varianceX, varianceY);
+  unpackTimeAndHalfFloat(map.at(horizontalVarianceXYAndTimeLayer, index), time, varianceXY);
+}
+
+void getHorizontalVariances(const grid_map::GridMap& map, const grid_map::Index& startIndex, const grid_map::Size& size,
+                            Eigen::ArrayXXf& varianceX, Eigen::ArrayXXf& varianceY, Eigen::ArrayXXf& varianceXY)
+{
+  const auto block = [&](const std::string& layer) {
+    return map.get(layer).block(startIndex(0), startIndex(1), size(0), size(1)).array();
+  };
+  if (!hasCompactLayers(map)) {
+    varianceX = block("horizontal_variance_x");
+    varianceY = block("horizontal_variance_y");
+    varianceXY = block("horizontal_variance_xy");
+    return;
+  }
+  varianceX.resize(size(0), size(1));
+  varianceY.resize(size(0), size(1));
+  varianceXY.resize(size(0), size(1));
+  const auto horizontalVariances = block(horizontalVariancesLayer);
+  const auto horizontalVarianceXYAndTime = block(horizontalVarianceXYAndTimeLayer);
+  for (int col = 0; col < size(1); ++col) {
+    for (int row = 0; row < size(0); ++row) {
+      uint16_t time;
+      unpackHalfFloats(horizontalVariances(row, col), varianceX(row, col), varianceY(row, col));
+      unpackTimeAndHalfFloat(horizontalVarianceXYAndTime(row, col), time, varianceXY(row, col));
+    }
+  }
+}
+
+} /* namespace elevation_mapping */
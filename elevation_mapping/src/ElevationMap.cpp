@@ -10,7 +10,14 @@
 
 // Elevation Mapping
 #include "elevation_mapping/ElevationMapFunctors.hpp"
-#include "elevation_mapping/WeightedEmpiricalCumulativeDistributionFunction.hpp"
+#include "elevation_mapping/ElevationMapAddKernel.hpp"
+#include "elevation_mapping/CompactLayers.hpp"
+#include "elevation_mapping/RawMapLayers.hpp"
+#include "elevation_mapping/CellBinning.hpp"
+#include "elevation_mapping/TileMask.hpp"
+#include "elevation_mapping/FlatWeightedEmpiricalCumulativeDistributionFunction.hpp"
+#include "elevation_mapping/FusionWeights.hpp"
+#include "elevation_mapping/MapPublishing.hpp"
 
 // Grid Map
 #include <grid_map_msgs/GridMap.h>
@@ -24,29 +31,119 @@
 // Eigen
 #include <Eigen/Dense>
 
+// STL
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
 using namespace std;
 using namespace grid_map;
 
 namespace elevation_mapping {
 
+constexpr double ElevationMap::uncertaintyFactor_;
+
+namespace {
+
+//! Published layers of the raw and the fused map by default.
+const std::vector<std::string> defaultRawMapPublishedLayers{
+    "elevation", "variance", "horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy", "color", "time",
+    "standard_deviation", "horizontal_standard_deviation", "two_sigma_bound"};
+const std::vector<std::string> defaultFusedMapPublishedLayers{
+    "elevation", "upper_bound", "lower_bound", "color", "uncertainty_range"};
+
+//! Max. number of submaps of an incremental map update (also the queue size of the updates topics).
+const size_t maxNumberOfUpdatedSubmaps = 8;
+
+//! Layers of the raw map that are saved to map files.
+const std::vector<std::string> persistentRawMapLayers{
+    "elevation", "variance", "horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy", "color", "time",
+    "lowest_scan_point", "sensor_x_at_lowest_scan", "sensor_y_at_lowest_scan", "sensor_z_at_lowest_scan"};
+
+//! Persistent layers of the lowest scan points, which are optional when a map is loaded (older map files).
+const std::vector<std::string> lowestScanPointLayers{
+    "lowest_scan_point", "sensor_x_at_lowest_scan", "sensor_y_at_lowest_scan", "sensor_z_at_lowest_scan"};
+
+//! Layers with the coordinates of the sensor origins of the lowest scan points, which are only
+//! created for snapshots from the origin ids (layer 'sensor_origin_at_lowest_scan').
+const std::vector<std::string> sensorOriginLayers{
+    "sensor_x_at_lowest_scan", "sensor_y_at_lowest_scan", "sensor_z_at_lowest_scan"};
+
+//! Layers of the raw map which are copied to the snapshot of the fusion, as float or as compact layers.
+const std::vector<std::string> fusionLayers{
+    "elevation", "variance", "horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy", "color"};
+const std::vector<std::string> compactFusionLayers{
+    "elevation", "variance", "compact_horizontal_variance_x_y", "compact_horizontal_variance_xy_time", "color"};
+
+/*!
+ * Gets the layer of the raw map from which a layer of a snapshot is copied.
+ * @param rawMap the raw map.
+ * @param layer the layer of the snapshot.
+ * @return the layer of the raw map.
+ */
+const std::string& getRawMapSourceLayer(const GridMap& rawMap, const std::string& layer)
+{
+  static const std::string sensorOriginIdLayer("sensor_origin_at_lowest_scan");
+  if (std::find(sensorOriginLayers.begin(), sensorOriginLayers.end(), layer) != sensorOriginLayers.end()) {
+    return sensorOriginIdLayer;
+  }
+  if (!rawMap.exists(layer) && !getCompactLayer(layer).empty()) return getCompactLayer(layer);
+  return layer;
+}
+
+//! Max. number of sensor origins of the lowest scan points (ids are exact as float up to 2^24).
+const size_t maxNumberOfSensorOrigins = 1 << 24;
+
+/*!
+ * Checks if a snapshot is not held by any caller anymore, such that its memory can be reused.
+ * The callers only get copies of a snapshot from its (locked) owner, so once the owner holds the
+ * only reference, no caller can obtain it again. use_count() is a relaxed read, the acquire fence
+ * orders the reuse after the last reads of the callers which released the snapshot.
+ * @param snapshot the snapshot.
+ * @return true if the snapshot can be reused.
+ */
+template<typename Snapshot>
+bool isUnusedSnapshot(const std::shared_ptr<Snapshot>& snapshot)
+{
+  if (snapshot.use_count() != 1) return false;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return true;
+}
+
+}
+
 ElevationMap::ElevationMap(ros::NodeHandle nodeHandle)
-    : nodeHandle_(nodeHandle),
-      rawMap_({"elevation", "variance", "horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy", "color", "time", "lowest_scan_point", "sensor_x_at_lowest_scan", "sensor_y_at_lowest_scan", "sensor_z_at_lowest_scan"}),
+    : ElevationMap()
+{
+  elevationMapRawPublisher_ = nodeHandle.advertise<grid_map_msgs::GridMap>("elevation_map_raw", 1);
+  elevationMapFusedPublisher_ = nodeHandle.advertise<grid_map_msgs::GridMap>("elevation_map", 1);
+  elevationMapRawUpdatesPublisher_ = nodeHandle.advertise<grid_map_msgs::GridMap>("elevation_map_raw_updates", maxNumberOfUpdatedSubmaps);
+  elevationMapFusedUpdatesPublisher_ = nodeHandle.advertise<grid_map_msgs::GridMap>("elevation_map_updates", maxNumberOfUpdatedSubmaps);
+  if (!underlyingMapTopic_.empty()) underlyingMapSubscriber_ =
+      nodeHandle.subscribe(underlyingMapTopic_, 1, &ElevationMap::underlyingMapCallback, this);
+  // TODO if (enableVisibilityCleanup_) when parameter cleanup is ready.
+  visbilityCleanupMapPublisher_ = nodeHandle.advertise<grid_map_msgs::GridMap>("visibility_cleanup_map", 1);
+}
+
+ElevationMap::ElevationMap()
+    : rawMap_({"elevation", "variance", "horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy", "color", "time", "lowest_scan_point", "sensor_origin_at_lowest_scan"}),
       fusedMap_({"elevation", "upper_bound", "lower_bound", "color"}),
       hasUnderlyingMap_(false),
-      visibilityCleanupDuration_(0.0)
+      numberOfRawMapUpdates_(0),
+      numberOfFusedMapUpdates_(0),
+      rawMapVersion_(0),
+      compactTimeBase_(0),
+      fusedMapVersion_(0),
+      fusedMapStaleTiles_(4),
+      isFusedMapSnapshotRequested_(false),
+      addGrainSize_(1024),
+      statistics_(nullptr)
 {
   rawMap_.setBasicLayers({"elevation", "variance"});
   fusedMap_.setBasicLayers({"elevation", "upper_bound", "lower_bound"});
   clear();
-
-  elevationMapRawPublisher_ = nodeHandle_.advertise<grid_map_msgs::GridMap>("elevation_map_raw", 1);
-  elevationMapFusedPublisher_ = nodeHandle_.advertise<grid_map_msgs::GridMap>("elevation_map", 1);
-  if (!underlyingMapTopic_.empty()) underlyingMapSubscriber_ =
-      nodeHandle_.subscribe(underlyingMapTopic_, 1, &ElevationMap::underlyingMapCallback, this);
-  // TODO if (enableVisibilityCleanup_) when parameter cleanup is ready.
-  visbilityCleanupMapPublisher_ = nodeHandle_.advertise<grid_map_msgs::GridMap>("visibility_cleanup_map", 1);
-
   initialTime_ = ros::Time::now();
 }
 
@@ -54,12 +151,69 @@ ElevationMap::~ElevationMap()
 {
 }
 
+void ElevationMap::setParameters(const Parameters& parameters)
+{
+  boost::mutex::scoped_lock scopedLockForVisibilityCleanupData(visibilityCleanupMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLockForFusedData(fusedMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLockForRawData(rawMapMutex_);
+  parameters_ = parameters;
+  if (parameters_.enableCompactLayers != hasCompactLayers(rawMap_)) {
+    // The layers are converted in place, the snapshots take the new layers.
+    if (parameters_.enableCompactLayers) {
+      resetCompactTimeBase();
+      packCompactLayers(rawMap_, compactTimeBase_);
+      if (hasUnderlyingMap_) packCompactLayers(underlyingMap_, compactTimeBase_);
+    } else {
+      unpackCompactLayers(rawMap_, compactTimeBase_);
+      if (hasUnderlyingMap_) unpackCompactLayers(underlyingMap_, compactTimeBase_);
+    }
+    touchRawMap();
+  }
+  addThreadPool_.setNumberOfThreads(parameters_.addThreads);
+  fusionThreadPool_.setNumberOfThreads(parameters_.fusionThreads);
+  visibilityCleanupThreadPool_.setNumberOfThreads(parameters_.visibilityCleanupThreads);
+  if (!parameters_.enableActiveTiles) rawMapActiveTiles_.markAll();
+  const std::vector<std::string> rawMapSnapshotLayers = getRawMapSnapshotLayers();
+  for (auto* layers : {&parameters_.rawMapPublishedLayers, &parameters_.fusedMapPublishedLayers}) {
+    const bool isRawMap = layers == &parameters_.rawMapPublishedLayers;
+    const GridMap& map = isRawMap ? rawMap_ : fusedMap_;
+    layers->erase(std::remove_if(layers->begin(), layers->end(), [&](const std::string& layer) {
+      std::vector<std::string> sourceLayers;
+      if (!getPublishedLayers(isRawMap ? rawMapSnapshotLayers : map.getLayers(), map.getBasicLayers(), {layer}, {},
+                              sourceLayers).empty()) return false;
+      ROS_WARN("The layer '%s' cannot be published.", layer.c_str());
+      return true;
+    }), layers->end());
+  }
+  fusedMapPyramid_.resize(parameters_.fusedMapPyramidLevels);
+  fusedMapPyramidVersions_.assign(parameters_.fusedMapPyramidLevels, 0);
+  touchFusedMap();
+}
+
+const ElevationMap::Parameters& ElevationMap::getParameters() const
+{
+  return parameters_;
+}
+
 void ElevationMap::setGeometry(const grid_map::Length& length, const double& resolution, const grid_map::Position& position)
 {
-  boost::recursive_mutex::scoped_lock scopedLockForRawData(rawMapMutex_);
-  boost::recursive_mutex::scoped_lock scopedLockForFusedData(fusedMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLockForFusedData(fusedMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLockForRawData(rawMapMutex_);
+  resizeMaps(length, resolution, position);
+}
+
+void ElevationMap::resizeMaps(const grid_map::Length& length, const double& resolution, const grid_map::Position& position)
+{
   rawMap_.setGeometry(length, resolution, position);
   fusedMap_.setGeometry(length, resolution, position);
+  touchFusedMap();
+  rawMapDirtyTiles_.setSize(rawMap_.getSize());
+  rawMapUnpublishedTiles_.setSize(rawMap_.getSize());
+  fusedMapUnpublishedTiles_.setSize(fusedMap_.getSize());
+  fusedMapStaleTiles_.setSize(fusedMap_.getSize());
+  std::atomic_store(&fusedMapSnapshot_, std::shared_ptr<const FusedMapSnapshot>());
+  resetActiveTiles();
+  touchRawMap();
   ROS_INFO_STREAM("Elevation map grid resized to " << rawMap_.getSize()(0) << " rows and "  << rawMap_.getSize()(1) << " columns.");
 }
 
@@ -71,60 +225,80 @@ bool ElevationMap::add(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud,
     return false;
   }
 
-  // Initialization for time calculation.
-  const ros::WallTime methodStartTime(ros::WallTime::now());
-  boost::recursive_mutex::scoped_lock scopedLockForRawData(rawMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLockForRawData(rawMapMutex_, boost::defer_lock);
+  ScopedTimer::lock(statistics_, PerformanceStatistics::Stage::RawMapLockWait, scopedLockForRawData);
+  ScopedTimer timer(statistics_, PerformanceStatistics::Stage::Add);
 
   // Update initial time if it is not initialized.
   if (initialTime_.toSec() == 0) {
     initialTime_ = timestamp;
   }
-  const double scanTimeSinceInitialization = (timestamp - initialTime_).toSec();
+  const float scanTimeSinceInitialization = (timestamp - initialTime_).toSec();
+  if (parameters_.enableCompactLayers) updateCompactTimeBase(scanTimeSinceInitialization);
+
+  // The variances are clamped as well (only the cells with new points in the fast add).
+  const float sensorOrigin = insertSensorOrigin(Position3(transformationSensorToMap.translation()));
+  if (parameters_.enableFastAdd) {
+    addPointsWithKernel(pointCloud, pointCloudVariances, scanTimeSinceInitialization, sensorOrigin);
+  } else {
+    addPoints(pointCloud, pointCloudVariances, scanTimeSinceInitialization, sensorOrigin);
+    clampVariances();
+  }
 
+  // Point cloud stores time in microseconds. Older point clouds (e.g. of another sensor) do not move the time back.
+  rawMap_.setTimestamp(std::max(rawMap_.getTimestamp(), static_cast<grid_map::Time>(timestamp.toNSec())));
+  touchRawMap();
+
+  const double duration = timer.stop();
+  if (statistics_) statistics_->increment(PerformanceStatistics::Counter::AddedPoints, pointCloud->size());
+  ROS_DEBUG("Raw map has been updated with a new point cloud in %f s.", duration);
+  return true;
+}
+
+void ElevationMap::addPoints(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud, const Eigen::VectorXf& pointCloudVariances,
+                             const float scanTimeSinceInitialization, const float sensorOrigin)
+{
+  // The horizontal variances and the time are accessed by their getters and setters (float or compact layers).
+  const RawMapLayers layers(rawMap_, compactTimeBase_);
   for (unsigned int i = 0; i < pointCloud->size(); ++i) {
     auto& point = pointCloud->points[i];
     Index index;
     Position position(point.x, point.y);
     if (!rawMap_.getIndex(position, index)) continue; // Skip this point if it does not lie within the elevation map.
+    rawMapDirtyTiles_.markCell(index);
+    rawMapActiveTiles_.markCell(index);
 
     auto& elevation = rawMap_.at("elevation", index);
     auto& variance = rawMap_.at("variance", index);
-    auto& horizontalVarianceX = rawMap_.at("horizontal_variance_x", index);
-    auto& horizontalVarianceY = rawMap_.at("horizontal_variance_y", index);
-    auto& horizontalVarianceXY = rawMap_.at("horizontal_variance_xy", index);
     auto& color = rawMap_.at("color", index);
-    auto& time = rawMap_.at("time", index);
+    const size_t cell = layers.getLinearIndex(index);
+    const float time = layers.getTime(cell);
     auto& lowestScanPoint = rawMap_.at("lowest_scan_point", index);
-    auto& sensorXatLowestScan = rawMap_.at("sensor_x_at_lowest_scan", index);
-    auto& sensorYatLowestScan = rawMap_.at("sensor_y_at_lowest_scan", index);
-    auto& sensorZatLowestScan = rawMap_.at("sensor_z_at_lowest_scan", index);
+    auto& sensorOriginAtLowestScan = rawMap_.at("sensor_origin_at_lowest_scan", index);
 
     const float& pointVariance = pointCloudVariances(i);
-    const float scanTimeSinceInitialization = (timestamp - initialTime_).toSec();
 
     if (!rawMap_.isValid(index)) {
       // No prior information in elevation map, use measurement.
       elevation = point.z;
       variance = pointVariance;
-      horizontalVarianceX = minHorizontalVariance_;
-      horizontalVarianceY = minHorizontalVariance_;
-      horizontalVarianceXY = 0.0;
+      layers.setHorizontalVariances(cell, parameters_.minHorizontalVariance, parameters_.minHorizontalVariance, 0.0);
       colorVectorToValue(point.getRGBVector3i(), color);
       continue;
     }
 
     // Deal with multiple heights in one cell.
     const double mahalanobisDistance = fabs(point.z - elevation) / sqrt(variance);
-    if (mahalanobisDistance > mahalanobisDistanceThreshold_) {
-      if (scanTimeSinceInitialization - time <= scanningDuration_ && elevation > point.z) {
+    if (mahalanobisDistance > parameters_.mahalanobisDistanceThreshold) {
+      if (scanTimeSinceInitialization - time <= parameters_.scanningDuration && elevation > point.z) {
         // Ignore point if measurement is from the same point cloud (time comparison) and
         // if measurement is lower then the elevation in the map.
-      } else if (scanTimeSinceInitialization - time <= scanningDuration_) {
+      } else if (scanTimeSinceInitialization - time <= parameters_.scanningDuration) {
         // If point is higher.
         elevation = point.z;
         variance = pointVariance;
       } else {
-        variance += multiHeightNoise_;
+        variance += parameters_.multiHeightNoise;
       }
       continue;
     }
@@ -133,10 +307,7 @@ bool ElevationMap::add(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud,
     const float pointHeightPlusUncertainty = point.z + 3.0 * sqrt(pointVariance); // 3 sigma.
     if (std::isnan(lowestScanPoint) || pointHeightPlusUncertainty < lowestScanPoint){
       lowestScanPoint = pointHeightPlusUncertainty;
-      const Position3 sensorTranslation(transformationSensorToMap.translation());
-      sensorXatLowestScan = sensorTranslation.x();
-      sensorYatLowestScan = sensorTranslation.y();
-      sensorZatLowestScan = sensorTranslation.z();
+      sensorOriginAtLowestScan = sensorOrigin;
     }
 
     // Fuse measurement with elevation map data.
@@ -144,27 +315,71 @@ bool ElevationMap::add(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud,
     variance = (pointVariance * variance) / (pointVariance + variance);
     // TODO Add color fusion.
     colorVectorToValue(point.getRGBVector3i(), color);
-    time = scanTimeSinceInitialization;
+    layers.setTime(cell, scanTimeSinceInitialization);
 
     // Horizontal variances are reset.
-    horizontalVarianceX = minHorizontalVariance_;
-    horizontalVarianceY = minHorizontalVariance_;
-    horizontalVarianceXY = 0.0;
+    layers.setHorizontalVariances(cell, parameters_.minHorizontalVariance, parameters_.minHorizontalVariance, 0.0);
   }
+}
 
-  clean();
-  rawMap_.setTimestamp(timestamp.toNSec()); // Point cloud stores time in microseconds.
+void ElevationMap::addPointsWithKernel(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud,
+                                       const Eigen::VectorXf& pointCloudVariances,
+                                       const float scanTimeSinceInitialization,
+                                       const float sensorOrigin)
+{
+  // Resolve the layers once for the entire point cloud.
+  const RawMapLayers layers(rawMap_, compactTimeBase_);
+  const ElevationMapAddKernel kernel(layers, scanTimeSinceInitialization, sensorOrigin,
+                                     parameters_.minHorizontalVariance, parameters_.mahalanobisDistanceThreshold, parameters_.multiHeightNoise,
+                                     parameters_.scanningDuration, getVarianceClampOperator());
+  const uint32_t numberOfCells = layers.getNumberOfCells();
+
+  // Phase one: Compute the cell of each point and group the points by cell.
+  pointCells_.resize(pointCloud->size());
+  addThreadPool_.parallelFor(pointCloud->size(), addGrainSize_, [&](size_t begin, size_t end, unsigned int) {
+    for (size_t i = begin; i < end; ++i) {
+      const auto& point = pointCloud->points[i];
+      Index index;
+      if (rawMap_.getIndex(Position(point.x, point.y), index)) {
+        pointCells_[i] = layers.getLinearIndex(index);
+      } else {
+        pointCells_[i] = numberOfCells; // Skip this point if it does not lie within the elevation map.
+      }
+    }
+  });
+  addBinning_.compute(pointCells_, numberOfCells);
+  for (size_t bin = 0; bin < addBinning_.getNumberOfBins(); ++bin) {
+    const uint32_t cell = addBinning_.getCell(bin);
+    const Index index(cell % layers.rows, cell / layers.rows);
+    rawMapDirtyTiles_.markCell(index);
+    rawMapActiveTiles_.markCell(index);
+  }
 
-  const ros::WallDuration duration = ros::WallTime::now() - methodStartTime;
-  ROS_INFO("Raw map has been updated with a new point cloud in %f s.", duration.toSec());
-  return true;
+  // Phase two: Fuse the points of each cell in their original order. Cells are independent.
+  const CellAggregation cellAggregation = parameters_.cellAggregation;
+  addThreadPool_.parallelFor(addBinning_.getNumberOfBins(), addGrainSize_, [&](size_t begin, size_t end, unsigned int) {
+    for (size_t bin = begin; bin < end; ++bin) {
+      const size_t binBegin = addBinning_.getBegin(bin);
+      const auto getPoint = [&](const size_t n, float& height, float& variance) {
+        const unsigned int i = addBinning_.getPointIndex(binBegin + n);
+        height = pointCloud->points[i].z;
+        variance = pointCloudVariances(i);
+      };
+      const auto getColor = [&](const size_t n) {
+        float color;
+        colorVectorToValue(pointCloud->points[addBinning_.getPointIndex(binBegin + n)].getRGBVector3i(), color);
+        return color;
+      };
+      kernel.addPoints(addBinning_.getCell(bin), addBinning_.getEnd(bin) - binBegin, cellAggregation, getPoint, getColor);
+    }
+  });
 }
 
 bool ElevationMap::update(const grid_map::Matrix& varianceUpdate, const grid_map::Matrix& horizontalVarianceUpdateX,
                           const grid_map::Matrix& horizontalVarianceUpdateY,
                           const grid_map::Matrix& horizontalVarianceUpdateXY, const ros::Time& time)
 {
-  boost::recursive_mutex::scoped_lock scopedLock(rawMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLock(rawMapMutex_);
 
   const auto& size = rawMap_.getSize();
 
@@ -176,12 +391,51 @@ bool ElevationMap::update(const grid_map::Matrix& varianceUpdate, const grid_map
     return false;
   }
 
-  rawMap_.get("variance") += varianceUpdate;
-  rawMap_.get("horizontal_variance_x") += horizontalVarianceUpdateX;
-  rawMap_.get("horizontal_variance_y") += horizontalVarianceUpdateY;
-  rawMap_.get("horizontal_variance_xy") += horizontalVarianceUpdateXY;
-  clean();
+  // Only the cells of the active tiles are updated. Keep track of the regions that change
+  // for the incremental fusion.
+  const RawMapLayers layers(rawMap_, compactTimeBase_);
+  const CellVarianceClampOperator varianceClamp = getVarianceClampOperator();
+  rawMapActiveTiles_.forEachMarkedTile([&](const Index& startIndex, const Size& tileSize) {
+    const auto hasChanges = [&](const grid_map::Matrix& update) {
+      return (update.block(startIndex(0), startIndex(1), tileSize(0), tileSize(1)).array() != 0.0).any();
+    };
+    if (!rawMapDirtyTiles_.isCellMarked(startIndex) && (hasChanges(varianceUpdate) || hasChanges(horizontalVarianceUpdateX)
+        || hasChanges(horizontalVarianceUpdateY) || hasChanges(horizontalVarianceUpdateXY))) {
+      rawMapDirtyTiles_.markCell(startIndex);
+    }
+
+    // Add the updates and clean the cells in one traversal.
+    for (int col = startIndex(1); col < startIndex(1) + tileSize(1); ++col) {
+      const size_t begin = layers.getLinearIndex(Index(startIndex(0), col));
+      for (size_t cell = begin; cell < begin + tileSize(0); ++cell) {
+        layers.variance[cell] += varianceUpdate.data()[cell];
+        float horizontalVarianceX, horizontalVarianceY, horizontalVarianceXY;
+        layers.getHorizontalVariances(cell, horizontalVarianceX, horizontalVarianceY, horizontalVarianceXY);
+        layers.setHorizontalVariances(cell, horizontalVarianceX + horizontalVarianceUpdateX.data()[cell],
+                                      horizontalVarianceY + horizontalVarianceUpdateY.data()[cell],
+                                      horizontalVarianceXY + horizontalVarianceUpdateXY.data()[cell]);
+        varianceClamp(layers, cell);
+      }
+    }
+  });
   rawMap_.setTimestamp(time.toNSec());
+  touchRawMapLayers({"variance", "horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy"});
+
+  return true;
+}
+
+bool ElevationMap::update(RobotMotionMapUpdateKernel& motionUpdate, const ros::Time& time)
+{
+  boost::unique_lock<boost::shared_mutex> scopedLock(rawMapMutex_);
+
+  // Keep track of the regions that change for the incremental fusion (the
+  // variances of cells without elevation do not matter for the fusion).
+  if (!motionUpdate.isZero()) rawMapDirtyTiles_.merge(rawMapActiveTiles_);
+
+  motionUpdate.apply(rawMap_, parameters_.minVariance, parameters_.maxVariance, parameters_.minHorizontalVariance,
+                     parameters_.maxHorizontalVariance, &rawMapActiveTiles_);
+  rawMap_.setTimestamp(time.toNSec());
+  touchRawMapLayers({"variance", "horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy"});
 
   return true;
 }
@@ -189,7 +443,8 @@ bool ElevationMap::update(const grid_map::Matrix& varianceUpdate, const grid_map
 bool ElevationMap::fuseAll()
 {
   ROS_DEBUG("Requested to fuse entire elevation map.");
-  boost::recursive_mutex::scoped_lock scopedLock(fusedMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLock(fusedMapMutex_, boost::defer_lock);
+  ScopedTimer::lock(statistics_, PerformanceStatistics::Stage::FusedMapLockWait, scopedLock);
   return fuse(Index(0, 0), fusedMap_.getSize());
 }
 
@@ -206,12 +461,16 @@ bool ElevationMap::fuseArea(const Eigen::Vector2d& position, const Eigen::Array2
   Length submapLength;
   Index requestedIndexInSubmap;
 
-  boost::recursive_mutex::scoped_lock scopedLock(fusedMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLock(fusedMapMutex_, boost::defer_lock);
+  ScopedTimer::lock(statistics_, PerformanceStatistics::Stage::FusedMapLockWait, scopedLock);
 
+  boost::shared_lock<boost::shared_mutex> scopedLockForRawData(rawMapMutex_);
   getSubmapInformation(topLeftIndex, submapBufferSize, submapPosition, submapLength,
                        requestedIndexInSubmap, position, length, rawMap_.getLength(),
                        rawMap_.getPosition(), rawMap_.getResolution(), rawMap_.getSize(),
                        rawMap_.getStartIndex());
+  scopedLockForRawData.unlock();
+  fusedMapStaleTiles_.extendRegionToTiles(topLeftIndex, submapBufferSize);
 
   return fuse(topLeftIndex, submapBufferSize);
 }
@@ -224,233 +483,369 @@ bool ElevationMap::fuse(const grid_map::Index& topLeftIndex, const grid_map::Ind
   if ((size == 0).any()) return false;
 
   // Initializations.
-  const ros::WallTime methodStartTime(ros::WallTime::now());
-  boost::recursive_mutex::scoped_lock scopedLock(fusedMapMutex_);
-
-  // Copy raw elevation map data for safe multi-threading.
-  boost::recursive_mutex::scoped_lock scopedLockForRawData(rawMapMutex_);
-  auto rawMapCopy = rawMap_;
+  ScopedTimer timer(statistics_, PerformanceStatistics::Stage::Fusion);
+
+  // Get a snapshot of the raw elevation map data for safe multi-threading. Only readers
+  // run in parallel, the adds wait for the snapshot.
+  boost::shared_lock<boost::shared_mutex> scopedLockForRawData(rawMapMutex_, boost::defer_lock);
+  ScopedTimer::lock(statistics_, PerformanceStatistics::Stage::RawMapLockWait, scopedLockForRawData);
+  // The compact layers are copied as they are, the fusion decodes the horizontal variances of the cells.
+  const auto rawMapSnapshot = copyRawMapSnapshot(parameters_.enableCompactLayers ? compactFusionLayers : fusionLayers);
+  boost::mutex::scoped_lock scopedLockForRawMapTiles(rawMapTilesMutex_);
+  TileMask dirtyTiles(rawMapDirtyTiles_);
+  // The changes are still published with the next raw map.
+  rawMapUnpublishedTiles_.merge(rawMapDirtyTiles_);
+  rawMapDirtyTiles_.reset();
+  scopedLockForRawMapTiles.unlock();
+  const TileMask activeTiles(rawMapActiveTiles_);
   scopedLockForRawData.unlock();
+  const GridMap& rawMapCopy = *rawMapSnapshot;
 
-  // More initializations.
-  const double halfResolution = fusedMap_.getResolution() / 2.0;
-  const float minimalWeight = std::numeric_limits<float>::epsilon() * (float) 2.0;
   // Conservative cell inclusion for ellipse iterator.
   const double ellipseExtension = M_SQRT2 * fusedMap_.getResolution();
 
-  // Check if there is the need to reset out-dated data.
-  if (fusedMap_.getTimestamp() != rawMapCopy.getTimestamp()) resetFusedData();
-
   // Align fused map with raw map.
   if (rawMapCopy.getPosition() != fusedMap_.getPosition()) fusedMap_.move(rawMapCopy.getPosition());
 
-  // For each cell in requested area.
-  for (SubmapIterator areaIterator(rawMapCopy, topLeftIndex, size); !areaIterator.isPastEnd(); ++areaIterator) {
-
-    // Check if fusion for this cell has already been done earlier.
-    if (fusedMap_.isValid(*areaIterator)) continue;
-
-    if (!rawMapCopy.isValid(*areaIterator)) {
-      // This is an empty cell (hole in the map).
-      // TODO.
-      continue;
-    }
-
-    // Get size of error ellipse.
-    const float& sigmaXsquare = rawMapCopy.at("horizontal_variance_x", *areaIterator);
-    const float& sigmaYsquare = rawMapCopy.at("horizontal_variance_y", *areaIterator);
-    const float& sigmaXYsquare = rawMapCopy.at("horizontal_variance_xy", *areaIterator);
-
-    Eigen::Matrix2d covarianceMatrix;
-    covarianceMatrix << sigmaXsquare, sigmaXYsquare, sigmaXYsquare, sigmaYsquare;
-    // 95.45% confidence ellipse which is 2.486-sigma for 2 dof problem.
-    // http://www.reid.ai/2012/09/chi-squared-distribution-table-with.html
-    const double uncertaintyFactor = 2.486; // sqrt(6.18)
-    Eigen::EigenSolver<Eigen::Matrix2d> solver(covarianceMatrix);
-    Eigen::Array2d eigenvalues(solver.eigenvalues().real().cwiseAbs());
-
-    Eigen::Array2d::Index maxEigenvalueIndex;
-    eigenvalues.maxCoeff(&maxEigenvalueIndex);
-    Eigen::Array2d::Index minEigenvalueIndex;
-    maxEigenvalueIndex == Eigen::Array2d::Index(0) ? minEigenvalueIndex = 1 : minEigenvalueIndex = 0;
-    const Length ellipseLength =  2.0 * uncertaintyFactor * Length(eigenvalues(maxEigenvalueIndex), eigenvalues(minEigenvalueIndex)).sqrt() + ellipseExtension;
-    const double ellipseRotation(atan2(solver.eigenvectors().col(maxEigenvalueIndex).real()(1), solver.eigenvectors().col(maxEigenvalueIndex).real()(0)));
-
-    // Requested length and position (center) of submap in map.
-    Position requestedSubmapPosition;
-    rawMapCopy.getPosition(*areaIterator, requestedSubmapPosition);
-    EllipseIterator ellipseIterator(rawMapCopy, requestedSubmapPosition, ellipseLength, ellipseRotation);
-
-    // Prepare data fusion.
-    Eigen::ArrayXf means, weights;
-    const unsigned int maxNumberOfCellsToFuse = ellipseIterator.getSubmapSize().prod();
-    means.resize(maxNumberOfCellsToFuse);
-    weights.resize(maxNumberOfCellsToFuse);
-    WeightedEmpiricalCumulativeDistributionFunction<float> lowerBoundDistribution;
-    WeightedEmpiricalCumulativeDistributionFunction<float> upperBoundDistribution;
-
-    float maxStandardDeviation = sqrt(eigenvalues(maxEigenvalueIndex));
-    float minStandardDeviation = sqrt(eigenvalues(minEigenvalueIndex));
-    Eigen::Rotation2Dd rotationMatrix(ellipseRotation);
-    std::string maxEigenvalueLayer, minEigenvalueLayer;
-    if (maxEigenvalueIndex == 0) {
-      maxEigenvalueLayer = "horizontal_variance_x";
-      minEigenvalueLayer = "horizontal_variance_y";
-    } else {
-      maxEigenvalueLayer = "horizontal_variance_y";
-      minEigenvalueLayer = "horizontal_variance_x";
-    }
+  // Check if there is the need to reset out-dated data.
+  if (parameters_.enableIncrementalFusion) {
+    // Only the cells whose ellipse can reach a changed raw cell are out-dated.
+    const double maxEllipseRadius = uncertaintyFactor_ * sqrt(updateMaxHorizontalVariance(rawMapCopy, dirtyTiles))
+        + 0.5 * ellipseExtension;
+    invalidateFusedData(dirtyTiles, maxEllipseRadius);
+  } else {
+    // The changes are not tracked, recompute the bounds once the fusion is incremental again.
+    tileMaxHorizontalVariances_.resize(0, 0);
+    if (fusedMap_.getTimestamp() != rawMapCopy.getTimestamp()) resetFusedData();
+  }
 
-    // For each cell in error ellipse.
-    size_t i = 0;
-    for (; !ellipseIterator.isPastEnd(); ++ellipseIterator) {
-      if (!rawMapCopy.isValid(*ellipseIterator)) {
-        // Empty cell in submap (cannot be center cell because we checked above).
-        continue;
+  // Fuse the requested area in tiles, each cell only depends on the raw map.
+  const int tileSize = 16;
+  const Size numberOfTiles = (size + tileSize - 1) / tileSize;
+  const Size bufferSize = rawMapCopy.getSize();
+  if (fusionBuffers_.size() < fusionThreadPool_.getNumberOfThreads()) {
+    fusionBuffers_.resize(fusionThreadPool_.getNumberOfThreads());
+  }
+  boost::mutex unpublishedTilesMutex;
+  fusionThreadPool_.parallelFor(numberOfTiles.prod(), 1, [&](size_t begin, size_t end, unsigned int threadIndex) {
+    for (size_t tile = begin; tile < end; ++tile) {
+      const Index tileStart = Index(tile % numberOfTiles(0), tile / numberOfTiles(0)) * tileSize;
+      const Index tileEnd = (tileStart + tileSize).min(size);
+      bool isTileFused = false;
+      for (int col = tileStart(1); col < tileEnd(1); ++col) {
+        for (int row = tileStart(0); row < tileEnd(0); ++row) {
+          Index index = topLeftIndex + Index(row, col);
+          wrapIndexToRange(index, bufferSize);
+          if (!activeTiles.isCellMarked(index)) continue;
+          if (fuseCell(rawMapCopy, index, fusionBuffers_[threadIndex])) isTileFused = true;
+        }
       }
+      if (isTileFused) {
+        Index tileStartIndex = topLeftIndex + tileStart;
+        wrapIndexToRange(tileStartIndex, bufferSize);
+        boost::mutex::scoped_lock scopedLockForUnpublishedTiles(unpublishedTilesMutex);
+        fusedMapUnpublishedTiles_.markRegion(tileStartIndex, tileEnd - tileStart);
+      }
+    }
+  });
+  fusedMapStaleTiles_.unmarkRegion(topLeftIndex, size);
 
-      means[i] = rawMapCopy.at("elevation", *ellipseIterator);
+  fusedMap_.setTimestamp(rawMapCopy.getTimestamp());
+  touchFusedMap();
+  if (isFusedMapSnapshotRequested_) updateFusedMapSnapshot();
 
-      // Compute weight from probability.
-      Position absolutePosition;
-      rawMapCopy.getPosition(*ellipseIterator, absolutePosition);
-      Eigen::Vector2d distanceToCenter = (rotationMatrix * (absolutePosition - requestedSubmapPosition)).cwiseAbs();
+  const double duration = timer.stop();
+  ROS_DEBUG("Elevation map has been fused in %f s.", duration);
 
-      float probability1 =
-            cumulativeDistributionFunction(distanceToCenter.x() + halfResolution, 0.0, maxStandardDeviation)
-          - cumulativeDistributionFunction(distanceToCenter.x() - halfResolution, 0.0, maxStandardDeviation);
-      float probability2 =
-            cumulativeDistributionFunction(distanceToCenter.y() + halfResolution, 0.0, minStandardDeviation)
-          - cumulativeDistributionFunction(distanceToCenter.y() - halfResolution, 0.0, minStandardDeviation);
+  return true;
+}
 
-      const float weight = max(minimalWeight, probability1 * probability2);
-      weights[i] = weight;
-      const float standardDeviation = sqrt(rawMapCopy.at("variance", *ellipseIterator));
-      lowerBoundDistribution.add(means[i] - 2.0 * standardDeviation, weight);
-      upperBoundDistribution.add(means[i] + 2.0 * standardDeviation, weight);
+bool ElevationMap::fuseCell(const grid_map::GridMap& rawMap, const grid_map::Index& index, FusionBuffers& buffers)
+{
+  // Check if fusion for this cell has already been done earlier.
+  if (fusedMap_.isValid(index)) return false;
 
-      i++;
-    }
+  if (!rawMap.isValid(index)) {
+    // This is an empty cell (hole in the map).
+    // TODO.
+    return false;
+  }
 
-    if (i == 0) {
-      // Nothing to fuse.
-      fusedMap_.at("elevation", *areaIterator) = rawMapCopy.at("elevation", *areaIterator);
-      fusedMap_.at("lower_bound", *areaIterator) = rawMapCopy.at("elevation", *areaIterator) - 2.0 * sqrt(rawMapCopy.at("variance", *areaIterator));
-      fusedMap_.at("upper_bound", *areaIterator) = rawMapCopy.at("elevation", *areaIterator) + 2.0 * sqrt(rawMapCopy.at("variance", *areaIterator));
-      fusedMap_.at("color", *areaIterator) = rawMapCopy.at("color", *areaIterator);
+  const double halfResolution = rawMap.getResolution() / 2.0;
+  const float minimalWeight = std::numeric_limits<float>::epsilon() * (float) 2.0;
+  // Conservative cell inclusion for ellipse iterator.
+  const double ellipseExtension = M_SQRT2 * rawMap.getResolution();
+
+  // Get size of error ellipse.
+  float sigmaXsquare, sigmaYsquare, sigmaXYsquare;
+  getHorizontalVariances(rawMap, index, sigmaXsquare, sigmaYsquare, sigmaXYsquare);
+
+  double maxEigenvalue, minEigenvalue, ellipseRotation;
+  computeCovarianceEllipse(sigmaXsquare, sigmaYsquare, sigmaXYsquare, maxEigenvalue, minEigenvalue, ellipseRotation);
+  const Length ellipseLength =  2.0 * uncertaintyFactor_ * Length(maxEigenvalue, minEigenvalue).sqrt() + ellipseExtension;
+
+  // Requested length and position (center) of submap in map.
+  Position requestedSubmapPosition;
+  rawMap.getPosition(index, requestedSubmapPosition);
+  EllipseIterator ellipseIterator(rawMap, requestedSubmapPosition, ellipseLength, ellipseRotation);
+
+  // Prepare data fusion.
+  buffers.reserve(ellipseIterator.getSubmapSize().prod());
+  buffers.lowerBoundDistribution.clear();
+  buffers.upperBoundDistribution.clear();
+
+  const float maxStandardDeviation = sqrt(maxEigenvalue);
+  const float minStandardDeviation = sqrt(minEigenvalue);
+  const double cosRotation = cos(ellipseRotation);
+  const double sinRotation = sin(ellipseRotation);
+  const grid_map::Matrix& elevationLayer = rawMap.get("elevation");
+  const grid_map::Matrix& varianceLayer = rawMap.get("variance");
+
+  // For each cell in error ellipse, collect the data.
+  size_t i = 0;
+  for (; !ellipseIterator.isPastEnd(); ++ellipseIterator) {
+    const Index& ellipseIndex = *ellipseIterator;
+    const float elevation = elevationLayer(ellipseIndex(0), ellipseIndex(1));
+    const float variance = varianceLayer(ellipseIndex(0), ellipseIndex(1));
+    if (!std::isfinite(elevation) || !std::isfinite(variance)) {
+      // Empty cell in submap (cannot be center cell because we checked above).
       continue;
     }
 
-    // Fuse.
-    means.conservativeResize(i);
-    weights.conservativeResize(i);
+    buffers.means[i] = elevation;
+    buffers.standardDeviations[i] = sqrt(variance);
 
-    float mean = (weights * means).sum() / weights.sum();
+    // Distance to the center in the frame of the ellipse.
+    Position absolutePosition;
+    rawMap.getPosition(ellipseIndex, absolutePosition);
+    const Position offset = absolutePosition - requestedSubmapPosition;
+    buffers.distancesX[i] = std::abs(cosRotation * offset.x() - sinRotation * offset.y());
+    buffers.distancesY[i] = std::abs(sinRotation * offset.x() + cosRotation * offset.y());
 
-    if (!std::isfinite(mean)) {
-      ROS_ERROR("Something went wrong when fusing the map: Mean = %f", mean);
-      continue;
-    }
+    i++;
+  }
 
-    // Add to fused map.
-    fusedMap_.at("elevation", *areaIterator) = mean;
-    lowerBoundDistribution.compute();
-    upperBoundDistribution.compute();
-    fusedMap_.at("lower_bound", *areaIterator) = lowerBoundDistribution.quantile(0.01); // TODO
-    fusedMap_.at("upper_bound", *areaIterator) = upperBoundDistribution.quantile(0.99); // TODO
-    // TODO Add fusion of colors.
-    fusedMap_.at("color", *areaIterator) = rawMapCopy.at("color", *areaIterator);
+  if (i == 0) {
+    // Nothing to fuse.
+    fusedMap_.at("elevation", index) = rawMap.at("elevation", index);
+    fusedMap_.at("lower_bound", index) = rawMap.at("elevation", index) - 2.0 * sqrt(rawMap.at("variance", index));
+    fusedMap_.at("upper_bound", index) = rawMap.at("elevation", index) + 2.0 * sqrt(rawMap.at("variance", index));
+    fusedMap_.at("color", index) = rawMap.at("color", index);
+    return true;
   }
 
-  fusedMap_.setTimestamp(rawMapCopy.getTimestamp());
+  // Compute weights from probability for all cells at once.
+  const auto means = buffers.means.head(i);
+  const auto weights = buffers.weights.head(i);
+  computeFusionWeights(buffers.distancesX.head(i), buffers.distancesY.head(i), maxStandardDeviation,
+                       minStandardDeviation, halfResolution, minimalWeight, buffers.weights.head(i),
+                       buffers.erfBufferA.head(i), buffers.erfBufferB.head(i));
+  for (size_t j = 0; j < i; ++j) {
+    buffers.lowerBoundDistribution.add(means[j] - 2.0 * buffers.standardDeviations[j], weights[j]);
+    buffers.upperBoundDistribution.add(means[j] + 2.0 * buffers.standardDeviations[j], weights[j]);
+  }
+
+  float mean = (weights * means).sum() / weights.sum();
 
-  const ros::WallDuration duration(ros::WallTime::now() - methodStartTime);
-  ROS_INFO("Elevation map has been fused in %f s.", duration.toSec());
+  if (!std::isfinite(mean)) {
+    ROS_ERROR("Something went wrong when fusing the map: Mean = %f", mean);
+    return false;
+  }
 
+  // Add to fused map.
+  fusedMap_.at("elevation", index) = mean;
+  buffers.lowerBoundDistribution.compute();
+  buffers.upperBoundDistribution.compute();
+  fusedMap_.at("lower_bound", index) = buffers.lowerBoundDistribution.quantile(0.01); // TODO
+  fusedMap_.at("upper_bound", index) = buffers.upperBoundDistribution.quantile(0.99); // TODO
+  // TODO Add fusion of colors.
+  fusedMap_.at("color", index) = rawMap.at("color", index);
   return true;
 }
 
+void ElevationMap::FusionBuffers::reserve(const size_t size)
+{
+  if (static_cast<size_t>(means.size()) >= size) return;
+  means.resize(size);
+  standardDeviations.resize(size);
+  distancesX.resize(size);
+  distancesY.resize(size);
+  weights.resize(size);
+  erfBufferA.resize(size);
+  erfBufferB.resize(size);
+  lowerBoundDistribution.reserve(size);
+  upperBoundDistribution.reserve(size);
+}
+
 bool ElevationMap::clear()
 {
-  boost::recursive_mutex::scoped_lock scopedLockForRawData(rawMapMutex_);
-  boost::recursive_mutex::scoped_lock scopedLockForFusedData(fusedMapMutex_);
-  boost::recursive_mutex::scoped_lock scopedLockForVisibilityCleanupData(visibilityCleanupMapMutex_);
+  boost::mutex::scoped_lock scopedLockForVisibilityCleanupData(visibilityCleanupMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLockForFusedData(fusedMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLockForRawData(rawMapMutex_);
   rawMap_.clearAll();
   rawMap_.resetTimestamp();
+  sensorOrigins_.clear();
+  rawMapDirtyTiles_.setSize(rawMap_.getSize());
+  rawMapUnpublishedTiles_.setSize(rawMap_.getSize());
+  fusedMapUnpublishedTiles_.setSize(fusedMap_.getSize());
+  fusedMapStaleTiles_.setSize(fusedMap_.getSize());
+  std::atomic_store(&fusedMapSnapshot_, std::shared_ptr<const FusedMapSnapshot>());
+  resetActiveTiles();
+  touchRawMap();
   fusedMap_.clearAll();
   fusedMap_.resetTimestamp();
-  visibilityCleanupMap_.clearAll();
-  visibilityCleanupMap_.resetTimestamp();
+  touchFusedMap();
+  visibilityCleanupMap_.reset();
+  visibilityCleanupMaxHeights_.clear();
+  return true;
+}
+
+bool ElevationMap::loadRawMap(const grid_map::GridMap& map, const ros::Time& initialTime)
+{
+  for (const auto& layer : getPersistentLayers()) {
+    const bool isOptional = std::find(lowestScanPointLayers.begin(), lowestScanPointLayers.end(), layer)
+        != lowestScanPointLayers.end();
+    if (!map.exists(layer) && !isOptional) {
+      ROS_ERROR("The loaded map does not have the layer '%s'.", layer.c_str());
+      return false;
+    }
+  }
+  if (map.getFrameId() != rawMap_.getFrameId()) {
+    ROS_ERROR_STREAM("The loaded map does not have the same map frame ('" << map.getFrameId()
+                     << "') as the elevation map ('" << rawMap_.getFrameId() << "').");
+    return false;
+  }
+
+  boost::mutex::scoped_lock scopedLockForVisibilityCleanupData(visibilityCleanupMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLockForFusedData(fusedMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLockForRawData(rawMapMutex_);
+  resizeMaps(map.getLength(), map.getResolution(), map.getPosition());
+  rawMap_.clearAll();
+  sensorOrigins_.clear();
+  const bool isCompact = hasCompactLayers(rawMap_);
+  for (const auto& layer : getPersistentLayers()) {
+    if (!map.exists(layer)) continue;
+    if (rawMap_.exists(layer)) rawMap_.get(layer) = map.get(layer);
+    // The layers of the compact layers are packed below.
+    else if (isCompact && !getCompactLayer(layer).empty()) rawMap_.add(layer, map.get(layer));
+  }
+  if (std::all_of(lowestScanPointLayers.begin(), lowestScanPointLayers.end(),
+                  [&](const std::string& layer) { return map.exists(layer); })) {
+    loadSensorOrigins(map);
+  } else {
+    rawMap_.clear("lowest_scan_point");
+  }
+  rawMap_.setStartIndex(map.getStartIndex());
+  fusedMap_.setStartIndex(map.getStartIndex());
+  rawMap_.setTimestamp(map.getTimestamp());
+  // The times of the loaded map are relative to its own initial time.
+  if (initialTime_.toSec() == 0) initialTime_ = initialTime;
+  rawMap_.get("time").array() += static_cast<float>((initialTime - initialTime_).toSec());
+  if (isCompact) {
+    resetCompactTimeBase();
+    packCompactLayers(rawMap_, compactTimeBase_);
+  }
+
+  resetFusedData();
+  rawMapActiveTiles_.markAll();
+  if (parameters_.enableActiveTiles) rawMapActiveTiles_.unmarkEmptyTiles(rawMap_.get("elevation"));
+  // The loaded map may have been saved with other variance limits.
+  clampVariances();
+  rawMapDirtyTiles_.markAll();
+  rawMapUnpublishedTiles_.markAll();
+  touchRawMap();
   return true;
 }
 
+const std::vector<std::string>& ElevationMap::getPersistentLayers()
+{
+  return persistentRawMapLayers;
+}
+
 void ElevationMap::visibilityCleanup(const ros::Time& updatedTime)
 {
-  // Get current time to compute calculation time.
-  const ros::WallTime methodStartTime(ros::WallTime::now());
+  ScopedTimer timer(statistics_, PerformanceStatistics::Stage::VisibilityCleanup);
   const double timeSinceInitialization = (updatedTime - initialTime_).toSec();
 
   // Copy raw elevation map data for safe multi-threading.
-  boost::recursive_mutex::scoped_lock scopedLockForVisibilityCleanupData(visibilityCleanupMapMutex_);
-  boost::recursive_mutex::scoped_lock scopedLockForRawData(rawMapMutex_);
-  visibilityCleanupMap_ = rawMap_;
+  boost::mutex::scoped_lock scopedLockForVisibilityCleanupData(visibilityCleanupMapMutex_);
+  // Release the previous snapshot, so that its memory can be reused.
+  visibilityCleanupMap_.reset();
+  boost::unique_lock<boost::shared_mutex> scopedLockForRawData(rawMapMutex_);
+  const bool isCompact = hasCompactLayers(rawMap_);
+  const int compactTimeBase = compactTimeBase_;
+  const std::string timeLayerName = isCompact ? getCompactLayer("time") : "time";
+  visibilityCleanupMap_ = copyRawMapSnapshot(
+      {"elevation", "variance", timeLayerName, "lowest_scan_point", "sensor_origin_at_lowest_scan"});
+  std::vector<Position3> sensorOrigins;
+  sensorOrigins.swap(sensorOrigins_);
   rawMap_.clear("lowest_scan_point");
-  rawMap_.clear("sensor_x_at_lowest_scan");
-  rawMap_.clear("sensor_y_at_lowest_scan");
-  rawMap_.clear("sensor_z_at_lowest_scan");
+  rawMap_.clear("sensor_origin_at_lowest_scan");
+  touchRawMapLayers({"lowest_scan_point", "sensor_origin_at_lowest_scan"});
+  const TileMask activeTiles(rawMapActiveTiles_);
   scopedLockForRawData.unlock();
-  visibilityCleanupMap_.add("max_height");
-
-  // Create max. height layer with ray tracing.
-  for (GridMapIterator iterator(visibilityCleanupMap_); !iterator.isPastEnd(); ++iterator) {
-    if (!visibilityCleanupMap_.isValid(*iterator)) continue;
-    const auto& lowestScanPoint = visibilityCleanupMap_.at("lowest_scan_point", *iterator);
-    const auto& sensorXatLowestScan = visibilityCleanupMap_.at("sensor_x_at_lowest_scan", *iterator);
-    const auto& sensorYatLowestScan = visibilityCleanupMap_.at("sensor_y_at_lowest_scan", *iterator);
-    const auto& sensorZatLowestScan = visibilityCleanupMap_.at("sensor_z_at_lowest_scan", *iterator);
-    if (std::isnan(lowestScanPoint)) continue;
-    Index indexAtSensor;
-    if(!visibilityCleanupMap_.getIndex(Position(sensorXatLowestScan, sensorYatLowestScan), indexAtSensor)) continue;
-    Position point;
-    visibilityCleanupMap_.getPosition(*iterator, point);
-    float pointDiffX = point.x() - sensorXatLowestScan;
-    float pointDiffY = point.y() - sensorYatLowestScan;
-    float distanceToPoint = sqrt(pointDiffX * pointDiffX + pointDiffY * pointDiffY);
-    if (distanceToPoint > 0.0) {
-      for (grid_map::LineIterator iterator(visibilityCleanupMap_, indexAtSensor, *iterator); !iterator.isPastEnd(); ++iterator) {
-        Position cellPosition;
-        visibilityCleanupMap_.getPosition(*iterator, cellPosition);
-        const float cellDiffX = cellPosition.x() - sensorXatLowestScan;
-        const float cellDiffY = cellPosition.y() - sensorYatLowestScan;
-        const float distanceToCell = distanceToPoint - sqrt(cellDiffX * cellDiffX + cellDiffY * cellDiffY);
-        const float maxHeightPoint = lowestScanPoint + (sensorZatLowestScan - lowestScanPoint) / distanceToPoint * distanceToCell;
-        auto& cellMaxHeight = visibilityCleanupMap_.at("max_height", *iterator);
-        if (std::isnan(cellMaxHeight) || cellMaxHeight > maxHeightPoint) {
-          cellMaxHeight = maxHeightPoint;
-        }
-      }
+  const GridMap& map = *visibilityCleanupMap_;
+
+  // Collect the rays with the sensor origins by id, origins outside of the map have an invalid index.
+  std::vector<VisibilityRayOrigin> origins(sensorOrigins.size());
+  for (size_t i = 0; i < sensorOrigins.size(); ++i) {
+    origins[i].position = sensorOrigins[i];
+    if (!map.getIndex(Position(sensorOrigins[i].x(), sensorOrigins[i].y()), origins[i].index)) origins[i].index.setConstant(-1);
+  }
+  std::vector<VisibilityRay> rays;
+  const Matrix& lowestScanPointLayer = map.get("lowest_scan_point");
+  const Matrix& sensorOriginAtLowestScanLayer = map.get("sensor_origin_at_lowest_scan");
+  forEachActiveCell(activeTiles, [&](const Index& index) {
+    if (std::isnan(lowestScanPointLayer(index(0), index(1))) || !map.isValid(index)) return;
+    const float sensorOrigin = sensorOriginAtLowestScanLayer(index(0), index(1));
+    if (!(sensorOrigin >= 0.0f && sensorOrigin < origins.size())) return;
+    const size_t origin = static_cast<size_t>(sensorOrigin);
+    if (origins[origin].index(0) < 0) return;
+    rays.push_back({index, origin});
+  });
+  // The rays of an origin share the cells close to the sensor.
+  std::stable_sort(rays.begin(), rays.end(), [](const VisibilityRay& a, const VisibilityRay& b) { return a.origin < b.origin; });
+
+  // Create max. height layer with ray tracing, each thread lowers its own max. heights.
+  visibilityCleanupMaxHeights_.resize(visibilityCleanupThreadPool_.getNumberOfThreads());
+  for (auto& maxHeight : visibilityCleanupMaxHeights_) {
+    maxHeight.setConstant(map.getSize()(0), map.getSize()(1), std::numeric_limits<float>::infinity());
+  }
+  visibilityCleanupThreadPool_.parallelFor(rays.size(), 256, [&](size_t begin, size_t end, unsigned int threadIndex) {
+    for (size_t i = begin; i < end; ++i) {
+      traceVisibilityRay(map, origins[rays[i].origin], rays[i].index, visibilityCleanupMaxHeights_[threadIndex]);
     }
+  });
+  Matrix& maxHeightLayer = visibilityCleanupMaxHeights_[0];
+  for (size_t i = 1; i < visibilityCleanupMaxHeights_.size(); ++i) {
+    maxHeightLayer = maxHeightLayer.cwiseMin(visibilityCleanupMaxHeights_[i]);
   }
 
-  // Vector of indices that will be removed.
+  // Vector of indices that will be removed, only cells below a ray can be removed.
   std::vector<Position> cellPositionsToRemove;
-  for (GridMapIterator iterator(visibilityCleanupMap_); !iterator.isPastEnd(); ++iterator) {
-    if (!visibilityCleanupMap_.isValid(*iterator)) continue;
-    const auto& time = visibilityCleanupMap_.at("time", *iterator);
-    if (timeSinceInitialization - time > scanningDuration_) {
+  const Matrix& elevationLayer = map.get("elevation");
+  const Matrix& varianceLayer = map.get("variance");
+  const Matrix& timeLayer = map.get(timeLayerName);
+  const auto getTime = [&](const Index& index) {
+    if (!isCompact) return timeLayer(index(0), index(1));
+    uint16_t time;
+    float varianceXY;
+    unpackTimeAndHalfFloat(timeLayer(index(0), index(1)), time, varianceXY);
+    return decodeCompactTime(time, compactTimeBase);
+  };
+  forEachActiveCell(activeTiles, [&](const Index& index) {
+    const float maxHeight = maxHeightLayer(index(0), index(1));
+    if (std::isinf(maxHeight) || !map.isValid(index)) return;
+    if (timeSinceInitialization - getTime(index) > parameters_.scanningDuration) {
       // Only remove cells that have not been updated during the last scan duration.
       // This prevents a.o. removal of overhanging objects.
-      const auto& elevation = visibilityCleanupMap_.at("elevation", *iterator);
-      const auto& variance = visibilityCleanupMap_.at("variance", *iterator);
-      const auto& maxHeight = visibilityCleanupMap_.at("max_height", *iterator);
-      if (!std::isnan(maxHeight) && elevation - 3.0 * sqrt(variance) > maxHeight) {
+      if (elevationLayer(index(0), index(1)) - 3.0 * sqrt(varianceLayer(index(0), index(1))) > maxHeight) {
         Position position;
-        visibilityCleanupMap_.getPosition(*iterator, position);
+        map.getPosition(index, position);
         cellPositionsToRemove.push_back(position);
       }
     }
-  }
-
+  });
   // Remove points in current raw map.
   scopedLockForRawData.lock();
   for(const auto& cellPosition : cellPositionsToRemove){
@@ -458,46 +853,110 @@ void ElevationMap::visibilityCleanup(const ros::Time& updatedTime)
     if (!rawMap_.getIndex(cellPosition, index)) continue;
     if(rawMap_.isValid(index)){
       rawMap_.at("elevation", index) = NAN;
+      rawMapDirtyTiles_.markCell(index);
     }
   }
+  if (!cellPositionsToRemove.empty()) touchRawMapLayers({"elevation"});
   scopedLockForRawData.unlock();
+  scopedLockForVisibilityCleanupData.unlock();
 
   // Publish visibility cleanup map for debugging.
   publishVisibilityCleanupMap();
 
-  ros::WallDuration duration(ros::WallTime::now() - methodStartTime);
-  ROS_INFO("Visibility cleanup has been performed in %f s (%d points).", duration.toSec(), (int)cellPositionsToRemove.size());
-  if(duration.toSec() > visibilityCleanupDuration_)
-    ROS_WARN("Visibility cleanup duration is too high (current rate is %f).", 1.0 / duration.toSec());
+  const double duration = timer.stop();
+  if (statistics_) statistics_->increment(PerformanceStatistics::Counter::VisibilityCleanupRemovedCells, cellPositionsToRemove.size());
+  ROS_DEBUG("Visibility cleanup has been performed in %f s (%d points).", duration, (int)cellPositionsToRemove.size());
+  if(duration > parameters_.visibilityCleanupDuration)
+    ROS_WARN("Visibility cleanup duration is too high (current rate is %f).", 1.0 / duration);
+}
+
+void ElevationMap::traceVisibilityRay(const grid_map::GridMap& map, const VisibilityRayOrigin& origin,
+                                      const grid_map::Index& index, grid_map::Matrix& maxHeight) const
+{
+  Position point;
+  map.getPosition(index, point);
+  const Eigen::Vector2d sensorToPoint = point - origin.position.head<2>();
+  const double distanceToPoint = sensorToPoint.norm();
+  if (distanceToPoint <= 0.0) return;
+  const float lowestScanPoint = map.at("lowest_scan_point", index);
+  const double slope = (origin.position.z() - lowestScanPoint) / distanceToPoint;
+
+  // Bresenham line in the unwrapped buffer indices (as grid_map::LineIterator).
+  const Size& size = map.getSize();
+  Index bufferStart = origin.index - map.getStartIndex();
+  Index bufferEnd = index - map.getStartIndex();
+  wrapIndexToRange(bufferStart, size);
+  wrapIndexToRange(bufferEnd, size);
+  const Index delta = (bufferEnd - bufferStart).abs();
+  const Index step((bufferEnd(0) >= bufferStart(0)) ? 1 : -1, (bufferEnd(1) >= bufferStart(1)) ? 1 : -1);
+  const int major = delta(0) >= delta(1) ? 0 : 1;
+  const int minor = 1 - major;
+  const int numberOfCells = delta(major) + 1;
+  int numerator = delta(major) / 2;
+
+  // Offset of the cell centers from the sensor, the position decreases with the index.
+  Position start;
+  map.getPosition(origin.index, start);
+  Eigen::Vector2d sensorToCell = start - origin.position.head<2>();
+  const double resolution = map.getResolution();
+  const double majorPositionStep = -step(major) * resolution;
+  const double minorPositionStep = -step(minor) * resolution;
+
+  Index cell = origin.index;
+  for (int i = 0; i < numberOfCells; ++i) {
+    const float height = lowestScanPoint + slope * (distanceToPoint - sensorToCell.norm());
+    float& cellMaxHeight = maxHeight(cell(0), cell(1));
+    if (height < cellMaxHeight) cellMaxHeight = height;
+    numerator += delta(minor);
+    if (numerator >= delta(major)) {
+      numerator -= delta(major);
+      cell(minor) += step(minor);
+      if (cell(minor) < 0) cell(minor) += size(minor);
+      else if (cell(minor) >= size(minor)) cell(minor) -= size(minor);
+      sensorToCell(minor) += minorPositionStep;
+    }
+    cell(major) += step(major);
+    if (cell(major) < 0) cell(major) += size(major);
+    else if (cell(major) >= size(major)) cell(major) -= size(major);
+    sensorToCell(major) += majorPositionStep;
+  }
 }
 
 void ElevationMap::move(const Eigen::Vector2d& position)
 {
-  boost::recursive_mutex::scoped_lock scopedLockForRawData(rawMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLockForRawData(rawMapMutex_);
   std::vector<BufferRegion> newRegions;
 
   if (rawMap_.move(position, newRegions)) {
     ROS_DEBUG("Elevation map has been moved to position (%f, %f).", rawMap_.getPosition().x(), rawMap_.getPosition().y());
-    if (hasUnderlyingMap_) rawMap_.addDataFrom(underlyingMap_, false, false, true);
+    for (const auto& region : newRegions) rawMapDirtyTiles_.markRegion(region.getStartIndex(), region.getSize());
+    if (parameters_.enableActiveTiles) rawMapActiveTiles_.unmarkEmptyTiles(rawMap_.get("elevation"));
+    touchRawMap();
+    if (hasUnderlyingMap_) {
+      rawMap_.addDataFrom(underlyingMap_, false, false, true);
+      rawMapActiveTiles_.markAll();
+      clampVariances();
+      rawMapDirtyTiles_.markAll();
+    }
   }
 }
 
 bool ElevationMap::publishRawElevationMap()
 {
   if (!hasRawMapSubscribers()) return false;
-  boost::recursive_mutex::scoped_lock scopedLock(rawMapMutex_);
-  grid_map::GridMap rawMapCopy = rawMap_;
+  boost::mutex::scoped_lock scopedLockForPublishing(rawMapPublishingMutex_);
+  boost::shared_lock<boost::shared_mutex> scopedLock(rawMapMutex_, boost::defer_lock);
+  ScopedTimer::lock(statistics_, PerformanceStatistics::Stage::RawMapLockWait, scopedLock);
+  ScopedTimer timer(statistics_, PerformanceStatistics::Stage::Serialization);
+  std::vector<std::string> sourceLayers;
+  const std::vector<std::string> layers = getPublishedLayers(getRawMapSnapshotLayers(), rawMap_.getBasicLayers(),
+                                                             parameters_.rawMapPublishedLayers,
+                                                             defaultRawMapPublishedLayers, sourceLayers);
+  const auto rawMapSnapshot = copyRawMapSnapshot(sourceLayers);
+  const TileMask updatedTiles = takeUnpublishedRawMapTiles();
   scopedLock.unlock();
-  rawMapCopy.erase("lowest_scan_point");
-  rawMapCopy.erase("sensor_x_at_lowest_scan");
-  rawMapCopy.erase("sensor_y_at_lowest_scan");
-  rawMapCopy.erase("sensor_z_at_lowest_scan");
-  rawMapCopy.add("standard_deviation", rawMapCopy.get("variance").array().sqrt().matrix());
-  rawMapCopy.add("horizontal_standard_deviation", (rawMapCopy.get("horizontal_variance_x") + rawMapCopy.get("horizontal_variance_y")).array().sqrt().matrix());
-  rawMapCopy.add("two_sigma_bound", rawMapCopy.get("elevation") + 2.0 * rawMapCopy.get("variance").array().sqrt().matrix());
-  grid_map_msgs::GridMap message;
-  GridMapRosConverter::toMessage(rawMapCopy, message);
-  elevationMapRawPublisher_.publish(message);
+  publishMap(*rawMapSnapshot, layers, updatedTiles, elevationMapRawPublisher_, elevationMapRawUpdatesPublisher_,
+             numberOfRawMapUpdates_);
   ROS_DEBUG("Elevation map raw has been published.");
   return true;
 }
@@ -505,32 +964,116 @@ bool ElevationMap::publishRawElevationMap()
 bool ElevationMap::publishFusedElevationMap()
 {
   if (!hasFusedMapSubscribers()) return false;
-  boost::recursive_mutex::scoped_lock scopedLock(fusedMapMutex_);
-  GridMap fusedMapCopy = fusedMap_;
+  boost::mutex::scoped_lock scopedLockForPublishing(fusedMapPublishingMutex_);
+  boost::shared_lock<boost::shared_mutex> scopedLock(fusedMapMutex_, boost::defer_lock);
+  ScopedTimer::lock(statistics_, PerformanceStatistics::Stage::FusedMapLockWait, scopedLock);
+  ScopedTimer timer(statistics_, PerformanceStatistics::Stage::Serialization);
+  std::vector<GridMap> pyramidCopy(fusedMapPyramidPublishers_.size());
+  for (size_t i = 0; i < fusedMapPyramidPublishers_.size(); ++i) {
+    if (fusedMapPyramidPublishers_[i].getNumSubscribers() > 0) copyFusedMapPyramidLevel(i + 1, pyramidCopy[i]);
+  }
+  const bool hasFusedMapSubscriber = elevationMapFusedPublisher_.getNumSubscribers() > 0
+      || elevationMapFusedUpdatesPublisher_.getNumSubscribers() > 0;
+  GridMap fusedMapCopy;
+  if (hasFusedMapSubscriber) fusedMapCopy = fusedMap_;
+  const TileMask updatedTiles(fusedMapUnpublishedTiles_);
+  fusedMapUnpublishedTiles_.reset();
   scopedLock.unlock();
-  fusedMapCopy.add("uncertainty_range", fusedMapCopy.get("upper_bound") - fusedMapCopy.get("lower_bound"));
-  grid_map_msgs::GridMap message;
-  GridMapRosConverter::toMessage(fusedMapCopy, message);
-  elevationMapFusedPublisher_.publish(message);
-  ROS_DEBUG("Elevation map (fused) has been published.");
+
+  if (hasFusedMapSubscriber) {
+    std::vector<std::string> sourceLayers;
+    const std::vector<std::string> layers = getPublishedLayers(fusedMapCopy, parameters_.fusedMapPublishedLayers,
+                                                               defaultFusedMapPublishedLayers, sourceLayers);
+    publishMap(fusedMapCopy, layers, updatedTiles, elevationMapFusedPublisher_, elevationMapFusedUpdatesPublisher_,
+               numberOfFusedMapUpdates_);
+    ROS_DEBUG("Elevation map (fused) has been published.");
+  }
+  for (size_t i = 0; i < pyramidCopy.size(); ++i) {
+    if (pyramidCopy[i].getLayers().empty()) continue;
+    grid_map_msgs::GridMap message;
+    GridMapRosConverter::toMessage(pyramidCopy[i], message);
+    fusedMapPyramidPublishers_[i].publish(message);
+    ROS_DEBUG("Level %zu of the fused elevation map pyramid has been published.", i + 1);
+  }
   return true;
 }
 
+TileMask ElevationMap::takeUnpublishedRawMapTiles()
+{
+  boost::mutex::scoped_lock scopedLock(rawMapTilesMutex_);
+  rawMapUnpublishedTiles_.merge(rawMapDirtyTiles_);
+  const TileMask updatedTiles(rawMapUnpublishedTiles_);
+  rawMapUnpublishedTiles_.reset();
+  return updatedTiles;
+}
+
+void ElevationMap::publishMap(const grid_map::GridMap& map, const std::vector<std::string>& layers, const TileMask& updatedTiles,
+                              const ros::Publisher& publisher, const ros::Publisher& updatesPublisher,
+                              unsigned int& numberOfUpdates) const
+{
+  if (publisher.getNumSubscribers() > 0) publishLayers(map, layers, publisher);
+
+  if (updatesPublisher.getNumSubscribers() > 0) {
+    const unsigned int keyframeInterval = parameters_.mapUpdatesKeyframeInterval;
+    const bool isKeyframe = keyframeInterval > 0 ? numberOfUpdates % keyframeInterval == 0 : numberOfUpdates == 0;
+    if (isKeyframe) {
+      publishLayers(map, layers, updatesPublisher);
+    } else {
+      std::vector<GridMap> submaps;
+      if (!getUpdatedSubmaps(map, updatedTiles, maxNumberOfUpdatedSubmaps, submaps)) return;
+      for (const auto& submap : submaps) publishLayers(submap, layers, updatesPublisher);
+    }
+    ++numberOfUpdates;
+  }
+}
+
+void ElevationMap::publishLayers(const grid_map::GridMap& map, const std::vector<std::string>& layers,
+                                 const ros::Publisher& publisher)
+{
+  grid_map_msgs::GridMap message;
+  const bool hasDerivedLayers = std::any_of(layers.begin(), layers.end(), [&](const std::string& layer) {
+    return isDerivedLayer(layer) && !map.exists(layer);
+  });
+  if (hasDerivedLayers) {
+    // Only copy the map if derived layers have to be added.
+    GridMap mapCopy = map;
+    addDerivedLayers(mapCopy, layers);
+    GridMapRosConverter::toMessage(mapCopy, layers, message);
+  } else {
+    GridMapRosConverter::toMessage(map, layers, message);
+  }
+  publisher.publish(message);
+}
+
+void ElevationMap::advertiseFusedMapPyramid(ros::NodeHandle nodeHandle)
+{
+  fusedMapPyramidPublishers_.clear();
+  for (unsigned int level = 1; level <= parameters_.fusedMapPyramidLevels; ++level) {
+    fusedMapPyramidPublishers_.push_back(
+        nodeHandle.advertise<grid_map_msgs::GridMap>("elevation_map_level_" + std::to_string(level), 1));
+  }
+}
+
 bool ElevationMap::publishVisibilityCleanupMap()
 {
   if (visbilityCleanupMapPublisher_.getNumSubscribers() < 1) return false;
-  boost::recursive_mutex::scoped_lock scopedLock(visibilityCleanupMapMutex_);
-  grid_map::GridMap visibilityCleanupMapCopy = visibilityCleanupMap_;
+  boost::mutex::scoped_lock scopedLock(visibilityCleanupMapMutex_);
+  if (!visibilityCleanupMap_ || visibilityCleanupMaxHeights_.empty()) return false;
+  // Only the published layers are copied from the snapshot of the raw map.
+  const GridMap& map = *visibilityCleanupMap_;
+  const std::vector<std::string> layers{"lowest_scan_point", "sensor_origin_at_lowest_scan"};
+  grid_map::GridMap visibilityCleanupMap(layers);
+  visibilityCleanupMap.setGeometry(map.getLength(), map.getResolution(), map.getPosition());
+  visibilityCleanupMap.setStartIndex(map.getStartIndex());
+  visibilityCleanupMap.setTimestamp(map.getTimestamp());
+  visibilityCleanupMap.setFrameId(map.getFrameId());
+  for (const auto& layer : layers) visibilityCleanupMap.get(layer) = map.get(layer);
+  visibilityCleanupMap.add("max_height", visibilityCleanupMaxHeights_[0].unaryExpr([](const float height) {
+    return std::isinf(height) ? NAN : height;
+  }));
   scopedLock.unlock();
-  visibilityCleanupMapCopy.erase("elevation");
-  visibilityCleanupMapCopy.erase("variance");
-  visibilityCleanupMapCopy.erase("horizontal_variance_x");
-  visibilityCleanupMapCopy.erase("horizontal_variance_y");
-  visibilityCleanupMapCopy.erase("horizontal_variance_xy");
-  visibilityCleanupMapCopy.erase("color");
-  visibilityCleanupMapCopy.erase("time");
   grid_map_msgs::GridMap message;
-  GridMapRosConverter::toMessage(visibilityCleanupMapCopy, message);
+  GridMapRosConverter::toMessage(visibilityCleanupMap, message);
   visbilityCleanupMapPublisher_.publish(message);
   ROS_DEBUG("Visibility cleanup map has been published.");
   return true;
@@ -541,22 +1084,210 @@ grid_map::GridMap& ElevationMap::getRawGridMap()
   return rawMap_;
 }
 
+float ElevationMap::addSensorOrigin(const grid_map::Position3& position)
+{
+  boost::unique_lock<boost::shared_mutex> scopedLock(rawMapMutex_);
+  return insertSensorOrigin(position);
+}
+
+float ElevationMap::insertSensorOrigin(const grid_map::Position3& position)
+{
+  // Usually all lowest scan points of a point cloud share the origin.
+  if (!sensorOrigins_.empty() && sensorOrigins_.back() == position) return sensorOrigins_.size() - 1;
+  // Without visibility cleanup, the table is only reset once it is full.
+  if (sensorOrigins_.size() >= maxNumberOfSensorOrigins) compactSensorOrigins();
+  if (sensorOrigins_.size() >= maxNumberOfSensorOrigins) {
+    // More origins than ids are still in use, start over.
+    ROS_WARN("Too many sensor origins of the lowest scan points, the lowest scan points are reset.");
+    sensorOrigins_.clear();
+    rawMap_.clear("lowest_scan_point");
+    rawMap_.clear("sensor_origin_at_lowest_scan");
+    touchRawMapLayers({"lowest_scan_point", "sensor_origin_at_lowest_scan"});
+  }
+  sensorOrigins_.push_back(position);
+  return sensorOrigins_.size() - 1;
+}
+
+void ElevationMap::compactSensorOrigins()
+{
+  // Most origins are not referenced anymore, as their lowest scan points have been replaced or have left the map.
+  Matrix& sensorOriginLayer = rawMap_.get("sensor_origin_at_lowest_scan");
+  std::vector<float> newIds(sensorOrigins_.size(), NAN);
+  std::vector<Position3> sensorOrigins;
+  for (Eigen::Index i = 0; i < sensorOriginLayer.size(); ++i) {
+    float& sensorOrigin = sensorOriginLayer(i);
+    if (!(sensorOrigin >= 0.0f && sensorOrigin < sensorOrigins_.size())) continue;
+    float& newId = newIds[static_cast<size_t>(sensorOrigin)];
+    if (std::isnan(newId)) {
+      newId = sensorOrigins.size();
+      sensorOrigins.push_back(sensorOrigins_[static_cast<size_t>(sensorOrigin)]);
+    }
+    sensorOrigin = newId;
+  }
+  ROS_DEBUG("Compacted the sensor origins of the lowest scan points from %zu to %zu.", sensorOrigins_.size(), sensorOrigins.size());
+  sensorOrigins_.swap(sensorOrigins);
+  touchRawMapLayers({"sensor_origin_at_lowest_scan"});
+}
+
+void ElevationMap::loadSensorOrigins(const grid_map::GridMap& map)
+{
+  // The cells of a loaded map store the coordinates of their sensor origins, which are registered again.
+  const Matrix& lowestScanPointLayer = map.get("lowest_scan_point");
+  const Matrix& sensorXLayer = map.get("sensor_x_at_lowest_scan");
+  const Matrix& sensorYLayer = map.get("sensor_y_at_lowest_scan");
+  const Matrix& sensorZLayer = map.get("sensor_z_at_lowest_scan");
+  Matrix& sensorOriginLayer = rawMap_.get("sensor_origin_at_lowest_scan");
+  std::map<std::array<float, 3>, float> ids;
+  for (Eigen::Index i = 0; i < lowestScanPointLayer.size(); ++i) {
+    if (std::isnan(lowestScanPointLayer(i))) continue;
+    const std::array<float, 3> sensorOrigin{{sensorXLayer(i), sensorYLayer(i), sensorZLayer(i)}};
+    auto id = ids.find(sensorOrigin);
+    if (id == ids.end()) {
+      id = ids.emplace(sensorOrigin, insertSensorOrigin(Position3(sensorOrigin[0], sensorOrigin[1], sensorOrigin[2]))).first;
+    }
+    sensorOriginLayer(i) = id->second;
+  }
+}
+
+std::shared_ptr<const grid_map::GridMap> ElevationMap::getRawMapSnapshot(const std::vector<std::string>& layers)
+{
+  boost::shared_lock<boost::shared_mutex> scopedLock(rawMapMutex_);
+  return copyRawMapSnapshot(layers);
+}
+
+std::shared_ptr<const grid_map::GridMap> ElevationMap::copyRawMapSnapshot(const std::vector<std::string>& layers)
+{
+  // Concurrent readers of the raw map take the snapshots of different layers in parallel.
+  boost::mutex::scoped_lock scopedLockForSnapshots(rawMapSnapshotsMutex_);
+  auto& snapshot = rawMapSnapshots_[layers];
+  scopedLockForSnapshots.unlock();
+  boost::mutex::scoped_lock scopedLockForSnapshot(snapshot.mutex);
+
+  if (snapshot.map) {
+    // Reuse the snapshot if none of its layers has changed since.
+    bool isUpToDate = true;
+    for (const auto& layer : layers) {
+      const auto layerVersion = rawMapLayerVersions_.find(getRawMapSourceLayer(rawMap_, layer));
+      if (layerVersion != rawMapLayerVersions_.end() && layerVersion->second > snapshot.version) {
+        isUpToDate = false;
+        break;
+      }
+    }
+    if (isUpToDate) return snapshot.map;
+  }
+
+  if (!snapshot.map || !isUnusedSnapshot(snapshot.map) || (snapshot.map->getSize() != rawMap_.getSize()).any()
+      || snapshot.map->getResolution() != rawMap_.getResolution()) {
+    // The old snapshot is still in use (or does not fit), create a new one.
+    snapshot.map = std::make_shared<GridMap>(layers);
+    snapshot.map->setGeometry(rawMap_.getLength(), rawMap_.getResolution(), rawMap_.getPosition());
+    snapshot.map->setBasicLayers(rawMap_.getBasicLayers());
+  }
+
+  // Copy the data (reuses the memory of the snapshot).
+  for (const auto& layer : layers) {
+    const auto sensorOriginLayer = std::find(sensorOriginLayers.begin(), sensorOriginLayers.end(), layer);
+    if (sensorOriginLayer == sensorOriginLayers.end()) {
+      if (rawMap_.exists(layer) || getCompactLayer(layer).empty()) {
+        snapshot.map->get(layer) = rawMap_.get(layer);
+      } else {
+        // The layer is decoded from its compact layer.
+        decodeCompactLayer(rawMap_, layer, compactTimeBase_, snapshot.map->get(layer));
+      }
+      continue;
+    }
+    // The coordinates of the sensor origins are looked up by the ids of the cells.
+    const size_t coordinate = sensorOriginLayer - sensorOriginLayers.begin();
+    snapshot.map->get(layer) = rawMap_.get("sensor_origin_at_lowest_scan").unaryExpr([&](const float sensorOrigin) {
+      return sensorOrigin >= 0.0f && sensorOrigin < sensorOrigins_.size()
+          ? static_cast<float>(sensorOrigins_[static_cast<size_t>(sensorOrigin)](coordinate)) : NAN;
+    });
+  }
+  snapshot.map->setPosition(rawMap_.getPosition());
+  snapshot.map->setStartIndex(rawMap_.getStartIndex());
+  snapshot.map->setTimestamp(rawMap_.getTimestamp());
+  snapshot.map->setFrameId(rawMap_.getFrameId());
+  snapshot.version = rawMapVersion_;
+  return snapshot.map;
+}
+
 grid_map::GridMap& ElevationMap::getFusedGridMap()
 {
   return fusedMap_;
 }
 
+bool ElevationMap::getFusedMapPyramidLevel(const unsigned int level, grid_map::GridMap& map)
+{
+  boost::shared_lock<boost::shared_mutex> scopedLock(fusedMapMutex_);
+  return copyFusedMapPyramidLevel(level, map);
+}
+
+bool ElevationMap::copyFusedMapPyramidLevel(const unsigned int level, grid_map::GridMap& map)
+{
+  if (level == 0) {
+    map = fusedMap_;
+    return true;
+  }
+  if (level > fusedMapPyramid_.size()) {
+    ROS_ERROR("Level %u of the fused elevation map pyramid does not exist (%zu levels).", level, fusedMapPyramid_.size());
+    return false;
+  }
+
+  // The levels are computed by the first reader after a change of the fused map.
+  boost::mutex::scoped_lock scopedLockForPyramid(fusedMapPyramidMutex_);
+  if (fusedMapPyramidVersions_[level - 1] != fusedMapVersion_) {
+    downsampleFusedMap(fusedMap_, 1 << level, fusedMapPyramid_[level - 1]);
+    fusedMapPyramidVersions_[level - 1] = fusedMapVersion_;
+  }
+  map = fusedMapPyramid_[level - 1];
+  return true;
+}
+
+std::shared_ptr<const ElevationMap::FusedMapSnapshot> ElevationMap::getFusedMapSnapshot()
+{
+  isFusedMapSnapshotRequested_ = true;
+  return std::atomic_load(&fusedMapSnapshot_);
+}
+
+bool ElevationMap::FusedMapSnapshot::isStale(const grid_map::Position& position, const grid_map::Length& length) const
+{
+  Index topLeftIndex;
+  Size size;
+
+  // These parameters are not used in this function.
+  Position submapPosition;
+  Length submapLength;
+  Index requestedIndexInSubmap;
+
+  if (!getSubmapInformation(topLeftIndex, size, submapPosition, submapLength, requestedIndexInSubmap, position, length,
+                            map.getLength(), map.getPosition(), map.getResolution(), map.getSize(), map.getStartIndex())) {
+    return false;
+  }
+  return staleTiles.isRegionMarked(topLeftIndex, size);
+}
+
 ros::Time ElevationMap::getTimeOfLastUpdate()
 {
+  boost::shared_lock<boost::shared_mutex> scopedLock(rawMapMutex_);
   return ros::Time().fromNSec(rawMap_.getTimestamp());
 }
 
 ros::Time ElevationMap::getTimeOfLastFusion()
 {
-  boost::recursive_mutex::scoped_lock scopedLock(fusedMapMutex_);
+  boost::shared_lock<boost::shared_mutex> scopedLock(fusedMapMutex_);
   return ros::Time().fromNSec(fusedMap_.getTimestamp());
 }
 
+ros::Time ElevationMap::getInitialTime()
+{
+  return initialTime_;
+}
+
+void ElevationMap::setInitialTime(const ros::Time& initialTime)
+{
+  initialTime_ = initialTime;
+}
+
 const kindr::HomTransformQuatD& ElevationMap::getPose()
 {
   return pose_;
@@ -570,36 +1301,274 @@ bool ElevationMap::getPosition3dInRobotParentFrame(const Eigen::Array2i& index,
   return true;
 }
 
-boost::recursive_mutex& ElevationMap::getFusedDataMutex()
+boost::shared_mutex& ElevationMap::getFusedDataMutex()
 {
   return fusedMapMutex_;
 }
 
-boost::recursive_mutex& ElevationMap::getRawDataMutex()
+boost::shared_mutex& ElevationMap::getRawDataMutex()
 {
   return rawMapMutex_;
 }
 
+void ElevationMap::touchRawMapLayers(const std::vector<std::string>& layers)
+{
+  ++rawMapVersion_;
+  for (const auto& layer : layers) rawMapLayerVersions_[getRawMapSourceLayer(rawMap_, layer)] = rawMapVersion_;
+}
+
+void ElevationMap::touchRawMap()
+{
+  touchRawMapLayers(rawMap_.getLayers());
+}
+
+std::vector<std::string> ElevationMap::getRawMapSnapshotLayers() const
+{
+  std::vector<std::string> layers = rawMap_.getLayers();
+  for (const auto& layer : persistentRawMapLayers) {
+    if (std::find(layers.begin(), layers.end(), layer) == layers.end()) layers.push_back(layer);
+  }
+  return layers;
+}
+
+void ElevationMap::resetCompactTimeBase()
+{
+  const auto time = rawMap_.get("time").array();
+  if (!time.isFinite().any()) return;
+  compactTimeBase_ = getCompactTimeBase(time.isFinite().select(time, -std::numeric_limits<float>::infinity()).maxCoeff());
+}
+
+void ElevationMap::updateCompactTimeBase(const float time)
+{
+  if (encodeCompactTime(time, compactTimeBase_) <= maxCompactTimeTick) return;
+  // The time base is moved ahead by half of the range, older times are stored as the new time base.
+  const int compactTimeBase = getCompactTimeBase(time);
+  rebaseCompactTime(rawMap_, compactTimeBase_, compactTimeBase);
+  compactTimeBase_ = compactTimeBase;
+  touchRawMapLayers({"time"});
+}
+
 bool ElevationMap::clean()
 {
-  boost::recursive_mutex::scoped_lock scopedLockForRawData(rawMapMutex_);
-  rawMap_.get("variance") = rawMap_.get("variance").unaryExpr(VarianceClampOperator<float>(minVariance_, maxVariance_));
-  rawMap_.get("horizontal_variance_x") = rawMap_.get("horizontal_variance_x").unaryExpr(VarianceClampOperator<float>(minHorizontalVariance_, maxHorizontalVariance_));
-  rawMap_.get("horizontal_variance_y") = rawMap_.get("horizontal_variance_y").unaryExpr(VarianceClampOperator<float>(minHorizontalVariance_, maxHorizontalVariance_));
+  boost::unique_lock<boost::shared_mutex> scopedLockForRawData(rawMapMutex_, boost::defer_lock);
+  ScopedTimer::lock(statistics_, PerformanceStatistics::Stage::RawMapLockWait, scopedLockForRawData);
+  ScopedTimer timer(statistics_, PerformanceStatistics::Stage::Clean);
+  clampVariances();
+  rawMapDirtyTiles_.markAll();
+  touchRawMapLayers({"variance", "horizontal_variance_x", "horizontal_variance_y"});
   return true;
 }
 
+void ElevationMap::clampVariances()
+{
+  const RawMapLayers layers(rawMap_, compactTimeBase_);
+  const CellVarianceClampOperator varianceClamp = getVarianceClampOperator();
+  rawMapActiveTiles_.forEachMarkedTile([&](const Index& startIndex, const Size& tileSize) {
+    for (int col = startIndex(1); col < startIndex(1) + tileSize(1); ++col) {
+      const size_t begin = layers.getLinearIndex(Index(startIndex(0), col));
+      for (size_t cell = begin; cell < begin + tileSize(0); ++cell) varianceClamp(layers, cell);
+    }
+  });
+}
+
+void ElevationMap::resetActiveTiles()
+{
+  rawMapActiveTiles_.setSize(rawMap_.getSize());
+  if (parameters_.enableActiveTiles) rawMapActiveTiles_.reset();
+}
+
+CellVarianceClampOperator ElevationMap::getVarianceClampOperator() const
+{
+  return CellVarianceClampOperator(parameters_.minVariance, parameters_.maxVariance, parameters_.minHorizontalVariance, parameters_.maxHorizontalVariance);
+}
+
 void ElevationMap::resetFusedData()
 {
-  boost::recursive_mutex::scoped_lock scopedLockForFusedData(fusedMapMutex_);
   fusedMap_.clearAll();
   fusedMap_.resetTimestamp();
+  fusedMapUnpublishedTiles_.markAll();
+  fusedMapStaleTiles_.markAll();
+  touchFusedMap();
+}
+
+void ElevationMap::touchFusedMap()
+{
+  ++fusedMapVersion_;
+}
+
+void ElevationMap::updateFusedMapSnapshot()
+{
+  // Reuse the previous snapshot if no caller holds it anymore (it cannot be requested anymore).
+  std::shared_ptr<FusedMapSnapshot> snapshot;
+  snapshot.swap(previousFusedMapSnapshot_);
+  if (!snapshot || !isUnusedSnapshot(snapshot) || (snapshot->map.getSize() != fusedMap_.getSize()).any()
+      || snapshot->map.getResolution() != fusedMap_.getResolution()) {
+    snapshot.reset(new FusedMapSnapshot{GridMap({"elevation", "upper_bound", "lower_bound"}), fusedMapStaleTiles_, ros::WallTime()});
+    snapshot->map.setGeometry(fusedMap_.getLength(), fusedMap_.getResolution(), fusedMap_.getPosition());
+    snapshot->map.setBasicLayers(fusedMap_.getBasicLayers());
+  }
+
+  for (const auto& layer : snapshot->map.getLayers()) snapshot->map.get(layer) = fusedMap_.get(layer);
+  snapshot->map.setPosition(fusedMap_.getPosition());
+  snapshot->map.setStartIndex(fusedMap_.getStartIndex());
+  snapshot->map.setTimestamp(fusedMap_.getTimestamp());
+  snapshot->map.setFrameId(fusedMap_.getFrameId());
+  snapshot->staleTiles.setSize(fusedMap_.getSize());
+  snapshot->staleTiles.reset();
+  snapshot->staleTiles.merge(fusedMapStaleTiles_);
+  snapshot->time = ros::WallTime::now();
+
+  const auto previousSnapshot = std::atomic_exchange(&fusedMapSnapshot_, std::shared_ptr<const FusedMapSnapshot>(snapshot));
+  previousFusedMapSnapshot_ = std::const_pointer_cast<FusedMapSnapshot>(previousSnapshot);
+}
+
+void ElevationMap::downsampleFusedMap(const grid_map::GridMap& fusedMap, const int factor, grid_map::GridMap& downsampledMap)
+{
+  // The cell with index (0, 0) is at the corner with the largest coordinates. The corner of the
+  // downsampled map is the next multiple of the downsampled resolution, such that its cells do
+  // not depend on the (moving) position of the fused map.
+  const double resolution = fusedMap.getResolution();
+  const Size& size = fusedMap.getSize();
+  const Eigen::Array2d corner = (fusedMap.getPosition().array() + 0.5 * fusedMap.getLength()) / resolution;
+  Index offset;
+  for (int i = 0; i < 2; ++i) {
+    const long cornerIndex = std::lround(corner(i));
+    offset(i) = static_cast<int>(((-cornerIndex) % factor + factor) % factor);
+  }
+  const Size downsampledSize = (size + offset + factor - 1) / factor;
+  const Length downsampledLength = downsampledSize.cast<double>() * factor * resolution;
+  const Position downsampledPosition = (corner + offset.cast<double>()).matrix() * resolution - 0.5 * downsampledLength.matrix();
+
+  if (!downsampledMap.exists("elevation") || (downsampledMap.getSize() != downsampledSize).any()
+      || downsampledMap.getResolution() != factor * resolution) {
+    downsampledMap = GridMap({"elevation", "upper_bound", "lower_bound"});
+    downsampledMap.setBasicLayers({"elevation", "upper_bound", "lower_bound"});
+    downsampledMap.setGeometry(downsampledLength, factor * resolution, downsampledPosition);
+  } else {
+    downsampledMap.setPosition(downsampledPosition);
+  }
+  downsampledMap.setFrameId(fusedMap.getFrameId());
+  downsampledMap.setTimestamp(fusedMap.getTimestamp());
+
+  const float infinity = std::numeric_limits<float>::infinity();
+  Matrix& elevation = downsampledMap.get("elevation");
+  Matrix& upperBound = downsampledMap.get("upper_bound");
+  Matrix& lowerBound = downsampledMap.get("lower_bound");
+  elevation.setZero();
+  upperBound.setConstant(-infinity);
+  lowerBound.setConstant(infinity);
+  Eigen::MatrixXi numberOfCells = Eigen::MatrixXi::Zero(downsampledSize(0), downsampledSize(1));
+
+  const Matrix& fusedElevation = fusedMap.get("elevation");
+  const Matrix& fusedUpperBound = fusedMap.get("upper_bound");
+  const Matrix& fusedLowerBound = fusedMap.get("lower_bound");
+  const Index& startIndex = fusedMap.getStartIndex();
+  for (int col = 0; col < size(1); ++col) {
+    const int bufferCol = (col + startIndex(1)) % size(1);
+    const int downsampledCol = (col + offset(1)) / factor;
+    for (int row = 0; row < size(0); ++row) {
+      const int bufferRow = (row + startIndex(0)) % size(0);
+      const float height = fusedElevation(bufferRow, bufferCol);
+      if (std::isnan(height)) continue;
+      const int downsampledRow = (row + offset(0)) / factor;
+      elevation(downsampledRow, downsampledCol) += height;
+      ++numberOfCells(downsampledRow, downsampledCol);
+      // The bounds are conservative, NaN bounds are ignored.
+      upperBound(downsampledRow, downsampledCol) = std::fmax(upperBound(downsampledRow, downsampledCol), fusedUpperBound(bufferRow, bufferCol));
+      lowerBound(downsampledRow, downsampledCol) = std::fmin(lowerBound(downsampledRow, downsampledCol), fusedLowerBound(bufferRow, bufferCol));
+    }
+  }
+
+  for (int i = 0; i < elevation.size(); ++i) {
+    if (numberOfCells(i) == 0) {
+      elevation(i) = upperBound(i) = lowerBound(i) = NAN;
+      continue;
+    }
+    elevation(i) /= numberOfCells(i);
+    if (std::isinf(upperBound(i))) upperBound(i) = NAN;
+    if (std::isinf(lowerBound(i))) lowerBound(i) = NAN;
+  }
+}
+
+void ElevationMap::invalidateFusedData(TileMask& dirtyTiles, const double maxEllipseRadius)
+{
+  if (!dirtyTiles.isAnyMarked()) return;
+
+  const double radius = std::ceil(maxEllipseRadius / fusedMap_.getResolution()) + 1.0;
+  if (!(radius < fusedMap_.getSize().maxCoeff())) {
+    resetFusedData();
+    return;
+  }
+
+  dirtyTiles.dilate(static_cast<unsigned int>(radius));
+  const Size& numberOfTiles = dirtyTiles.getNumberOfTiles();
+  for (int tileCol = 0; tileCol < numberOfTiles(1); ++tileCol) {
+    for (int tileRow = 0; tileRow < numberOfTiles(0); ++tileRow) {
+      const Index tileIndex(tileRow, tileCol);
+      if (!dirtyTiles.isMarked(tileIndex)) continue;
+      Index startIndex;
+      Size tileSize;
+      dirtyTiles.getTileRegion(tileIndex, startIndex, tileSize);
+      for (const auto& layer : fusedMap_.getLayers()) {
+        fusedMap_.get(layer).block(startIndex(0), startIndex(1), tileSize(0), tileSize(1)).setConstant(NAN);
+      }
+      // The stale tiles are smaller than the dirty tiles.
+      fusedMapStaleTiles_.markRegion(startIndex, tileSize);
+    }
+  }
+  fusedMapUnpublishedTiles_.merge(dirtyTiles);
+}
+
+float ElevationMap::updateMaxHorizontalVariance(const grid_map::GridMap& rawMap, const TileMask& dirtyTiles)
+{
+  // All tiles are recomputed if the bounds are out-dated.
+  const Size& numberOfTiles = dirtyTiles.getNumberOfTiles();
+  const bool isUpdateOfAllTiles = tileMaxHorizontalVariances_.rows() != numberOfTiles(0)
+      || tileMaxHorizontalVariances_.cols() != numberOfTiles(1);
+  if (isUpdateOfAllTiles) tileMaxHorizontalVariances_.resize(numberOfTiles(0), numberOfTiles(1));
+
+  const float infinity = std::numeric_limits<float>::infinity();
+  Eigen::ArrayXXf varianceX, varianceY, varianceXY;
+  for (int tileCol = 0; tileCol < numberOfTiles(1); ++tileCol) {
+    for (int tileRow = 0; tileRow < numberOfTiles(0); ++tileRow) {
+      const Index tileIndex(tileRow, tileCol);
+      if (!isUpdateOfAllTiles && !dirtyTiles.isMarked(tileIndex)) continue;
+      Index startIndex;
+      Size size;
+      dirtyTiles.getTileRegion(tileIndex, startIndex, size);
+      const auto block = [&](const std::string& layer) {
+        return rawMap.get(layer).block(startIndex(0), startIndex(1), size(0), size(1)).array();
+      };
+      getHorizontalVariances(rawMap, startIndex, size, varianceX, varianceY, varianceXY);
+      const Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> isValid =
+          block("elevation").abs() < infinity && block("variance").abs() < infinity;
+
+      // Upper bound for the absolute eigenvalues of the horizontal covariance matrix.
+      const Eigen::ArrayXXf maxEigenvalue = 0.5 * (varianceX + varianceY).abs()
+          + (0.25 * (varianceX - varianceY).square() + varianceXY.square()).sqrt();
+      float& tileMaxHorizontalVariance = tileMaxHorizontalVariances_(tileRow, tileCol);
+      if ((isValid && !(maxEigenvalue < infinity)).any()) {
+        tileMaxHorizontalVariance = infinity;
+      } else {
+        tileMaxHorizontalVariance = isValid.select(maxEigenvalue, 0.0f).maxCoeff();
+      }
+    }
+  }
+  return tileMaxHorizontalVariances_.size() == 0 ? 0.0f : tileMaxHorizontalVariances_.maxCoeff();
 }
 
 void ElevationMap::setFrameId(const std::string& frameId)
 {
+  boost::unique_lock<boost::shared_mutex> scopedLockForFusedData(fusedMapMutex_);
+  boost::unique_lock<boost::shared_mutex> scopedLockForRawData(rawMapMutex_);
   rawMap_.setFrameId(frameId);
   fusedMap_.setFrameId(frameId);
+  touchFusedMap();
+}
+
+void ElevationMap::setPerformanceStatistics(PerformanceStatistics* statistics)
+{
+  statistics_ = statistics;
 }
 
 const std::string& ElevationMap::getFrameId()
@@ -609,41 +1578,48 @@ const std::string& ElevationMap::getFrameId()
 
 bool ElevationMap::hasRawMapSubscribers() const
 {
-  if (elevationMapRawPublisher_.getNumSubscribers() < 1) return false;
-  return true;
+  return elevationMapRawPublisher_.getNumSubscribers() > 0 || elevationMapRawUpdatesPublisher_.getNumSubscribers() > 0;
 }
 
 bool ElevationMap::hasFusedMapSubscribers() const
 {
-  if (elevationMapFusedPublisher_.getNumSubscribers() < 1) return false;
-  return true;
+  if (elevationMapFusedPublisher_.getNumSubscribers() > 0) return true;
+  if (elevationMapFusedUpdatesPublisher_.getNumSubscribers() > 0) return true;
+  for (const auto& publisher : fusedMapPyramidPublishers_) {
+    if (publisher.getNumSubscribers() > 0) return true;
+  }
+  return false;
 }
 
 void ElevationMap::underlyingMapCallback(const grid_map_msgs::GridMap& underlyingMap)
 {
   ROS_INFO("Updating underlying map.");
-  GridMapRosConverter::fromMessage(underlyingMap, underlyingMap_);
-  if (underlyingMap_.getFrameId() != rawMap_.getFrameId()) {
-    ROS_ERROR_STREAM("The underlying map does not have the same map frame ('" <<underlyingMap_.getFrameId()
+  // The underlying map is used by move(), it is only replaced with the raw map locked.
+  GridMap map;
+  GridMapRosConverter::fromMessage(underlyingMap, map);
+  boost::unique_lock<boost::shared_mutex> scopedLockForRawData(rawMapMutex_);
+  if (map.getFrameId() != rawMap_.getFrameId()) {
+    ROS_ERROR_STREAM("The underlying map does not have the same map frame ('" << map.getFrameId()
                      << "') as the elevation map ('" << rawMap_.getFrameId() << "').");
     return;
   }
-  if (!underlyingMap_.exists("elevation")) {
+  if (!map.exists("elevation")) {
     ROS_ERROR_STREAM("The underlying map does not have an 'elevation' layer.");
     return;
   }
-  if (!underlyingMap_.exists("variance")) underlyingMap_.add("variance", minVariance_);
-  if (!underlyingMap_.exists("horizontal_variance_x")) underlyingMap_.add("horizontal_variance_x", minHorizontalVariance_);
-  if (!underlyingMap_.exists("horizontal_variance_y")) underlyingMap_.add("horizontal_variance_y", minHorizontalVariance_);
-  if (!underlyingMap_.exists("color")) underlyingMap_.add("color", 0.0);
-  underlyingMap_.setBasicLayers(rawMap_.getBasicLayers());
+  if (!map.exists("variance")) map.add("variance", parameters_.minVariance);
+  if (!map.exists("horizontal_variance_x")) map.add("horizontal_variance_x", parameters_.minHorizontalVariance);
+  if (!map.exists("horizontal_variance_y")) map.add("horizontal_variance_y", parameters_.minHorizontalVariance);
+  if (!map.exists("color")) map.add("color", 0.0);
+  map.setBasicLayers(rawMap_.getBasicLayers());
+  if (parameters_.enableCompactLayers) packCompactLayers(map, compactTimeBase_);
+  underlyingMap_ = map;
   hasUnderlyingMap_ = true;
   rawMap_.addDataFrom(underlyingMap_, false, false, true);
-}
-
-float ElevationMap::cumulativeDistributionFunction(float x, float mean, float standardDeviation)
-{
-  return 0.5 * erfc(-(x - mean) / (standardDeviation * sqrt(2.0)));
+  rawMapActiveTiles_.markAll();
+  clampVariances();
+  rawMapDirtyTiles_.markAll();
+  touchRawMap();
 }
 
 } /* namespace */
@@ -9,6 +9,7 @@
 
 // Elevation Mapping
 #include "elevation_mapping/ElevationMap.hpp"
+#include "elevation_mapping/MapFile.hpp"
 #include "elevation_mapping/sensor_processors/StructuredLightSensorProcessor.hpp"
 #include "elevation_mapping/sensor_processors/StereoSensorProcessor.hpp"
 #include "elevation_mapping/sensor_processors/LaserSensorProcessor.hpp"
@@ -24,7 +25,9 @@
 #include <pcl/point_types.h>
 #include <pcl/PCLPointCloud2.h>
 #include <pcl_conversions/pcl_conversions.h>
-#include <pcl/filters/voxel_grid.h>
+
+// ROS
+#include <diagnostic_msgs/DiagnosticArray.h>
 
 // Kindr
 #include <kindr/Core>
@@ -32,12 +35,16 @@
 
 // Boost
 #include <boost/bind.hpp>
-#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
 
 // STL
+#include <algorithm>
+#include <cstdio>
 #include <string>
 #include <math.h>
 #include <limits>
+#include <utility>
 
 using namespace std;
 using namespace grid_map;
@@ -49,25 +56,49 @@ using namespace kindr_ros;
 
 namespace elevation_mapping {
 
-ElevationMapping::ElevationMapping(ros::NodeHandle& nodeHandle)
+ElevationMapping::ElevationMapping(ros::NodeHandle& nodeHandle, const bool isOffline)
     : nodeHandle_(nodeHandle),
+      isOffline_(isOffline),
+      transformer_(isOffline ? new tf::Transformer() : new tf::TransformListener()),
       map_(nodeHandle),
-      robotMotionMapUpdater_(nodeHandle),
+      enableDirectPointCloudIngestion_(true),
+      enablePipelinedProcessing_(false),
+      pointCloudQueueSize_(1),
+      pointCloudQueuePolicy_(QueueDropPolicy::DropOldest),
+      enableRobotPoseInterpolation_(false),
       isContinouslyFusing_(false),
-      ignoreRobotMotionUpdates_(false)
+      ignoreRobotMotionUpdates_(false),
+      isSavingMap_(false)
 {
   ROS_INFO("Elevation mapping node started.");
 
   readParameters();
-  pointCloudSubscriber_ = nodeHandle_.subscribe(pointCloudTopic_, 1, &ElevationMapping::pointCloudCallback, this);
+  map_.setPerformanceStatistics(&statistics_);
   if (!robotPoseTopic_.empty()) {
-    robotPoseSubscriber_.subscribe(nodeHandle_, robotPoseTopic_, 1);
-    robotPoseCache_.connectInput(robotPoseSubscriber_);
-    robotPoseCache_.setCacheSize(robotPoseCacheSize_);
+    robotPoseHistory_.setCapacity(robotPoseCacheSize_);
   } else {
     ignoreRobotMotionUpdates_ = true;
   }
 
+  if (isOffline) {
+    // The transformations are added before the point clouds are processed, such that the lookups do not wait.
+    transformer_->getTF2BufferPtr()->setUsingDedicatedThread(true);
+    // The time of the map starts with the first point cloud (or the loaded map), not the wall clock.
+    map_.setInitialTime(ros::Time());
+    if (!initialMapFile_.empty()) loadMapFromFile(initialMapFile_);
+    return;
+  }
+
+  for (size_t i = 0; i < sensorInputs_.size(); ++i) {
+    sensorInputs_[i]->pointCloudSubscriber = nodeHandle_.subscribe<sensor_msgs::PointCloud2>(
+        sensorInputs_[i]->pointCloudTopic, 1, boost::bind(&ElevationMapping::pointCloudCallback, this, _1, i));
+  }
+  if (!robotPoseTopic_.empty()) {
+    robotPoseSubscriber_ = nodeHandle_.subscribe(robotPoseTopic_, 1, &ElevationMapping::robotPoseCallback, this);
+  }
+  // The static transformations are latched, such that all of them are received after subscribing.
+  staticTransformSubscriber_ = nodeHandle_.subscribe("/tf_static", 100, &ElevationMapping::staticTransformCallback, this);
+
   mapUpdateTimer_ = nodeHandle_.createTimer(maxNoUpdateDuration_, &ElevationMapping::mapUpdateTimerCallback, this, true, false);
 
   // Multi-threading for fusion.
@@ -81,6 +112,21 @@ ElevationMapping::ElevationMapping(ros::NodeHandle& nodeHandle)
       &fusionServiceQueue_);
   submapService_ = nodeHandle_.advertiseService(advertiseServiceOptionsForGetSubmap);
 
+  // Multi-threading for the map queries, which do not wait for the fusion.
+  AdvertiseServiceOptions advertiseServiceOptionsForQueryMap = AdvertiseServiceOptions::create<QueryMap>(
+      "query_map", boost::bind(&ElevationMapping::queryMap, this, _1, _2), ros::VoidConstPtr(),
+      &queryServiceQueue_);
+  queryMapService_ = nodeHandle_.advertiseService(advertiseServiceOptionsForQueryMap);
+
+  map_.advertiseFusedMapPyramid(nodeHandle_);
+  for (unsigned int level = 1; level <= map_.getParameters().fusedMapPyramidLevels; ++level) {
+    AdvertiseServiceOptions advertiseServiceOptionsForGetPyramidSubmap = AdvertiseServiceOptions::create<grid_map_msgs::GetGridMap>(
+        "get_submap_level_" + std::to_string(level),
+        boost::bind(&ElevationMapping::getSubmapOfPyramidLevel, this, _1, _2, level), ros::VoidConstPtr(),
+        &fusionServiceQueue_);
+    pyramidSubmapServices_.push_back(nodeHandle_.advertiseService(advertiseServiceOptionsForGetPyramidSubmap));
+  }
+
   if (!fusedMapPublishTimerDuration_.isZero()) {
     TimerOptions timerOptions = TimerOptions(
         fusedMapPublishTimerDuration_,
@@ -90,7 +136,7 @@ ElevationMapping::ElevationMapping(ros::NodeHandle& nodeHandle)
   }
 
   // Multi-threading for visibility cleanup.
-  if (map_.enableVisibilityCleanup_ && !visibilityCleanupTimerDuration_.isZero()){
+  if (map_.getParameters().enableVisibilityCleanup && !visibilityCleanupTimerDuration_.isZero()){
     TimerOptions timerOptions = TimerOptions(
         visibilityCleanupTimerDuration_,
         boost::bind(&ElevationMapping::visibilityCleanupCallback, this, _1), &visibilityCleanupQueue_,
@@ -100,23 +146,60 @@ ElevationMapping::ElevationMapping(ros::NodeHandle& nodeHandle)
 
   clearMapService_ = nodeHandle_.advertiseService("clear_map", &ElevationMapping::clearMap, this);
   saveMapService_ = nodeHandle_.advertiseService("save_map", &ElevationMapping::saveMap, this);
+  saveBinaryMapService_ = nodeHandle_.advertiseService("save_binary_map", &ElevationMapping::saveBinaryMap, this);
+  loadMapService_ = nodeHandle_.advertiseService("load_map", &ElevationMapping::loadMap, this);
+  statisticsService_ = nodeHandle_.advertiseService("get_statistics", &ElevationMapping::getStatistics, this);
 
+  if (!statisticsPublishTimerDuration_.isZero()) {
+    statisticsPublisher_ = nodeHandle_.advertise<diagnostic_msgs::DiagnosticArray>("statistics", 1);
+    statisticsPublishTimer_ = nodeHandle_.createTimer(statisticsPublishTimerDuration_, &ElevationMapping::publishStatisticsCallback, this);
+  }
+
+  if (!initialMapFile_.empty()) loadMapFromFile(initialMapFile_);
   initialize();
 }
 
 ElevationMapping::~ElevationMapping()
 {
+  for (auto& sensorInput : sensorInputs_) sensorInput->receivedPointCloudQueue.stop();
+  processedPointCloudQueue_.stop();
+  for (auto& sensorInput : sensorInputs_) sensorInput->processingThread.join();
+  pointCloudIntegrationThread_.join();
   fusionServiceQueue_.clear();
   fusionServiceQueue_.disable();
+  queryServiceQueue_.clear();
+  queryServiceQueue_.disable();
+  if (queryServiceSpinner_) queryServiceSpinner_->stop();
   nodeHandle_.shutdown();
   fusionServiceThread_.join();
+  mapSavingThread_.join();
 }
 
 bool ElevationMapping::readParameters()
 {
   // ElevationMapping parameters.
-  nodeHandle_.param("point_cloud_topic", pointCloudTopic_, string("/points"));
   nodeHandle_.param("robot_pose_with_covariance_topic", robotPoseTopic_, string("/pose"));
+  nodeHandle_.param("enable_direct_point_cloud_ingestion", enableDirectPointCloudIngestion_, true);
+  nodeHandle_.param("enable_pipelined_processing", enablePipelinedProcessing_, false);
+  int pointCloudQueueSize;
+  nodeHandle_.param("point_cloud_queue_size", pointCloudQueueSize, 1);
+  if (pointCloudQueueSize < 1) {
+    ROS_ERROR("The point cloud queue size must be at least 1.");
+    return false;
+  }
+  string pointCloudQueuePolicy;
+  nodeHandle_.param("point_cloud_queue_policy", pointCloudQueuePolicy, string("drop_oldest"));
+  pointCloudQueueSize_ = pointCloudQueueSize;
+  if (pointCloudQueuePolicy == "drop_oldest") {
+    pointCloudQueuePolicy_ = QueueDropPolicy::DropOldest;
+  } else if (pointCloudQueuePolicy == "drop_newest") {
+    pointCloudQueuePolicy_ = QueueDropPolicy::DropNewest;
+  } else if (pointCloudQueuePolicy == "coalesce") {
+    pointCloudQueuePolicy_ = QueueDropPolicy::Coalesce;
+  } else {
+    ROS_ERROR("The point cloud queue policy %s is not available.", pointCloudQueuePolicy.c_str());
+    return false;
+  }
   nodeHandle_.param("track_point_frame_id", trackPointFrameId_, string("/robot"));
   nodeHandle_.param("track_point_x", trackPoint_.x(), 0.0);
   nodeHandle_.param("track_point_y", trackPoint_.y(), 0.0);
@@ -124,6 +207,7 @@ bool ElevationMapping::readParameters()
 
   nodeHandle_.param("robot_pose_cache_size", robotPoseCacheSize_, 200);
   ROS_ASSERT(robotPoseCacheSize_ >= 0);
+  nodeHandle_.param("enable_robot_pose_interpolation", enableRobotPoseInterpolation_, false);
 
   double minUpdateRate;
   nodeHandle_.param("min_update_rate", minUpdateRate, 2.0);
@@ -146,6 +230,21 @@ bool ElevationMapping::readParameters()
     fusedMapPublishTimerDuration_.fromSec(1.0 / fusedMapPublishingRate);
   }
 
+  nodeHandle_.param("query_service_threads", queryServiceThreads_, 2);
+  ROS_ASSERT(queryServiceThreads_ >= 1);
+  nodeHandle_.param("fused_map_snapshot_max_age", fusedMapSnapshotMaxAge_, 1.0);
+  nodeHandle_.param("initial_map_file", initialMapFile_, string(""));
+  nodeHandle_.param("map_file_compression", isMapFileCompressed_, true);
+
+  double statisticsPublishingRate;
+  nodeHandle_.param("statistics_publishing_rate", statisticsPublishingRate, 0.2);
+  if (statisticsPublishingRate > 0.0) {
+    statisticsPublishTimerDuration_.fromSec(1.0 / statisticsPublishingRate);
+  } else {
+    statisticsPublishTimerDuration_.fromSec(0.0);
+  }
+
+  ElevationMap::Parameters mapParameters;
   double visibilityCleanupRate;
   nodeHandle_.param("visibility_cleanup_rate", visibilityCleanupRate, 1.0);
   if (visibilityCleanupRate == 0.0) {
@@ -154,7 +253,7 @@ bool ElevationMapping::readParameters()
   }
   else {
     visibilityCleanupTimerDuration_.fromSec(1.0 / visibilityCleanupRate);
-    map_.visibilityCleanupDuration_ = 1.0 / visibilityCleanupRate;
+    mapParameters.visibilityCleanupDuration = 1.0 / visibilityCleanupRate;
   }
 
 
@@ -173,33 +272,118 @@ bool ElevationMapping::readParameters()
   nodeHandle_.param("resolution", resolution, 0.01);
   map_.setGeometry(length, resolution, position);
 
-  nodeHandle_.param("min_variance", map_.minVariance_, pow(0.003, 2));
-  nodeHandle_.param("max_variance", map_.maxVariance_, pow(0.03, 2));
-  nodeHandle_.param("mahalanobis_distance_threshold", map_.mahalanobisDistanceThreshold_, 2.5);
-  nodeHandle_.param("multi_height_noise", map_.multiHeightNoise_, pow(0.003, 2));
-  nodeHandle_.param("min_horizontal_variance", map_.minHorizontalVariance_, pow(resolution / 2.0, 2)); // two-sigma
-  nodeHandle_.param("max_horizontal_variance", map_.maxHorizontalVariance_, 0.5);
+  nodeHandle_.param("min_variance", mapParameters.minVariance, pow(0.003, 2));
+  nodeHandle_.param("max_variance", mapParameters.maxVariance, pow(0.03, 2));
+  nodeHandle_.param("mahalanobis_distance_threshold", mapParameters.mahalanobisDistanceThreshold, 2.5);
+  nodeHandle_.param("multi_height_noise", mapParameters.multiHeightNoise, pow(0.003, 2));
+  nodeHandle_.param("min_horizontal_variance", mapParameters.minHorizontalVariance, pow(resolution / 2.0, 2)); // two-sigma
+  nodeHandle_.param("max_horizontal_variance", mapParameters.maxHorizontalVariance, 0.5);
   nodeHandle_.param("underlying_map_topic", map_.underlyingMapTopic_, string());
-  nodeHandle_.param("enable_visibility_cleanup", map_.enableVisibilityCleanup_, true);
-  nodeHandle_.param("scanning_duration", map_.scanningDuration_, 1.0);
+  nodeHandle_.param("enable_visibility_cleanup", mapParameters.enableVisibilityCleanup, true);
+  nodeHandle_.param("scanning_duration", mapParameters.scanningDuration, 1.0);
+  nodeHandle_.param("enable_fast_add", mapParameters.enableFastAdd, true);
+  nodeHandle_.param("enable_incremental_fusion", mapParameters.enableIncrementalFusion, true);
+  nodeHandle_.param("enable_active_tiles", mapParameters.enableActiveTiles, true);
+  nodeHandle_.param("enable_compact_layers", mapParameters.enableCompactLayers, false);
+  int addThreads;
+  nodeHandle_.param("add_threads", addThreads, 1);
+  ROS_ASSERT(addThreads >= 0);
+  mapParameters.addThreads = addThreads;
+  int fusionThreads;
+  nodeHandle_.param("fusion_threads", fusionThreads, 1);
+  ROS_ASSERT(fusionThreads >= 0);
+  mapParameters.fusionThreads = fusionThreads;
+  int visibilityCleanupThreads;
+  nodeHandle_.param("visibility_cleanup_threads", visibilityCleanupThreads, 1);
+  ROS_ASSERT(visibilityCleanupThreads >= 0);
+  mapParameters.visibilityCleanupThreads = visibilityCleanupThreads;
+  int fusedMapPyramidLevels;
+  nodeHandle_.param("fused_map_pyramid_levels", fusedMapPyramidLevels, 0);
+  ROS_ASSERT(fusedMapPyramidLevels >= 0 && fusedMapPyramidLevels <= 8);
+  mapParameters.fusedMapPyramidLevels = fusedMapPyramidLevels;
+  nodeHandle_.param("raw_map_published_layers", mapParameters.rawMapPublishedLayers, vector<string>());
+  nodeHandle_.param("fused_map_published_layers", mapParameters.fusedMapPublishedLayers, vector<string>());
+  int mapUpdatesKeyframeInterval;
+  nodeHandle_.param("map_updates_keyframe_interval", mapUpdatesKeyframeInterval, 10);
+  ROS_ASSERT(mapUpdatesKeyframeInterval >= 0);
+  mapParameters.mapUpdatesKeyframeInterval = mapUpdatesKeyframeInterval;
+  string cellAggregation;
+  nodeHandle_.param("cell_aggregation", cellAggregation, string("none"));
+  if (cellAggregation == "none") {
+    mapParameters.cellAggregation = ElevationMap::CellAggregation::None;
+  } else if (cellAggregation == "inverse_variance") {
+    mapParameters.cellAggregation = ElevationMap::CellAggregation::InverseVariance;
+  } else if (cellAggregation == "min_max") {
+    mapParameters.cellAggregation = ElevationMap::CellAggregation::MinMax;
+  } else {
+    ROS_ERROR("The cell aggregation %s is not available.", cellAggregation.c_str());
+    return false;
+  }
+  if (mapParameters.cellAggregation != ElevationMap::CellAggregation::None && !mapParameters.enableFastAdd) {
+    ROS_WARN("The cell aggregation is only applied with the fast add (enable_fast_add).");
+  }
+  map_.setParameters(mapParameters);
+
+  // Sensor inputs, either a list in the namespace 'inputs' or a single input in the node namespace.
+  if (nodeHandle_.hasParam("inputs")) {
+    XmlRpc::XmlRpcValue inputs;
+    nodeHandle_.getParam("inputs", inputs);
+    if (inputs.getType() != XmlRpc::XmlRpcValue::TypeStruct || inputs.size() == 0) {
+      ROS_ERROR("The parameter inputs must be a non-empty dictionary of sensor inputs.");
+      return false;
+    }
+    for (XmlRpc::XmlRpcValue::iterator input = inputs.begin(); input != inputs.end(); ++input) {
+      ros::NodeHandle inputNodeHandle(nodeHandle_, "inputs/" + input->first);
+      if (!addSensorInput(input->first, inputNodeHandle)) return false;
+    }
+  } else {
+    if (!addSensorInput(string(), nodeHandle_)) return false;
+  }
+  processedPointCloudQueue_.configure(pointCloudQueueSize_ * sensorInputs_.size(), pointCloudQueuePolicy_,
+                                      &ElevationMapping::coalescePointClouds);
+  // The point clouds of the sensors are integrated in the order of their time stamps.
+  processedPointCloudQueue_.setOrder([](const ProcessedPointCloud& pointCloud, const ProcessedPointCloud& otherPointCloud) {
+    return pointCloud.timeStamp < otherPointCloud.timeStamp;
+  });
+
+  if (!robotMotionMapUpdater_.readParameters(nodeHandle_)) return false;
+
+  return true;
+}
+
+bool ElevationMapping::addSensorInput(const std::string& name, ros::NodeHandle& nodeHandle)
+{
+  std::unique_ptr<SensorInput> sensorInput(new SensorInput);
+  sensorInput->name = name;
+  nodeHandle.param("point_cloud_topic", sensorInput->pointCloudTopic, string("/points"));
 
   // SensorProcessor parameters.
   string sensorType;
-  nodeHandle_.param("sensor_processor/type", sensorType, string("structured_light"));
+  nodeHandle.param("sensor_processor/type", sensorType, string("structured_light"));
   if (sensorType == "structured_light") {
-    sensorProcessor_.reset(new StructuredLightSensorProcessor(nodeHandle_, transformListener_));
+    sensorInput->sensorProcessor.reset(new StructuredLightSensorProcessor(*transformer_));
   } else if (sensorType == "stereo") {
-    sensorProcessor_.reset(new StereoSensorProcessor(nodeHandle_, transformListener_));
+    sensorInput->sensorProcessor.reset(new StereoSensorProcessor(*transformer_));
   } else if (sensorType == "laser") {
-    sensorProcessor_.reset(new LaserSensorProcessor(nodeHandle_, transformListener_));
+    sensorInput->sensorProcessor.reset(new LaserSensorProcessor(*transformer_));
   } else if (sensorType == "perfect") {
-    sensorProcessor_.reset(new PerfectSensorProcessor(nodeHandle_, transformListener_));
+    sensorInput->sensorProcessor.reset(new PerfectSensorProcessor(*transformer_));
   } else {
     ROS_ERROR("The sensor type %s is not available.", sensorType.c_str());
+    return false;
   }
-  if (!sensorProcessor_->readParameters()) return false;
-  if (!robotMotionMapUpdater_.readParameters()) return false;
+  if (!sensorInput->sensorProcessor->readParameters(nodeHandle)) return false;
+  sensorInput->sensorProcessor->setPerformanceStatistics(&statistics_);
+
+  // Only processed point clouds can be merged, received point clouds are dropped instead.
+  sensorInput->receivedPointCloudQueue.configure(
+      pointCloudQueueSize_, pointCloudQueuePolicy_ == QueueDropPolicy::Coalesce ? QueueDropPolicy::DropOldest : pointCloudQueuePolicy_);
 
+  if (!name.empty()) {
+    ROS_INFO("Added sensor input %s (%s) for the point cloud topic %s.", name.c_str(), sensorType.c_str(),
+             sensorInput->pointCloudTopic.c_str());
+  }
+  sensorInputs_.push_back(std::move(sensorInput));
   return true;
 }
 
@@ -207,11 +391,19 @@ bool ElevationMapping::initialize()
 {
   ROS_INFO("Elevation mapping node initializing ... ");
   fusionServiceThread_ = boost::thread(boost::bind(&ElevationMapping::runFusionServiceThread, this));
+  queryServiceSpinner_.reset(new ros::AsyncSpinner(queryServiceThreads_, &queryServiceQueue_));
+  queryServiceSpinner_->start();
   Duration(1.0).sleep(); // Need this to get the TF caches fill up.
   resetMapUpdateTimer();
   fusedMapPublishTimer_.start();
   visibilityCleanupThread_ = boost::thread(boost::bind(&ElevationMapping::visibilityCleanupThread, this));
   visibilityCleanupTimer_.start();
+  if (enablePipelinedProcessing_) {
+    for (size_t i = 0; i < sensorInputs_.size(); ++i) {
+      sensorInputs_[i]->processingThread = boost::thread(boost::bind(&ElevationMapping::runPointCloudProcessingThread, this, i));
+    }
+    pointCloudIntegrationThread_ = boost::thread(boost::bind(&ElevationMapping::runPointCloudIntegrationThread, this));
+  }
   ROS_INFO("Done.");
   return true;
 }
@@ -234,62 +426,146 @@ void ElevationMapping::visibilityCleanupThread()
   }
 }
 
-void ElevationMapping::pointCloudCallback(
-    const sensor_msgs::PointCloud2& rawPointCloud)
+void ElevationMapping::runPointCloudProcessingThread(const size_t sensorInputIndex)
 {
-  stopMapUpdateTimer();
+  ReceivedPointCloud receivedPointCloud;
+  while (sensorInputs_[sensorInputIndex]->receivedPointCloudQueue.pop(receivedPointCloud)) {
+    ProcessedPointCloud processedPointCloud;
+    if (!processPointCloud(sensorInputIndex, receivedPointCloud, processedPointCloud)) {
+      resetMapUpdateTimer();
+      continue;
+    }
+    if (!processedPointCloudQueue_.push(std::move(processedPointCloud))) {
+      statistics_.increment(PerformanceStatistics::Counter::DroppedProcessedPointClouds);
+      ROS_WARN_THROTTLE(1.0, "Elevation map integration is too slow, processed point clouds are dropped or merged.");
+    }
+  }
+}
 
-  boost::recursive_mutex::scoped_lock scopedLock(map_.getRawDataMutex());
+void ElevationMapping::runPointCloudIntegrationThread()
+{
+  ProcessedPointCloud processedPointCloud;
+  while (processedPointCloudQueue_.pop(processedPointCloud)) {
+    integratePointCloud(processedPointCloud);
+    resetMapUpdateTimer();
+  }
+}
 
-  // Convert the sensor_msgs/PointCloud2 data to pcl/PointCloud.
-  // TODO Double check with http://wiki.ros.org/hydro/Migration
-  pcl::PCLPointCloud2 pcl_pc;
-  pcl_conversions::toPCL(rawPointCloud, pcl_pc);
+void ElevationMapping::pointCloudCallback(
+    const sensor_msgs::PointCloud2ConstPtr& rawPointCloud, const size_t sensorInputIndex)
+{
+  stopMapUpdateTimer();
+  statistics_.increment(PerformanceStatistics::Counter::ReceivedPointClouds);
 
-  PointCloud<PointXYZRGB>::Ptr pointCloud(new PointCloud<PointXYZRGB>);
-  pcl::fromPCLPointCloud2(pcl_pc, *pointCloud);
-  lastPointCloudUpdateTime_.fromNSec(1000 * pointCloud->header.stamp);
+  ReceivedPointCloud receivedPointCloud;
+  receivedPointCloud.message = rawPointCloud;
+  receivedPointCloud.receiveTime = WallTime::now();
 
-  ROS_INFO("ElevationMap received a point cloud (%i points) for elevation mapping.", static_cast<int>(pointCloud->size()));
+  if (enablePipelinedProcessing_) {
+    if (!sensorInputs_[sensorInputIndex]->receivedPointCloudQueue.push(receivedPointCloud)) {
+      statistics_.increment(PerformanceStatistics::Counter::DroppedPointClouds);
+      ROS_WARN_THROTTLE(1.0, "Point cloud processing is too slow, received point clouds are dropped.");
+    }
+    return;
+  }
 
-  // Update map location.
-  updateMapLocation();
+  ProcessedPointCloud processedPointCloud;
+  if (processPointCloud(sensorInputIndex, receivedPointCloud, processedPointCloud)) {
+    integratePointCloud(processedPointCloud);
+  }
+  resetMapUpdateTimer();
+}
 
-  // Update map from motion prediction.
-  if (!updatePrediction(lastPointCloudUpdateTime_)) {
-    ROS_ERROR("Updating process noise failed.");
-    resetMapUpdateTimer();
-    return;
+bool ElevationMapping::processPointCloud(const size_t sensorInputIndex, const ReceivedPointCloud& receivedPointCloud,
+                                         ProcessedPointCloud& processedPointCloud)
+{
+  SensorInput& sensorInput = *sensorInputs_[sensorInputIndex];
+  processedPointCloud.sensorInputIndex = sensorInputIndex;
+  processedPointCloud.receiveTime = receivedPointCloud.receiveTime;
+  processedPointCloud.processingStartTime = WallTime::now();
+  const sensor_msgs::PointCloud2& rawPointCloud = *receivedPointCloud.message;
+
+  PointCloud<PointXYZRGB>::Ptr pointCloud;
+  size_t numberOfPoints;
+  ScopedTimer conversionTimer(&statistics_, PerformanceStatistics::Stage::Conversion);
+  if (enableDirectPointCloudIngestion_) {
+    // Read the points directly from the message data.
+    if (!sensorInput.pointCloudBuffer.fromMessage(rawPointCloud)) {
+      ROS_ERROR("Point cloud could not be read.");
+      return false;
+    }
+    processedPointCloud.timeStamp = sensorInput.pointCloudBuffer.getTimeStamp();
+    numberOfPoints = sensorInput.pointCloudBuffer.size();
+  } else {
+    // Convert the sensor_msgs/PointCloud2 data to pcl/PointCloud.
+    // TODO Double check with http://wiki.ros.org/hydro/Migration
+    pcl::PCLPointCloud2 pcl_pc;
+    pcl_conversions::toPCL(rawPointCloud, pcl_pc);
+
+    pointCloud.reset(new PointCloud<PointXYZRGB>);
+    pcl::fromPCLPointCloud2(pcl_pc, *pointCloud);
+    processedPointCloud.timeStamp.fromNSec(1000 * pointCloud->header.stamp);
+    numberOfPoints = pointCloud->size();
   }
+  conversionTimer.stop();
+
+  ROS_DEBUG("ElevationMap received a point cloud (%i points) for elevation mapping.", static_cast<int>(numberOfPoints));
 
   // Get robot pose covariance matrix at timestamp of point cloud.
   Eigen::Matrix<double, 6, 6> robotPoseCovariance;
   robotPoseCovariance.setZero();
   if (!ignoreRobotMotionUpdates_) {
-    boost::shared_ptr<geometry_msgs::PoseWithCovarianceStamped const> poseMessage = robotPoseCache_.getElemBeforeTime(lastPointCloudUpdateTime_);
-    if (!poseMessage) {
-      ROS_ERROR("Could not get pose information from robot for time %f. Buffer empty?", lastPointCloudUpdateTime_.toSec());
-      return;
+    RobotPoseHistory::Entry robotPose;
+    if (!getRobotPose(processedPointCloud.timeStamp, robotPose)) {
+      ROS_ERROR("Could not get pose information from robot for time %f. Buffer empty?", processedPointCloud.timeStamp.toSec());
+      return false;
     }
-    robotPoseCovariance = Eigen::Map<const Eigen::MatrixXd>(poseMessage->pose.covariance.data(), 6, 6);
+    robotPoseCovariance = robotPose.covariance;
   }
 
   // Process point cloud.
-  PointCloud<PointXYZRGB>::Ptr pointCloudProcessed(new PointCloud<PointXYZRGB>);
-  Eigen::VectorXf measurementVariances;
-  if (!sensorProcessor_->process(pointCloud, robotPoseCovariance, pointCloudProcessed,
-                                 measurementVariances)) {
+  processedPointCloud.pointCloud.reset(new PointCloud<PointXYZRGB>);
+  const bool isProcessed = enableDirectPointCloudIngestion_ ?
+      sensorInput.sensorProcessor->process(sensorInput.pointCloudBuffer, robotPoseCovariance, processedPointCloud.pointCloud, processedPointCloud.variances) :
+      sensorInput.sensorProcessor->process(pointCloud, robotPoseCovariance, processedPointCloud.pointCloud, processedPointCloud.variances);
+  if (!isProcessed) {
     ROS_ERROR("Point cloud could not be processed.");
-    resetMapUpdateTimer();
-    return;
+    return false;
+  }
+  processedPointCloud.transformationSensorToMap = sensorInput.sensorProcessor->transformationSensorToMap_;
+  processedPointCloud.transformationBaseToMap = sensorInput.sensorProcessor->transformationBaseToMap_;
+  processedPointCloud.robotBaseFrameId = sensorInput.sensorProcessor->robotBaseFrameId_;
+  processedPointCloud.processingEndTime = WallTime::now();
+  return true;
+}
+
+bool ElevationMapping::integratePointCloud(const ProcessedPointCloud& processedPointCloud)
+{
+  boost::mutex::scoped_lock scopedLock(integrationMutex_);
+  const WallTime lockTime = WallTime::now();
+  // A point cloud can be older than the last point cloud of another sensor input (but not of its own input).
+  SensorInput& sensorInput = *sensorInputs_[processedPointCloud.sensorInputIndex];
+  const bool isOlderThanOtherInput = processedPointCloud.timeStamp < lastPointCloudUpdateTime_
+      && processedPointCloud.timeStamp >= sensorInput.lastPointCloudUpdateTime;
+  sensorInput.lastPointCloudUpdateTime = processedPointCloud.timeStamp;
+  lastPointCloudUpdateTime_ = std::max(lastPointCloudUpdateTime_, processedPointCloud.timeStamp);
+
+  // Update map location.
+  updateMapLocation(processedPointCloud);
+
+  // Update map from motion prediction (the motion until the last point cloud of the other input is already predicted).
+  if (!isOlderThanOtherInput && !updatePrediction(processedPointCloud.timeStamp)) {
+    ROS_ERROR("Updating process noise failed.");
+    return false;
   }
 
   // Add point cloud to elevation map.
-  if (!map_.add(pointCloudProcessed, measurementVariances, lastPointCloudUpdateTime_, Eigen::Affine3d(sensorProcessor_->transformationSensorToMap_))) {
+  if (!map_.add(processedPointCloud.pointCloud, processedPointCloud.variances, processedPointCloud.timeStamp,
+                Eigen::Affine3d(processedPointCloud.transformationSensorToMap))) {
     ROS_ERROR("Adding point cloud to elevation map failed.");
-    resetMapUpdateTimer();
-    return;
+    return false;
   }
+  scopedLock.unlock();
 
   // Publish elevation map.
   map_.publishRawElevationMap();
@@ -298,14 +574,39 @@ void ElevationMapping::pointCloudCallback(
     map_.publishFusedElevationMap();
   }
 
-  resetMapUpdateTimer();
+  const WallTime integrationEndTime = WallTime::now();
+  ROS_DEBUG("Point cloud has been integrated with a latency of %f s (queued %f s, processing %f s, queued %f s, integration %f s).",
+           (integrationEndTime - processedPointCloud.receiveTime).toSec(),
+            (processedPointCloud.processingStartTime - processedPointCloud.receiveTime).toSec(),
+            (processedPointCloud.processingEndTime - processedPointCloud.processingStartTime).toSec(),
+            (lockTime - processedPointCloud.processingEndTime).toSec(),
+            (integrationEndTime - lockTime).toSec());
+  return true;
+}
+
+bool ElevationMapping::coalescePointClouds(ProcessedPointCloud& queuedPointCloud, ProcessedPointCloud&& newPointCloud)
+{
+  if (queuedPointCloud.sensorInputIndex != newPointCloud.sensorInputIndex) return false;
+  // The points share the sensor origin of the map update (for the lowest scan points), so only
+  // point clouds taken from the same sensor pose are merged.
+  if (!(queuedPointCloud.transformationSensorToMap.matrix() == newPointCloud.transformationSensorToMap.matrix())) return false;
+  const size_t numberOfQueuedPoints = queuedPointCloud.variances.size();
+  *queuedPointCloud.pointCloud += *newPointCloud.pointCloud;
+  queuedPointCloud.variances.conservativeResize(numberOfQueuedPoints + newPointCloud.variances.size());
+  queuedPointCloud.variances.tail(newPointCloud.variances.size()) = newPointCloud.variances;
+  // The merged point cloud is added at the time of the newer point cloud (the receive time is kept for the latency).
+  queuedPointCloud.timeStamp = newPointCloud.timeStamp;
+  queuedPointCloud.transformationBaseToMap = newPointCloud.transformationBaseToMap;
+  queuedPointCloud.processingStartTime = newPointCloud.processingStartTime;
+  queuedPointCloud.processingEndTime = newPointCloud.processingEndTime;
+  return true;
 }
 
 void ElevationMapping::mapUpdateTimerCallback(const ros::TimerEvent&)
 {
   ROS_WARN("Elevation map is updated without data from the sensor.");
 
-  boost::recursive_mutex::scoped_lock scopedLock(map_.getRawDataMutex());
+  boost::mutex::scoped_lock scopedLock(integrationMutex_);
 
   stopMapUpdateTimer();
   ros::Time time = ros::Time::now();
@@ -316,6 +617,7 @@ void ElevationMapping::mapUpdateTimerCallback(const ros::TimerEvent&)
     resetMapUpdateTimer();
     return;
   }
+  scopedLock.unlock();
 
   // Publish elevation map.
   map_.publishRawElevationMap();
@@ -331,7 +633,6 @@ void ElevationMapping::publishFusedMapCallback(const ros::TimerEvent&)
 {
   if (!map_.hasFusedMapSubscribers()) return;
   ROS_DEBUG("Elevation map is fused and published from timer.");
-  boost::recursive_mutex::scoped_lock scopedLock(map_.getFusedDataMutex());
   map_.fuseAll();
   map_.publishFusedElevationMap();
 }
@@ -339,23 +640,97 @@ void ElevationMapping::publishFusedMapCallback(const ros::TimerEvent&)
 void ElevationMapping::visibilityCleanupCallback(const ros::TimerEvent&)
 {
   ROS_DEBUG("Elevation map is running visibility cleanup.");
-  // Copy constructors for thread-safety.
-  map_.visibilityCleanup(ros::Time(lastPointCloudUpdateTime_));
+  boost::mutex::scoped_lock scopedLock(integrationMutex_);
+  const ros::Time lastPointCloudUpdateTime = lastPointCloudUpdateTime_;
+  scopedLock.unlock();
+  map_.visibilityCleanup(lastPointCloudUpdateTime);
+}
+
+void ElevationMapping::publishStatisticsCallback(const ros::TimerEvent&)
+{
+  if (statisticsPublisher_.getNumSubscribers() < 1) return;
+  diagnostic_msgs::DiagnosticStatus status;
+  status.level = diagnostic_msgs::DiagnosticStatus::OK;
+  status.name = "elevation_mapping: Performance statistics";
+  status.hardware_id = "none";
+  status.message = "Durations in ms.";
+
+  char value[32];
+  diagnostic_msgs::KeyValue keyValue;
+  for (size_t i = 0; i < PerformanceStatistics::numberOfStages; ++i) {
+    const PerformanceStatistics::Stage stage = static_cast<PerformanceStatistics::Stage>(i);
+    const LatencyHistogram::Summary summary = statistics_.getHistogram(stage).getSummary();
+    const std::string name = PerformanceStatistics::getName(stage);
+    const std::pair<const char*, double> values[] = {{"mean", summary.mean}, {"p50", summary.percentile50},
+        {"p90", summary.percentile90}, {"p99", summary.percentile99}, {"max", summary.max}};
+    keyValue.key = name + "/count";
+    keyValue.value = std::to_string(summary.count);
+    status.values.push_back(keyValue);
+    for (const auto& entry : values) {
+      std::snprintf(value, sizeof(value), "%.3f", 1e3 * entry.second);
+      keyValue.key = name + "/" + entry.first;
+      keyValue.value = value;
+      status.values.push_back(keyValue);
+    }
+  }
+  for (size_t i = 0; i < PerformanceStatistics::numberOfCounters; ++i) {
+    const PerformanceStatistics::Counter counter = static_cast<PerformanceStatistics::Counter>(i);
+    keyValue.key = PerformanceStatistics::getName(counter);
+    keyValue.value = std::to_string(statistics_.getCounter(counter));
+    status.values.push_back(keyValue);
+  }
+
+  diagnostic_msgs::DiagnosticArray message;
+  message.header.stamp = ros::Time::now();
+  message.status.push_back(status);
+  statisticsPublisher_.publish(message);
 }
 
 bool ElevationMapping::fuseEntireMap(std_srvs::Empty::Request&, std_srvs::Empty::Response&)
 {
-  boost::recursive_mutex::scoped_lock scopedLock(map_.getFusedDataMutex());
   map_.fuseAll();
   map_.publishFusedElevationMap();
   return true;
 }
 
+bool ElevationMapping::getStatistics(std_srvs::Trigger::Request&, std_srvs::Trigger::Response& response)
+{
+  response.message = statistics_.toString();
+  response.success = true;
+  return true;
+}
+
+void ElevationMapping::staticTransformCallback(const tf2_msgs::TFMessageConstPtr& message)
+{
+  for (auto& sensorInput : sensorInputs_) sensorInput->sensorProcessor->addStaticTransformations(message->transforms);
+}
+
+void ElevationMapping::robotPoseCallback(const geometry_msgs::PoseWithCovarianceStampedConstPtr& pose)
+{
+  RobotPoseHistory::Entry entry;
+  entry.time = pose->header.stamp;
+  const geometry_msgs::Pose& robotPose = pose->pose.pose;
+  entry.position = Eigen::Vector3d(robotPose.position.x, robotPose.position.y, robotPose.position.z);
+  entry.orientation = Eigen::Quaterniond(robotPose.orientation.w, robotPose.orientation.x,
+                                         robotPose.orientation.y, robotPose.orientation.z);
+  // Covariance is stored in row-major in ROS: http://docs.ros.org/api/geometry_msgs/html/msg/PoseWithCovariance.html
+  entry.covariance = Eigen::Map<const Eigen::Matrix<double, 6, 6, Eigen::RowMajor>>(pose->pose.covariance.data());
+  if (!robotPoseHistory_.add(entry)) {
+    ROS_WARN_THROTTLE(1.0, "Robot pose with time stamp %f is older than the latest pose and is ignored.", entry.time.toSec());
+  }
+}
+
+bool ElevationMapping::getRobotPose(const ros::Time& time, RobotPoseHistory::Entry& pose) const
+{
+  if (enableRobotPoseInterpolation_) return robotPoseHistory_.getEntryAtTime(time, pose);
+  return robotPoseHistory_.getEntryBeforeTime(time, pose);
+}
+
 bool ElevationMapping::updatePrediction(const ros::Time& time)
 {
   if (ignoreRobotMotionUpdates_) return true;
 
-  ROS_DEBUG("Updating map with latest prediction from time %f.", robotPoseCache_.getLatestTime().toSec());
+  ROS_DEBUG("Updating map with latest prediction from time %f.", robotPoseHistory_.getLatestTime().toSec());
 
   if (time + timeTolerance_ < map_.getTimeOfLastUpdate()) {
     ROS_ERROR("Requested update with time stamp %f, but time of last update was %f.", time.toSec(), map_.getTimeOfLastUpdate().toSec());
@@ -366,60 +741,83 @@ bool ElevationMapping::updatePrediction(const ros::Time& time)
   }
 
   // Get robot pose at requested time.
-  boost::shared_ptr<geometry_msgs::PoseWithCovarianceStamped const> poseMessage = robotPoseCache_.getElemBeforeTime(time);
-  if (!poseMessage) {
+  RobotPoseHistory::Entry robotPoseEntry;
+  if (!getRobotPose(time, robotPoseEntry)) {
     ROS_ERROR("Could not get pose information from robot for time %f. Buffer empty?", time.toSec());
     return false;
   }
 
-  HomTransformQuatD robotPose;
-  convertFromRosGeometryMsg(poseMessage->pose.pose, robotPose);
-  // Covariance is stored in row-major in ROS: http://docs.ros.org/api/geometry_msgs/html/msg/PoseWithCovariance.html
-  Eigen::Matrix<double, 6, 6> robotPoseCovariance = Eigen::Map<
-      const Eigen::Matrix<double, 6, 6, Eigen::RowMajor>>(poseMessage->pose.covariance.data(), 6, 6);
+  const HomTransformQuatD robotPose(
+      Position3D(robotPoseEntry.position),
+      RotationQuaternionD(robotPoseEntry.orientation.w(), robotPoseEntry.orientation.x(),
+                          robotPoseEntry.orientation.y(), robotPoseEntry.orientation.z()));
 
   // Compute map variance update from motion prediction.
-  robotMotionMapUpdater_.update(map_, robotPose, robotPoseCovariance, time);
+  ScopedTimer timer(&statistics_, PerformanceStatistics::Stage::MotionPrediction);
+  robotMotionMapUpdater_.update(map_, robotPose, robotPoseEntry.covariance, time);
 
   return true;
 }
 
-bool ElevationMapping::updateMapLocation()
+bool ElevationMapping::updateMapLocation(const ros::Time& time)
 {
   ROS_DEBUG("Elevation map is checked for relocalization.");
 
-  geometry_msgs::PointStamped trackPoint;
-  trackPoint.header.frame_id = trackPointFrameId_;
-  trackPoint.header.stamp = ros::Time(0);
-  convertToRosGeometryMsg(trackPoint_, trackPoint.point);
-  geometry_msgs::PointStamped trackPointTransformed;
+  const tf::Stamped<tf::Point> trackPoint(tf::Point(trackPoint_.x(), trackPoint_.y(), trackPoint_.z()), time,
+                                          trackPointFrameId_);
+  tf::Stamped<tf::Point> trackPointTransformed;
 
   try {
-    transformListener_.transformPoint(map_.getFrameId(), trackPoint, trackPointTransformed);
+    transformer_->transformPoint(map_.getFrameId(), trackPoint, trackPointTransformed);
   } catch (TransformException &ex) {
     ROS_ERROR("%s", ex.what());
     return false;
   }
 
-  Position3D position3d;
-  convertFromRosGeometryMsg(trackPointTransformed.point, position3d);
-  grid_map::Position position = position3d.vector().head(2);
-  map_.move(position);
+  map_.move(grid_map::Position(trackPointTransformed.x(), trackPointTransformed.y()));
+  return true;
+}
+
+bool ElevationMapping::updateMapLocation(const ProcessedPointCloud& processedPointCloud)
+{
+  if (tf::strip_leading_slash(trackPointFrameId_) != tf::strip_leading_slash(processedPointCloud.robotBaseFrameId)) {
+    return updateMapLocation(isOffline_ ? processedPointCloud.timeStamp : ros::Time(0));
+  }
+
+  ROS_DEBUG("Elevation map is checked for relocalization.");
+  const Eigen::Vector3d trackPointInMapFrame = processedPointCloud.transformationBaseToMap * trackPoint_.toImplementation();
+  map_.move(grid_map::Position(trackPointInMapFrame.head(2)));
   return true;
 }
 
 bool ElevationMapping::getSubmap(grid_map_msgs::GetGridMap::Request& request, grid_map_msgs::GetGridMap::Response& response)
+{
+  return getSubmapOfPyramidLevel(request, response, 0);
+}
+
+bool ElevationMapping::getSubmapOfPyramidLevel(grid_map_msgs::GetGridMap::Request& request, grid_map_msgs::GetGridMap::Response& response,
+                                               const unsigned int level)
 {
   grid_map::Position requestedSubmapPosition(request.position_x, request.position_y);
   Length requestedSubmapLength(request.length_x, request.length_y);
-  ROS_DEBUG("Elevation submap request: Position x=%f, y=%f, Length x=%f, y=%f.", requestedSubmapPosition.x(), requestedSubmapPosition.y(), requestedSubmapLength(0), requestedSubmapLength(1));
-  boost::recursive_mutex::scoped_lock scopedLock(map_.getFusedDataMutex());
-  map_.fuseArea(requestedSubmapPosition, requestedSubmapLength);
+  ROS_DEBUG("Elevation submap request (level %u): Position x=%f, y=%f, Length x=%f, y=%f.", level, requestedSubmapPosition.x(), requestedSubmapPosition.y(), requestedSubmapLength(0), requestedSubmapLength(1));
 
+  // The map may be fused again before the submap is copied (which only makes the submap more recent).
   bool isSuccess;
   Index index;
-  GridMap subMap = map_.getFusedGridMap().getSubmap(requestedSubmapPosition, requestedSubmapLength, index, isSuccess);
-  scopedLock.unlock();
+  GridMap subMap;
+  if (level == 0) {
+    map_.fuseArea(requestedSubmapPosition, requestedSubmapLength);
+    boost::shared_lock<boost::shared_mutex> scopedLock(map_.getFusedDataMutex());
+    subMap = map_.getFusedGridMap().getSubmap(requestedSubmapPosition, requestedSubmapLength, index, isSuccess);
+  } else {
+    // Fuse the cells of all downsampled cells that overlap with the submap.
+    const double levelResolution = (1 << level) * map_.getFusedGridMap().getResolution();
+    map_.fuseArea(requestedSubmapPosition, requestedSubmapLength + 2.0 * levelResolution);
+    GridMap levelMap;
+    isSuccess = map_.getFusedMapPyramidLevel(level, levelMap);
+    if (isSuccess) subMap = levelMap.getSubmap(requestedSubmapPosition, requestedSubmapLength, index, isSuccess);
+  }
 
   if (request.layers.empty()) {
     GridMapRosConverter::toMessage(subMap, response.map);
@@ -435,6 +833,76 @@ bool ElevationMapping::getSubmap(grid_map_msgs::GetGridMap::Request& request, gr
   return isSuccess;
 }
 
+bool ElevationMapping::queryMap(QueryMap::Request& request, QueryMap::Response& response)
+{
+  const size_t numberOfRegions = request.region_positions.size();
+  if (request.region_lengths_x.size() != numberOfRegions || request.region_lengths_y.size() != numberOfRegions) {
+    ROS_ERROR("The number of region positions (%zu) and lengths (%zu, %zu) of the map query do not agree.", numberOfRegions,
+              request.region_lengths_x.size(), request.region_lengths_y.size());
+    return false;
+  }
+
+  // The points are queried as regions of a single cell.
+  std::vector<grid_map::Position> positions;
+  std::vector<Length> lengths;
+  for (const auto& point : request.points) {
+    positions.emplace_back(point.x, point.y);
+    lengths.push_back(Length::Zero());
+  }
+  for (size_t i = 0; i < numberOfRegions; ++i) {
+    positions.emplace_back(request.region_positions[i].x, request.region_positions[i].y);
+    lengths.emplace_back(request.region_lengths_x[i], request.region_lengths_y[i]);
+  }
+
+  // Fuse the area of all stale regions at once, such that all queries are answered from the same snapshot.
+  auto snapshot = map_.getFusedMapSnapshot();
+  const bool isSnapshotOutdated = !snapshot || (WallTime::now() - snapshot->time).toSec() > fusedMapSnapshotMaxAge_;
+  Eigen::Array2d staleAreaMin = Eigen::Array2d::Constant(std::numeric_limits<double>::infinity());
+  Eigen::Array2d staleAreaMax = -staleAreaMin;
+  for (size_t i = 0; i < positions.size(); ++i) {
+    if (!isSnapshotOutdated && !snapshot->isStale(positions[i], lengths[i])) continue;
+    staleAreaMin = staleAreaMin.min(positions[i].array() - 0.5 * lengths[i]);
+    staleAreaMax = staleAreaMax.max(positions[i].array() + 0.5 * lengths[i]);
+  }
+  if ((staleAreaMin <= staleAreaMax).all()) {
+    ROS_DEBUG("Map query fuses the stale area from (%f, %f) to (%f, %f).", staleAreaMin.x(), staleAreaMin.y(),
+              staleAreaMax.x(), staleAreaMax.y());
+    map_.fuseArea(0.5 * (staleAreaMin + staleAreaMax).matrix(), staleAreaMax - staleAreaMin);
+    snapshot = map_.getFusedMapSnapshot();
+  }
+
+  response.success = true;
+  if (snapshot) response.stamp.fromNSec(snapshot->map.getTimestamp());
+  for (size_t i = 0; i < request.points.size(); ++i) {
+    Index index;
+    if (snapshot && snapshot->map.getIndex(positions[i], index)) {
+      response.elevations.push_back(snapshot->map.at("elevation", index));
+      response.upper_bounds.push_back(snapshot->map.at("upper_bound", index));
+      response.lower_bounds.push_back(snapshot->map.at("lower_bound", index));
+    } else {
+      response.elevations.push_back(NAN);
+      response.upper_bounds.push_back(NAN);
+      response.lower_bounds.push_back(NAN);
+    }
+  }
+  for (size_t i = request.points.size(); i < positions.size(); ++i) {
+    response.regions.emplace_back();
+    bool isSuccess = false;
+    Index index;
+    GridMap subMap;
+    if (snapshot) subMap = snapshot->map.getSubmap(positions[i], lengths[i], index, isSuccess);
+    if (isSuccess) {
+      GridMapRosConverter::toMessage(subMap, response.regions.back());
+    } else {
+      response.success = false;
+    }
+  }
+
+  ROS_DEBUG("Map query (%zu points, %zu regions) responded with timestamp %f.", request.points.size(), numberOfRegions,
+            response.stamp.toSec());
+  return true;
+}
+
 bool ElevationMapping::clearMap(std_srvs::Empty::Request& request, std_srvs::Empty::Response& response)
 {
   ROS_INFO("Clearing map.");
@@ -444,14 +912,125 @@ bool ElevationMapping::clearMap(std_srvs::Empty::Request& request, std_srvs::Emp
 bool ElevationMapping::saveMap(grid_map_msgs::ProcessFile::Request& request, grid_map_msgs::ProcessFile::Response& response)
 {
   ROS_INFO("Saving map to file.");
-  boost::recursive_mutex::scoped_lock scopedLock(map_.getFusedDataMutex());
   map_.fuseAll();
+  // The raw map is saved with its persistent layers, which are decoded from the compact layers.
+  const std::shared_ptr<const grid_map::GridMap> rawMapSnapshot = map_.getRawMapSnapshot(ElevationMap::getPersistentLayers());
+  boost::shared_lock<boost::shared_mutex> scopedLockForFusedData(map_.getFusedDataMutex());
   std::string topic = nodeHandle_.getNamespace() + "/elevation_map";
   response.success = GridMapRosConverter::saveToBag(map_.getFusedGridMap(), request.file_path, topic);
-  response.success = GridMapRosConverter::saveToBag(map_.getRawGridMap(), request.file_path + "_raw", topic + "_raw");
+  response.success = GridMapRosConverter::saveToBag(*rawMapSnapshot, request.file_path + "_raw", topic + "_raw");
   return response.success;
 }
 
+bool ElevationMapping::saveBinaryMap(grid_map_msgs::ProcessFile::Request& request, grid_map_msgs::ProcessFile::Response& response)
+{
+  if (isSavingMap_.exchange(true)) {
+    ROS_WARN("A map file is still being saved, not saving to %s.", request.file_path.c_str());
+    response.success = false;
+    return response.success;
+  }
+  ROS_INFO("Saving map to binary file %s.", request.file_path.c_str());
+  // The file is written from a snapshot, such that the map is not locked while writing.
+  const std::shared_ptr<const grid_map::GridMap> snapshot = map_.getRawMapSnapshot(ElevationMap::getPersistentLayers());
+  const ros::Time initialTime = map_.getInitialTime();
+  const std::string path = request.file_path;
+  const bool isCompressed = isMapFileCompressed_;
+  mapSavingThread_.join();
+  mapSavingThread_ = boost::thread([this, snapshot, initialTime, path, isCompressed]() {
+    if (MapFile::save(path, *snapshot, ElevationMap::getPersistentLayers(), initialTime, isCompressed)) {
+      ROS_INFO("Saved map to binary file %s.", path.c_str());
+    }
+    isSavingMap_ = false;
+  });
+  response.success = true;
+  return response.success;
+}
+
+bool ElevationMapping::loadMap(grid_map_msgs::ProcessFile::Request& request, grid_map_msgs::ProcessFile::Response& response)
+{
+  response.success = loadMapFromFile(request.file_path);
+  return response.success;
+}
+
+bool ElevationMapping::loadMapFromFile(const std::string& path)
+{
+  ROS_INFO("Loading map from binary file %s.", path.c_str());
+  grid_map::GridMap map;
+  ros::Time initialTime;
+  if (!MapFile::load(path, map, initialTime)) return false;
+  if (!map_.loadRawMap(map, initialTime)) return false;
+  ROS_INFO("Loaded map with %i rows and %i columns.", map.getSize()(0), map.getSize()(1));
+  return true;
+}
+
+void ElevationMapping::addTransformations(const tf2_msgs::TFMessage& message, const bool isStatic)
+{
+  for (const auto& transform : message.transforms) {
+    transformer_->getTF2BufferPtr()->setTransform(transform, "elevation_mapping", isStatic);
+  }
+  if (isStatic) {
+    for (auto& sensorInput : sensorInputs_) sensorInput->sensorProcessor->addStaticTransformations(message.transforms);
+  }
+}
+
+std::vector<std::string> ElevationMapping::getPointCloudTopics() const
+{
+  std::vector<std::string> topics;
+  for (const auto& sensorInput : sensorInputs_) topics.push_back(sensorInput->pointCloudTopic);
+  return topics;
+}
+
+const std::string& ElevationMapping::getRobotPoseTopic() const
+{
+  return robotPoseTopic_;
+}
+
+bool ElevationMapping::isPipelinedProcessingEnabled() const
+{
+  return enablePipelinedProcessing_;
+}
+
+ros::Duration ElevationMapping::getMotionUpdateDuration() const
+{
+  return ignoreRobotMotionUpdates_ ? ros::Duration() : maxNoUpdateDuration_;
+}
+
+ros::Duration ElevationMapping::getVisibilityCleanupDuration() const
+{
+  return map_.getParameters().enableVisibilityCleanup ? visibilityCleanupTimerDuration_ : ros::Duration();
+}
+
+bool ElevationMapping::processPointCloud(const size_t sensorInputIndex, const sensor_msgs::PointCloud2ConstPtr& pointCloud,
+                                         ProcessedPointCloud& processedPointCloud)
+{
+  statistics_.increment(PerformanceStatistics::Counter::ReceivedPointClouds);
+  ReceivedPointCloud receivedPointCloud;
+  receivedPointCloud.message = pointCloud;
+  receivedPointCloud.receiveTime = WallTime::now();
+  return processPointCloud(sensorInputIndex, receivedPointCloud, processedPointCloud);
+}
+
+bool ElevationMapping::updateMotionPrediction(const ros::Time& time)
+{
+  ROS_DEBUG("Elevation map is updated without data from the sensor at time %f.", time.toSec());
+  boost::mutex::scoped_lock scopedLock(integrationMutex_);
+  if (!updatePrediction(time)) {
+    ROS_ERROR("Updating process noise failed.");
+    return false;
+  }
+  return true;
+}
+
+bool ElevationMapping::saveBinaryMapFile(const std::string& path)
+{
+  const std::shared_ptr<const grid_map::GridMap> snapshot = map_.getRawMapSnapshot(ElevationMap::getPersistentLayers());
+  if (!MapFile::save(path, *snapshot, ElevationMap::getPersistentLayers(), map_.getInitialTime(), isMapFileCompressed_)) {
+    return false;
+  }
+  ROS_INFO("Saved map to binary file %s.", path.c_str());
+  return true;
+}
+
 void ElevationMapping::resetMapUpdateTimer()
 {
   mapUpdateTimer_.stop();
@@ -0,0 +1,317 @@
+/*
+ * MapFile.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/MapFile.hpp"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+// POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace elevation_mapping {
+
+namespace {
+
+const char magic[4] = {'E', 'M', 'A', 'P'};
+const uint32_t version = 1;
+const uint32_t compressedFlag = 1;
+
+template<typename T>
+void write(std::ostream& stream, const T& value)
+{
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeString(std::ostream& stream, const std::string& string)
+{
+  write(stream, static_cast<uint32_t>(string.size()));
+  stream.write(string.data(), string.size());
+}
+
+/*!
+ * Compresses the runs of NaN cells of a layer. The result is a sequence of
+ * [number of NaN cells, number of values, values].
+ * @param data the cell data.
+ * @param size the number of cells.
+ * @param[out] block the compressed block.
+ */
+void compress(const float* data, const size_t size, std::vector<char>& block)
+{
+  block.clear();
+  size_t i = 0;
+  while (i < size) {
+    const size_t nanStart = i;
+    while (i < size && std::isnan(data[i])) ++i;
+    const size_t valueStart = i;
+    while (i < size && !std::isnan(data[i])) ++i;
+    const uint32_t runs[2] = {static_cast<uint32_t>(valueStart - nanStart), static_cast<uint32_t>(i - valueStart)};
+    const size_t offset = block.size();
+    block.resize(offset + sizeof(runs) + runs[1] * sizeof(float));
+    std::memcpy(&block[offset], runs, sizeof(runs));
+    std::memcpy(&block[offset + sizeof(runs)], &data[valueStart], runs[1] * sizeof(float));
+  }
+}
+
+/*!
+ * Read-only memory mapping of a file, unmapped on destruction.
+ */
+class MappedFile
+{
+ public:
+  explicit MappedFile(const std::string& path)
+  {
+    const int fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) return;
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) == 0 && fileStatus.st_size > 0) {
+      void* data = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+      if (data != MAP_FAILED) {
+        data_ = static_cast<const char*>(data);
+        size_ = fileStatus.st_size;
+        madvise(data, size_, MADV_SEQUENTIAL);
+      }
+    }
+    close(fileDescriptor);
+  }
+
+  ~MappedFile()
+  {
+    if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+/*!
+ * Bounds-checked reading from a memory block.
+ */
+class Reader
+{
+ public:
+  Reader(const char* data, const size_t size)
+      : data_(data),
+        size_(size),
+        offset_(0)
+  {
+  }
+
+  bool read(void* destination, const size_t size)
+  {
+    if (size > size_ - offset_) return false;
+    std::memcpy(destination, data_ + offset_, size);
+    offset_ += size;
+    return true;
+  }
+
+  template<typename T>
+  bool read(T& value)
+  {
+    return read(&value, sizeof(T));
+  }
+
+  bool readString(std::string& string)
+  {
+    uint32_t length;
+    if (!read(length) || length > size_ - offset_) return false;
+    string.assign(data_ + offset_, length);
+    offset_ += length;
+    return true;
+  }
+
+  bool readStrings(std::vector<std::string>& strings)
+  {
+    uint32_t number;
+    if (!read(number)) return false;
+    strings.clear();
+    for (uint32_t i = 0; i < number; ++i) {
+      std::string string;
+      if (!readString(string)) return false;
+      strings.push_back(string);
+    }
+    return true;
+  }
+
+  Reader getBlock(const size_t size)
+  {
+    Reader block(data_ + offset_, std::min(size, size_ - offset_));
+    offset_ += block.size_;
+    return block;
+  }
+
+  size_t getRemainingSize() const { return size_ - offset_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t offset_;
+};
+
+/*!
+ * Reads the cell data of a layer.
+ * @param block the data block of the layer.
+ * @param isCompressed if the block is compressed.
+ * @param[out] data the cell data (with the size of the map).
+ * @return true if the block is valid.
+ */
+bool readLayer(Reader& block, const bool isCompressed, grid_map::Matrix& data)
+{
+  const size_t size = data.size();
+  if (!isCompressed) return block.getRemainingSize() == size * sizeof(float) && block.read(data.data(), size * sizeof(float));
+
+  size_t i = 0;
+  while (i < size) {
+    uint32_t runs[2];
+    if (!block.read(runs) || runs[0] > size - i || runs[1] > size - i - runs[0]) return false;
+    std::fill(data.data() + i, data.data() + i + runs[0], std::numeric_limits<float>::quiet_NaN());
+    i += runs[0];
+    if (!block.read(data.data() + i, runs[1] * sizeof(float))) return false;
+    i += runs[1];
+  }
+  return block.getRemainingSize() == 0;
+}
+
+}
+
+bool MapFile::save(const std::string& path, const grid_map::GridMap& map, const std::vector<std::string>& layers,
+                   const ros::Time& initialTime, const bool isCompressed)
+{
+  // Write to a temporary file first, such that an existing map file is only replaced by a complete one.
+  const std::string temporaryPath = path + ".tmp";
+  std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+  if (!stream) {
+    ROS_ERROR("Could not open map file %s for writing.", temporaryPath.c_str());
+    return false;
+  }
+
+  stream.write(magic, sizeof(magic));
+  write(stream, version);
+  write(stream, isCompressed ? compressedFlag : uint32_t(0));
+  const grid_map::Size& size = map.getSize();
+  const grid_map::Index& startIndex = map.getStartIndex();
+  write(stream, static_cast<int32_t>(size(0)));
+  write(stream, static_cast<int32_t>(size(1)));
+  write(stream, static_cast<int32_t>(startIndex(0)));
+  write(stream, static_cast<int32_t>(startIndex(1)));
+  write(stream, map.getResolution());
+  write(stream, map.getPosition().x());
+  write(stream, map.getPosition().y());
+  write(stream, static_cast<uint64_t>(map.getTimestamp()));
+  write(stream, static_cast<uint64_t>(initialTime.toNSec()));
+  writeString(stream, map.getFrameId());
+  write(stream, static_cast<uint32_t>(layers.size()));
+  for (const auto& layer : layers) writeString(stream, layer);
+  std::vector<std::string> basicLayers;
+  for (const auto& layer : map.getBasicLayers()) {
+    if (std::find(layers.begin(), layers.end(), layer) != layers.end()) basicLayers.push_back(layer);
+  }
+  write(stream, static_cast<uint32_t>(basicLayers.size()));
+  for (const auto& layer : basicLayers) writeString(stream, layer);
+
+  std::vector<char> block;
+  for (const auto& layer : layers) {
+    const grid_map::Matrix& data = map.get(layer);
+    if (isCompressed) {
+      compress(data.data(), data.size(), block);
+      write(stream, static_cast<uint64_t>(block.size()));
+      stream.write(block.data(), block.size());
+    } else {
+      write(stream, static_cast<uint64_t>(data.size() * sizeof(float)));
+      stream.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(float));
+    }
+  }
+
+  stream.close();
+  if (!stream) {
+    ROS_ERROR("Could not write map file %s.", temporaryPath.c_str());
+    std::remove(temporaryPath.c_str());
+    return false;
+  }
+  if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+    ROS_ERROR("Could not rename map file %s to %s.", temporaryPath.c_str(), path.c_str());
+    std::remove(temporaryPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool MapFile::load(const std::string& path, grid_map::GridMap& map, ros::Time& initialTime)
+{
+  const MappedFile file(path);
+  if (file.data() == nullptr) {
+    ROS_ERROR("Could not open map file %s.", path.c_str());
+    return false;
+  }
+
+  Reader reader(file.data(), file.size());
+  char fileMagic[4];
+  uint32_t fileVersion, flags;
+  if (!reader.read(fileMagic) || std::memcmp(fileMagic, magic, sizeof(magic)) != 0 || !reader.read(fileVersion)
+      || fileVersion != version || !reader.read(flags)) {
+    ROS_ERROR("%s is not a map file of version %u.", path.c_str(), version);
+    return false;
+  }
+
+  int32_t size[2], startIndex[2];
+  double resolution, position[2];
+  uint64_t timestamp, initialTimeNanoseconds;
+  std::string frameId;
+  std::vector<std::string> layers, basicLayers;
+  if (!reader.read(size) || !reader.read(startIndex) || !reader.read(resolution) || !reader.read(position)
+      || !reader.read(timestamp) || !reader.read(initialTimeNanoseconds) || !reader.readString(frameId)
+      || !reader.readStrings(layers) || !reader.readStrings(basicLayers)) {
+    ROS_ERROR("Map file %s has an incomplete header.", path.c_str());
+    return false;
+  }
+  if (size[0] <= 0 || size[1] <= 0 || startIndex[0] < 0 || startIndex[0] >= size[0] || startIndex[1] < 0
+      || startIndex[1] >= size[1] || !(resolution > 0.0)) {
+    ROS_ERROR("Map file %s has an invalid geometry.", path.c_str());
+    return false;
+  }
+
+  grid_map::GridMap loadedMap(layers);
+  loadedMap.setGeometry(grid_map::Length(size[0] * resolution, size[1] * resolution), resolution,
+                        grid_map::Position(position[0], position[1]));
+  for (const auto& layer : layers) {
+    uint64_t blockSize;
+    if (!reader.read(blockSize) || blockSize > reader.getRemainingSize()) {
+      ROS_ERROR("Map file %s is truncated.", path.c_str());
+      return false;
+    }
+    Reader block = reader.getBlock(blockSize);
+    if (!readLayer(block, flags & compressedFlag, loadedMap.get(layer))) {
+      ROS_ERROR("Map file %s has an invalid block for layer %s.", path.c_str(), layer.c_str());
+      return false;
+    }
+  }
+
+  loadedMap.setStartIndex(grid_map::Index(startIndex[0], startIndex[1]));
+  loadedMap.setBasicLayers(basicLayers);
+  loadedMap.setTimestamp(timestamp);
+  loadedMap.setFrameId(frameId);
+  map = loadedMap;
+  initialTime.fromNSec(initialTimeNanoseconds);
+  return true;
+}
+
+} /* namespace elevation_mapping */
@@ -0,0 +1,118 @@
+/*
+ * MapPublishing.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/MapPublishing.hpp"
+
+// Grid Map
+#include <grid_map_core/GridMapMath.hpp>
+
+// STL
+#include <algorithm>
+#include <map>
+
+using namespace grid_map;
+
+namespace elevation_mapping {
+
+namespace {
+
+//! Layers that are computed for publishing, with the layers they are computed from.
+const std::map<std::string, std::vector<std::string>> derivedLayerSources{
+    {"standard_deviation", {"variance"}},
+    {"horizontal_standard_deviation", {"horizontal_variance_x", "horizontal_variance_y"}},
+    {"two_sigma_bound", {"elevation", "variance"}},
+    {"uncertainty_range", {"upper_bound", "lower_bound"}}};
+
+} // namespace
+
+std::vector<std::string> getPublishedLayers(const grid_map::GridMap& map, const std::vector<std::string>& selectedLayers,
+                                            const std::vector<std::string>& defaultLayers,
+                                            std::vector<std::string>& sourceLayers)
+{
+  return getPublishedLayers(map.getLayers(), map.getBasicLayers(), selectedLayers, defaultLayers, sourceLayers);
+}
+
+std::vector<std::string> getPublishedLayers(const std::vector<std::string>& availableLayers,
+                                            const std::vector<std::string>& basicLayers,
+                                            const std::vector<std::string>& selectedLayers,
+                                            const std::vector<std::string>& defaultLayers,
+                                            std::vector<std::string>& sourceLayers)
+{
+  const auto isAvailable = [&](const std::string& layer) {
+    return std::find(availableLayers.begin(), availableLayers.end(), layer) != availableLayers.end();
+  };
+  sourceLayers = basicLayers;
+  std::vector<std::string> layers;
+  for (const auto& layer : selectedLayers.empty() ? defaultLayers : selectedLayers) {
+    const auto derivedLayer = derivedLayerSources.find(layer);
+    const std::vector<std::string> requiredLayers = derivedLayer == derivedLayerSources.end()
+        ? std::vector<std::string>({layer}) : derivedLayer->second;
+    if (!std::all_of(requiredLayers.begin(), requiredLayers.end(), isAvailable)) continue;
+    for (const auto& requiredLayer : requiredLayers) {
+      if (std::find(sourceLayers.begin(), sourceLayers.end(), requiredLayer) == sourceLayers.end()) {
+        sourceLayers.push_back(requiredLayer);
+      }
+    }
+    layers.push_back(layer);
+  }
+  return layers;
+}
+
+bool isDerivedLayer(const std::string& layer)
+{
+  return derivedLayerSources.count(layer) > 0;
+}
+
+void addDerivedLayers(grid_map::GridMap& map, const std::vector<std::string>& layers)
+{
+  for (const auto& layer : layers) {
+    if (!isDerivedLayer(layer) || map.exists(layer)) continue;
+    if (layer == "standard_deviation") {
+      map.add(layer, map.get("variance").array().sqrt().matrix());
+    } else if (layer == "horizontal_standard_deviation") {
+      map.add(layer, (map.get("horizontal_variance_x") + map.get("horizontal_variance_y")).array().sqrt().matrix());
+    } else if (layer == "two_sigma_bound") {
+      map.add(layer, map.get("elevation") + 2.0 * map.get("variance").array().sqrt().matrix());
+    } else if (layer == "uncertainty_range") {
+      map.add(layer, map.get("upper_bound") - map.get("lower_bound"));
+    }
+  }
+}
+
+bool getUpdatedSubmaps(const grid_map::GridMap& map, const TileMask& updatedTiles, const size_t maxNumberOfSubmaps,
+                       std::vector<grid_map::GridMap>& submaps)
+{
+  submaps.clear();
+  std::vector<TileMask::Region> regions = updatedTiles.getMarkedRegions(map.getStartIndex());
+  if (regions.empty()) return false;
+  if (regions.size() > maxNumberOfSubmaps) {
+    regions.resize(1);
+    updatedTiles.getBoundingRegion(map.getStartIndex(), regions[0].startIndex, regions[0].size);
+  }
+
+  for (const auto& region : regions) {
+    if ((region.size == map.getSize()).all()) {
+      submaps.assign(1, map);
+      return true;
+    }
+    Index firstIndex = map.getStartIndex() + region.startIndex;
+    Index lastIndex = firstIndex + region.size - 1;
+    wrapIndexToRange(firstIndex, map.getSize());
+    wrapIndexToRange(lastIndex, map.getSize());
+    Position firstPosition, lastPosition;
+    map.getPosition(firstIndex, firstPosition);
+    map.getPosition(lastIndex, lastPosition);
+    // The corners of the requested submap are inside of the border cells of the region.
+    const Length length = (region.size.cast<double>() - 0.5) * map.getResolution();
+    bool isSuccess;
+    Index requestedIndexInSubmap;
+    submaps.push_back(map.getSubmap(0.5 * (firstPosition + lastPosition), length, requestedIndexInSubmap, isSuccess));
+    if (!isSuccess) return false;
+  }
+  return true;
+}
+
+} /* namespace elevation_mapping */
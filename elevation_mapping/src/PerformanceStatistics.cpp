@@ -0,0 +1,165 @@
+/*
+ * PerformanceStatistics.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/PerformanceStatistics.hpp"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+namespace elevation_mapping {
+
+LatencyHistogram::LatencyHistogram()
+{
+  reset();
+}
+
+void LatencyHistogram::add(const double duration)
+{
+  const uint64_t nanoseconds = duration > 0.0 ? static_cast<uint64_t>(duration * 1e9) : 0;
+  const uint64_t microseconds = nanoseconds / 1000;
+  unsigned int bin = 0;
+  while (bin + 1 < numberOfBins && (microseconds >> bin) > 0) ++bin;
+  bins_[bin].fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(nanoseconds, std::memory_order_relaxed);
+  uint64_t max = max_.load(std::memory_order_relaxed);
+  while (nanoseconds > max && !max_.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed));
+}
+
+LatencyHistogram::Summary LatencyHistogram::getSummary() const
+{
+  Summary summary;
+  std::array<uint64_t, numberOfBins> bins;
+  uint64_t count = 0;
+  for (unsigned int i = 0; i < numberOfBins; ++i) {
+    bins[i] = bins_[i].load(std::memory_order_relaxed);
+    count += bins[i];
+  }
+  summary.count = count;
+  summary.mean = count > 0 ? 1e-9 * sum_.load(std::memory_order_relaxed) / count : 0.0;
+  summary.max = 1e-9 * max_.load(std::memory_order_relaxed);
+
+  const double quantiles[3] = {0.5, 0.9, 0.99};
+  double* percentiles[3] = {&summary.percentile50, &summary.percentile90, &summary.percentile99};
+  for (unsigned int q = 0; q < 3; ++q) {
+    *percentiles[q] = 0.0;
+    if (count == 0) continue;
+    const uint64_t rank = static_cast<uint64_t>(std::ceil(quantiles[q] * count));
+    uint64_t cumulativeCount = 0;
+    for (unsigned int i = 0; i < numberOfBins; ++i) {
+      cumulativeCount += bins[i];
+      if (cumulativeCount < rank) continue;
+      // The last bin is unbounded, its percentile is the maximum.
+      *percentiles[q] = i + 1 < numberOfBins ? std::min(getBinUpperLimit(i), summary.max) : summary.max;
+      break;
+    }
+  }
+  return summary;
+}
+
+uint64_t LatencyHistogram::getBinCount(const unsigned int bin) const
+{
+  return bins_[bin].load(std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset()
+{
+  for (auto& bin : bins_) bin.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::getBinUpperLimit(const unsigned int bin)
+{
+  // Bin 0 is [0, 1) us, bin i is [2^(i-1), 2^i) us.
+  return 1e-6 * static_cast<double>(uint64_t(1) << bin);
+}
+
+PerformanceStatistics::PerformanceStatistics()
+{
+  reset();
+}
+
+void PerformanceStatistics::addDuration(const Stage stage, const double duration)
+{
+  histograms_[static_cast<size_t>(stage)].add(duration);
+}
+
+void PerformanceStatistics::increment(const Counter counter, const uint64_t value)
+{
+  counters_[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+const LatencyHistogram& PerformanceStatistics::getHistogram(const Stage stage) const
+{
+  return histograms_[static_cast<size_t>(stage)];
+}
+
+uint64_t PerformanceStatistics::getCounter(const Counter counter) const
+{
+  return counters_[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+}
+
+void PerformanceStatistics::reset()
+{
+  for (auto& histogram : histograms_) histogram.reset();
+  for (auto& counter : counters_) counter.store(0, std::memory_order_relaxed);
+}
+
+const char* PerformanceStatistics::getName(const Stage stage)
+{
+  switch (stage) {
+    case Stage::Conversion: return "conversion";
+    case Stage::TransformWait: return "transform_wait";
+    case Stage::SensorProcessing: return "sensor_processing";
+    case Stage::MotionPrediction: return "motion_prediction";
+    case Stage::Add: return "add";
+    case Stage::Clean: return "clean";
+    case Stage::Fusion: return "fusion";
+    case Stage::VisibilityCleanup: return "visibility_cleanup";
+    case Stage::Serialization: return "serialization";
+    case Stage::RawMapLockWait: return "raw_map_lock_wait";
+    case Stage::FusedMapLockWait: return "fused_map_lock_wait";
+    default: return "unknown";
+  }
+}
+
+const char* PerformanceStatistics::getName(const Counter counter)
+{
+  switch (counter) {
+    case Counter::ReceivedPointClouds: return "received_point_clouds";
+    case Counter::DroppedPointClouds: return "dropped_point_clouds";
+    case Counter::DroppedProcessedPointClouds: return "dropped_processed_point_clouds";
+    case Counter::SensorProcessingInputPoints: return "sensor_processing_input_points";
+    case Counter::SensorProcessingOutputPoints: return "sensor_processing_output_points";
+    case Counter::AddedPoints: return "added_points";
+    case Counter::VisibilityCleanupRemovedCells: return "visibility_cleanup_removed_cells";
+    default: return "unknown";
+  }
+}
+
+std::string PerformanceStatistics::toString() const
+{
+  std::ostringstream stream;
+  char line[256];
+  for (size_t i = 0; i < numberOfStages; ++i) {
+    const Stage stage = static_cast<Stage>(i);
+    const LatencyHistogram::Summary summary = getHistogram(stage).getSummary();
+    std::snprintf(line, sizeof(line), "%s: count %llu, mean %.3f ms, p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                  getName(stage), static_cast<unsigned long long>(summary.count), 1e3 * summary.mean,
+                  1e3 * summary.percentile50, 1e3 * summary.percentile90, 1e3 * summary.percentile99, 1e3 * summary.max);
+    stream << line;
+  }
+  for (size_t i = 0; i < numberOfCounters; ++i) {
+    const Counter counter = static_cast<Counter>(i);
+    stream << getName(counter) << ": " << getCounter(counter) << "\n";
+  }
+  return stream.str();
+}
+
+} /* namespace elevation_mapping */
@@ -0,0 +1,193 @@
+/*
+ * PointCloudBuffer.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/PointCloudBuffer.hpp"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace elevation_mapping {
+
+namespace {
+
+//! Returns the field with the given name or null if not available.
+const sensor_msgs::PointField* findField(const sensor_msgs::PointCloud2& message, const std::string& name)
+{
+  for (const auto& field : message.fields) {
+    if (field.name == name) return &field;
+  }
+  return nullptr;
+}
+
+//! Returns the number of blocks of the given size needed to cover a length.
+uint32_t getNumberOfBlocks(const uint32_t length, const uint32_t blockSize)
+{
+  return (length + blockSize - 1) / blockSize;
+}
+
+bool isLittleEndianHost()
+{
+  const uint16_t value = 1;
+  return *reinterpret_cast<const uint8_t*>(&value) == 1;
+}
+
+}
+
+PointCloudBuffer::PointCloudBuffer()
+    : width_(0),
+      height_(0),
+      hasColor_(false)
+{
+}
+
+PointCloudBuffer::~PointCloudBuffer()
+{
+}
+
+bool PointCloudBuffer::fromMessage(const sensor_msgs::PointCloud2& message)
+{
+  const sensor_msgs::PointField* fieldX = findField(message, "x");
+  const sensor_msgs::PointField* fieldY = findField(message, "y");
+  const sensor_msgs::PointField* fieldZ = findField(message, "z");
+  if (fieldX == nullptr || fieldY == nullptr || fieldZ == nullptr) {
+    ROS_ERROR("The point cloud has no x, y and z fields.");
+    return false;
+  }
+  for (const auto field : {fieldX, fieldY, fieldZ}) {
+    if (field->datatype != sensor_msgs::PointField::FLOAT32 || field->offset + sizeof(float) > message.point_step) {
+      ROS_ERROR("The point cloud field %s is not supported (needs to be FLOAT32).", field->name.c_str());
+      return false;
+    }
+  }
+  if (message.is_bigendian == isLittleEndianHost()) {
+    ROS_ERROR("The endianness of the point cloud does not match the system.");
+    return false;
+  }
+  if (static_cast<size_t>(message.point_step) * message.width > message.row_step
+      || message.data.size() < static_cast<size_t>(message.row_step) * message.height) {
+    ROS_ERROR("The point cloud data does not match its size.");
+    return false;
+  }
+
+  const sensor_msgs::PointField* fieldColor = findField(message, "rgb");
+  if (fieldColor == nullptr) fieldColor = findField(message, "rgba");
+  if (fieldColor != nullptr && ((fieldColor->datatype != sensor_msgs::PointField::FLOAT32
+                                 && fieldColor->datatype != sensor_msgs::PointField::UINT32)
+                                || fieldColor->offset + sizeof(uint32_t) > message.point_step)) {
+    ROS_WARN_THROTTLE(10.0, "The point cloud field %s is not supported and is ignored.", fieldColor->name.c_str());
+    fieldColor = nullptr;
+  }
+
+  resize(message.width, message.height, fieldColor != nullptr);
+  frameId_ = message.header.frame_id;
+  timeStamp_ = message.header.stamp;
+
+  const uint32_t offsetX = fieldX->offset, offsetY = fieldY->offset, offsetZ = fieldZ->offset;
+  const uint32_t offsetColor = hasColor_ ? fieldColor->offset : 0;
+  const uint32_t pointStep = message.point_step;
+  size_t i = 0;
+  for (uint32_t row = 0; row < height_; ++row) {
+    const uint8_t* point = message.data.data() + static_cast<size_t>(row) * message.row_step;
+    for (uint32_t column = 0; column < width_; ++column, ++i, point += pointStep) {
+      std::memcpy(&x_[i], point + offsetX, sizeof(float));
+      std::memcpy(&y_[i], point + offsetY, sizeof(float));
+      std::memcpy(&z_[i], point + offsetZ, sizeof(float));
+      if (hasColor_) std::memcpy(&rgba_[i], point + offsetColor, sizeof(uint32_t));
+    }
+  }
+  return true;
+}
+
+void PointCloudBuffer::fromPointCloud(const pcl::PointCloud<pcl::PointXYZRGB>& pointCloud)
+{
+  resize(pointCloud.width, pointCloud.height, true);
+  if (size() != pointCloud.size()) resize(pointCloud.size(), 1, true);
+  frameId_ = pointCloud.header.frame_id;
+  timeStamp_.fromNSec(1000 * pointCloud.header.stamp);
+  for (size_t i = 0; i < pointCloud.size(); ++i) {
+    const auto& point = pointCloud[i];
+    x_[i] = point.x;
+    y_[i] = point.y;
+    z_[i] = point.z;
+    rgba_[i] = point.rgba;
+  }
+}
+
+void PointCloudBuffer::subsample(const PointCloudBuffer& pointCloud, const uint32_t stride)
+{
+  resize(getNumberOfBlocks(pointCloud.width_, stride), getNumberOfBlocks(pointCloud.height_, stride), pointCloud.hasColor_);
+  frameId_ = pointCloud.frameId_;
+  timeStamp_ = pointCloud.timeStamp_;
+  size_t i = 0;
+  for (uint32_t row = 0; row < height_; ++row) {
+    size_t j = static_cast<size_t>(row) * stride * pointCloud.width_;
+    for (uint32_t column = 0; column < width_; ++column, ++i, j += stride) {
+      x_[i] = pointCloud.x_[j];
+      y_[i] = pointCloud.y_[j];
+      z_[i] = pointCloud.z_[j];
+      if (hasColor_) rgba_[i] = pointCloud.rgba_[j];
+    }
+  }
+}
+
+void PointCloudBuffer::decimate(const PointCloudBuffer& pointCloud, const uint32_t factor)
+{
+  resize(getNumberOfBlocks(pointCloud.width_, factor), getNumberOfBlocks(pointCloud.height_, factor), pointCloud.hasColor_);
+  frameId_ = pointCloud.frameId_;
+  timeStamp_ = pointCloud.timeStamp_;
+
+  // Sum up the rows of each block row, such that the input is read in memory order.
+  std::vector<float> sumX(width_), sumY(width_), sumZ(width_);
+  std::vector<uint32_t> count(width_);
+  for (uint32_t row = 0; row < height_; ++row) {
+    std::fill(sumX.begin(), sumX.end(), 0.0f);
+    std::fill(sumY.begin(), sumY.end(), 0.0f);
+    std::fill(sumZ.begin(), sumZ.end(), 0.0f);
+    std::fill(count.begin(), count.end(), 0);
+    const size_t offset = static_cast<size_t>(row) * width_;
+    const uint32_t endRow = std::min(pointCloud.height_, (row + 1) * factor);
+    for (uint32_t inputRow = row * factor; inputRow < endRow; ++inputRow) {
+      size_t j = static_cast<size_t>(inputRow) * pointCloud.width_;
+      for (uint32_t inputColumn = 0; inputColumn < pointCloud.width_; ++inputColumn, ++j) {
+        const float x = pointCloud.x_[j], y = pointCloud.y_[j], z = pointCloud.z_[j];
+        if (!std::isfinite(x) || !std::isfinite(y) || !std::isfinite(z)) continue;
+        const uint32_t column = inputColumn / factor;
+        if (hasColor_ && count[column] == 0) rgba_[offset + column] = pointCloud.rgba_[j];
+        sumX[column] += x;
+        sumY[column] += y;
+        sumZ[column] += z;
+        ++count[column];
+      }
+    }
+    for (uint32_t column = 0; column < width_; ++column) {
+      const size_t i = offset + column;
+      if (count[column] == 0) {
+        x_[i] = y_[i] = z_[i] = std::numeric_limits<float>::quiet_NaN();
+        continue;
+      }
+      x_[i] = sumX[column] / count[column];
+      y_[i] = sumY[column] / count[column];
+      z_[i] = sumZ[column] / count[column];
+    }
+  }
+}
+
+void PointCloudBuffer::resize(const uint32_t width, const uint32_t height, const bool hasColor)
+{
+  width_ = width;
+  height_ = height;
+  hasColor_ = hasColor;
+  const size_t numberOfPoints = static_cast<size_t>(width) * height;
+  x_.resize(numberOfPoints);
+  y_.resize(numberOfPoints);
+  z_.resize(numberOfPoints);
+  rgba_.resize(hasColor ? numberOfPoints : 0);
+}
+
+} /* namespace elevation_mapping */
@@ -0,0 +1,143 @@
+/*
+ * RobotMotionMapUpdateKernel.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/RobotMotionMapUpdateKernel.hpp"
+
+// Elevation Mapping
+#include "elevation_mapping/CompactLayers.hpp"
+#include "elevation_mapping/ElevationMapFunctors.hpp"
+
+// STL
+#include <cmath>
+#include <limits>
+
+using namespace grid_map;
+
+namespace elevation_mapping {
+
+RobotMotionMapUpdateKernel::RobotMotionMapUpdateKernel()
+    : translationVarianceUpdate_(Eigen::Vector3f::Zero()),
+      yawVariance_(0.0),
+      positionRobotToMap_(Eigen::Vector3d::Zero()),
+      rotationAxis_(Eigen::Vector3d::UnitZ())
+{
+}
+
+RobotMotionMapUpdateKernel::~RobotMotionMapUpdateKernel()
+{
+}
+
+void RobotMotionMapUpdateKernel::setUpdate(const Eigen::Vector3f& translationVarianceUpdate, const double yawVariance,
+                                           const Eigen::Vector3d& positionRobotToMap,
+                                           const Eigen::Vector3d& rotationAxis)
+{
+  translationVarianceUpdate_ = translationVarianceUpdate;
+  yawVariance_ = yawVariance;
+  positionRobotToMap_ = positionRobotToMap;
+  rotationAxis_ = rotationAxis;
+}
+
+bool RobotMotionMapUpdateKernel::isZero() const
+{
+  return translationVarianceUpdate_.isZero(0.0) && yawVariance_ == 0.0;
+}
+
+void RobotMotionMapUpdateKernel::apply(GridMap& rawMap, const float minVariance, const float maxVariance,
+                                       const float minHorizontalVariance, const float maxHorizontalVariance,
+                                       const TileMask* activeTiles)
+{
+  const Size& size = rawMap.getSize();
+  const float infinity = std::numeric_limits<float>::infinity();
+  const VarianceClampOperator<float> varianceClamp(minVariance, maxVariance);
+  const VarianceClampOperator<float> horizontalVarianceClamp(minHorizontalVariance, maxHorizontalVariance);
+
+  // The x-coordinate of a cell only depends on its row, the y-coordinate only on its column.
+  leverArmsX_.resize(size(0));
+  for (int i = 0; i < size(0); ++i) {
+    Position position;
+    rawMap.getPosition(Index(i, 0), position);
+    leverArmsX_(i) = positionRobotToMap_.x() + position.x();
+  }
+  leverArmsY_.resize(size(1));
+  for (int j = 0; j < size(1); ++j) {
+    Position position;
+    rawMap.getPosition(Index(0, j), position);
+    leverArmsY_(j) = positionRobotToMap_.y() + position.y();
+  }
+
+  const Matrix& elevation = rawMap.get("elevation");
+  Matrix& variance = rawMap.get("variance");
+  // The compact layers (see CompactLayers.hpp) are unpacked to the buffers for the update of a column.
+  const bool isCompact = hasCompactLayers(rawMap);
+  Matrix* horizontalVarianceX = isCompact ? nullptr : &rawMap.get("horizontal_variance_x");
+  Matrix* horizontalVarianceY = isCompact ? nullptr : &rawMap.get("horizontal_variance_y");
+  Matrix* horizontalVarianceXY = isCompact ? nullptr : &rawMap.get("horizontal_variance_xy");
+  Matrix* compactHorizontalVariances = isCompact ? &rawMap.get("compact_horizontal_variance_x_y") : nullptr;
+  Matrix* compactHorizontalVarianceXYAndTime = isCompact ? &rawMap.get("compact_horizontal_variance_xy_time") : nullptr;
+
+  // Updates the rows [startRow, startRow + numberOfRows) of column j.
+  const auto applyToColumn = [&](const int j, const int startRow, const int numberOfRows) {
+    const double leverArmY = leverArmsY_(j);
+    const auto elevationColumn = elevation.col(j).segment(startRow, numberOfRows).array();
+    isValid_ = elevationColumn.unaryExpr([](const float value) { return std::isfinite(value); });
+    heights_ = elevationColumn.cast<double>() + positionRobotToMap_.z();
+
+    // Rotation Jacobian J_R (25) times the rotation axis, i.e. the lever arm of the cell
+    // (M_r_BP) crossed with the rotation axis. The sign cancels in the products below.
+    rotationJacobiansX_ = leverArmY * rotationAxis_.z() - heights_ * rotationAxis_.y();
+    rotationJacobiansY_ = heights_ * rotationAxis_.x() - leverArmsX_.segment(startRow, numberOfRows) * rotationAxis_.z();
+
+    // Variance update, cells without elevation get infinite variance.
+    const auto constant = [&](const float value) {
+      return Eigen::ArrayXf::Constant(numberOfRows, value);
+    };
+    if (isCompact) {
+      horizontalVariancesX_.resize(numberOfRows);
+      horizontalVariancesY_.resize(numberOfRows);
+      horizontalVariancesXY_.resize(numberOfRows);
+      compactTimes_.resize(numberOfRows);
+      for (int i = 0; i < numberOfRows; ++i) {
+        unpackHalfFloats((*compactHorizontalVariances)(startRow + i, j), horizontalVariancesX_(i), horizontalVariancesY_(i));
+        unpackTimeAndHalfFloat((*compactHorizontalVarianceXYAndTime)(startRow + i, j), compactTimes_(i), horizontalVariancesXY_(i));
+      }
+    }
+    const auto getColumn = [&](Matrix* layer, Eigen::ArrayXf& buffer) {
+      return Eigen::Map<Eigen::ArrayXf>(isCompact ? buffer.data() : &(*layer)(startRow, j), numberOfRows);
+    };
+    auto varianceColumn = variance.col(j).segment(startRow, numberOfRows).array();
+    auto horizontalVarianceXColumn = getColumn(horizontalVarianceX, horizontalVariancesX_);
+    auto horizontalVarianceYColumn = getColumn(horizontalVarianceY, horizontalVariancesY_);
+    auto horizontalVarianceXYColumn = getColumn(horizontalVarianceXY, horizontalVariancesXY_);
+    varianceColumn = (varianceColumn + isValid_.select(constant(translationVarianceUpdate_.z()), infinity))
+        .unaryExpr(varianceClamp);
+    horizontalVarianceXColumn = (horizontalVarianceXColumn
+        + isValid_.select(translationVarianceUpdate_.x()
+            + ((rotationJacobiansX_ * yawVariance_) * rotationJacobiansX_).cast<float>(), infinity))
+        .unaryExpr(horizontalVarianceClamp);
+    horizontalVarianceYColumn = (horizontalVarianceYColumn
+        + isValid_.select(translationVarianceUpdate_.y()
+            + ((rotationJacobiansY_ * yawVariance_) * rotationJacobiansY_).cast<float>(), infinity))
+        .unaryExpr(horizontalVarianceClamp);
+    horizontalVarianceXYColumn += isValid_.select(
+        ((rotationJacobiansX_ * yawVariance_) * rotationJacobiansY_).cast<float>(), infinity);
+
+    if (!isCompact) return;
+    for (int i = 0; i < numberOfRows; ++i) {
+      (*compactHorizontalVariances)(startRow + i, j) = packHalfFloats(horizontalVariancesX_(i), horizontalVariancesY_(i));
+      (*compactHorizontalVarianceXYAndTime)(startRow + i, j) = packTimeAndHalfFloat(compactTimes_(i), horizontalVariancesXY_(i));
+    }
+  };
+
+  if (activeTiles == nullptr) {
+    for (int j = 0; j < size(1); ++j) applyToColumn(j, 0, size(0));
+    return;
+  }
+  activeTiles->forEachMarkedTile([&](const Index& startIndex, const Size& tileSize) {
+    for (int j = startIndex(1); j < startIndex(1) + tileSize(1); ++j) applyToColumn(j, startIndex(0), tileSize(0));
+  });
+}
+
+} /* namespace elevation_mapping */
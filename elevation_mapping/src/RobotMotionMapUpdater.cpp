@@ -16,9 +16,8 @@ using namespace kindr;
 
 namespace elevation_mapping {
 
-RobotMotionMapUpdater::RobotMotionMapUpdater(ros::NodeHandle nodeHandle)
-    : nodeHandle_(nodeHandle),
-      covarianceScale_(1.0)
+RobotMotionMapUpdater::RobotMotionMapUpdater()
+    : covarianceScale_(1.0)
 {
   previousReducedCovariance_.setZero();
   previousUpdateTime_ = ros::Time::now();
@@ -30,9 +29,9 @@ RobotMotionMapUpdater::~RobotMotionMapUpdater()
 
 }
 
-bool RobotMotionMapUpdater::readParameters()
+bool RobotMotionMapUpdater::readParameters(ros::NodeHandle& nodeHandle)
 {
-  nodeHandle_.param("robot_motion_map_update/covariance_scale", covarianceScale_, 1.0);
+  nodeHandle.param("robot_motion_map_update/covariance_scale", covarianceScale_, 1.0);
   return true;
 }
 
@@ -45,23 +44,15 @@ bool RobotMotionMapUpdater::update(
   // Check if update necessary.
   if (previousUpdateTime_ == time) return false;
 
-  // Initialize update data.
-  Size size = map.getRawGridMap().getSize();
-  Matrix varianceUpdate(size(0), size(1)); // TODO Make as grid map?
-  Matrix horizontalVarianceUpdateX(size(0), size(1));
-  Matrix horizontalVarianceUpdateY(size(0), size(1));
-  Matrix horizontalVarianceUpdateXY(size(0), size(1));
-
   // Relative convariance matrix between two robot poses.
   ReducedCovariance reducedCovariance;
   computeReducedCovariance(robotPose, robotPoseCovarianceScaled, reducedCovariance);
   ReducedCovariance relativeCovariance;
   computeRelativeCovariance(robotPose, reducedCovariance, relativeCovariance);
 
-  // Retrieve covariances for (24).
+  // Retrieve covariances for (24). Of the rotation, only the yaw variance is considered.
   Covariance positionCovariance = relativeCovariance.topLeftCorner<3, 3>();
-  Covariance rotationCovariance(Covariance::Zero());
-  rotationCovariance(2, 2) = relativeCovariance(3, 3);
+  const double yawVariance = relativeCovariance(3, 3);
 
   // Map to robot pose rotation (R_B_M = R_I_B^T * R_I_M).
   RotationMatrixPD mapToRobotRotation = RotationMatrixPD(robotPose.getRotation().inverted() * map.getPose().getRotation());
@@ -80,37 +71,10 @@ bool RobotMotionMapUpdater::update(
   const kindr::Position3D positionRobotToMap = map.getPose().getRotation().inverseRotate(
       map.getPose().getPosition() - previousRobotPose_.getPosition());
 
-  // For each cell in map. // TODO Change to new iterator.
-  for (unsigned int i = 0; i < size(0); ++i) {
-    for (unsigned int j = 0; j < size(1); ++j) {
-      kindr::Position3D cellPosition;  // M_r_MP
-
-      if (map.getRawGridMap().getPosition3("elevation", Index(i, j), cellPosition.vector())) {
-        // Rotation Jacobian J_R (25)
-        const Eigen::Matrix3d rotationJacobian = -getSkewMatrixFromVector(
-            (positionRobotToMap + cellPosition).vector())
-            * mapToPreviousRobotRotationInverted.matrix();
-
-        // Rotation variance update.
-        const Eigen::Matrix2f rotationVarianceUpdate = (rotationJacobian * rotationCovariance
-            * rotationJacobian.transpose()).topLeftCorner<2, 2>().cast<float>();
-
-        // Variance update.
-        varianceUpdate(i, j) = translationVarianceUpdate.z();
-        horizontalVarianceUpdateX(i, j) = translationVarianceUpdate.x() + rotationVarianceUpdate(0, 0);
-        horizontalVarianceUpdateY(i, j) = translationVarianceUpdate.y() + rotationVarianceUpdate(1, 1);
-        horizontalVarianceUpdateXY(i, j) = rotationVarianceUpdate(0, 1);
-      } else {
-        // Cell invalid. // TODO Change to new functions
-        varianceUpdate(i, j) = numeric_limits<float>::infinity();
-        horizontalVarianceUpdateX(i, j) = numeric_limits<float>::infinity();
-        horizontalVarianceUpdateY(i, j) = numeric_limits<float>::infinity();
-        horizontalVarianceUpdateXY(i, j) = numeric_limits<float>::infinity();
-      }
-    }
-  }
-
-  map.update(varianceUpdate, horizontalVarianceUpdateX, horizontalVarianceUpdateY, horizontalVarianceUpdateXY, time);
+  // Rotation variance update for each cell (with J_R from (25)), added to the map.
+  motionUpdateKernel_.setUpdate(translationVarianceUpdate, yawVariance, positionRobotToMap.vector(),
+                                mapToPreviousRobotRotationInverted.matrix().col(2));
+  map.update(motionUpdateKernel_, time);
   previousReducedCovariance_ = reducedCovariance;
   previousRobotPose_ = robotPose;
   return true;
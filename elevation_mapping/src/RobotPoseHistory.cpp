@@ -0,0 +1,151 @@
+/*
+ * RobotPoseHistory.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/RobotPoseHistory.hpp"
+
+namespace elevation_mapping {
+
+namespace {
+
+//! Number of attempts of a lookup that is disturbed by the writer.
+const unsigned int maxNumberOfAttempts = 8;
+
+}
+
+RobotPoseHistory::RobotPoseHistory(const size_t capacity)
+    : capacity_(0),
+      numberOfEntries_(0)
+{
+  setCapacity(capacity);
+}
+
+RobotPoseHistory::~RobotPoseHistory() {}
+
+void RobotPoseHistory::setCapacity(const size_t capacity)
+{
+  capacity_ = capacity > 0 ? capacity : 1;
+  slots_.reset(new Slot[capacity_]);
+  for (size_t i = 0; i < capacity_; ++i) slots_[i].sequence.store(0, std::memory_order_relaxed);
+  numberOfEntries_.store(0, std::memory_order_release);
+  latestTime_ = ros::Time();
+}
+
+size_t RobotPoseHistory::getCapacity() const
+{
+  return capacity_;
+}
+
+bool RobotPoseHistory::add(const Entry& entry)
+{
+  const uint64_t index = numberOfEntries_.load(std::memory_order_relaxed);
+  if (index > 0 && entry.time < latestTime_) return false;
+
+  Slot& slot = slots_[index % capacity_];
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.entry = entry;
+  slot.sequence.store(2 * index + 2, std::memory_order_release);
+  numberOfEntries_.store(index + 1, std::memory_order_release);
+  latestTime_ = entry.time;
+  return true;
+}
+
+bool RobotPoseHistory::getEntryBeforeTime(const ros::Time& time, Entry& entry) const
+{
+  Entry entryAfter;
+  bool hasEntryAfter = false;
+  return find(time, entry, entryAfter, hasEntryAfter);
+}
+
+bool RobotPoseHistory::getEntryAtTime(const ros::Time& time, Entry& entry) const
+{
+  Entry entryAfter;
+  bool hasEntryAfter = true;
+  if (!find(time, entry, entryAfter, hasEntryAfter)) return false;
+  if (!hasEntryAfter || entry.time == time) return true;
+
+  const double weight = (time - entry.time).toSec() / (entryAfter.time - entry.time).toSec();
+  entry.position = (1.0 - weight) * entry.position + weight * entryAfter.position;
+  entry.orientation = entry.orientation.slerp(weight, entryAfter.orientation);
+  entry.covariance = (1.0 - weight) * entry.covariance + weight * entryAfter.covariance;
+  entry.time = time;
+  return true;
+}
+
+ros::Time RobotPoseHistory::getLatestTime() const
+{
+  for (unsigned int attempt = 0; attempt < maxNumberOfAttempts; ++attempt) {
+    const uint64_t numberOfEntries = numberOfEntries_.load(std::memory_order_acquire);
+    if (numberOfEntries == 0) return ros::Time();
+    ros::Time time;
+    if (readTime(numberOfEntries - 1, time)) return time;
+  }
+  return ros::Time();
+}
+
+size_t RobotPoseHistory::size() const
+{
+  const uint64_t numberOfEntries = numberOfEntries_.load(std::memory_order_acquire);
+  return numberOfEntries < capacity_ ? numberOfEntries : capacity_;
+}
+
+bool RobotPoseHistory::readTime(const uint64_t index, ros::Time& time) const
+{
+  const Slot& slot = slots_[index % capacity_];
+  const uint64_t sequence = 2 * index + 2;
+  if (slot.sequence.load(std::memory_order_acquire) != sequence) return false;
+  time = slot.entry.time;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+bool RobotPoseHistory::readEntry(const uint64_t index, Entry& entry) const
+{
+  const Slot& slot = slots_[index % capacity_];
+  const uint64_t sequence = 2 * index + 2;
+  if (slot.sequence.load(std::memory_order_acquire) != sequence) return false;
+  entry = slot.entry;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+bool RobotPoseHistory::find(const ros::Time& time, Entry& entryBefore, Entry& entryAfter, bool& hasEntryAfter) const
+{
+  const bool isEntryAfterRequested = hasEntryAfter;
+  for (unsigned int attempt = 0; attempt < maxNumberOfAttempts; ++attempt) {
+    const uint64_t end = numberOfEntries_.load(std::memory_order_acquire);
+    if (end == 0) return false;
+    const uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+
+    // Binary search for the first pose after the time.
+    uint64_t lower = begin;
+    uint64_t upper = end;
+    bool isOverwritten = false;
+    while (lower < upper) {
+      const uint64_t middle = lower + (upper - lower) / 2;
+      ros::Time middleTime;
+      if (!readTime(middle, middleTime)) {
+        isOverwritten = true;
+        break;
+      }
+      if (middleTime <= time) {
+        lower = middle + 1;
+      } else {
+        upper = middle;
+      }
+    }
+    if (isOverwritten) continue;
+    if (lower == begin) return false;
+
+    if (!readEntry(lower - 1, entryBefore)) continue;
+    hasEntryAfter = isEntryAfterRequested && lower < end;
+    if (hasEntryAfter && !readEntry(lower, entryAfter)) continue;
+    return true;
+  }
+  return false;
+}
+
+} /* namespace elevation_mapping */
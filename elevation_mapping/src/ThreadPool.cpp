@@ -0,0 +1,125 @@
+/*
+ * ThreadPool.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/ThreadPool.hpp"
+
+// Boost
+#include <boost/bind.hpp>
+
+// STL
+#include <algorithm>
+
+namespace elevation_mapping {
+
+ThreadPool::ThreadPool(unsigned int numberOfThreads)
+    : numberOfThreads_(1),
+      function_(nullptr),
+      size_(0),
+      grainSize_(1),
+      nextIndex_(0),
+      numberOfActiveWorkers_(0),
+      generation_(0),
+      isStopping_(false)
+{
+  start(numberOfThreads);
+}
+
+ThreadPool::~ThreadPool()
+{
+  stop();
+}
+
+void ThreadPool::setNumberOfThreads(unsigned int numberOfThreads)
+{
+  boost::mutex::scoped_lock callLock(callMutex_);
+  stop();
+  start(numberOfThreads);
+}
+
+unsigned int ThreadPool::getNumberOfThreads() const
+{
+  return numberOfThreads_;
+}
+
+void ThreadPool::parallelFor(size_t size, size_t grainSize, const RangeFunction& function)
+{
+  if (size == 0) return;
+  grainSize = std::max(grainSize, size_t(1));
+  boost::mutex::scoped_lock callLock(callMutex_);
+
+  if (numberOfThreads_ <= 1 || size <= grainSize) {
+    function(0, size, 0);
+    return;
+  }
+
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    function_ = &function;
+    size_ = size;
+    grainSize_ = grainSize;
+    nextIndex_ = 0;
+    numberOfActiveWorkers_ = numberOfThreads_ - 1;
+    ++generation_;
+  }
+  jobCondition_.notify_all();
+
+  processChunks(0);
+
+  boost::mutex::scoped_lock lock(mutex_);
+  while (numberOfActiveWorkers_ > 0) finishedCondition_.wait(lock);
+  function_ = nullptr;
+}
+
+void ThreadPool::start(unsigned int numberOfThreads)
+{
+  if (numberOfThreads == 0) numberOfThreads = std::max(boost::thread::hardware_concurrency(), 1u);
+  numberOfThreads_ = numberOfThreads;
+  isStopping_ = false;
+  for (unsigned int i = 1; i < numberOfThreads_; ++i) {
+    workers_.emplace_back(new boost::thread(boost::bind(&ThreadPool::runWorker, this, i, generation_)));
+  }
+}
+
+void ThreadPool::stop()
+{
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    isStopping_ = true;
+  }
+  jobCondition_.notify_all();
+  for (auto& worker : workers_) worker->join();
+  workers_.clear();
+  numberOfThreads_ = 1;
+}
+
+void ThreadPool::runWorker(unsigned int threadIndex, unsigned long generation)
+{
+  unsigned long processedGeneration = generation;
+  while (true) {
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      while (!isStopping_ && generation_ == processedGeneration) jobCondition_.wait(lock);
+      if (isStopping_) return;
+      processedGeneration = generation_;
+    }
+
+    processChunks(threadIndex);
+
+    boost::mutex::scoped_lock lock(mutex_);
+    if (--numberOfActiveWorkers_ == 0) finishedCondition_.notify_all();
+  }
+}
+
+void ThreadPool::processChunks(unsigned int threadIndex)
+{
+  while (true) {
+    const size_t begin = nextIndex_.fetch_add(grainSize_);
+    if (begin >= size_) return;
+    (*function_)(begin, std::min(begin + grainSize_, size_), threadIndex);
+  }
+}
+
+} /* namespace elevation_mapping */
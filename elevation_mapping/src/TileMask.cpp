@@ -0,0 +1,303 @@
+/*
+ * TileMask.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/TileMask.hpp"
+
+// STL
+#include <algorithm>
+#include <cmath>
+
+namespace elevation_mapping {
+
+TileMask::TileMask(const unsigned int tileSize)
+    : tileSize_(static_cast<int>(std::max(tileSize, 1u))),
+      size_(0, 0),
+      numberOfTiles_(0, 0)
+{
+}
+
+TileMask::~TileMask()
+{
+}
+
+void TileMask::setSize(const grid_map::Size& size)
+{
+  size_ = size;
+  numberOfTiles_ = (size + tileSize_ - 1) / tileSize_;
+  marks_.assign(numberOfTiles_.prod(), 1);
+}
+
+void TileMask::markAll()
+{
+  std::fill(marks_.begin(), marks_.end(), 1);
+}
+
+void TileMask::reset()
+{
+  std::fill(marks_.begin(), marks_.end(), 0);
+}
+
+void TileMask::markRegion(const grid_map::Index& startIndex, const grid_map::Size& size)
+{
+  if ((size <= 0).any()) return;
+  if ((size >= size_).all()) {
+    markAll();
+    return;
+  }
+
+  std::vector<int> tiles[2];
+  getRegionTiles(startIndex, size, false, tiles);
+  for (const auto tileCol : tiles[1]) {
+    for (const auto tileRow : tiles[0]) {
+      marks_[getTile(tileRow, tileCol)] = 1;
+    }
+  }
+}
+
+void TileMask::unmarkRegion(const grid_map::Index& startIndex, const grid_map::Size& size)
+{
+  if ((size <= 0).any()) return;
+  if ((size >= size_).all()) {
+    reset();
+    return;
+  }
+
+  std::vector<int> tiles[2];
+  getRegionTiles(startIndex, size, true, tiles);
+  for (const auto tileCol : tiles[1]) {
+    for (const auto tileRow : tiles[0]) {
+      marks_[getTile(tileRow, tileCol)] = 0;
+    }
+  }
+}
+
+bool TileMask::isRegionMarked(const grid_map::Index& startIndex, const grid_map::Size& size) const
+{
+  if ((size <= 0).any()) return false;
+
+  std::vector<int> tiles[2];
+  getRegionTiles(startIndex, size, false, tiles);
+  for (const auto tileCol : tiles[1]) {
+    for (const auto tileRow : tiles[0]) {
+      if (marks_[getTile(tileRow, tileCol)]) return true;
+    }
+  }
+  return false;
+}
+
+void TileMask::merge(const TileMask& other)
+{
+  if (other.marks_.size() != marks_.size()) {
+    markAll();
+    return;
+  }
+  for (size_t i = 0; i < marks_.size(); ++i) marks_[i] |= other.marks_[i];
+}
+
+void TileMask::dilate(const unsigned int radius)
+{
+  if (marks_.empty() || radius == 0) return;
+
+  // Across the buffer border, neighboring cells can be one tile further apart.
+  const int radiusInTiles = (static_cast<int>(radius) + tileSize_ - 1) / tileSize_ + 1;
+  std::vector<uint8_t> buffer(marks_.size());
+
+  // Separable dilation, first along the rows and then along the columns.
+  for (int d = 0; d < 2; ++d) {
+    const int numberOfTiles = numberOfTiles_(d);
+    const bool isFullRange = 2 * radiusInTiles + 1 >= numberOfTiles;
+    std::fill(buffer.begin(), buffer.end(), 0);
+    for (int tileCol = 0; tileCol < numberOfTiles_(1); ++tileCol) {
+      for (int tileRow = 0; tileRow < numberOfTiles_(0); ++tileRow) {
+        if (!marks_[getTile(tileRow, tileCol)]) continue;
+        const int tile = (d == 0 ? tileRow : tileCol);
+        const int begin = isFullRange ? 0 : tile - radiusInTiles;
+        const int end = isFullRange ? numberOfTiles - 1 : tile + radiusInTiles;
+        for (int t = begin; t <= end; ++t) {
+          const int wrappedTile = (t % numberOfTiles + numberOfTiles) % numberOfTiles;
+          if (d == 0) {
+            buffer[getTile(wrappedTile, tileCol)] = 1;
+          } else {
+            buffer[getTile(tileRow, wrappedTile)] = 1;
+          }
+        }
+      }
+    }
+    marks_.swap(buffer);
+  }
+}
+
+void TileMask::unmarkEmptyTiles(const grid_map::Matrix& layer)
+{
+  for (int tileCol = 0; tileCol < numberOfTiles_(1); ++tileCol) {
+    for (int tileRow = 0; tileRow < numberOfTiles_(0); ++tileRow) {
+      uint8_t& mark = marks_[getTile(tileRow, tileCol)];
+      if (!mark) continue;
+      grid_map::Index startIndex;
+      grid_map::Size size;
+      getTileRegion(grid_map::Index(tileRow, tileCol), startIndex, size);
+      const auto block = layer.block(startIndex(0), startIndex(1), size(0), size(1));
+      if (!block.unaryExpr([](const float value) { return std::isfinite(value); }).any()) mark = 0;
+    }
+  }
+}
+
+bool TileMask::isAnyMarked() const
+{
+  return std::find(marks_.begin(), marks_.end(), 1) != marks_.end();
+}
+
+void TileMask::getTileRegion(const grid_map::Index& tileIndex, grid_map::Index& startIndex, grid_map::Size& size) const
+{
+  startIndex = tileIndex * tileSize_;
+  size = (size_ - startIndex).min(tileSize_);
+}
+
+bool TileMask::getBoundingRegion(const grid_map::Index& bufferStartIndex, grid_map::Index& startIndex,
+                                 grid_map::Size& size) const
+{
+  // Tile rows and columns with marked tiles.
+  std::vector<uint8_t> isTileMarked[2];
+  for (int d = 0; d < 2; ++d) isTileMarked[d].assign(numberOfTiles_(d), 0);
+  bool isAnyTileMarked = false;
+  for (int tileCol = 0; tileCol < numberOfTiles_(1); ++tileCol) {
+    for (int tileRow = 0; tileRow < numberOfTiles_(0); ++tileRow) {
+      if (!marks_[getTile(tileRow, tileCol)]) continue;
+      isTileMarked[0][tileRow] = 1;
+      isTileMarked[1][tileCol] = 1;
+      isAnyTileMarked = true;
+    }
+  }
+  if (!isAnyTileMarked) return false;
+
+  // Range of the cells of these tiles relative to the buffer start index.
+  for (int d = 0; d < 2; ++d) {
+    int first = size_(d);
+    int last = -1;
+    for (int tile = 0; tile < numberOfTiles_(d); ++tile) {
+      if (!isTileMarked[d][tile]) continue;
+      const int end = std::min((tile + 1) * tileSize_, size_(d));
+      for (int cell = tile * tileSize_; cell < end; ++cell) {
+        const int unwrappedCell = (cell - bufferStartIndex(d) + size_(d)) % size_(d);
+        first = std::min(first, unwrappedCell);
+        last = std::max(last, unwrappedCell);
+      }
+    }
+    startIndex(d) = first;
+    size(d) = last - first + 1;
+  }
+  return true;
+}
+
+std::vector<TileMask::Region> TileMask::getMarkedRegions(const grid_map::Index& bufferStartIndex) const
+{
+  std::vector<Region> regions;
+  if (!isAnyMarked()) return regions;
+
+  // Intervals of the unwrapped cells that belong to a single tile in each direction (a tile is
+  // split into two intervals by the buffer start index).
+  std::vector<int> bounds[2];
+  for (int d = 0; d < 2; ++d) {
+    bounds[d].push_back(0);
+    bounds[d].push_back(size_(d));
+    for (int tile = 0; tile < numberOfTiles_(d); ++tile) {
+      bounds[d].push_back((tile * tileSize_ - bufferStartIndex(d) + size_(d)) % size_(d));
+    }
+    std::sort(bounds[d].begin(), bounds[d].end());
+    bounds[d].erase(std::unique(bounds[d].begin(), bounds[d].end()), bounds[d].end());
+  }
+  const auto getTileOfInterval = [&](const int d, const size_t interval) {
+    return ((bounds[d][interval] + bufferStartIndex(d)) % size_(d)) / tileSize_;
+  };
+
+  // Runs of marked intervals along the rows, merged with the runs of the previous column interval
+  // if they cover the same rows.
+  std::vector<Region> openRegions;
+  for (size_t colInterval = 0; colInterval + 1 < bounds[1].size(); ++colInterval) {
+    const int tileCol = getTileOfInterval(1, colInterval);
+    const int startCol = bounds[1][colInterval];
+    const int numberOfCols = bounds[1][colInterval + 1] - startCol;
+    std::vector<Region> columnRegions;
+    for (size_t rowInterval = 0; rowInterval + 1 < bounds[0].size(); ++rowInterval) {
+      if (!marks_[getTile(getTileOfInterval(0, rowInterval), tileCol)]) continue;
+      const int startRow = bounds[0][rowInterval];
+      const int endRow = bounds[0][rowInterval + 1];
+      if (!columnRegions.empty() && columnRegions.back().startIndex(0) + columnRegions.back().size(0) == startRow) {
+        columnRegions.back().size(0) = endRow - columnRegions.back().startIndex(0);
+      } else {
+        Region region;
+        region.startIndex = grid_map::Index(startRow, startCol);
+        region.size = grid_map::Size(endRow - startRow, numberOfCols);
+        columnRegions.push_back(region);
+      }
+    }
+
+    std::vector<Region> nextOpenRegions;
+    for (const auto& columnRegion : columnRegions) {
+      const auto openRegion = std::find_if(openRegions.begin(), openRegions.end(), [&](const Region& region) {
+        return region.startIndex(0) == columnRegion.startIndex(0) && region.size(0) == columnRegion.size(0);
+      });
+      if (openRegion == openRegions.end()) {
+        nextOpenRegions.push_back(columnRegion);
+        continue;
+      }
+      nextOpenRegions.push_back(*openRegion);
+      nextOpenRegions.back().size(1) += numberOfCols;
+      openRegions.erase(openRegion);
+    }
+    regions.insert(regions.end(), openRegions.begin(), openRegions.end());
+    openRegions.swap(nextOpenRegions);
+  }
+  regions.insert(regions.end(), openRegions.begin(), openRegions.end());
+  return regions;
+}
+
+void TileMask::extendRegionToTiles(grid_map::Index& startIndex, grid_map::Size& size) const
+{
+  for (int d = 0; d < 2; ++d) {
+    if (size(d) >= size_(d)) {
+      size(d) = size_(d);
+      continue;
+    }
+    const int begin = startIndex(d) - startIndex(d) % tileSize_;
+    // The tile borders are at multiples of the tile size from the buffer border (the last tile may be smaller).
+    const int end = startIndex(d) + size(d);
+    const int offset = end > size_(d) ? size_(d) : 0;
+    const int extendedEnd = offset + std::min((end - offset + tileSize_ - 1) / tileSize_ * tileSize_, size_(d));
+    startIndex(d) = begin;
+    size(d) = std::min(extendedEnd - begin, size_(d));
+  }
+}
+
+void TileMask::getRegionTiles(const grid_map::Index& startIndex, const grid_map::Size& size, const bool isCoveredOnly,
+                              std::vector<int> tiles[2]) const
+{
+  for (int d = 0; d < 2; ++d) {
+    const int regionSize = std::min(size(d), size_(d));
+    const int firstTile = startIndex(d) / tileSize_;
+    const int lastCell = startIndex(d) + regionSize - 1;
+    std::vector<int> overlappingTiles;
+    if (lastCell < size_(d)) {
+      for (int t = firstTile; t <= lastCell / tileSize_; ++t) overlappingTiles.push_back(t);
+    } else {
+      for (int t = firstTile; t < numberOfTiles_(d); ++t) overlappingTiles.push_back(t);
+      for (int t = 0; t <= (lastCell - size_(d)) / tileSize_; ++t) overlappingTiles.push_back(t);
+    }
+    for (const auto t : overlappingTiles) {
+      if (isCoveredOnly) {
+        // Offsets of the first and the last cell of the tile from the start of the region.
+        const int firstCell = t * tileSize_;
+        const int lastCellOfTile = std::min(firstCell + tileSize_, size_(d)) - 1;
+        const int firstOffset = (firstCell - startIndex(d) + size_(d)) % size_(d);
+        const int lastOffset = (lastCellOfTile - startIndex(d) + size_(d)) % size_(d);
+        if (firstOffset > lastOffset || lastOffset >= regionSize) continue;
+      }
+      tiles[d].push_back(t);
+    }
+  }
+}
+
+} /* namespace elevation_mapping */
@@ -0,0 +1,16 @@
+/*
+ * elevation_mapping_replay_node.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include <ros/ros.h>
+#include "elevation_mapping/BagReplay.hpp"
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "elevation_mapping_replay");
+  ros::NodeHandle nodeHandle("~");
+  elevation_mapping::BagReplay bagReplay(nodeHandle);
+  return bagReplay.run() ? 0 : 1;
+}
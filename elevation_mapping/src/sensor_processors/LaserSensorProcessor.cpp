@@ -25,8 +25,42 @@ namespace elevation_mapping {
  * International Conference on Applied Robotics for the Power Industry (CARPI), 2012.
  */
 
-LaserSensorProcessor::LaserSensorProcessor(ros::NodeHandle& nodeHandle, tf::TransformListener& transformListener)
-    : SensorProcessorBase(nodeHandle, transformListener)
+namespace {
+
+typedef SensorProcessingKernel::BatchArray BatchArray;
+
+//! Laser sensor model for the single pass processing.
+class LaserSensorModel
+{
+ public:
+  explicit LaserSensorModel(const LaserSensorProcessor::Parameters& parameters)
+      : minRadius_(parameters.minRadius),
+        beamAngle_(parameters.beamAngle),
+        beamConstant_(parameters.beamConstant)
+  {
+  }
+
+  bool isValid(const Eigen::Vector3f& /*pointSensorFrame*/) const
+  {
+    return true;
+  }
+
+  void computeSensorVariances(const SensorProcessingKernel::PointBatch& points, BatchArray& varianceLateral,
+                              BatchArray& varianceNormal) const
+  {
+    const BatchArray measurementDistance = (points.x.square() + points.y.square() + points.z.square()).sqrt();
+    varianceNormal.setConstant(minRadius_ * minRadius_);
+    varianceLateral = (beamConstant_ + beamAngle_ * measurementDistance).square();
+  }
+
+ private:
+  const float minRadius_, beamAngle_, beamConstant_;
+};
+
+}
+
+LaserSensorProcessor::LaserSensorProcessor(tf::Transformer& transformer)
+    : SensorProcessorBase(transformer)
 {
 
 }
@@ -36,12 +70,22 @@ LaserSensorProcessor::~LaserSensorProcessor()
 
 }
 
-bool LaserSensorProcessor::readParameters()
+void LaserSensorProcessor::setParameters(const Parameters& parameters)
 {
-  SensorProcessorBase::readParameters();
-  nodeHandle_.param("sensor_processor/min_radius", sensorParameters_["min_radius"], 0.0);
-  nodeHandle_.param("sensor_processor/beam_angle", sensorParameters_["beam_angle"], 0.0);
-  nodeHandle_.param("sensor_processor/beam_constant", sensorParameters_["beam_constant"], 0.0);
+  parameters_ = parameters;
+}
+
+const LaserSensorProcessor::Parameters& LaserSensorProcessor::getParameters() const
+{
+  return parameters_;
+}
+
+bool LaserSensorProcessor::readParameters(ros::NodeHandle& nodeHandle)
+{
+  SensorProcessorBase::readParameters(nodeHandle);
+  nodeHandle.param("sensor_processor/min_radius", parameters_.minRadius, 0.0);
+  nodeHandle.param("sensor_processor/beam_angle", parameters_.beamAngle, 0.0);
+  nodeHandle.param("sensor_processor/beam_constant", parameters_.beamConstant, 0.0);
   return true;
 }
 
@@ -56,6 +100,13 @@ bool LaserSensorProcessor::cleanPointCloud(const pcl::PointCloud<pcl::PointXYZRG
   return true;
 }
 
+void LaserSensorProcessor::processPoints(const PointCloudBuffer& pointCloud, const SensorProcessingKernel& kernel,
+                                         pcl::PointCloud<pcl::PointXYZRGB>& pointCloudMapFrame,
+                                         Eigen::VectorXf& variances)
+{
+  kernel.process(pointCloud, LaserSensorModel(parameters_), pointCloudMapFrame, variances);
+}
+
 bool LaserSensorProcessor::computeVariances(
 		const pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr pointCloud,
 		const Eigen::Matrix<double, 6, 6>& robotPoseCovariance,
@@ -90,8 +141,8 @@ bool LaserSensorProcessor::computeVariances(
 		float measurementDistance = pointVector.norm();
 
 		// Compute sensor covariance matrix (Sigma_S) with sensor model.
-		float varianceNormal = pow(sensorParameters_.at("min_radius"), 2);
-		float varianceLateral = pow(sensorParameters_.at("beam_constant") + sensorParameters_.at("beam_angle") * measurementDistance, 2);
+		float varianceNormal = pow(parameters_.minRadius, 2);
+		float varianceLateral = pow(parameters_.beamConstant + parameters_.beamAngle * measurementDistance, 2);
 		Eigen::Matrix3f sensorVariance = Eigen::Matrix3f::Zero();
 		sensorVariance.diagonal() << varianceLateral, varianceLateral, varianceNormal;
 
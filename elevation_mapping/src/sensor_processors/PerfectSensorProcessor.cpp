@@ -22,8 +22,30 @@ namespace elevation_mapping {
  * Noiseless, perfect sensor.
  */
 
-PerfectSensorProcessor::PerfectSensorProcessor(ros::NodeHandle& nodeHandle, tf::TransformListener& transformListener)
-    : SensorProcessorBase(nodeHandle, transformListener)
+namespace {
+
+//! Noiseless sensor model for the single pass processing.
+class PerfectSensorModel
+{
+ public:
+  bool isValid(const Eigen::Vector3f& /*pointSensorFrame*/) const
+  {
+    return true;
+  }
+
+  void computeSensorVariances(const SensorProcessingKernel::PointBatch& /*points*/,
+                              SensorProcessingKernel::BatchArray& varianceLateral,
+                              SensorProcessingKernel::BatchArray& varianceNormal) const
+  {
+    varianceLateral.setZero();
+    varianceNormal.setZero();
+  }
+};
+
+}
+
+PerfectSensorProcessor::PerfectSensorProcessor(tf::Transformer& transformer)
+    : SensorProcessorBase(transformer)
 {
 
 }
@@ -33,7 +55,7 @@ PerfectSensorProcessor::~PerfectSensorProcessor()
 
 }
 
-bool PerfectSensorProcessor::readParameters()
+bool PerfectSensorProcessor::readParameters(ros::NodeHandle& nodeHandle)
 {
   return true;
 }
@@ -49,6 +71,13 @@ bool PerfectSensorProcessor::cleanPointCloud(const pcl::PointCloud<pcl::PointXYZ
   return true;
 }
 
+void PerfectSensorProcessor::processPoints(const PointCloudBuffer& pointCloud, const SensorProcessingKernel& kernel,
+                                           pcl::PointCloud<pcl::PointXYZRGB>& pointCloudMapFrame,
+                                           Eigen::VectorXf& variances)
+{
+  kernel.process(pointCloud, PerfectSensorModel(), pointCloudMapFrame, variances);
+}
+
 bool PerfectSensorProcessor::computeVariances(
 		const pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr pointCloud,
 		const Eigen::Matrix<double, 6, 6>& robotPoseCovariance,
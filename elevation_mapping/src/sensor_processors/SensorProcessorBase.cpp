@@ -19,38 +19,62 @@
 #include <tf_conversions/tf_eigen.h>
 
 // STL
+#include <algorithm>
 #include <limits>
 #include <math.h>
 #include <vector>
 
 namespace elevation_mapping {
 
-SensorProcessorBase::SensorProcessorBase(ros::NodeHandle& nodeHandle, tf::TransformListener& transformListener)
-    : nodeHandle_(nodeHandle),
-      transformListener_(transformListener),
+namespace {
+
+/*!
+ * Reads a parameter from the namespace of the node handle or, if it is not set there, from the
+ * closest parent namespace (e.g. the parameters shared by all sensor inputs of the node).
+ */
+template<typename Type>
+void searchParam(ros::NodeHandle& nodeHandle, const std::string& name, Type& value, const Type& defaultValue)
+{
+  std::string key;
+  if (!nodeHandle.searchParam(name, key)) {
+    value = defaultValue;
+    return;
+  }
+  nodeHandle.param(key, value, defaultValue);
+}
+
+}
+
+SensorProcessorBase::SensorProcessorBase(tf::Transformer& transformer)
+    : transformListener_(transformer),
       ignorePointsUpperThreshold_(std::numeric_limits<double>::infinity()),
-      ignorePointsLowerThreshold_(-std::numeric_limits<double>::infinity())
+      ignorePointsLowerThreshold_(-std::numeric_limits<double>::infinity()),
+      enableSinglePassProcessing_(true),
+      staticTransformationsVersion_(0),
+      statistics_(nullptr)
 {
   pcl::console::setVerbosityLevel(pcl::console::L_ERROR);
 	transformationSensorToMap_.setIdentity();
+	transformationBaseToMap_.setIdentity();
 	transformListenerTimeout_.fromSec(1.0);
 }
 
 SensorProcessorBase::~SensorProcessorBase() {}
 
-bool SensorProcessorBase::readParameters()
+bool SensorProcessorBase::readParameters(ros::NodeHandle& nodeHandle)
 {
-  nodeHandle_.param("sensor_frame_id", sensorFrameId_, std::string("/sensor")); // TODO Fail if parameters are not found.
-  nodeHandle_.param("robot_base_frame_id", robotBaseFrameId_, std::string("/robot"));
-  nodeHandle_.param("map_frame_id", mapFrameId_, std::string("/map"));
+  nodeHandle.param("sensor_frame_id", sensorFrameId_, std::string("/sensor")); // TODO Fail if parameters are not found.
+  searchParam(nodeHandle, "robot_base_frame_id", robotBaseFrameId_, std::string("/robot"));
+  searchParam(nodeHandle, "map_frame_id", mapFrameId_, std::string("/map"));
 
   double minUpdateRate;
-  nodeHandle_.param("min_update_rate", minUpdateRate, 2.0);
+  searchParam(nodeHandle, "min_update_rate", minUpdateRate, 2.0);
   transformListenerTimeout_.fromSec(1.0 / minUpdateRate);
   ROS_ASSERT(!transformListenerTimeout_.isZero());
 
-  nodeHandle_.param("sensor_processor/ignore_points_above", ignorePointsUpperThreshold_, std::numeric_limits<double>::infinity());
-  nodeHandle_.param("sensor_processor/ignore_points_below", ignorePointsLowerThreshold_, -std::numeric_limits<double>::infinity());
+  nodeHandle.param("sensor_processor/ignore_points_above", ignorePointsUpperThreshold_, std::numeric_limits<double>::infinity());
+  nodeHandle.param("sensor_processor/ignore_points_below", ignorePointsLowerThreshold_, -std::numeric_limits<double>::infinity());
+  nodeHandle.param("sensor_processor/enable_single_pass", enableSinglePassProcessing_, true);
   return true;
 }
 
@@ -60,12 +84,92 @@ bool SensorProcessorBase::process(
 		const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloudMapFrame,
 		Eigen::VectorXf& variances)
 {
+  if (enableSinglePassProcessing_) {
+    inputBuffer_.fromPointCloud(*pointCloudInput);
+    return process(inputBuffer_, robotPoseCovariance, pointCloudMapFrame, variances);
+  }
+
   ros::Time timeStamp;
   timeStamp.fromNSec(1000 * pointCloudInput->header.stamp);
+  ScopedTimer transformWaitTimer(statistics_, PerformanceStatistics::Stage::TransformWait);
   if (!updateTransformations(timeStamp)) return false;
+  transformWaitTimer.stop();
 
+  ScopedTimer timer(statistics_, PerformanceStatistics::Stage::SensorProcessing);
 	pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloudSensorFrame(new pcl::PointCloud<pcl::PointXYZRGB>);
 	transformPointCloud(pointCloudInput, pointCloudSensorFrame, sensorFrameId_);
+	if (!processSensorFrame(pointCloudSensorFrame, robotPoseCovariance, pointCloudMapFrame, variances)) return false;
+	countPoints(pointCloudInput->size(), pointCloudMapFrame->size());
+	return true;
+}
+
+bool SensorProcessorBase::process(
+    const PointCloudBuffer& pointCloudInput,
+    const Eigen::Matrix<double, 6, 6>& robotPoseCovariance,
+    const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloudMapFrame,
+    Eigen::VectorXf& variances)
+{
+  const ros::Time& timeStamp = pointCloudInput.getTimeStamp();
+  ScopedTimer transformWaitTimer(statistics_, PerformanceStatistics::Stage::TransformWait);
+  if (!updateTransformations(timeStamp)) return false;
+  Eigen::Affine3d transformationInputToSensor;
+  if (!lookupTransformation(sensorFrameId_, pointCloudInput.getFrameId(), timeStamp, transformationInputToSensor)) return false;
+  transformWaitTimer.stop();
+
+  ScopedTimer timer(statistics_, PerformanceStatistics::Stage::SensorProcessing);
+  if (enableSinglePassProcessing_) {
+    processPoints(pointCloudInput, createProcessingKernel(transformationInputToSensor, robotPoseCovariance),
+                  *pointCloudMapFrame, variances);
+    pointCloudMapFrame->header.frame_id = mapFrameId_;
+    pointCloudMapFrame->header.stamp = timeStamp.toNSec() / 1000;
+    countPoints(pointCloudInput.size(), pointCloudMapFrame->size());
+    ROS_DEBUG("process() reduced point cloud to %i points.", static_cast<int>(pointCloudMapFrame->size()));
+    return true;
+  }
+
+  const Eigen::Affine3f transformation = transformationInputToSensor.cast<float>();
+
+  // Copy the points from the buffer and transform them to the sensor frame (NaN stays NaN).
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloudSensorFrame(
+      new pcl::PointCloud<pcl::PointXYZRGB>(pointCloudInput.getWidth(), pointCloudInput.getHeight()));
+  pointCloudSensorFrame->header.frame_id = sensorFrameId_;
+  pointCloudSensorFrame->header.stamp = timeStamp.toNSec() / 1000;
+  pointCloudSensorFrame->is_dense = false;
+  const std::vector<float>& x = pointCloudInput.getX();
+  const std::vector<float>& y = pointCloudInput.getY();
+  const std::vector<float>& z = pointCloudInput.getZ();
+  for (size_t i = 0; i < pointCloudInput.size(); ++i) {
+    pcl::PointXYZRGB& point = pointCloudSensorFrame->points[i];
+    point.getVector3fMap() = transformation * Eigen::Vector3f(x[i], y[i], z[i]);
+  }
+  if (pointCloudInput.hasColor()) {
+    const std::vector<uint32_t>& rgba = pointCloudInput.getRgba();
+    for (size_t i = 0; i < pointCloudInput.size(); ++i) pointCloudSensorFrame->points[i].rgba = rgba[i];
+  }
+
+  if (!processSensorFrame(pointCloudSensorFrame, robotPoseCovariance, pointCloudMapFrame, variances)) return false;
+  countPoints(pointCloudInput.size(), pointCloudMapFrame->size());
+  return true;
+}
+
+void SensorProcessorBase::setPerformanceStatistics(PerformanceStatistics* statistics)
+{
+  statistics_ = statistics;
+}
+
+void SensorProcessorBase::countPoints(const size_t numberOfInputPoints, const size_t numberOfOutputPoints)
+{
+  if (statistics_ == nullptr) return;
+  statistics_->increment(PerformanceStatistics::Counter::SensorProcessingInputPoints, numberOfInputPoints);
+  statistics_->increment(PerformanceStatistics::Counter::SensorProcessingOutputPoints, numberOfOutputPoints);
+}
+
+bool SensorProcessorBase::processSensorFrame(
+    const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloudSensorFrame,
+    const Eigen::Matrix<double, 6, 6>& robotPoseCovariance,
+    const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloudMapFrame,
+    Eigen::VectorXf& variances)
+{
 	cleanPointCloud(pointCloudSensorFrame);
 
 	if (!transformPointCloud(pointCloudSensorFrame, pointCloudMapFrame, mapFrameId_)) return false;
@@ -78,29 +182,125 @@ bool SensorProcessorBase::process(
 
 bool SensorProcessorBase::updateTransformations(const ros::Time& timeStamp)
 {
+  transformationTimeStamp_ = ros::Time();
   try {
-    transformListener_.waitForTransform(sensorFrameId_, mapFrameId_, timeStamp, ros::Duration(1.0));
-
+    transformListener_.waitForTransform(mapFrameId_, sensorFrameId_, timeStamp, transformListenerTimeout_);
     tf::StampedTransform transformTf;
     transformListener_.lookupTransform(mapFrameId_, sensorFrameId_, timeStamp, transformTf);
     poseTFToEigen(transformTf, transformationSensorToMap_);
+  } catch (tf::TransformException &ex) {
+    ROS_ERROR("%s", ex.what());
+    return false;
+  }
+
+  // The pose of the sensor in the base frame (from the base to the sensor frame, B_r_BS).
+  Eigen::Affine3d transform;
+  if (!lookupTransformation(robotBaseFrameId_, sensorFrameId_, timeStamp, transform)) return false;
+  rotationBaseToSensor_.setMatrix(transform.rotation().matrix());
+  translationBaseToSensorInBaseFrame_.toImplementation() = transform.translation();
+
+  transformationBaseToMap_ = transformationSensorToMap_ * transform.inverse(Eigen::Isometry);
+  rotationMapToBase_.setMatrix(transformationBaseToMap_.rotation().matrix());
+  translationMapToBaseInMapFrame_.toImplementation() = transformationBaseToMap_.translation();
+
+  transformationTimeStamp_ = timeStamp;
+  return true;
+}
 
-    transformListener_.lookupTransform(robotBaseFrameId_, sensorFrameId_, timeStamp, transformTf);  // TODO Why wrong direction?
-    Eigen::Affine3d transform;
-    poseTFToEigen(transformTf, transform);
-    rotationBaseToSensor_.setMatrix(transform.rotation().matrix());
-    translationBaseToSensorInBaseFrame_.toImplementation() = transform.translation();
+void SensorProcessorBase::addStaticTransformations(const std::vector<geometry_msgs::TransformStamped>& transforms)
+{
+  boost::mutex::scoped_lock lock(staticTransformationsMutex_);
+  for (const auto& transform : transforms) {
+    staticParentFrameIds_[tf::strip_leading_slash(transform.child_frame_id)] = tf::strip_leading_slash(transform.header.frame_id);
+  }
+  staticTransformations_.clear();
+  ++staticTransformationsVersion_;
+}
+
+bool SensorProcessorBase::isStaticTransformation(const std::string& targetFrameId, const std::string& sourceFrameId) const
+{
+  // Static frames starting from the source frame towards the root of the tree.
+  static const size_t maxTreeDepth = 100;
+  std::vector<std::string> sourceFrameIds({sourceFrameId});
+  for (size_t i = 0; i < maxTreeDepth; ++i) {
+    const auto parent = staticParentFrameIds_.find(sourceFrameIds.back());
+    if (parent == staticParentFrameIds_.end()) break;
+    sourceFrameIds.push_back(parent->second);
+  }
+
+  // The transformation is static if a static frame of the target frame is one of them.
+  std::string frameId = targetFrameId;
+  for (size_t i = 0; i < maxTreeDepth; ++i) {
+    if (std::find(sourceFrameIds.begin(), sourceFrameIds.end(), frameId) != sourceFrameIds.end()) return true;
+    const auto parent = staticParentFrameIds_.find(frameId);
+    if (parent == staticParentFrameIds_.end()) return false;
+    frameId = parent->second;
+  }
+  return false;
+}
+
+SensorProcessingKernel SensorProcessorBase::createProcessingKernel(
+    const Eigen::Affine3d& transformationInputToSensor, const Eigen::Matrix<double, 6, 6>& robotPoseCovariance) const
+{
+  const double heightLowerLimit = translationMapToBaseInMapFrame_.z() + ignorePointsLowerThreshold_;
+  const double heightUpperLimit = translationMapToBaseInMapFrame_.z() + ignorePointsUpperThreshold_;
+  const Eigen::Matrix3f rotationVariance = robotPoseCovariance.bottomRightCorner(3, 3).cast<float>();
+  return SensorProcessingKernel(transformationInputToSensor.cast<float>(), transformationSensorToMap_.cast<float>(),
+                                heightLowerLimit, heightUpperLimit, rotationMapToBase_, rotationBaseToSensor_,
+                                translationBaseToSensorInBaseFrame_, rotationVariance);
+}
 
-    transformListener_.lookupTransform(mapFrameId_, robotBaseFrameId_, timeStamp, transformTf);  // TODO Why wrong direction?
-    poseTFToEigen(transformTf, transform);
-    rotationMapToBase_.setMatrix(transform.rotation().matrix());
-    translationMapToBaseInMapFrame_.toImplementation() = transform.translation();
+bool SensorProcessorBase::lookupTransformation(const std::string& targetFrame, const std::string& sourceFrame,
+                                               const ros::Time& timeStamp, Eigen::Affine3d& transformation)
+{
+  const std::string targetFrameId = tf::strip_leading_slash(targetFrame);
+  const std::string sourceFrameId = tf::strip_leading_slash(sourceFrame);
+  if (targetFrameId == sourceFrameId) {
+    transformation.setIdentity();
+    return true;
+  }
 
+  // Transformation of the current point cloud.
+  if (!transformationTimeStamp_.isZero() && timeStamp == transformationTimeStamp_
+      && targetFrameId == tf::strip_leading_slash(mapFrameId_) && sourceFrameId == tf::strip_leading_slash(sensorFrameId_)) {
+    transformation = transformationSensorToMap_;
     return true;
+  }
+
+  // Static transformations are looked up once (at any time).
+  const std::pair<std::string, std::string> frameIds(targetFrameId, sourceFrameId);
+  boost::mutex::scoped_lock lock(staticTransformationsMutex_);
+  const bool isStatic = isStaticTransformation(targetFrameId, sourceFrameId);
+  const uint64_t staticTransformationsVersion = staticTransformationsVersion_;
+  if (isStatic) {
+    const auto staticTransformation = staticTransformations_.find(frameIds);
+    if (staticTransformation != staticTransformations_.end()) {
+      transformation = staticTransformation->second;
+      return true;
+    }
+  }
+  lock.unlock();
+
+  tf::StampedTransform transformTf;
+  try {
+    if (isStatic && transformListener_.canTransform(targetFrame, sourceFrame, ros::Time(0))) {
+      transformListener_.lookupTransform(targetFrame, sourceFrame, ros::Time(0), transformTf);
+    } else {
+      transformListener_.waitForTransform(targetFrame, sourceFrame, timeStamp, transformListenerTimeout_);
+      transformListener_.lookupTransform(targetFrame, sourceFrame, timeStamp, transformTf);
+    }
   } catch (tf::TransformException &ex) {
     ROS_ERROR("%s", ex.what());
     return false;
   }
+  poseTFToEigen(transformTf, transformation);
+
+  if (isStatic) {
+    lock.lock();
+    // Only cached if the static transformations have not changed meanwhile.
+    if (staticTransformationsVersion == staticTransformationsVersion_) staticTransformations_[frameIds] = transformation;
+  }
+  return true;
 }
 
 bool SensorProcessorBase::transformPointCloud(
@@ -112,17 +312,8 @@ bool SensorProcessorBase::transformPointCloud(
   timeStamp.fromNSec(1000 * pointCloud->header.stamp);
   const std::string inputFrameId(pointCloud->header.frame_id);
 
-  tf::StampedTransform transformTf;
-  try {
-    transformListener_.waitForTransform(targetFrame, inputFrameId, timeStamp, ros::Duration(1.0));
-    transformListener_.lookupTransform(targetFrame, inputFrameId, timeStamp, transformTf);
-  } catch (tf::TransformException &ex) {
-    ROS_ERROR("%s", ex.what());
-    return false;
-  }
-
   Eigen::Affine3d transform;
-  poseTFToEigen(transformTf, transform);
+  if (!lookupTransformation(targetFrame, inputFrameId, timeStamp, transform)) return false;
   pcl::transformPointCloud(*pointCloud, *pointCloudTransformed, transform.cast<float>());
   pointCloudTransformed->header.frame_id = targetFrame;
 
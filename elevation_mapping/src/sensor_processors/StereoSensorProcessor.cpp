@@ -12,24 +12,100 @@
 
 namespace elevation_mapping {
 
-StereoSensorProcessor::StereoSensorProcessor(ros::NodeHandle & nodeHandle, tf::TransformListener & transformListener)
-    : SensorProcessorBase(nodeHandle, transformListener)
+namespace {
+
+typedef SensorProcessingKernel::BatchArray BatchArray;
+
+//! Stereo sensor model for the single pass processing.
+class StereoSensorModel
+{
+ public:
+  /*!
+   * Constructor.
+   * @param parameters the sensor model parameters.
+   * @param imageCenterRow the image row of the optical center.
+   * @param pixelScale the scale from the processed to the original pixel coordinates.
+   * @param pixelOffset the offset from the processed to the original pixel coordinates.
+   */
+  StereoSensorModel(const StereoSensorProcessor::Parameters& parameters, const float imageCenterRow,
+                    const float pixelScale, const float pixelOffset)
+      : p1_(parameters.p1),
+        p2_(parameters.p2),
+        p3_(parameters.p3),
+        p4_(parameters.p4),
+        p5_(parameters.p5),
+        lateralFactor_(parameters.lateralFactor),
+        depthToDisparityFactor_(parameters.depthToDisparityFactor),
+        imageCenterRow_(imageCenterRow),
+        pixelScale_(pixelScale),
+        pixelOffset_(pixelOffset)
+  {
+  }
+
+  bool isValid(const Eigen::Vector3f& /*pointSensorFrame*/) const
+  {
+    return true;
+  }
+
+  void computeSensorVariances(const SensorProcessingKernel::PointBatch& points, BatchArray& varianceLateral,
+                              BatchArray& varianceNormal) const
+  {
+    const BatchArray disparity = depthToDisparityFactor_ / points.z;
+    const BatchArray measurementDistance = (points.x.square() + points.y.square() + points.z.square()).sqrt();
+    const BatchArray column = pixelScale_ * points.u + pixelOffset_;
+    const BatchArray row = pixelScale_ * points.v + pixelOffset_;
+    varianceNormal = (depthToDisparityFactor_ / disparity.square()).square()
+        * ((p5_ * disparity + p2_) * ((p3_ * disparity + p4_ - column).square() + (imageCenterRow_ - row).square()).sqrt() + p1_);
+    varianceLateral = (lateralFactor_ * measurementDistance).square();
+  }
+
+ private:
+  const float p1_, p2_, p3_, p4_, p5_, lateralFactor_, depthToDisparityFactor_;
+  const float imageCenterRow_, pixelScale_, pixelOffset_;
+};
+
+}
+
+StereoSensorProcessor::StereoSensorProcessor(tf::Transformer& transformer)
+    : SensorProcessorBase(transformer),
+      originalWidth_(1),
+      originalHeight_(1)
 {
 
 }
 
 StereoSensorProcessor::~StereoSensorProcessor() {}
 
-bool StereoSensorProcessor::readParameters()
+void StereoSensorProcessor::setParameters(const Parameters& parameters)
 {
-  SensorProcessorBase::readParameters();
-  nodeHandle_.param("sensor_processor/p_1", sensorParameters_["p_1"], 0.0);
-  nodeHandle_.param("sensor_processor/p_2", sensorParameters_["p_2"], 0.0);
-  nodeHandle_.param("sensor_processor/p_3", sensorParameters_["p_3"], 0.0);
-  nodeHandle_.param("sensor_processor/p_4", sensorParameters_["p_4"], 0.0);
-  nodeHandle_.param("sensor_processor/p_5", sensorParameters_["p_5"], 0.0);
-  nodeHandle_.param("sensor_processor/lateral_factor", sensorParameters_["lateral_factor"], 0.0);
-  nodeHandle_.param("sensor_processor/depth_to_disparity_factor", sensorParameters_["depth_to_disparity_factor"], 0.0);
+  parameters_ = parameters;
+}
+
+const StereoSensorProcessor::Parameters& StereoSensorProcessor::getParameters() const
+{
+  return parameters_;
+}
+
+bool StereoSensorProcessor::readParameters(ros::NodeHandle& nodeHandle)
+{
+  SensorProcessorBase::readParameters(nodeHandle);
+  nodeHandle.param("sensor_processor/p_1", parameters_.p1, 0.0);
+  nodeHandle.param("sensor_processor/p_2", parameters_.p2, 0.0);
+  nodeHandle.param("sensor_processor/p_3", parameters_.p3, 0.0);
+  nodeHandle.param("sensor_processor/p_4", parameters_.p4, 0.0);
+  nodeHandle.param("sensor_processor/p_5", parameters_.p5, 0.0);
+  nodeHandle.param("sensor_processor/lateral_factor", parameters_.lateralFactor, 0.0);
+  nodeHandle.param("sensor_processor/depth_to_disparity_factor", parameters_.depthToDisparityFactor, 0.0);
+  nodeHandle.param("sensor_processor/image_center_row", parameters_.imageCenterRow, -1.0);
+  nodeHandle.param("sensor_processor/pixel_stride", parameters_.pixelStride, 1);
+  nodeHandle.param("sensor_processor/decimation_factor", parameters_.decimationFactor, 1);
+  if (parameters_.pixelStride < 1 || parameters_.decimationFactor < 1) {
+    ROS_ERROR("The pixel stride and the decimation factor of the stereo sensor processor need to be at least 1.");
+    return false;
+  }
+  if (!enableSinglePassProcessing_ && (parameters_.pixelStride > 1 || parameters_.decimationFactor > 1)) {
+    ROS_WARN("The pixel stride and the decimation factor are only applied with the single pass processing.");
+  }
   return true;
 }
 
@@ -39,6 +115,7 @@ bool StereoSensorProcessor::cleanPointCloud(const pcl::PointCloud<pcl::PointXYZR
   pcl::PointCloud<pcl::PointXYZRGB> tempPointCloud;
 
   originalWidth_ = pointCloud->width;
+  originalHeight_ = pointCloud->height;
   pcl::removeNaNFromPointCloud(*pointCloud, tempPointCloud, indices_);
   tempPointCloud.is_dense = true;
   pointCloud->swap(tempPointCloud);
@@ -47,6 +124,29 @@ bool StereoSensorProcessor::cleanPointCloud(const pcl::PointCloud<pcl::PointXYZR
   return true;
 }
 
+void StereoSensorProcessor::processPoints(const PointCloudBuffer& pointCloud, const SensorProcessingKernel& kernel,
+                                          pcl::PointCloud<pcl::PointXYZRGB>& pointCloudMapFrame,
+                                          Eigen::VectorXf& variances)
+{
+  // Subsampling and decimation in image space, the sensor model uses the original pixel coordinates.
+  const PointCloudBuffer* input = &pointCloud;
+  float pixelScale = 1.0f, pixelOffset = 0.0f;
+  if (parameters_.pixelStride > 1) {
+    subsampledPointCloud_.subsample(*input, parameters_.pixelStride);
+    input = &subsampledPointCloud_;
+    pixelScale = parameters_.pixelStride;
+  }
+  if (parameters_.decimationFactor > 1) {
+    decimatedPointCloud_.decimate(*input, parameters_.decimationFactor);
+    input = &decimatedPointCloud_;
+    pixelOffset = 0.5f * pixelScale * (parameters_.decimationFactor - 1);
+    pixelScale *= parameters_.decimationFactor;
+  }
+
+  const StereoSensorModel sensorModel(parameters_, getImageCenterRow(pointCloud.getHeight()), pixelScale, pixelOffset);
+  kernel.process(*input, sensorModel, pointCloudMapFrame, variances);
+}
+
 bool StereoSensorProcessor::computeVariances(
     const pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr pointCloud,
     const Eigen::Matrix<double, 6, 6>& robotPoseCovariance,
@@ -69,13 +169,15 @@ bool StereoSensorProcessor::computeVariances(
   const Eigen::Matrix3f C_SB_transpose = rotationBaseToSensor_.transposed().toImplementation().cast<float>();
   const Eigen::Matrix3f B_r_BS_skew = kindr::getSkewMatrixFromVector(Eigen::Vector3f(translationBaseToSensorInBaseFrame_.toImplementation().cast<float>()));
 
+  const double imageCenterRow = getImageCenterRow(originalHeight_);
+
   for (unsigned int i = 0; i < pointCloud->size(); ++i)
   {
     // For every point in point cloud.
 
     // Preparation.
     pcl::PointXYZRGB point = pointCloud->points[i];
-    double disparity = sensorParameters_.at("depth_to_disparity_factor")/point.z;
+    double disparity = parameters_.depthToDisparityFactor/point.z;
     Eigen::Vector3f pointVector(point.x, point.y, point.z); // S_r_SP
     float heightVariance = 0.0; // sigma_p
 
@@ -83,11 +185,11 @@ bool StereoSensorProcessor::computeVariances(
     float measurementDistance = pointVector.norm();
 
     // Compute sensor covariance matrix (Sigma_S) with sensor model.
-    float varianceNormal = pow(sensorParameters_.at("depth_to_disparity_factor") / pow(disparity, 2), 2)
-        * ((sensorParameters_.at("p_5") * disparity + sensorParameters_.at("p_2"))
-            * sqrt(pow(sensorParameters_.at("p_3") * disparity + sensorParameters_.at("p_4") - getJ(i), 2)
-                    + pow(240 - getI(i), 2)) + sensorParameters_.at("p_1"));
-    float varianceLateral = pow(sensorParameters_.at("lateral_factor") * measurementDistance, 2);
+    float varianceNormal = pow(parameters_.depthToDisparityFactor / pow(disparity, 2), 2)
+        * ((parameters_.p5 * disparity + parameters_.p2)
+            * sqrt(pow(parameters_.p3 * disparity + parameters_.p4 - getJ(i), 2)
+                    + pow(imageCenterRow - getI(i), 2)) + parameters_.p1);
+    float varianceLateral = pow(parameters_.lateralFactor * measurementDistance, 2);
     Eigen::Matrix3f sensorVariance = Eigen::Matrix3f::Zero();
     sensorVariance.diagonal() << varianceLateral, varianceLateral, varianceNormal;
 
@@ -106,6 +208,14 @@ bool StereoSensorProcessor::computeVariances(
   return true;
 }
 
+float StereoSensorProcessor::getImageCenterRow(const uint32_t height) const
+{
+  if (parameters_.imageCenterRow >= 0.0) return parameters_.imageCenterRow;
+  // Unorganized point clouds have no image rows, keep the center of the original 480 rows.
+  if (height <= 1) return 240.0f;
+  return 0.5f * height;
+}
+
 int StereoSensorProcessor::getI(int index)
 {
   return indices_[index]/originalWidth_;
@@ -10,6 +10,7 @@
 
 #include <pcl/filters/passthrough.h>
 #include <pcl/filters/voxel_grid.h>
+#include <algorithm>
 #include <vector>
 #include <limits>
 #include <string>
@@ -22,8 +23,102 @@ namespace elevation_mapping {
  * Taken from: Nguyen, C. V., Izadi, S., & Lovell, D., Modeling Kinect Sensor Noise for Improved 3D Reconstruction and Tracking, 2012.
  */
 
-StructuredLightSensorProcessor::StructuredLightSensorProcessor(ros::NodeHandle& nodeHandle, tf::TransformListener& transformListener)
-    : SensorProcessorBase(nodeHandle, transformListener)
+namespace {
+
+typedef SensorProcessingKernel::BatchArray BatchArray;
+
+//! Integer power x^N of the measurement distance (resolved at compile time).
+template<int N>
+struct IntegerPower
+{
+  static BatchArray compute(const BatchArray& x, const float /*exponent*/)
+  {
+    return x * IntegerPower<N - 1>::compute(x, 0.0f);
+  }
+};
+
+template<>
+struct IntegerPower<1>
+{
+  static BatchArray compute(const BatchArray& x, const float /*exponent*/)
+  {
+    return x;
+  }
+};
+
+template<>
+struct IntegerPower<0>
+{
+  static BatchArray compute(const BatchArray& /*x*/, const float /*exponent*/)
+  {
+    return BatchArray::Ones();
+  }
+};
+
+//! Power with an arbitrary exponent.
+struct RuntimePower
+{
+  static BatchArray compute(const BatchArray& x, const float exponent)
+  {
+    return x.pow(exponent);
+  }
+};
+
+//! Converts a cutoff depth to float, depths beyond the range of float are limited to it.
+inline float toFloatDepth(const double depth)
+{
+  const double maxDepth = std::numeric_limits<float>::max();
+  return static_cast<float>(std::max(-maxDepth, std::min(depth, maxDepth)));
+}
+
+//! Structured light sensor model for the single pass processing.
+template<typename NormalPower>
+class StructuredLightSensorModel
+{
+ public:
+  explicit StructuredLightSensorModel(const StructuredLightSensorProcessor::Parameters& parameters)
+      : cutoffMinDepth_(toFloatDepth(parameters.cutoffMinDepth)),
+        cutoffMaxDepth_(toFloatDepth(parameters.cutoffMaxDepth)),
+        normalFactorA_(parameters.normalFactorA),
+        normalFactorB_(parameters.normalFactorB),
+        normalFactorC_(parameters.normalFactorC),
+        normalFactorD_(parameters.normalFactorD),
+        normalFactorE_(parameters.normalFactorE),
+        lateralFactor_(parameters.lateralFactor)
+  {
+  }
+
+  bool isValid(const Eigen::Vector3f& pointSensorFrame) const
+  {
+    return pointSensorFrame.z() >= cutoffMinDepth_ && pointSensorFrame.z() <= cutoffMaxDepth_;
+  }
+
+  void computeSensorVariances(const SensorProcessingKernel::PointBatch& points, BatchArray& varianceLateral,
+                              BatchArray& varianceNormal) const
+  {
+    const BatchArray& measurementDistance = points.z;
+    varianceNormal = (normalFactorA_ + normalFactorB_ * (measurementDistance - normalFactorC_).square()
+        + normalFactorD_ * NormalPower::compute(measurementDistance, normalFactorE_)).square();
+    varianceLateral = (lateralFactor_ * measurementDistance).square();
+  }
+
+ private:
+  const float cutoffMinDepth_, cutoffMaxDepth_;
+  const float normalFactorA_, normalFactorB_, normalFactorC_, normalFactorD_, normalFactorE_, lateralFactor_;
+};
+
+template<typename NormalPower>
+void processPointsWithModel(const PointCloudBuffer& pointCloud, const SensorProcessingKernel& kernel,
+                            const StructuredLightSensorProcessor::Parameters& parameters,
+                            pcl::PointCloud<pcl::PointXYZRGB>& pointCloudMapFrame, Eigen::VectorXf& variances)
+{
+  kernel.process(pointCloud, StructuredLightSensorModel<NormalPower>(parameters), pointCloudMapFrame, variances);
+}
+
+}
+
+StructuredLightSensorProcessor::StructuredLightSensorProcessor(tf::Transformer& transformer)
+    : SensorProcessorBase(transformer)
 {
 
 }
@@ -33,17 +128,27 @@ StructuredLightSensorProcessor::~StructuredLightSensorProcessor()
 
 }
 
-bool StructuredLightSensorProcessor::readParameters()
+void StructuredLightSensorProcessor::setParameters(const Parameters& parameters)
+{
+  parameters_ = parameters;
+}
+
+const StructuredLightSensorProcessor::Parameters& StructuredLightSensorProcessor::getParameters() const
+{
+  return parameters_;
+}
+
+bool StructuredLightSensorProcessor::readParameters(ros::NodeHandle& nodeHandle)
 {
-  SensorProcessorBase::readParameters();
-  nodeHandle_.param("sensor_processor/cutoff_min_depth", sensorParameters_["cutoff_min_depth"], std::numeric_limits<double>::min());
-  nodeHandle_.param("sensor_processor/cutoff_max_depth", sensorParameters_["cutoff_max_depth"], std::numeric_limits<double>::max());
-  nodeHandle_.param("sensor_processor/normal_factor_a", sensorParameters_["normal_factor_a"], 0.0);
-  nodeHandle_.param("sensor_processor/normal_factor_b", sensorParameters_["normal_factor_b"], 0.0);
-  nodeHandle_.param("sensor_processor/normal_factor_c", sensorParameters_["normal_factor_c"], 0.0);
-  nodeHandle_.param("sensor_processor/normal_factor_d", sensorParameters_["normal_factor_d"], 0.0);
-  nodeHandle_.param("sensor_processor/normal_factor_e", sensorParameters_["normal_factor_e"], 0.0);
-  nodeHandle_.param("sensor_processor/lateral_factor", sensorParameters_["lateral_factor"], 0.0);
+  SensorProcessorBase::readParameters(nodeHandle);
+  nodeHandle.param("sensor_processor/cutoff_min_depth", parameters_.cutoffMinDepth, (double) std::numeric_limits<float>::min());
+  nodeHandle.param("sensor_processor/cutoff_max_depth", parameters_.cutoffMaxDepth, (double) std::numeric_limits<float>::max());
+  nodeHandle.param("sensor_processor/normal_factor_a", parameters_.normalFactorA, 0.0);
+  nodeHandle.param("sensor_processor/normal_factor_b", parameters_.normalFactorB, 0.0);
+  nodeHandle.param("sensor_processor/normal_factor_c", parameters_.normalFactorC, 0.0);
+  nodeHandle.param("sensor_processor/normal_factor_d", parameters_.normalFactorD, 0.0);
+  nodeHandle.param("sensor_processor/normal_factor_e", parameters_.normalFactorE, 0.0);
+  nodeHandle.param("sensor_processor/lateral_factor", parameters_.lateralFactor, 0.0);
   return true;
 }
 
@@ -54,7 +159,7 @@ bool StructuredLightSensorProcessor::cleanPointCloud(const pcl::PointCloud<pcl::
 
 	passThroughFilter.setInputCloud(pointCloud);
 	passThroughFilter.setFilterFieldName("z");
-	passThroughFilter.setFilterLimits(sensorParameters_.at("cutoff_min_depth"), sensorParameters_.at("cutoff_max_depth"));
+	passThroughFilter.setFilterLimits(parameters_.cutoffMinDepth, parameters_.cutoffMaxDepth);
 	// This makes the point cloud also dense (no NaN points).
 	passThroughFilter.filter(tempPointCloud);
 	tempPointCloud.is_dense = true;
@@ -64,6 +169,25 @@ bool StructuredLightSensorProcessor::cleanPointCloud(const pcl::PointCloud<pcl::
 	return true;
 }
 
+void StructuredLightSensorProcessor::processPoints(const PointCloudBuffer& pointCloud, const SensorProcessingKernel& kernel,
+                                                   pcl::PointCloud<pcl::PointXYZRGB>& pointCloudMapFrame,
+                                                   Eigen::VectorXf& variances)
+{
+  // Integer exponents of the normal distance term are expanded to products at compile time.
+  const double exponent = parameters_.normalFactorE;
+  if (exponent == 0.0 || parameters_.normalFactorD == 0.0) {
+    processPointsWithModel<IntegerPower<0>>(pointCloud, kernel, parameters_, pointCloudMapFrame, variances);
+  } else if (exponent == 1.0) {
+    processPointsWithModel<IntegerPower<1>>(pointCloud, kernel, parameters_, pointCloudMapFrame, variances);
+  } else if (exponent == 2.0) {
+    processPointsWithModel<IntegerPower<2>>(pointCloud, kernel, parameters_, pointCloudMapFrame, variances);
+  } else if (exponent == 3.0) {
+    processPointsWithModel<IntegerPower<3>>(pointCloud, kernel, parameters_, pointCloudMapFrame, variances);
+  } else {
+    processPointsWithModel<RuntimePower>(pointCloud, kernel, parameters_, pointCloudMapFrame, variances);
+  }
+}
+
 bool StructuredLightSensorProcessor::computeVariances(
 		const pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr pointCloud,
 		const Eigen::Matrix<double, 6, 6>& robotPoseCovariance,
@@ -98,12 +222,12 @@ bool StructuredLightSensorProcessor::computeVariances(
 		float measurementDistance = pointVector.z();
 
 		// Compute sensor covariance matrix (Sigma_S) with sensor model.
-                float deviationNormal = sensorParameters_.at("normal_factor_a")
-                    + sensorParameters_.at("normal_factor_b")
-                        * (measurementDistance - sensorParameters_.at("normal_factor_c")) * (measurementDistance - sensorParameters_.at("normal_factor_c"))
-                    + sensorParameters_.at("normal_factor_d") * pow(measurementDistance, sensorParameters_.at("normal_factor_e"));
+                float deviationNormal = parameters_.normalFactorA
+                    + parameters_.normalFactorB
+                        * (measurementDistance - parameters_.normalFactorC) * (measurementDistance - parameters_.normalFactorC)
+                    + parameters_.normalFactorD * pow(measurementDistance, parameters_.normalFactorE);
 		float varianceNormal = deviationNormal * deviationNormal;
-		float deviationLateral = sensorParameters_.at("lateral_factor") * measurementDistance;
+		float deviationLateral = parameters_.lateralFactor * measurementDistance;
 		float varianceLateral = deviationLateral * deviationLateral;
 		Eigen::Matrix3f sensorVariance = Eigen::Matrix3f::Zero();
 		sensorVariance.diagonal() << varianceLateral, varianceLateral, varianceNormal;
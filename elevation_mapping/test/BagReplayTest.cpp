@@ -0,0 +1,176 @@
+/*
+ * BagReplayTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/BagReplay.hpp"
+#include "elevation_mapping/MapFile.hpp"
+
+// gtest
+#include <gtest/gtest.h>
+
+// ROS
+#include <geometry_msgs/PoseWithCovarianceStamped.h>
+#include <ros/ros.h>
+#include <rosbag/bag.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/point_cloud2_iterator.h>
+#include <tf2_msgs/TFMessage.h>
+
+// STL
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace elevation_mapping;
+
+namespace {
+
+std::string getTemporaryPath(const std::string& name)
+{
+  return std::string(P_tmpdir) + "/elevation_mapping_replay_" + name;
+}
+
+geometry_msgs::TransformStamped createTransform(const std::string& parentFrameId, const std::string& childFrameId,
+                                                const ros::Time& time, const double x, const double z)
+{
+  geometry_msgs::TransformStamped transform;
+  transform.header.stamp = time;
+  transform.header.frame_id = parentFrameId;
+  transform.child_frame_id = childFrameId;
+  transform.transform.translation.x = x;
+  transform.transform.translation.z = z;
+  transform.transform.rotation.w = 1.0;
+  return transform;
+}
+
+//! Writes a bag of a robot driving along x over a wavy ground, with the sensor 0.5 m above the robot
+//! (frames and topics of the parameters in bag_replay.test).
+void writeBag(const std::string& path)
+{
+  rosbag::Bag bag(path, rosbag::bagmode::Write);
+  const ros::Time startTime(100.0);
+  const double speed = 0.5;
+
+  tf2_msgs::TFMessage staticTransforms;
+  staticTransforms.transforms.push_back(createTransform("robot", "sensor", startTime, 0.0, 0.5));
+  bag.write("/tf_static", startTime, staticTransforms);
+
+  for (int i = 0; i <= 100; ++i) {
+    const ros::Time time = startTime + ros::Duration(0.02 * i);
+    const double x = speed * 0.02 * i;
+    tf2_msgs::TFMessage transforms;
+    transforms.transforms.push_back(createTransform("map", "robot", time, x, 0.0));
+    bag.write("/tf", time, transforms);
+
+    geometry_msgs::PoseWithCovarianceStamped pose;
+    pose.header.stamp = time;
+    pose.header.frame_id = "map";
+    pose.pose.pose.position.x = x;
+    pose.pose.pose.orientation.w = 1.0;
+    for (int j = 0; j < 6; ++j) pose.pose.covariance[7 * j] = 1e-4;
+    bag.write("/pose", time, pose);
+
+    // Point clouds at 10 Hz.
+    if (i % 5 != 0) continue;
+    sensor_msgs::PointCloud2 pointCloud;
+    pointCloud.header.stamp = time;
+    pointCloud.header.frame_id = "sensor";
+    pointCloud.height = 1;
+    sensor_msgs::PointCloud2Modifier modifier(pointCloud);
+    modifier.setPointCloud2FieldsByString(1, "xyz");
+    modifier.resize(41 * 41);
+    sensor_msgs::PointCloud2Iterator<float> pointX(pointCloud, "x"), pointY(pointCloud, "y"), pointZ(pointCloud, "z");
+    for (int row = 0; row < 41; ++row) {
+      for (int col = 0; col < 41; ++col, ++pointX, ++pointY, ++pointZ) {
+        *pointX = 0.025 * row - 0.5;
+        *pointY = 0.025 * col - 0.5;
+        *pointZ = 0.05 * std::sin(3.0 * (x + *pointX)) + 0.001 * (i % 3) - 0.5;
+      }
+    }
+    bag.write("/points", time, pointCloud);
+  }
+  bag.close();
+}
+
+bool isBitwiseEqual(const grid_map::Matrix& a, const grid_map::Matrix& b)
+{
+  if (a.rows() != b.rows() || a.cols() != b.cols()) return false;
+  return std::memcmp(a.data(), b.data(), a.size() * sizeof(grid_map::Matrix::Scalar)) == 0;
+}
+
+/*!
+ * Replays the bag twice and checks that the maps of the replays are identical.
+ * @param[in] trackPointFrameId the frame of the tracking point of the map.
+ * @param[out] map the map of the first replay.
+ */
+void expectIdenticalReplays(const std::string& trackPointFrameId, grid_map::GridMap& map)
+{
+  ros::NodeHandle nodeHandle("~");
+  const std::string bagFile = getTemporaryPath("test.bag");
+  writeBag(bagFile);
+  nodeHandle.setParam("replay/bag_file", bagFile);
+  nodeHandle.setParam("track_point_frame_id", trackPointFrameId);
+
+  // The integration runs in a separate thread, the maps of the replays are identical nevertheless.
+  grid_map::GridMap maps[2];
+  ros::Time initialTimes[2];
+  for (int i = 0; i < 2; ++i) {
+    const std::string mapFile = getTemporaryPath(std::to_string(i) + ".map");
+    nodeHandle.setParam("replay/output_map_file", mapFile);
+    {
+      BagReplay bagReplay(nodeHandle);
+      ASSERT_TRUE(bagReplay.run());
+    }
+    ASSERT_TRUE(MapFile::load(mapFile, maps[i], initialTimes[i]));
+    std::remove(mapFile.c_str());
+  }
+  std::remove(bagFile.c_str());
+
+  EXPECT_EQ(initialTimes[0], initialTimes[1]);
+  ASSERT_EQ(maps[0].getSize()(0), maps[1].getSize()(0));
+  ASSERT_EQ(maps[0].getSize()(1), maps[1].getSize()(1));
+  EXPECT_EQ(maps[0].getPosition(), maps[1].getPosition());
+  EXPECT_EQ(maps[0].getStartIndex()(0), maps[1].getStartIndex()(0));
+  EXPECT_EQ(maps[0].getStartIndex()(1), maps[1].getStartIndex()(1));
+  ASSERT_EQ(maps[0].getLayers(), maps[1].getLayers());
+  for (const std::string& layer : maps[0].getLayers()) {
+    EXPECT_TRUE(isBitwiseEqual(maps[0].get(layer), maps[1].get(layer))) << "Layer: " << layer;
+  }
+  map = maps[0];
+}
+
+} // namespace
+
+TEST(BagReplay, ReplaysIdenticalMaps)
+{
+  grid_map::GridMap map;
+  expectIdenticalReplays("robot", map);
+
+  // The point clouds have been added.
+  ASSERT_TRUE(map.exists("elevation"));
+  const grid_map::Matrix& elevation = map.get("elevation");
+  EXPECT_GT(elevation.unaryExpr([](float value) { return std::isfinite(value) ? 1 : 0; }).sum(), elevation.size() / 8);
+}
+
+TEST(BagReplay, ReplaysIdenticalMapsWithTrackPointInOtherFrame)
+{
+  // The tracking point is transformed with TF at the time of each point cloud, as it is not in the
+  // robot base frame.
+  grid_map::GridMap map;
+  expectIdenticalReplays("sensor", map);
+
+  // The map follows the sensor to its position at the last point cloud (x = 1 m).
+  ASSERT_TRUE(map.exists("elevation"));
+  EXPECT_NEAR(1.0, map.getPosition().x(), map.getResolution());
+  EXPECT_NEAR(0.0, map.getPosition().y(), map.getResolution());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "bag_replay_test");
+  return RUN_ALL_TESTS();
+}
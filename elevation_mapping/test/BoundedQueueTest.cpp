@@ -0,0 +1,160 @@
+/*
+ * BoundedQueueTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/BoundedQueue.hpp"
+
+// gtest
+#include <gtest/gtest.h>
+
+// Boost
+#include <boost/thread.hpp>
+
+// STL
+#include <atomic>
+#include <utility>
+#include <vector>
+
+using namespace elevation_mapping;
+
+namespace {
+
+std::vector<int> popAll(BoundedQueue<int>& queue)
+{
+  std::vector<int> items;
+  int item;
+  while (queue.size() > 0 && queue.pop(item)) items.push_back(item);
+  return items;
+}
+
+}
+
+TEST(BoundedQueue, DropOldest)
+{
+  BoundedQueue<int> queue(2, QueueDropPolicy::DropOldest);
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+  EXPECT_FALSE(queue.push(3));
+  EXPECT_EQ(std::vector<int>({2, 3}), popAll(queue));
+}
+
+TEST(BoundedQueue, DropNewest)
+{
+  BoundedQueue<int> queue(2, QueueDropPolicy::DropNewest);
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+  EXPECT_FALSE(queue.push(3));
+  EXPECT_EQ(std::vector<int>({1, 2}), popAll(queue));
+}
+
+TEST(BoundedQueue, Coalesce)
+{
+  BoundedQueue<int> queue(2, QueueDropPolicy::Coalesce, [](int& queuedItem, int&& newItem) {
+    queuedItem += newItem;
+    return true;
+  });
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+  EXPECT_FALSE(queue.push(3));
+  EXPECT_FALSE(queue.push(4));
+  EXPECT_EQ(std::vector<int>({1, 9}), popAll(queue));
+}
+
+TEST(BoundedQueue, Order)
+{
+  // Items with a time and an id, ordered by their time.
+  typedef std::pair<int, int> Item;
+  BoundedQueue<Item> queue(3, QueueDropPolicy::DropOldest);
+  queue.setOrder([](const Item& item, const Item& otherItem) { return item.first < otherItem.first; });
+  EXPECT_TRUE(queue.push(Item(2, 0)));
+  EXPECT_TRUE(queue.push(Item(1, 1)));
+  EXPECT_TRUE(queue.push(Item(2, 2)));
+  // The oldest item in the order is dropped.
+  EXPECT_FALSE(queue.push(Item(3, 3)));
+  std::vector<int> ids;
+  Item item;
+  while (queue.size() > 0 && queue.pop(item)) ids.push_back(item.second);
+  EXPECT_EQ(std::vector<int>({0, 2, 3}), ids);
+}
+
+TEST(BoundedQueue, CoalesceOnlyMatchingItems)
+{
+  // Only items with the same parity are merged, otherwise the oldest item is dropped.
+  BoundedQueue<int> queue(2, QueueDropPolicy::Coalesce, [](int& queuedItem, int&& newItem) {
+    if ((queuedItem - newItem) % 2 != 0) return false;
+    queuedItem += newItem;
+    return true;
+  });
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+  EXPECT_FALSE(queue.push(4));
+  EXPECT_FALSE(queue.push(5));
+  EXPECT_EQ(std::vector<int>({6, 5}), popAll(queue));
+}
+
+TEST(BoundedQueue, StopWakesUpConsumer)
+{
+  BoundedQueue<int> queue;
+  bool isPopped = true;
+  boost::thread consumer([&]() {
+    int item;
+    isPopped = queue.pop(item);
+  });
+  queue.stop();
+  consumer.join();
+  EXPECT_FALSE(isPopped);
+  EXPECT_FALSE(queue.push(1));
+}
+
+TEST(BoundedQueue, ProducerAndConsumer)
+{
+  BoundedQueue<int> queue(1000);
+  std::vector<int> items;
+  boost::thread consumer([&]() {
+    int item;
+    while (queue.pop(item)) {
+      items.push_back(item);
+      if (item == 99) break;
+    }
+  });
+  for (int i = 0; i < 100; ++i) queue.push(i);
+  consumer.join();
+  ASSERT_EQ(100u, items.size());
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(i, items[i]);
+}
+
+TEST(BoundedQueue, BlockWaitsForConsumer)
+{
+  BoundedQueue<int> queue(2, QueueDropPolicy::Block);
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+  std::atomic<bool> isPushed(false);
+  boost::thread producer([&]() {
+    EXPECT_TRUE(queue.push(3));
+    isPushed = true;
+  });
+  boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+  EXPECT_FALSE(isPushed);
+  int item;
+  ASSERT_TRUE(queue.pop(item));
+  EXPECT_EQ(1, item);
+  producer.join();
+  EXPECT_EQ(std::vector<int>({2, 3}), popAll(queue));
+}
+
+TEST(BoundedQueue, CloseDrainsQueue)
+{
+  BoundedQueue<int> queue(3);
+  queue.push(1);
+  queue.push(2);
+  queue.close();
+  EXPECT_FALSE(queue.push(3));
+  int item;
+  ASSERT_TRUE(queue.pop(item));
+  EXPECT_EQ(1, item);
+  ASSERT_TRUE(queue.pop(item));
+  EXPECT_EQ(2, item);
+  EXPECT_FALSE(queue.pop(item));
+}
@@ -0,0 +1,58 @@
+/*
+ * CellBinningTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/CellBinning.hpp"
+
+// gtest
+#include <gtest/gtest.h>
+
+// STL
+#include <random>
+#include <vector>
+
+using namespace elevation_mapping;
+
+TEST(CellBinning, Empty)
+{
+  CellBinning binning;
+  binning.compute(std::vector<uint32_t>(), 100);
+  EXPECT_EQ(0, binning.getNumberOfBins());
+  binning.compute(std::vector<uint32_t>({100, 200}), 100);
+  EXPECT_EQ(0, binning.getNumberOfBins());
+}
+
+TEST(CellBinning, SortedAndStable)
+{
+  std::mt19937 generator(1);
+  const uint32_t numberOfCells = 600 * 600;
+  std::uniform_int_distribution<uint32_t> cellDistribution(0, numberOfCells + 100); // Some outside.
+  std::vector<uint32_t> pointCells(50000);
+  for (auto& cell : pointCells) cell = cellDistribution(generator);
+
+  CellBinning binning;
+  binning.compute(pointCells, numberOfCells);
+
+  size_t numberOfPoints = 0;
+  for (size_t bin = 0; bin < binning.getNumberOfBins(); ++bin) {
+    if (bin > 0) {
+      EXPECT_LT(binning.getCell(bin - 1), binning.getCell(bin));
+    }
+    ASSERT_LT(binning.getBegin(bin), binning.getEnd(bin));
+    for (size_t j = binning.getBegin(bin); j < binning.getEnd(bin); ++j) {
+      EXPECT_EQ(binning.getCell(bin), pointCells[binning.getPointIndex(j)]);
+      if (j > binning.getBegin(bin)) {
+        EXPECT_LT(binning.getPointIndex(j - 1), binning.getPointIndex(j));
+      }
+      ++numberOfPoints;
+    }
+  }
+
+  size_t numberOfPointsInside = 0;
+  for (const auto cell : pointCells) {
+    if (cell < numberOfCells) ++numberOfPointsInside;
+  }
+  EXPECT_EQ(numberOfPointsInside, numberOfPoints);
+}
@@ -0,0 +1,129 @@
+/*
+ * CompactLayersTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/CompactLayers.hpp"
+
+// gtest
+#include <gtest/gtest.h>
+
+// STL
+#include <cmath>
+#include <limits>
+
+using namespace elevation_mapping;
+using grid_map::GridMap;
+using grid_map::Index;
+using grid_map::Length;
+using grid_map::Matrix;
+using grid_map::Position;
+
+TEST(CompactLayers, HalfConversion)
+{
+  // Values with up to 11 significant bits are exact.
+  for (const float value : {0.0f, 1.0f, -2.5f, 0.1875f, 65504.0f, 6.103515625e-5f}) {
+    EXPECT_EQ(value, halfToFloat(floatToHalf(value)));
+  }
+  // Subnormal halves.
+  EXPECT_EQ(std::ldexp(1.0f, -24), halfToFloat(floatToHalf(std::ldexp(1.0f, -24))));
+  EXPECT_EQ(3.0f * std::ldexp(1.0f, -24), halfToFloat(floatToHalf(3.0f * std::ldexp(1.0f, -24))));
+  EXPECT_EQ(0.0f, halfToFloat(floatToHalf(std::ldexp(1.0f, -26))));
+
+  // Rounded to nearest, ties to even.
+  EXPECT_EQ(1.0f, halfToFloat(floatToHalf(1.0f + std::ldexp(1.0f, -11))));
+  EXPECT_EQ(1.0f + std::ldexp(1.0f, -9), halfToFloat(floatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11))));
+  EXPECT_EQ(1.0f + std::ldexp(1.0f, -10), halfToFloat(floatToHalf(1.0f + 1.5f * std::ldexp(1.0f, -11))));
+  const float value = 1e-4f;
+  EXPECT_NEAR(value, halfToFloat(floatToHalf(value)), value * std::ldexp(1.0f, -11));
+
+  // Out of range and NaN.
+  EXPECT_EQ(65504.0f, halfToFloat(floatToHalf(65519.0f)));
+  EXPECT_EQ(std::numeric_limits<float>::infinity(), halfToFloat(floatToHalf(65520.0f)));
+  EXPECT_EQ(-std::numeric_limits<float>::infinity(), halfToFloat(floatToHalf(-1e10f)));
+  EXPECT_TRUE(std::isnan(halfToFloat(floatToHalf(NAN))));
+}
+
+TEST(CompactLayers, PackedCellsAreNotNaN)
+{
+  // The largest high fields, which would give a NaN float if they were not limited.
+  for (const float high : {std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), NAN}) {
+    EXPECT_FALSE(std::isnan(packHalfFloats(1.0f, high)));
+    EXPECT_FALSE(std::isnan(packTimeAndHalfFloat(maxCompactTimeTick + 1, high)));
+  }
+  float low, high;
+  unpackHalfFloats(packHalfFloats(0.25f, -3.0f), low, high);
+  EXPECT_EQ(0.25f, low);
+  EXPECT_EQ(-3.0f, high);
+
+  // A cleared cell has no values.
+  uint16_t time;
+  unpackHalfFloats(NAN, low, high);
+  EXPECT_TRUE(std::isnan(low));
+  EXPECT_TRUE(std::isnan(high));
+  unpackTimeAndHalfFloat(NAN, time, high);
+  EXPECT_EQ(0, time);
+  EXPECT_TRUE(std::isnan(high));
+}
+
+TEST(CompactLayers, CompactTime)
+{
+  const int timeBase = getCompactTimeBase(100.0f);
+  EXPECT_EQ(10000 - maxCompactTimeTick / 2, timeBase);
+  EXPECT_FLOAT_EQ(100.0f, decodeCompactTime(encodeCompactTime(100.0f, timeBase), timeBase));
+  EXPECT_FLOAT_EQ(99.12f, decodeCompactTime(encodeCompactTime(99.1234f, timeBase), timeBase));
+  EXPECT_FLOAT_EQ(-200.0f, decodeCompactTime(encodeCompactTime(-200.0f, timeBase), timeBase));
+
+  // Times beyond the range are saturated.
+  const float oldestTime = timeBase / compactTimeTicksPerSecond;
+  const float latestTime = (timeBase + maxCompactTimeTick) / compactTimeTicksPerSecond;
+  EXPECT_FLOAT_EQ(oldestTime, decodeCompactTime(encodeCompactTime(-1000.0f, timeBase), timeBase));
+  EXPECT_FLOAT_EQ(latestTime, decodeCompactTime(encodeCompactTime(1000.0f, timeBase), timeBase));
+
+  EXPECT_EQ(0, encodeCompactTime(NAN, timeBase));
+  EXPECT_TRUE(std::isnan(decodeCompactTime(0, timeBase)));
+}
+
+TEST(CompactLayers, PackAndUnpackMap)
+{
+  GridMap map({"elevation", "horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy", "time"});
+  map.setGeometry(Length(0.3, 0.2), 0.1, Position(0.0, 0.0));
+  map["elevation"].setZero();
+  map["horizontal_variance_x"].setConstant(0.5);
+  map["horizontal_variance_y"].setConstant(0.25);
+  map["horizontal_variance_xy"].setConstant(-0.125);
+  map["time"].setConstant(3.0);
+  map.at("time", Index(1, 0)) = NAN;
+
+  const int timeBase = getCompactTimeBase(3.0f);
+  packCompactLayers(map, timeBase);
+  EXPECT_TRUE(hasCompactLayers(map));
+  EXPECT_FALSE(map.exists("time"));
+  EXPECT_EQ(3u, map.getLayers().size());
+  EXPECT_EQ(getCompactLayer("horizontal_variance_xy"), getCompactLayer("time"));
+  EXPECT_TRUE(getCompactLayer("elevation").empty());
+
+  float varianceX, varianceY, varianceXY;
+  getHorizontalVariances(map, Index(2, 1), varianceX, varianceY, varianceXY);
+  EXPECT_EQ(0.5f, varianceX);
+  EXPECT_EQ(0.25f, varianceY);
+  EXPECT_EQ(-0.125f, varianceXY);
+
+  // Later times move the time base, the older times are kept as long as they are in range.
+  const int newTimeBase = getCompactTimeBase(10.0f);
+  rebaseCompactTime(map, timeBase, newTimeBase);
+  Matrix time;
+  decodeCompactLayer(map, "time", newTimeBase, time);
+  EXPECT_FLOAT_EQ(3.0f, time(0, 0));
+  EXPECT_TRUE(std::isnan(time(1, 0)));
+
+  // A cleared cell has no values.
+  map.clear("compact_horizontal_variance_xy_time");
+  unpackCompactLayers(map, newTimeBase);
+  EXPECT_FALSE(hasCompactLayers(map));
+  EXPECT_TRUE((map["horizontal_variance_x"].array() == 0.5f).all());
+  EXPECT_TRUE((map["horizontal_variance_y"].array() == 0.25f).all());
+  EXPECT_TRUE(map["horizontal_variance_xy"].array().isNaN().all());
+  EXPECT_TRUE(map["time"].array().isNaN().all());
+}
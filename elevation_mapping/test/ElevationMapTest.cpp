@@ -6,17 +6,68 @@
  *	 Institute: ETH Zurich, Autonomous Systems Lab
  */
 
+#include "elevation_mapping/CompactLayers.hpp"
 #include "elevation_mapping/ElevationMap.hpp"
+#include "elevation_mapping/MapPublishing.hpp"
+#include "elevation_mapping/RobotMotionMapUpdateKernel.hpp"
 #include "grid_map_core/GridMap.hpp"
+#include "grid_map_core/GridMapMath.hpp"
 
 #include <ros/ros.h>
 
 // gtest
 #include <gtest/gtest.h>
 
+// Boost
+#include <boost/thread.hpp>
+
+// STL
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
 using namespace elevation_mapping;
 using namespace grid_map;
 
+namespace {
+
+//! Points partially outside of the map of setUpMapForAdd(...), which hit cells multiple times.
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr createPointCloud(std::mt19937& generator, const unsigned int numberOfPoints,
+                                                        Eigen::VectorXf& pointCloudVariances)
+{
+  std::uniform_real_distribution<float> positionDistribution(-0.25, 0.45);
+  std::uniform_real_distribution<float> heightDistribution(-0.05, 0.05);
+  std::uniform_real_distribution<float> varianceDistribution(0.00001, 0.0004);
+  std::uniform_int_distribution<int> colorDistribution(0, 255);
+  std::bernoulli_distribution stepDistribution(0.1);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  pointCloudVariances.resize(numberOfPoints);
+  for (unsigned int i = 0; i < numberOfPoints; ++i) {
+    pcl::PointXYZRGB point;
+    point.x = positionDistribution(generator);
+    point.y = positionDistribution(generator);
+    point.z = heightDistribution(generator) + (stepDistribution(generator) ? 0.3 : 0.0);
+    point.r = colorDistribution(generator);
+    point.g = colorDistribution(generator);
+    point.b = colorDistribution(generator);
+    pointCloud->push_back(point);
+    pointCloudVariances[i] = varianceDistribution(generator);
+  }
+  return pointCloud;
+}
+
+bool isBitwiseEqual(const Matrix& a, const Matrix& b)
+{
+  if (a.size() != b.size()) return false;
+  return std::memcmp(a.data(), b.data(), a.size() * sizeof(Matrix::Scalar)) == 0;
+}
+
+} // namespace
+
 TEST(ElevationMap, Test)
 {
 //  ros::M_string remappings;
@@ -26,3 +77,973 @@ TEST(ElevationMap, Test)
 //  map.setGeometry(Length(1.0, 1.0), 0.01, Position(0.0, 0.0));
 }
 
+namespace {
+
+void setUpMapForAdd(ElevationMap& map, const bool enableFastAdd, const unsigned int addThreads = 1)
+{
+  ElevationMap::Parameters parameters;
+  parameters.enableVisibilityCleanup = false;
+  parameters.enableFastAdd = enableFastAdd;
+  parameters.addThreads = addThreads;
+  map.setParameters(parameters);
+  map.setGeometry(Length(0.5, 0.5), 0.05, Position(0.1, -0.05));
+  // The same initial time for all maps, such that their times are equal.
+  map.setInitialTime(ros::Time(5.0));
+}
+
+} // namespace
+
+TEST(ElevationMapAdd, AddKernelIsBitwiseEqualToLayerLookup)
+{
+  std::mt19937 generator(42);
+  ElevationMap mapWithLayerLookup, mapWithKernel;
+  setUpMapForAdd(mapWithLayerLookup, false);
+  setUpMapForAdd(mapWithKernel, true);
+
+  // Several scans from different sensor origins, partially within the scanning duration of each other.
+  const std::vector<double> scanTimes({10.0, 10.5, 10.7, 12.5, 12.6, 20.0});
+  for (size_t i = 0; i < scanTimes.size(); ++i) {
+    Eigen::VectorXf pointCloudVariances;
+    const auto pointCloud = createPointCloud(generator, 2000, pointCloudVariances);
+    const Eigen::Affine3d transformationSensorToMap(Eigen::Translation3d(0.1 * i, -0.2, 1.0));
+    for (ElevationMap* map : {&mapWithLayerLookup, &mapWithKernel}) {
+      ASSERT_TRUE(map->add(pointCloud, pointCloudVariances, ros::Time(scanTimes[i]), transformationSensorToMap));
+    }
+  }
+
+  const GridMap& rawMapWithLayerLookup = mapWithLayerLookup.getRawGridMap();
+  EXPECT_GT((rawMapWithLayerLookup.get("elevation").array() == rawMapWithLayerLookup.get("elevation").array()).count(), 50);
+  for (const auto& layer : rawMapWithLayerLookup.getLayers()) {
+    EXPECT_TRUE(isBitwiseEqual(rawMapWithLayerLookup.get(layer), mapWithKernel.getRawGridMap().get(layer))) << "Layer: " << layer;
+  }
+}
+
+TEST(ElevationMapAdd, OlderPointCloudOfOtherSensorIsAdded)
+{
+  std::mt19937 generator(42);
+  ElevationMap map;
+  setUpMapForAdd(map, true);
+  Eigen::VectorXf pointCloudVariances;
+  const auto pointCloud = createPointCloud(generator, 2000, pointCloudVariances);
+  const auto olderPointCloud = createPointCloud(generator, 2000, pointCloudVariances);
+  ASSERT_TRUE(map.add(pointCloud, pointCloudVariances, ros::Time(11.0), Eigen::Affine3d(Eigen::Translation3d(0.0, -0.2, 1.0))));
+
+  // The point cloud of the other sensor is added with its own time, the time of the last update stays.
+  const Matrix varianceBefore = map.getRawGridMap().get("variance");
+  ASSERT_TRUE(map.add(olderPointCloud, pointCloudVariances, ros::Time(10.5), Eigen::Affine3d(Eigen::Translation3d(0.3, 0.2, 1.0))));
+  EXPECT_EQ(ros::Time(11.0), map.getTimeOfLastUpdate());
+  EXPECT_GT((map.getRawGridMap().get("variance").array() < varianceBefore.array()).count(), 0);
+}
+
+TEST(ElevationMapAdd, MultiThreadedAddIsBitwiseEqualToSingleThreaded)
+{
+  std::mt19937 generator(42);
+  ElevationMap singleThreadedMap, multiThreadedMap;
+  setUpMapForAdd(singleThreadedMap, true, 1);
+  setUpMapForAdd(multiThreadedMap, true, 4);
+  // Finer cells, such that the points are also updated in several chunks of cells.
+  for (ElevationMap* map : {&singleThreadedMap, &multiThreadedMap}) map->setGeometry(Length(1.0, 1.0), 0.01, Position(0.1, -0.05));
+
+  const std::vector<double> scanTimes({10.0, 10.5, 12.5, 20.0});
+  for (size_t i = 0; i < scanTimes.size(); ++i) {
+    Eigen::VectorXf pointCloudVariances;
+    const auto pointCloud = createPointCloud(generator, 20000, pointCloudVariances);
+    const Eigen::Affine3d transformationSensorToMap(Eigen::Translation3d(0.1 * i, -0.2, 1.0));
+    for (ElevationMap* map : {&singleThreadedMap, &multiThreadedMap}) {
+      ASSERT_TRUE(map->add(pointCloud, pointCloudVariances, ros::Time(scanTimes[i]), transformationSensorToMap));
+    }
+  }
+
+  const GridMap& singleThreadedRawMap = singleThreadedMap.getRawGridMap();
+  for (const auto& layer : singleThreadedRawMap.getLayers()) {
+    EXPECT_TRUE(isBitwiseEqual(singleThreadedRawMap.get(layer), multiThreadedMap.getRawGridMap().get(layer))) << "Layer: " << layer;
+  }
+}
+
+namespace {
+
+//! Elevation map with the aggregation of the points per cell for the tests.
+void setUpMapWithCellAggregation(ElevationMap& map, const ElevationMap::CellAggregation cellAggregation)
+{
+  ElevationMap::Parameters parameters;
+  parameters.minVariance = 1e-8;
+  parameters.enableVisibilityCleanup = false;
+  parameters.cellAggregation = cellAggregation;
+  map.setParameters(parameters);
+  map.setGeometry(Length(0.5, 0.5), 0.05, Position(0.0, 0.0));
+}
+
+//! Points at the center of a cell with the given heights and variances.
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr createPointsInCell(const std::vector<float>& heights,
+                                                          const std::vector<float>& variances,
+                                                          Eigen::VectorXf& pointCloudVariances)
+{
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  pointCloudVariances.resize(heights.size());
+  for (size_t i = 0; i < heights.size(); ++i) {
+    pcl::PointXYZRGB point;
+    point.x = 0.01;
+    point.y = -0.01;
+    point.z = heights[i];
+    pointCloud->push_back(point);
+    pointCloudVariances(i) = variances[i];
+  }
+  return pointCloud;
+}
+
+} // namespace
+
+TEST(ElevationMapCellAggregation, InverseVarianceEqualsSequentialFusion)
+{
+  const std::vector<float> heights({0.100, 0.102, 0.099, 0.101});
+  const std::vector<float> variances({1e-4, 4e-4, 2e-4, 1e-4});
+  Eigen::VectorXf pointCloudVariances;
+  const auto pointCloud = createPointsInCell(heights, variances, pointCloudVariances);
+  const ros::Time timeStamp(10.0);
+
+  ElevationMap sequentialMap, aggregatedMap;
+  setUpMapWithCellAggregation(sequentialMap, ElevationMap::CellAggregation::None);
+  setUpMapWithCellAggregation(aggregatedMap, ElevationMap::CellAggregation::InverseVariance);
+  ASSERT_TRUE(sequentialMap.add(pointCloud, pointCloudVariances, timeStamp, Eigen::Affine3d::Identity()));
+  ASSERT_TRUE(aggregatedMap.add(pointCloud, pointCloudVariances, timeStamp, Eigen::Affine3d::Identity()));
+
+  const Position position(0.01, -0.01);
+  EXPECT_NEAR(sequentialMap.getRawGridMap().atPosition("elevation", position),
+              aggregatedMap.getRawGridMap().atPosition("elevation", position), 1e-6);
+  EXPECT_NEAR(sequentialMap.getRawGridMap().atPosition("variance", position),
+              aggregatedMap.getRawGridMap().atPosition("variance", position), 1e-10);
+}
+
+TEST(ElevationMapCellAggregation, MinMaxKeepsHighestPoint)
+{
+  // A previous scan initializes the cell, the points of the second scan are far apart (multi-height).
+  Eigen::VectorXf previousPointCloudVariances, pointCloudVariances;
+  const auto previousPointCloud = createPointsInCell({0.0, 0.001}, {1e-4, 1e-4}, previousPointCloudVariances);
+  const auto pointCloud = createPointsInCell({0.3, 0.1, 0.5, 0.2}, {1e-4, 1e-4, 1e-4, 1e-4}, pointCloudVariances);
+
+  ElevationMap sequentialMap, aggregatedMap;
+  setUpMapWithCellAggregation(sequentialMap, ElevationMap::CellAggregation::None);
+  setUpMapWithCellAggregation(aggregatedMap, ElevationMap::CellAggregation::MinMax);
+  for (ElevationMap* map : {&sequentialMap, &aggregatedMap}) {
+    ASSERT_TRUE(map->add(previousPointCloud, previousPointCloudVariances, ros::Time(10.0), Eigen::Affine3d::Identity()));
+    ASSERT_TRUE(map->add(pointCloud, pointCloudVariances, ros::Time(10.5), Eigen::Affine3d::Identity()));
+  }
+
+  const Position position(0.01, -0.01);
+  EXPECT_FLOAT_EQ(0.5, aggregatedMap.getRawGridMap().atPosition("elevation", position));
+  EXPECT_FLOAT_EQ(sequentialMap.getRawGridMap().atPosition("elevation", position),
+                  aggregatedMap.getRawGridMap().atPosition("elevation", position));
+}
+
+namespace {
+
+//! Flat ground with obstacles of 0.5 m height, of which two are below the rays of the visibility cleanup.
+void setUpMapForVisibilityCleanup(ElevationMap& map, const unsigned int numberOfThreads)
+{
+  ElevationMap::Parameters parameters;
+  parameters.visibilityCleanupThreads = numberOfThreads;
+  // The cells are written directly, not by adding points.
+  parameters.enableActiveTiles = false;
+  map.setParameters(parameters);
+  map.setGeometry(Length(1.0, 1.0), 0.05, Position(0.0, 0.0));
+  GridMap& rawMap = map.getRawGridMap();
+  rawMap["elevation"].setZero();
+  rawMap["variance"].setConstant(parameters.minVariance);
+  rawMap["time"].setConstant(-100.0);
+  for (const auto& position : {Position(0.0, 0.0), Position(0.0, -0.3), Position(0.0, 0.3)}) {
+    rawMap.atPosition("elevation", position) = 0.5;
+  }
+}
+
+//! Sets the lowest scan point of the cell at a position as seen from a sensor.
+void setLowestScanPoint(ElevationMap& map, const Position& position, const Eigen::Vector3f& sensorPosition)
+{
+  GridMap& rawMap = map.getRawGridMap();
+  rawMap.atPosition("lowest_scan_point", position) = rawMap.atPosition("elevation", position);
+  rawMap.atPosition("sensor_origin_at_lowest_scan", position) = map.addSensorOrigin(sensorPosition.cast<double>());
+}
+
+//! Max. heights of the visibility cleanup as traced with grid_map::LineIterator for each cell with
+//! a lowest scan point, NAN where no ray passes.
+Matrix computeMaxHeightsWithLineIterator(const GridMap& rawMap, const std::vector<Eigen::Vector3f>& sensorOrigins)
+{
+  Matrix maxHeights = Matrix::Constant(rawMap.getSize()(0), rawMap.getSize()(1), NAN);
+  for (GridMapIterator iterator(rawMap); !iterator.isPastEnd(); ++iterator) {
+    if (!rawMap.isValid(*iterator)) continue;
+    const float lowestScanPoint = rawMap.at("lowest_scan_point", *iterator);
+    if (std::isnan(lowestScanPoint)) continue;
+    const Eigen::Vector3f& sensorPosition = sensorOrigins.at(rawMap.at("sensor_origin_at_lowest_scan", *iterator));
+    Index indexAtSensor;
+    if (!rawMap.getIndex(Position(sensorPosition.x(), sensorPosition.y()), indexAtSensor)) continue;
+    Position point;
+    rawMap.getPosition(*iterator, point);
+    const float distanceToPoint = (point - sensorPosition.head<2>().cast<double>()).norm();
+    if (!(distanceToPoint > 0.0)) continue;
+    for (LineIterator lineIterator(rawMap, indexAtSensor, *iterator); !lineIterator.isPastEnd(); ++lineIterator) {
+      Position cellPosition;
+      rawMap.getPosition(*lineIterator, cellPosition);
+      const float distanceToCell = distanceToPoint - (cellPosition - sensorPosition.head<2>().cast<double>()).norm();
+      const float maxHeightPoint = lowestScanPoint + (sensorPosition.z() - lowestScanPoint) / distanceToPoint * distanceToCell;
+      float& cellMaxHeight = maxHeights((*lineIterator)(0), (*lineIterator)(1));
+      if (std::isnan(cellMaxHeight) || cellMaxHeight > maxHeightPoint) cellMaxHeight = maxHeightPoint;
+    }
+  }
+  return maxHeights;
+}
+
+} // namespace
+
+TEST(ElevationMapVisibilityCleanup, RemovesCellsBelowRays)
+{
+  ElevationMap map;
+  setUpMapForVisibilityCleanup(map, 2);
+  GridMap& rawMap = map.getRawGridMap();
+  // Two sensor origins, the rays pass above the ground but below the obstacles.
+  setLowestScanPoint(map, Position(-0.4, 0.0), Eigen::Vector3f(0.4, 0.0, 0.6));
+  setLowestScanPoint(map, Position(-0.3, -0.3), Eigen::Vector3f(0.3, -0.3, 0.6));
+  map.visibilityCleanup(ros::Time::now());
+
+  EXPECT_TRUE(std::isnan(rawMap.atPosition("elevation", Position(0.0, 0.0))));
+  EXPECT_TRUE(std::isnan(rawMap.atPosition("elevation", Position(0.0, -0.3))));
+  EXPECT_FLOAT_EQ(0.5, rawMap.atPosition("elevation", Position(0.0, 0.3)));
+  for (const auto& position : {Position(-0.4, 0.0), Position(0.2, 0.0), Position(0.4, 0.0), Position(-0.3, -0.3)}) {
+    EXPECT_FLOAT_EQ(0.0, rawMap.atPosition("elevation", position));
+  }
+  // The lowest scan points are reset for the next cleanup.
+  EXPECT_TRUE(std::isnan(rawMap.atPosition("lowest_scan_point", Position(-0.4, 0.0))));
+}
+
+TEST(ElevationMapVisibilityCleanup, SensorOriginsAreResetByCleanup)
+{
+  ElevationMap map;
+  setUpMapForVisibilityCleanup(map, 1);
+  const Position3 sensorPosition(0.4, 0.0, 0.6);
+  EXPECT_EQ(0.0f, map.addSensorOrigin(sensorPosition));
+  EXPECT_EQ(0.0f, map.addSensorOrigin(sensorPosition));
+  EXPECT_EQ(1.0f, map.addSensorOrigin(Position3(0.3, -0.3, 0.6)));
+  setLowestScanPoint(map, Position(-0.4, 0.0), sensorPosition.cast<float>());
+  map.visibilityCleanup(ros::Time::now());
+  EXPECT_TRUE(std::isnan(map.getRawGridMap().atPosition("sensor_origin_at_lowest_scan", Position(-0.4, 0.0))));
+  EXPECT_EQ(0.0f, map.addSensorOrigin(Position3(0.3, -0.3, 0.6)));
+}
+
+TEST(ElevationMapVisibilityCleanup, ResultIsIndependentOfNumberOfThreads)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> positionDistribution(-0.49, 0.49);
+  std::uniform_real_distribution<float> heightDistribution(0.0, 0.6);
+  ElevationMap singleThreadedMap, multiThreadedMap;
+  setUpMapForVisibilityCleanup(singleThreadedMap, 1);
+  setUpMapForVisibilityCleanup(multiThreadedMap, 4);
+  for (int i = 0; i < 500; ++i) {
+    const Position position(positionDistribution(generator), positionDistribution(generator));
+    const Eigen::Vector3f sensorPosition(0.1 * (i % 3), -0.2, 0.7);
+    const float height = heightDistribution(generator);
+    for (ElevationMap* map : {&singleThreadedMap, &multiThreadedMap}) {
+      map->getRawGridMap().atPosition("elevation", position) = height;
+      setLowestScanPoint(*map, position, sensorPosition);
+    }
+  }
+  const ros::Time time = ros::Time::now();
+  singleThreadedMap.visibilityCleanup(time);
+  multiThreadedMap.visibilityCleanup(time);
+  const Matrix& elevation = singleThreadedMap.getRawGridMap().get("elevation");
+  EXPECT_GT((elevation.array() != elevation.array()).count(), 0);
+  EXPECT_TRUE(isBitwiseEqual(singleThreadedMap.getRawGridMap().get("elevation"), multiThreadedMap.getRawGridMap().get("elevation")));
+}
+
+TEST(ElevationMapVisibilityCleanup, LoadedMapHasSameLowestScanPoints)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> positionDistribution(-0.49, 0.49);
+  std::uniform_real_distribution<float> heightDistribution(0.0, 0.6);
+  ElevationMap map, loadedMap;
+  setUpMapForVisibilityCleanup(map, 1);
+  setUpMapForVisibilityCleanup(loadedMap, 1);
+  for (int i = 0; i < 500; ++i) {
+    const Position position(positionDistribution(generator), positionDistribution(generator));
+    map.getRawGridMap().atPosition("elevation", position) = heightDistribution(generator);
+    setLowestScanPoint(map, position, Eigen::Vector3f(0.1 * (i % 3), -0.2, 0.7));
+  }
+
+  // The sensor origins are saved by their coordinates and registered again when loaded.
+  const auto snapshot = map.getRawMapSnapshot(ElevationMap::getPersistentLayers());
+  ASSERT_TRUE(loadedMap.loadRawMap(*snapshot, map.getInitialTime()));
+  const auto loadedSnapshot = loadedMap.getRawMapSnapshot(ElevationMap::getPersistentLayers());
+  for (const std::string layer : {"lowest_scan_point", "sensor_x_at_lowest_scan", "sensor_y_at_lowest_scan", "sensor_z_at_lowest_scan"}) {
+    EXPECT_TRUE(isBitwiseEqual(snapshot->get(layer), loadedSnapshot->get(layer))) << "Layer: " << layer;
+  }
+  const Matrix& lowestScanPoint = snapshot->get("lowest_scan_point");
+  const Matrix& sensorZ = snapshot->get("sensor_z_at_lowest_scan");
+  EXPECT_GT(lowestScanPoint.array().isFinite().count(), 0);
+  EXPECT_TRUE((lowestScanPoint.array().isFinite() == (sensorZ.array() == 0.7f)).all());
+
+  const ros::Time time = ros::Time::now();
+  map.visibilityCleanup(time);
+  loadedMap.visibilityCleanup(time);
+  const Matrix& elevation = map.getRawGridMap().get("elevation");
+  EXPECT_GT((elevation.array() != elevation.array()).count(), 0);
+  EXPECT_TRUE(isBitwiseEqual(elevation, loadedMap.getRawGridMap().get("elevation")));
+}
+
+TEST(ElevationMapVisibilityCleanup, SameResultAsLineIterator)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> positionDistribution(-0.49, 0.49);
+  std::uniform_real_distribution<float> groundDistribution(0.0, 0.05);
+  std::uniform_real_distribution<float> obstacleDistribution(0.3, 0.8);
+  ElevationMap map;
+  setUpMapForVisibilityCleanup(map, 2);
+  // The buffer of the moved map wraps around, which the rays have to follow.
+  map.move(Position(0.23, -0.11));
+  GridMap& rawMap = map.getRawGridMap();
+  rawMap["variance"].setConstant(1e-6);
+  rawMap["time"].setConstant(-100.0);
+  Matrix& elevation = rawMap["elevation"];
+  for (Eigen::Index i = 0; i < elevation.size(); ++i) elevation(i) = groundDistribution(generator);
+
+  // Occluding obstacles between the sensors and the lowest scan points, some of them are below the rays.
+  for (int i = 0; i < 40; ++i) {
+    const Position position(rawMap.getPosition().x() + positionDistribution(generator),
+                            rawMap.getPosition().y() + positionDistribution(generator));
+    rawMap.atPosition("elevation", position) = obstacleDistribution(generator);
+  }
+  const std::vector<Eigen::Vector3f> sensorOrigins{Eigen::Vector3f(0.6, -0.3, 0.7), Eigen::Vector3f(0.0, 0.2, 0.9),
+                                                   Eigen::Vector3f(-0.1, -0.5, 0.5)};
+  // The ids of the sensor origins are their indices, as the scan points of a sensor are consecutive.
+  for (const auto& sensorOrigin : sensorOrigins) {
+    for (int i = 0; i < 100; ++i) {
+      const Position position(rawMap.getPosition().x() + positionDistribution(generator),
+                              rawMap.getPosition().y() + positionDistribution(generator));
+      if (rawMap.atPosition("elevation", position) > 0.1) continue;
+      setLowestScanPoint(map, position, sensorOrigin);
+    }
+  }
+
+  // Expected cells to remove, as with the previous implementation.
+  const GridMap rawMapBeforeCleanup = rawMap;
+  const Matrix maxHeights = computeMaxHeightsWithLineIterator(rawMapBeforeCleanup, sensorOrigins);
+  const Matrix& variance = rawMapBeforeCleanup.get("variance");
+  Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> isRemoved(elevation.rows(), elevation.cols());
+  for (Eigen::Index i = 0; i < elevation.size(); ++i) {
+    isRemoved(i) = !std::isnan(maxHeights(i)) && elevation(i) - 3.0 * sqrt(variance(i)) > maxHeights(i);
+  }
+  ASSERT_GT(isRemoved.count(), 0);
+  ASSERT_GT((rawMapBeforeCleanup.get("elevation").array() > 0.3 && !isRemoved).count(), 0);
+
+  map.visibilityCleanup(ros::Time::now());
+  for (Eigen::Index i = 0; i < elevation.size(); ++i) {
+    EXPECT_EQ(isRemoved(i), std::isnan(elevation(i))) << "Cell: " << i;
+  }
+}
+
+namespace {
+
+void setUpMapWithActiveTiles(ElevationMap& map, const bool enableActiveTiles)
+{
+  ElevationMap::Parameters parameters;
+  parameters.enableVisibilityCleanup = false;
+  parameters.enableActiveTiles = enableActiveTiles;
+  map.setParameters(parameters);
+  map.setGeometry(Length(2.0, 2.0), 0.05, Position(0.0, 0.0));
+}
+
+//! Points in a corridor which covers only a few tiles of the map.
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr createPointsInCorridor(std::mt19937& generator, const double offsetX,
+                                                              Eigen::VectorXf& pointCloudVariances)
+{
+  std::uniform_real_distribution<float> xDistribution(-0.9, -0.3);
+  std::uniform_real_distribution<float> yDistribution(-0.2, 0.2);
+  std::uniform_real_distribution<float> heightDistribution(-0.05, 0.05);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  const size_t numberOfPoints = 2000;
+  pointCloudVariances.setConstant(numberOfPoints, 1e-4);
+  for (size_t i = 0; i < numberOfPoints; ++i) {
+    pcl::PointXYZRGB point;
+    point.x = xDistribution(generator) + offsetX;
+    point.y = yDistribution(generator);
+    point.z = heightDistribution(generator);
+    pointCloud->push_back(point);
+  }
+  return pointCloud;
+}
+
+//! Checks if two layers are equal in all cells where the reference layer is valid.
+bool isEqualOnValidCells(const Matrix& reference, const Matrix& layer, const Matrix& valid)
+{
+  for (Eigen::Index i = 0; i < reference.size(); ++i) {
+    if (std::isnan(valid(i))) continue;
+    if (!(reference(i) == layer(i))) return false;
+  }
+  return true;
+}
+
+} // namespace
+
+TEST(ElevationMapActiveTiles, SameResultAsDenseMap)
+{
+  std::mt19937 generator(42);
+  ElevationMap denseMap, mapWithActiveTiles;
+  setUpMapWithActiveTiles(denseMap, false);
+  setUpMapWithActiveTiles(mapWithActiveTiles, true);
+  RobotMotionMapUpdateKernel motionUpdate;
+  motionUpdate.setUpdate(Eigen::Vector3f(1e-6, 2e-6, 1e-5), 1e-4, Eigen::Vector3d(0.2, -0.1, 0.0),
+                         Eigen::Vector3d::UnitZ());
+  const Matrix varianceUpdate = Matrix::Constant(40, 40, 1e-5);
+  const Matrix horizontalVarianceUpdate = Matrix::Constant(40, 40, 1e-6);
+
+  // Two scans with motion and variance updates in between, and a move of the map which
+  // leaves some of the explored tiles.
+  Eigen::VectorXf pointCloudVariances;
+  const auto firstPointCloud = createPointsInCorridor(generator, 0.0, pointCloudVariances);
+  const auto secondPointCloud = createPointsInCorridor(generator, 0.6, pointCloudVariances);
+  for (ElevationMap* map : {&denseMap, &mapWithActiveTiles}) {
+    ASSERT_TRUE(map->add(firstPointCloud, pointCloudVariances, ros::Time(10.0), Eigen::Affine3d::Identity()));
+    ASSERT_TRUE(map->update(motionUpdate, ros::Time(10.1)));
+    ASSERT_TRUE(map->update(varianceUpdate, horizontalVarianceUpdate, horizontalVarianceUpdate,
+                            Matrix::Zero(40, 40), ros::Time(10.2)));
+    map->move(Eigen::Vector2d(0.5, 0.0));
+    ASSERT_TRUE(map->add(secondPointCloud, pointCloudVariances, ros::Time(10.5), Eigen::Affine3d::Identity()));
+    ASSERT_TRUE(map->update(motionUpdate, ros::Time(10.6)));
+    ASSERT_TRUE(map->fuseAll());
+  }
+
+  const GridMap& denseRawMap = denseMap.getRawGridMap();
+  const GridMap& rawMapWithActiveTiles = mapWithActiveTiles.getRawGridMap();
+  const Matrix& elevation = denseRawMap.get("elevation");
+  EXPECT_GT((elevation.array() == elevation.array()).count(), 100);
+  EXPECT_TRUE(isBitwiseEqual(elevation, rawMapWithActiveTiles.get("elevation")));
+  for (const std::string layer : {"variance", "horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy"}) {
+    EXPECT_TRUE(isEqualOnValidCells(denseRawMap.get(layer), rawMapWithActiveTiles.get(layer), elevation))
+        << "Layer: " << layer;
+  }
+  for (const std::string layer : {"elevation", "upper_bound", "lower_bound"}) {
+    EXPECT_TRUE(isBitwiseEqual(denseMap.getFusedGridMap().get(layer), mapWithActiveTiles.getFusedGridMap().get(layer)))
+        << "Layer: " << layer;
+  }
+}
+
+TEST(ElevationMapActiveTiles, LoadedRawMapIsFusedAsOriginal)
+{
+  std::mt19937 generator(42);
+  ElevationMap map, loadedMap;
+  setUpMapWithActiveTiles(map, true);
+  setUpMapWithActiveTiles(loadedMap, true);
+  Eigen::VectorXf pointCloudVariances;
+  const auto pointCloud = createPointsInCorridor(generator, 0.0, pointCloudVariances);
+  ASSERT_TRUE(map.add(pointCloud, pointCloudVariances, ros::Time(10.0), Eigen::Affine3d::Identity()));
+  map.move(Eigen::Vector2d(0.3, 0.1));
+  ASSERT_TRUE(map.fuseAll());
+
+  // The loaded map has its own initial time, the times are shifted to it.
+  const double initialTimeOffset = (map.getInitialTime() - loadedMap.getInitialTime()).toSec();
+  ASSERT_TRUE(loadedMap.loadRawMap(map.getRawGridMap(), map.getInitialTime()));
+  ASSERT_TRUE(loadedMap.fuseAll());
+
+  const GridMap& rawMap = map.getRawGridMap();
+  const GridMap& loadedRawMap = loadedMap.getRawGridMap();
+  EXPECT_TRUE((rawMap.getStartIndex() == loadedRawMap.getStartIndex()).all());
+  EXPECT_TRUE(rawMap.getPosition().isApprox(loadedRawMap.getPosition()));
+  for (const std::string layer : {"elevation", "variance", "horizontal_variance_x", "horizontal_variance_y"}) {
+    EXPECT_TRUE(isBitwiseEqual(rawMap.get(layer), loadedRawMap.get(layer))) << "Layer: " << layer;
+  }
+  const Matrix expectedTime = rawMap.get("time").array() + static_cast<float>(initialTimeOffset);
+  EXPECT_TRUE(isBitwiseEqual(expectedTime, loadedRawMap.get("time")));
+  EXPECT_TRUE(loadedRawMap.get("sensor_origin_at_lowest_scan").array().isNaN().all());
+  for (const std::string layer : {"elevation", "upper_bound", "lower_bound"}) {
+    EXPECT_TRUE(isBitwiseEqual(map.getFusedGridMap().get(layer), loadedMap.getFusedGridMap().get(layer)))
+        << "Layer: " << layer;
+  }
+}
+
+TEST(ElevationMapActiveTiles, LoadedRawMapVariancesAreClamped)
+{
+  std::mt19937 generator(42);
+  ElevationMap map, loadedMap;
+  setUpMapWithActiveTiles(map, true);
+  setUpMapWithActiveTiles(loadedMap, true);
+  Eigen::VectorXf pointCloudVariances;
+  const auto pointCloud = createPointsInCorridor(generator, 0.0, pointCloudVariances);
+  ASSERT_TRUE(map.add(pointCloud, pointCloudVariances, ros::Time(10.0), Eigen::Affine3d::Identity()));
+
+  // Variances beyond the limits of the loaded map, as if saved with other parameters.
+  GridMap savedMap = map.getRawGridMap();
+  const ElevationMap::Parameters& parameters = loadedMap.getParameters();
+  savedMap["variance"].setConstant(0.1 * parameters.minVariance);
+  savedMap["horizontal_variance_x"].setConstant(0.1 * parameters.minHorizontalVariance);
+  savedMap["horizontal_variance_y"].setConstant(10.0 * parameters.maxHorizontalVariance);
+  ASSERT_TRUE(loadedMap.loadRawMap(savedMap, map.getInitialTime()));
+
+  const GridMap& loadedRawMap = loadedMap.getRawGridMap();
+  const Matrix& elevation = loadedRawMap.get("elevation");
+  EXPECT_GT((elevation.array() == elevation.array()).count(), 50);
+  EXPECT_TRUE(isEqualOnValidCells(Matrix::Constant(40, 40, parameters.minVariance), loadedRawMap.get("variance"), elevation));
+  EXPECT_TRUE(isEqualOnValidCells(Matrix::Constant(40, 40, parameters.minHorizontalVariance),
+                                  loadedRawMap.get("horizontal_variance_x"), elevation));
+  EXPECT_TRUE(isEqualOnValidCells(Matrix::Constant(40, 40, std::numeric_limits<float>::infinity()),
+                                  loadedRawMap.get("horizontal_variance_y"), elevation));
+}
+
+namespace {
+
+void setUpMapWithCompactLayers(ElevationMap& map, const bool enableCompactLayers)
+{
+  ElevationMap::Parameters parameters;
+  parameters.enableCompactLayers = enableCompactLayers;
+  map.setParameters(parameters);
+  map.setGeometry(Length(2.0, 2.0), 0.05, Position(0.0, 0.0));
+  // The times are multiples of the resolution of the compact time.
+  map.setInitialTime(ros::Time(9.0));
+}
+
+//! Checks if two layers are equal up to a relative tolerance in all cells where the reference layer is valid.
+bool isNearOnValidCells(const Matrix& reference, const Matrix& layer, const Matrix& valid, const float tolerance)
+{
+  for (Eigen::Index i = 0; i < reference.size(); ++i) {
+    if (std::isnan(valid(i))) continue;
+    if (!(std::abs(reference(i) - layer(i)) <= tolerance * std::abs(reference(i)))) return false;
+  }
+  return true;
+}
+
+} // namespace
+
+TEST(ElevationMapCompactLayers, SameResultAsFloatLayers)
+{
+  std::mt19937 generator(42);
+  ElevationMap floatMap, compactMap;
+  setUpMapWithCompactLayers(floatMap, false);
+  setUpMapWithCompactLayers(compactMap, true);
+  RobotMotionMapUpdateKernel motionUpdate;
+  motionUpdate.setUpdate(Eigen::Vector3f(1e-6, 2e-6, 1e-5), 1e-4, Eigen::Vector3d(0.2, -0.1, 0.0),
+                         Eigen::Vector3d::UnitZ());
+  const Matrix varianceUpdate = Matrix::Constant(40, 40, 1e-5);
+  const Matrix horizontalVarianceUpdate = Matrix::Constant(40, 40, 1e-6);
+
+  // The add, the motion and variance updates, the visibility cleanup and the fusion, on both layouts.
+  Eigen::VectorXf pointCloudVariances;
+  const auto firstPointCloud = createPointsInCorridor(generator, 0.0, pointCloudVariances);
+  const auto secondPointCloud = createPointsInCorridor(generator, 0.6, pointCloudVariances);
+  for (ElevationMap* map : {&floatMap, &compactMap}) {
+    ASSERT_TRUE(map->add(firstPointCloud, pointCloudVariances, ros::Time(10.0), Eigen::Affine3d::Identity()));
+    ASSERT_TRUE(map->update(motionUpdate, ros::Time(10.1)));
+    ASSERT_TRUE(map->update(varianceUpdate, horizontalVarianceUpdate, horizontalVarianceUpdate,
+                            Matrix::Zero(40, 40), ros::Time(10.2)));
+    map->move(Eigen::Vector2d(0.5, 0.0));
+    ASSERT_TRUE(map->add(secondPointCloud, pointCloudVariances, ros::Time(10.5), Eigen::Affine3d::Identity()));
+    map->visibilityCleanup(ros::Time(10.5));
+    ASSERT_TRUE(map->update(motionUpdate, ros::Time(10.6)));
+    ASSERT_TRUE(map->fuseAll());
+  }
+
+  // The horizontal variances and the time are stored in two instead of four layers.
+  EXPECT_EQ(floatMap.getRawGridMap().getLayers().size() - 2, compactMap.getRawGridMap().getLayers().size());
+  EXPECT_FALSE(compactMap.getRawGridMap().exists("time"));
+
+  const auto floatRawMap = floatMap.getRawMapSnapshot(ElevationMap::getPersistentLayers());
+  const auto compactRawMap = compactMap.getRawMapSnapshot(ElevationMap::getPersistentLayers());
+  const Matrix& elevation = floatRawMap->get("elevation");
+  EXPECT_GT((elevation.array() == elevation.array()).count(), 100);
+  EXPECT_TRUE(isBitwiseEqual(elevation, compactRawMap->get("elevation")));
+  for (const std::string layer : {"variance", "time"}) {
+    EXPECT_TRUE(isEqualOnValidCells(floatRawMap->get(layer), compactRawMap->get(layer), elevation))
+        << "Layer: " << layer;
+  }
+  // Half precision, with a rounding per update.
+  for (const std::string layer : {"horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy"}) {
+    EXPECT_TRUE(isNearOnValidCells(floatRawMap->get(layer), compactRawMap->get(layer), elevation, 4e-3))
+        << "Layer: " << layer;
+  }
+  const Matrix& fusedElevation = floatMap.getFusedGridMap().get("elevation");
+  EXPECT_TRUE(isNearOnValidCells(fusedElevation, compactMap.getFusedGridMap().get("elevation"), fusedElevation, 1e-3));
+}
+
+TEST(ElevationMapCompactLayers, TimeBaseFollowsScans)
+{
+  std::mt19937 generator(42);
+  ElevationMap map;
+  setUpMapWithCompactLayers(map, true);
+  Eigen::VectorXf pointCloudVariances;
+  const auto firstPointCloud = createPointsInCorridor(generator, 0.0, pointCloudVariances);
+  const auto secondPointCloud = createPointsInCorridor(generator, 1.2, pointCloudVariances);
+
+  // The second scan is beyond the range of the compact times after the first one, which is kept
+  // as the oldest time of the range.
+  ASSERT_TRUE(map.add(firstPointCloud, pointCloudVariances, ros::Time(10.0), Eigen::Affine3d::Identity()));
+  ASSERT_TRUE(map.add(secondPointCloud, pointCloudVariances, ros::Time(1010.0), Eigen::Affine3d::Identity()));
+  const auto rawMap = map.getRawMapSnapshot({"elevation", "time"});
+  const float oldestTime = 1001.0f - (maxCompactTimeTick / 2) / compactTimeTicksPerSecond;
+  EXPECT_FLOAT_EQ(oldestTime, rawMap->atPosition("time", Position(-0.6, 0.0)));
+  EXPECT_FLOAT_EQ(1001.0f, rawMap->atPosition("time", Position(0.6, 0.0)));
+  EXPECT_TRUE(std::isnan(rawMap->atPosition("time", Position(0.0, 0.8))));
+}
+
+TEST(ElevationMapCompactLayers, LoadedRawMapIsFusedAsOriginal)
+{
+  std::mt19937 generator(42);
+  ElevationMap map, loadedMap;
+  setUpMapWithCompactLayers(map, true);
+  setUpMapWithCompactLayers(loadedMap, true);
+  Eigen::VectorXf pointCloudVariances;
+  const auto pointCloud = createPointsInCorridor(generator, 0.0, pointCloudVariances);
+  ASSERT_TRUE(map.add(pointCloud, pointCloudVariances, ros::Time(10.0), Eigen::Affine3d::Identity()));
+  map.move(Eigen::Vector2d(0.3, 0.1));
+  ASSERT_TRUE(map.fuseAll());
+
+  // The saved map has the float layers, which are packed again by the loaded map.
+  const auto savedMap = map.getRawMapSnapshot(ElevationMap::getPersistentLayers());
+  ASSERT_TRUE(loadedMap.loadRawMap(*savedMap, map.getInitialTime()));
+  ASSERT_TRUE(loadedMap.fuseAll());
+  EXPECT_TRUE(hasCompactLayers(loadedMap.getRawGridMap()));
+
+  const auto loadedRawMap = loadedMap.getRawMapSnapshot(ElevationMap::getPersistentLayers());
+  for (const std::string layer : {"elevation", "variance", "horizontal_variance_x", "horizontal_variance_y",
+                                  "horizontal_variance_xy", "time"}) {
+    EXPECT_TRUE(isBitwiseEqual(savedMap->get(layer), loadedRawMap->get(layer))) << "Layer: " << layer;
+  }
+  for (const std::string layer : {"elevation", "upper_bound", "lower_bound"}) {
+    EXPECT_TRUE(isBitwiseEqual(map.getFusedGridMap().get(layer), loadedMap.getFusedGridMap().get(layer)))
+        << "Layer: " << layer;
+  }
+}
+
+TEST(ElevationMapIncrementalFusion, SameResultAsFullFusion)
+{
+  std::mt19937 generator(42);
+  ElevationMap fullyFusedMap, incrementallyFusedMap;
+  for (ElevationMap* map : {&fullyFusedMap, &incrementallyFusedMap}) {
+    ElevationMap::Parameters parameters;
+    parameters.enableVisibilityCleanup = false;
+    parameters.enableIncrementalFusion = (map == &incrementallyFusedMap);
+    map->setParameters(parameters);
+    map->setGeometry(Length(6.4, 6.4), 0.025, Position(0.0, 0.0));
+  }
+  const Matrix horizontalVarianceUpdate = Matrix::Constant(256, 256, 0.3);
+
+  // The ellipses of the first scan with large horizontal variances reach into the tiles of the
+  // second scan, which do not contain any cells of the first scan.
+  Eigen::VectorXf pointCloudVariances;
+  const auto firstPointCloud = createPointsInCorridor(generator, 0.0, pointCloudVariances);
+  const auto secondPointCloud = createPointsInCorridor(generator, 1.5, pointCloudVariances);
+  for (ElevationMap* map : {&fullyFusedMap, &incrementallyFusedMap}) {
+    ASSERT_TRUE(map->add(firstPointCloud, pointCloudVariances, ros::Time(10.0), Eigen::Affine3d::Identity()));
+    ASSERT_TRUE(map->update(Matrix::Zero(256, 256), horizontalVarianceUpdate, horizontalVarianceUpdate,
+                            Matrix::Zero(256, 256), ros::Time(10.1)));
+    ASSERT_TRUE(map->fuseAll());
+    ASSERT_TRUE(map->add(secondPointCloud, pointCloudVariances, ros::Time(10.2), Eigen::Affine3d::Identity()));
+    ASSERT_TRUE(map->fuseAll());
+  }
+
+  const Matrix& elevation = fullyFusedMap.getFusedGridMap().get("elevation");
+  EXPECT_GT((elevation.array() == elevation.array()).count(), 100);
+  for (const std::string layer : {"elevation", "upper_bound", "lower_bound"}) {
+    EXPECT_TRUE(isBitwiseEqual(fullyFusedMap.getFusedGridMap().get(layer), incrementallyFusedMap.getFusedGridMap().get(layer)))
+        << "Layer: " << layer;
+  }
+}
+
+TEST(ElevationMapFusedMapPyramid, LevelsAreConservativeAndAligned)
+{
+  ElevationMap map;
+  ElevationMap::Parameters parameters;
+  parameters.enableVisibilityCleanup = false;
+  parameters.fusedMapPyramidLevels = 2;
+  map.setParameters(parameters);
+  // The corner of the map is not aligned with the coarser resolutions in x-direction.
+  map.setGeometry(Length(1.0, 1.0), 0.05, Position(0.05, 0.0));
+
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> xDistribution(-0.45, 0.55);
+  std::uniform_real_distribution<float> yDistribution(-0.5, 0.5);
+  std::uniform_real_distribution<float> heightDistribution(-0.2, 0.2);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  for (int i = 0; i < 300; ++i) {
+    pcl::PointXYZRGB point;
+    point.x = xDistribution(generator);
+    point.y = yDistribution(generator);
+    point.z = heightDistribution(generator);
+    pointCloud->push_back(point);
+  }
+  Eigen::VectorXf pointCloudVariances = Eigen::VectorXf::Constant(pointCloud->size(), 1e-4);
+  ASSERT_TRUE(map.add(pointCloud, pointCloudVariances, ros::Time(10.0), Eigen::Affine3d::Identity()));
+  map.move(Eigen::Vector2d(0.1, 0.05));
+  ASSERT_TRUE(map.fuseAll());
+
+  GridMap level;
+  EXPECT_FALSE(map.getFusedMapPyramidLevel(3, level));
+  const GridMap& fusedMap = map.getFusedGridMap();
+  for (unsigned int levelIndex = 1; levelIndex <= 2; ++levelIndex) {
+    ASSERT_TRUE(map.getFusedMapPyramidLevel(levelIndex, level));
+    const double resolution = (1 << levelIndex) * fusedMap.getResolution();
+    EXPECT_DOUBLE_EQ(resolution, level.getResolution());
+    Position cellPosition;
+    ASSERT_TRUE(level.getPosition(Index(0, 0), cellPosition));
+    for (int i = 0; i < 2; ++i) {
+      EXPECT_NEAR(0.5, cellPosition(i) / resolution - std::floor(cellPosition(i) / resolution), 1e-6);
+    }
+
+    // Expected mean and bounds from the fused cells contained in each downsampled cell.
+    Matrix sum = Matrix::Zero(level.getSize()(0), level.getSize()(1));
+    Matrix count = sum;
+    Matrix lowerBound = Matrix::Constant(sum.rows(), sum.cols(), std::numeric_limits<float>::infinity());
+    Matrix upperBound = -lowerBound;
+    for (int col = 0; col < fusedMap.getSize()(1); ++col) {
+      for (int row = 0; row < fusedMap.getSize()(0); ++row) {
+        const Index index(row, col);
+        if (!fusedMap.isValid(index)) continue;
+        Position position;
+        fusedMap.getPosition(index, position);
+        Index levelIndexOfCell;
+        ASSERT_TRUE(level.getIndex(position, levelIndexOfCell));
+        sum(levelIndexOfCell(0), levelIndexOfCell(1)) += fusedMap.at("elevation", index);
+        count(levelIndexOfCell(0), levelIndexOfCell(1)) += 1.0;
+        lowerBound(levelIndexOfCell(0), levelIndexOfCell(1)) = std::min(lowerBound(levelIndexOfCell(0), levelIndexOfCell(1)), fusedMap.at("lower_bound", index));
+        upperBound(levelIndexOfCell(0), levelIndexOfCell(1)) = std::max(upperBound(levelIndexOfCell(0), levelIndexOfCell(1)), fusedMap.at("upper_bound", index));
+      }
+    }
+    EXPECT_GT(count.sum(), 100.0);
+    for (int i = 0; i < sum.size(); ++i) {
+      if (count(i) == 0.0) {
+        EXPECT_TRUE(std::isnan(level.get("elevation")(i)));
+        continue;
+      }
+      EXPECT_NEAR(sum(i) / count(i), level.get("elevation")(i), 1e-5);
+      EXPECT_EQ(lowerBound(i), level.get("lower_bound")(i));
+      EXPECT_EQ(upperBound(i), level.get("upper_bound")(i));
+    }
+  }
+}
+
+TEST(ElevationMapPublishing, FusionKeepsUnpublishedRawMapChanges)
+{
+  ElevationMap map;
+  ElevationMap::Parameters parameters;
+  parameters.enableVisibilityCleanup = false;
+  map.setParameters(parameters);
+  map.setGeometry(Length(2.0, 2.0), 0.05, Position(0.0, 0.0));
+  ASSERT_TRUE(map.fuseAll());
+  map.takeUnpublishedRawMapTiles();
+
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  pcl::PointXYZRGB point;
+  point.x = 0.5;
+  point.y = 0.5;
+  point.z = 0.1;
+  pointCloud->push_back(point);
+  Eigen::VectorXf pointCloudVariances = Eigen::VectorXf::Constant(1, 1e-4);
+  ASSERT_TRUE(map.add(pointCloud, pointCloudVariances, ros::Time(10.0), Eigen::Affine3d::Identity()));
+  // The fusion resets the changes of the raw map for the next fusion, not for the publishing.
+  ASSERT_TRUE(map.fuseAll());
+
+  const TileMask updatedTiles = map.takeUnpublishedRawMapTiles();
+  Index index;
+  ASSERT_TRUE(map.getRawGridMap().getIndex(Position(0.5, 0.5), index));
+  EXPECT_TRUE(updatedTiles.isCellMarked(index));
+  ASSERT_TRUE(map.getRawGridMap().getIndex(Position(-0.9, -0.9), index));
+  EXPECT_FALSE(updatedTiles.isCellMarked(index));
+  EXPECT_FALSE(map.takeUnpublishedRawMapTiles().isAnyMarked());
+}
+
+TEST(ElevationMapPublishing, PublishedLayers)
+{
+  GridMap map({"elevation", "variance", "color"});
+  map.setBasicLayers({"elevation"});
+  map.setGeometry(Length(0.5, 0.5), 0.05, Position(0.0, 0.0));
+
+  // Derived layers add their source layers, layers without (source) layers are skipped.
+  std::vector<std::string> sourceLayers;
+  const std::vector<std::string> defaultLayers{"elevation", "standard_deviation"};
+  std::vector<std::string> layers = getPublishedLayers(
+      map, {"color", "two_sigma_bound", "horizontal_standard_deviation", "unknown", "standard_deviation"}, defaultLayers,
+      sourceLayers);
+  EXPECT_EQ(std::vector<std::string>({"color", "two_sigma_bound", "standard_deviation"}), layers);
+  EXPECT_EQ(std::vector<std::string>({"elevation", "color", "variance"}), sourceLayers);
+
+  // The default layers if none are selected.
+  layers = getPublishedLayers(map, {}, defaultLayers, sourceLayers);
+  EXPECT_EQ(std::vector<std::string>({"elevation", "standard_deviation"}), layers);
+  EXPECT_EQ(std::vector<std::string>({"elevation", "variance"}), sourceLayers);
+}
+
+TEST(ElevationMapPublishing, DerivedLayers)
+{
+  GridMap map({"elevation", "variance", "upper_bound", "lower_bound"});
+  map.setGeometry(Length(0.5, 0.5), 0.05, Position(0.0, 0.0));
+  map.get("elevation").setConstant(1.0);
+  map.get("variance").setConstant(4.0);
+  map.get("upper_bound").setConstant(3.0);
+  map.get("lower_bound").setConstant(0.5);
+  map.add("standard_deviation", -1.0);
+
+  addDerivedLayers(map, {"elevation", "two_sigma_bound", "uncertainty_range", "standard_deviation"});
+  EXPECT_TRUE((map.get("two_sigma_bound").array() == 5.0).all());
+  EXPECT_TRUE((map.get("uncertainty_range").array() == 2.5).all());
+  // Existing layers are kept, derived layers are only added if requested.
+  EXPECT_TRUE((map.get("standard_deviation").array() == -1.0).all());
+  EXPECT_FALSE(map.exists("horizontal_standard_deviation"));
+}
+
+TEST(ElevationMapPublishing, UpdatedSubmapsPerRegion)
+{
+  const size_t maxNumberOfSubmaps = 8;
+  GridMap map({"elevation"});
+  map.setGeometry(Length(6.4, 6.4), 0.05, Position(0.0, 0.0));
+  // The buffer start index is not aligned with the tiles.
+  map.move(Position(0.4, 0.2));
+  for (int i = 0; i < map.get("elevation").size(); ++i) map.get("elevation")(i) = i;
+  TileMask updatedTiles;
+  updatedTiles.setSize(map.getSize());
+  updatedTiles.reset();
+  std::vector<GridMap> submaps;
+  EXPECT_FALSE(getUpdatedSubmaps(map, updatedTiles, maxNumberOfSubmaps, submaps));
+
+  // A strip of tiles across the map (as after a move) and a tile in the center, apart from the strip.
+  Index centerIndex;
+  ASSERT_TRUE(map.getIndex(Position(0.0, 0.0), centerIndex));
+  updatedTiles.markCell(centerIndex);
+  updatedTiles.markRegion(Index((centerIndex(0) / 16 * 16 + 64) % 128, 0), Size(1, 128));
+  ASSERT_TRUE(getUpdatedSubmaps(map, updatedTiles, maxNumberOfSubmaps, submaps));
+  EXPECT_GE(submaps.size(), 2u);
+  EXPECT_LE(submaps.size(), 4u);
+
+  // The submaps cover exactly the cells of the updated tiles, with the data of the map.
+  int numberOfCells = 0;
+  for (const auto& submap : submaps) {
+    const Matrix& elevation = submap.get("elevation");
+    numberOfCells += elevation.size();
+    for (int col = 0; col < elevation.cols(); ++col) {
+      for (int row = 0; row < elevation.rows(); ++row) {
+        Position position;
+        submap.getPosition(Index(row, col), position);
+        Index index;
+        ASSERT_TRUE(map.getIndex(position, index));
+        EXPECT_TRUE(updatedTiles.isCellMarked(index));
+        EXPECT_EQ(map.at("elevation", index), submap.at("elevation", Index(row, col)));
+      }
+    }
+  }
+  EXPECT_EQ(16 * 128 + 16 * 16, numberOfCells);
+
+  // Too many regions are sent as a single submap.
+  updatedTiles.reset();
+  for (int tileRow = 0; tileRow < 8; ++tileRow) {
+    for (int tileCol = tileRow % 2; tileCol < 8; tileCol += 2) updatedTiles.markCell(Index(16 * tileRow, 16 * tileCol));
+  }
+  ASSERT_TRUE(getUpdatedSubmaps(map, updatedTiles, maxNumberOfSubmaps, submaps));
+  EXPECT_EQ(1u, submaps.size());
+}
+
+TEST(ElevationMapFusedMapSnapshot, SnapshotsAreImmutableAndTrackStaleRegions)
+{
+  std::mt19937 generator(42);
+  ElevationMap map;
+  setUpMapWithActiveTiles(map, true);
+  Eigen::VectorXf pointCloudVariances;
+  const auto firstPointCloud = createPointsInCorridor(generator, 0.0, pointCloudVariances);
+  const auto secondPointCloud = createPointsInCorridor(generator, 0.6, pointCloudVariances);
+  ASSERT_TRUE(map.add(firstPointCloud, pointCloudVariances, ros::Time(10.0), Eigen::Affine3d::Identity()));
+
+  // Snapshots are only taken once they have been requested.
+  EXPECT_FALSE(map.getFusedMapSnapshot());
+  ASSERT_TRUE(map.fuseArea(Position(-0.6, 0.0), Length(0.8, 0.6)));
+  const auto firstSnapshot = map.getFusedMapSnapshot();
+  ASSERT_TRUE(firstSnapshot);
+  EXPECT_FALSE(firstSnapshot->isStale(Position(-0.6, 0.0), Length(0.8, 0.6)));
+  EXPECT_TRUE(firstSnapshot->isStale(Position(0.6, 0.0), Length(0.2, 0.2)));
+  const Position position(-0.6, 0.0);
+  const float elevation = firstSnapshot->map.atPosition("elevation", position);
+  EXPECT_TRUE(std::isfinite(elevation));
+  EXPECT_EQ(elevation, map.getFusedGridMap().atPosition("elevation", position));
+
+  // New data makes the surrounding region stale with the next fusion, the old snapshot is unchanged.
+  ASSERT_TRUE(map.add(secondPointCloud, pointCloudVariances, ros::Time(11.0), Eigen::Affine3d::Identity()));
+  ASSERT_TRUE(map.fuseArea(Position(0.8, 0.8), Length(0.2, 0.2)));
+  const auto secondSnapshot = map.getFusedMapSnapshot();
+  ASSERT_TRUE(secondSnapshot);
+  EXPECT_NE(firstSnapshot, secondSnapshot);
+  EXPECT_TRUE(secondSnapshot->isStale(Position(-0.3, 0.0), Length(0.2, 0.2)));
+  EXPECT_FALSE(secondSnapshot->isStale(Position(0.8, 0.8), Length(0.1, 0.1)));
+  EXPECT_EQ(elevation, firstSnapshot->map.atPosition("elevation", position));
+
+  ASSERT_TRUE(map.fuseAll());
+  EXPECT_FALSE(map.getFusedMapSnapshot()->isStale(Position(0.0, 0.0), Length(2.0, 2.0)));
+  EXPECT_TRUE(map.clear());
+  EXPECT_FALSE(map.getFusedMapSnapshot());
+}
+
+TEST(ElevationMapFusedMapSnapshot, RegionsFarFromAddStayUpToDate)
+{
+  std::mt19937 generator(42);
+  ElevationMap map;
+  ElevationMap::Parameters parameters;
+  parameters.enableVisibilityCleanup = false;
+  map.setParameters(parameters);
+  map.setGeometry(Length(6.4, 6.4), 0.05, Position(0.0, 0.0));
+  // The snapshots are taken with the fusions once they have been requested.
+  EXPECT_FALSE(map.getFusedMapSnapshot());
+  ASSERT_TRUE(map.fuseAll());
+  Eigen::VectorXf pointCloudVariances;
+  const auto pointCloud = createPointsInCorridor(generator, 0.0, pointCloudVariances);
+  ASSERT_TRUE(map.add(pointCloud, pointCloudVariances, ros::Time(10.0), Eigen::Affine3d::Identity()));
+
+  // Only the surroundings of the added points become stale.
+  ASSERT_TRUE(map.fuseArea(Position(-0.6, 0.0), Length(0.1, 0.1)));
+  const auto snapshot = map.getFusedMapSnapshot();
+  ASSERT_TRUE(snapshot);
+  EXPECT_TRUE(snapshot->isStale(Position(-0.4, -0.1), Length(0.1, 0.1)));
+  EXPECT_FALSE(snapshot->isStale(Position(2.8, 2.8), Length(0.2, 0.2)));
+  EXPECT_FALSE(snapshot->isStale(Position(-2.8, -2.8), Length(0.2, 0.2)));
+}
+
+TEST(ElevationMapConcurrency, ReadersDoNotChangeResult)
+{
+  std::mt19937 generator(42);
+  std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> pointClouds;
+  Eigen::VectorXf pointCloudVariances;
+  for (int i = 0; i < 10; ++i) pointClouds.push_back(createPointsInCorridor(generator, 0.12 * i, pointCloudVariances));
+
+  ElevationMap sequentialMap, concurrentMap;
+  for (ElevationMap* map : {&sequentialMap, &concurrentMap}) {
+    ElevationMap::Parameters parameters;
+    parameters.enableVisibilityCleanup = false;
+    parameters.fusedMapPyramidLevels = 2;
+    map->setParameters(parameters);
+    map->setGeometry(Length(2.0, 2.0), 0.05, Position(0.0, 0.0));
+  }
+  for (size_t i = 0; i < pointClouds.size(); ++i) {
+    ASSERT_TRUE(sequentialMap.add(pointClouds[i], pointCloudVariances, ros::Time(10.0 + i), Eigen::Affine3d::Identity()));
+  }
+  ASSERT_TRUE(sequentialMap.fuseAll());
+
+  // Fusions and readers of both maps run in parallel to the adds.
+  std::atomic<bool> isAdding(true);
+  boost::thread fusionThread([&]() {
+    while (isAdding) {
+      concurrentMap.fuseArea(Position(-0.3, 0.0), Length(1.0, 0.6));
+      concurrentMap.getFusedMapSnapshot();
+    }
+  });
+  boost::thread readerThread([&]() {
+    GridMap level;
+    while (isAdding) {
+      concurrentMap.getRawMapSnapshot({"elevation", "variance", "color"});
+      concurrentMap.getFusedMapPyramidLevel(2, level);
+      concurrentMap.getTimeOfLastFusion();
+    }
+  });
+  for (size_t i = 0; i < pointClouds.size(); ++i) {
+    ASSERT_TRUE(concurrentMap.add(pointClouds[i], pointCloudVariances, ros::Time(10.0 + i), Eigen::Affine3d::Identity()));
+  }
+  isAdding = false;
+  fusionThread.join();
+  readerThread.join();
+  ASSERT_TRUE(concurrentMap.fuseAll());
+
+  // The incremental fusion in between is invalidated where the raw map has changed since.
+  for (const std::string layer : {"elevation", "variance", "horizontal_variance_x", "color"}) {
+    EXPECT_TRUE(isBitwiseEqual(sequentialMap.getRawGridMap().get(layer), concurrentMap.getRawGridMap().get(layer)));
+  }
+  for (const std::string layer : {"elevation", "upper_bound", "lower_bound"}) {
+    EXPECT_TRUE(isBitwiseEqual(sequentialMap.getFusedGridMap().get(layer), concurrentMap.getFusedGridMap().get(layer)));
+  }
+}
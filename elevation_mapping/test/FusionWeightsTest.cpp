@@ -0,0 +1,167 @@
+/*
+ * FusionWeightsTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/FusionWeights.hpp"
+
+// gtest
+#include <gtest/gtest.h>
+
+// Grid Map
+#include <grid_map_ros/grid_map_ros.hpp>
+
+// Eigen
+#include <Eigen/Dense>
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <set>
+#include <utility>
+
+using namespace elevation_mapping;
+
+TEST(FusionWeights, CovarianceEllipse)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> varianceDistribution(0.0001, 0.5);
+  std::uniform_real_distribution<double> correlationDistribution(-0.99, 0.99);
+
+  for (unsigned int i = 0; i < 1000; ++i) {
+    const double varianceX = varianceDistribution(generator);
+    const double varianceY = varianceDistribution(generator);
+    const double varianceXY = correlationDistribution(generator) * std::sqrt(varianceX * varianceY);
+    double maxEigenvalue, minEigenvalue, rotation;
+    computeCovarianceEllipse(varianceX, varianceY, varianceXY, maxEigenvalue, minEigenvalue, rotation);
+
+    Eigen::Matrix2d covarianceMatrix;
+    covarianceMatrix << varianceX, varianceXY, varianceXY, varianceY;
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix2d> solver(covarianceMatrix);
+    EXPECT_NEAR(solver.eigenvalues()(1), maxEigenvalue, 1e-12);
+    EXPECT_NEAR(solver.eigenvalues()(0), minEigenvalue, 1e-12);
+
+    // The principal axis is an eigenvector of the larger eigenvalue.
+    const Eigen::Vector2d axis(std::cos(rotation), std::sin(rotation));
+    EXPECT_NEAR(0.0, (covarianceMatrix * axis - maxEigenvalue * axis).norm(), 1e-12);
+  }
+}
+
+TEST(FusionWeights, ErrorFunction)
+{
+  const Eigen::ArrayXf x = Eigen::ArrayXf::LinSpaced(10001, -6.0, 6.0);
+  Eigen::ArrayXf y(x.size());
+  approximateErrorFunction(x, y);
+  for (int i = 0; i < x.size(); ++i) {
+    EXPECT_NEAR(std::erf(static_cast<double>(x(i))), y(i), 5e-7) << "x = " << x(i);
+  }
+  Eigen::ArrayXf limits(2);
+  approximateErrorFunction(Eigen::Array2f(INFINITY, -INFINITY), limits);
+  EXPECT_FLOAT_EQ(1.0, limits(0));
+  EXPECT_FLOAT_EQ(-1.0, limits(1));
+}
+
+TEST(FusionWeights, Weights)
+{
+  const float halfResolution = 0.05;
+  const float minimalWeight = 1e-6;
+  const float maxStandardDeviation = 0.2;
+  const float minStandardDeviation = 0.1;
+  const Eigen::ArrayXf distancesX = Eigen::ArrayXf::LinSpaced(50, 0.0, 1.0);
+  const Eigen::ArrayXf distancesY = Eigen::ArrayXf::LinSpaced(50, 0.5, 0.0);
+  Eigen::ArrayXf weights(distancesX.size()), bufferA(distancesX.size()), bufferB(distancesX.size());
+  computeFusionWeights(distancesX, distancesY, maxStandardDeviation, minStandardDeviation, halfResolution,
+                       minimalWeight, weights, bufferA, bufferB);
+
+  const auto cumulativeDistributionFunction = [](double x, double standardDeviation) {
+    return 0.5 * std::erfc(-x / (standardDeviation * std::sqrt(2.0)));
+  };
+  for (int i = 0; i < weights.size(); ++i) {
+    const double probability1 = cumulativeDistributionFunction(distancesX(i) + halfResolution, maxStandardDeviation)
+        - cumulativeDistributionFunction(distancesX(i) - halfResolution, maxStandardDeviation);
+    const double probability2 = cumulativeDistributionFunction(distancesY(i) + halfResolution, minStandardDeviation)
+        - cumulativeDistributionFunction(distancesY(i) - halfResolution, minStandardDeviation);
+    EXPECT_NEAR(std::max<double>(minimalWeight, probability1 * probability2), weights(i), 1e-6);
+  }
+}
+
+TEST(FusionWeights, SingleWeightAgreesWithWeights)
+{
+  const float halfResolution = 0.025;
+  const float minimalWeight = std::numeric_limits<float>::epsilon() * 2.0f;
+  const Eigen::ArrayXf distancesX = Eigen::ArrayXf::LinSpaced(100, 0.0, 0.6);
+  const Eigen::ArrayXf distancesY = Eigen::ArrayXf::LinSpaced(100, 0.3, 0.0);
+  Eigen::ArrayXf weights(distancesX.size()), bufferA(distancesX.size()), bufferB(distancesX.size());
+  computeFusionWeights(distancesX, distancesY, 0.15, 0.05, halfResolution, minimalWeight, weights, bufferA, bufferB);
+  for (int i = 0; i < weights.size(); ++i) {
+    const float weight = computeFusionWeight(distancesX(i), distancesY(i), 0.15, 0.05, halfResolution, minimalWeight);
+    EXPECT_NEAR(weights(i), weight, 1e-6 * weights(i) + 1e-9) << "i = " << i;
+  }
+  EXPECT_NEAR(std::erf(0.3), approximateErrorFunction(0.3f), 5e-7);
+  EXPECT_FLOAT_EQ(-1.0, approximateErrorFunction(-INFINITY));
+}
+
+TEST(FusionWeights, EllipseHasCellsOfEllipseIterator)
+{
+  grid_map::GridMap map({"elevation"});
+  map.setGeometry(grid_map::Length(1.2, 0.8), 0.05, grid_map::Position(0.1, -0.2));
+  // With a wrapped buffer.
+  map.move(grid_map::Position(0.35, -0.45));
+  const grid_map::Size& size = map.getSize();
+  const grid_map::Index& startIndex = map.getStartIndex();
+  const double resolution = map.getResolution();
+
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> rowDistribution(0, size(0) - 1);
+  std::uniform_int_distribution<int> colDistribution(0, size(1) - 1);
+  std::uniform_real_distribution<double> lengthDistribution(0.02, 0.6);
+  std::uniform_real_distribution<double> rotationDistribution(-M_PI, M_PI);
+  for (unsigned int i = 0; i < 1000; ++i) {
+    // The center of the ellipse is a cell (of its unwrapped index).
+    const int row = rowDistribution(generator);
+    const int col = colDistribution(generator);
+    const grid_map::Index centerIndex((row + startIndex(0)) % size(0), (col + startIndex(1)) % size(1));
+    grid_map::Position center;
+    map.getPosition(centerIndex, center);
+    const double centerX = getCellCenterPosition(map.getPosition().x(), map.getLength().x(), resolution, row);
+    const double centerY = getCellCenterPosition(map.getPosition().y(), map.getLength().y(), resolution, col);
+    ASSERT_EQ(center.x(), centerX);
+    ASSERT_EQ(center.y(), centerY);
+
+    double lengthX = lengthDistribution(generator);
+    double lengthY = std::min(lengthX, lengthDistribution(generator));
+    double rotation = rotationDistribution(generator);
+    if (i % 2 == 1) {
+      // Cell centers on the boundary of the ellipse, where the rounding decides.
+      lengthX = 2.0 * resolution * (1 + i % 7);
+      lengthY = 2.0 * resolution * (1 + i % 3);
+      rotation = M_PI_4 * (i % 8);
+    }
+    std::set<std::pair<int, int>> iteratorCells;
+    for (grid_map::EllipseIterator iterator(map, center, grid_map::Length(lengthX, lengthY), rotation);
+         !iterator.isPastEnd(); ++iterator) {
+      iteratorCells.emplace((*iterator)(0), (*iterator)(1));
+    }
+
+    // The cells of the bounding box in the ellipse.
+    const FusionEllipse ellipse(lengthX, lengthY, rotation);
+    double halfBoxX, halfBoxY;
+    ellipse.getBoundingBox(halfBoxX, halfBoxY);
+    const int rowRadius = static_cast<int>(std::ceil(halfBoxX / resolution)) + 1;
+    const int colRadius = static_cast<int>(std::ceil(halfBoxY / resolution)) + 1;
+    std::set<std::pair<int, int>> ellipseCells;
+    for (int ellipseCol = std::max(col - colRadius, 0); ellipseCol <= std::min(col + colRadius, size(1) - 1); ++ellipseCol) {
+      for (int ellipseRow = std::max(row - rowRadius, 0); ellipseRow <= std::min(row + rowRadius, size(0) - 1); ++ellipseRow) {
+        const double offsetX = getCellCenterPosition(map.getPosition().x(), map.getLength().x(), resolution, ellipseRow) - centerX;
+        const double offsetY = getCellCenterPosition(map.getPosition().y(), map.getLength().y(), resolution, ellipseCol) - centerY;
+        if (!ellipse.isInside(offsetX, offsetY)) continue;
+        ellipseCells.emplace((ellipseRow + startIndex(0)) % size(0), (ellipseCol + startIndex(1)) % size(1));
+      }
+    }
+    ASSERT_EQ(iteratorCells, ellipseCells) << "Center: " << row << ", " << col << ", length: " << lengthX << ", "
+                                          << lengthY << ", rotation: " << rotation;
+  }
+}
@@ -0,0 +1,145 @@
+/*
+ * MapFileTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/MapFile.hpp"
+
+// gtest
+#include <gtest/gtest.h>
+
+// STL
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace elevation_mapping;
+
+namespace {
+
+const std::vector<std::string> layers{"elevation", "variance", "time"};
+
+grid_map::GridMap createMap()
+{
+  grid_map::GridMap map(layers);
+  map.setBasicLayers({"elevation", "variance"});
+  map.setGeometry(grid_map::Length(3.0, 2.0), 0.1, grid_map::Position(1.0, -0.5));
+  map.setFrameId("map");
+  map.setTimestamp(1234567890123);
+  for (int col = 0; col < map.getSize()(1); ++col) {
+    for (int row = 0; row < map.getSize()(0); ++row) {
+      // Leave runs of empty cells.
+      if ((row / 5 + col) % 3 == 0) continue;
+      map.at("elevation", grid_map::Index(row, col)) = 0.01 * row - 0.02 * col;
+      map.at("variance", grid_map::Index(row, col)) = 0.001 * (row + col);
+      map.at("time", grid_map::Index(row, col)) = 0.5 * col;
+    }
+  }
+  // Store a moved circular buffer.
+  map.setStartIndex(grid_map::Index(7, 3));
+  return map;
+}
+
+std::string getTemporaryPath(const std::string& name)
+{
+  return std::string(P_tmpdir) + "/elevation_mapping_" + name + ".map";
+}
+
+void expectEqualMaps(const grid_map::GridMap& expectedMap, const grid_map::GridMap& map)
+{
+  EXPECT_TRUE((expectedMap.getSize() == map.getSize()).all());
+  EXPECT_TRUE((expectedMap.getStartIndex() == map.getStartIndex()).all());
+  EXPECT_DOUBLE_EQ(expectedMap.getResolution(), map.getResolution());
+  EXPECT_TRUE(expectedMap.getPosition().isApprox(map.getPosition()));
+  EXPECT_EQ(expectedMap.getTimestamp(), map.getTimestamp());
+  EXPECT_EQ(expectedMap.getFrameId(), map.getFrameId());
+  EXPECT_EQ(expectedMap.getBasicLayers(), map.getBasicLayers());
+  for (const auto& layer : layers) {
+    ASSERT_TRUE(map.exists(layer));
+    const grid_map::Matrix& expectedData = expectedMap.get(layer);
+    const grid_map::Matrix& data = map.get(layer);
+    for (int i = 0; i < expectedData.size(); ++i) {
+      if (std::isnan(expectedData(i))) {
+        EXPECT_TRUE(std::isnan(data(i)));
+      } else {
+        EXPECT_EQ(expectedData(i), data(i));
+      }
+    }
+  }
+}
+
+}
+
+TEST(MapFile, RoundTrip)
+{
+  const grid_map::GridMap map = createMap();
+  ros::Time initialTime;
+  initialTime.fromSec(100.0);
+  for (const bool isCompressed : {false, true}) {
+    const std::string path = getTemporaryPath(isCompressed ? "compressed" : "uncompressed");
+    ASSERT_TRUE(MapFile::save(path, map, layers, initialTime, isCompressed));
+    grid_map::GridMap loadedMap;
+    ros::Time loadedInitialTime;
+    ASSERT_TRUE(MapFile::load(path, loadedMap, loadedInitialTime));
+    EXPECT_EQ(initialTime, loadedInitialTime);
+    expectEqualMaps(map, loadedMap);
+    std::remove(path.c_str());
+  }
+}
+
+TEST(MapFile, CompressionOfEmptyCells)
+{
+  grid_map::GridMap map = createMap();
+  map.clearAll();
+  map.at("elevation", grid_map::Index(0, 0)) = 1.0;
+  const std::string path = getTemporaryPath("empty");
+  ASSERT_TRUE(MapFile::save(path, map, layers, ros::Time(), true));
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  // Each layer only stores its runs, far less than the cells.
+  EXPECT_LT(static_cast<size_t>(file.tellg()), map.getSize().prod() * sizeof(float));
+  grid_map::GridMap loadedMap;
+  ros::Time initialTime;
+  ASSERT_TRUE(MapFile::load(path, loadedMap, initialTime));
+  expectEqualMaps(map, loadedMap);
+  std::remove(path.c_str());
+}
+
+TEST(MapFile, InvalidFiles)
+{
+  grid_map::GridMap loadedMap;
+  ros::Time initialTime;
+  EXPECT_FALSE(MapFile::load(getTemporaryPath("missing"), loadedMap, initialTime));
+
+  const std::string path = getTemporaryPath("invalid");
+  const grid_map::GridMap map = createMap();
+  for (const bool isCompressed : {false, true}) {
+    ASSERT_TRUE(MapFile::save(path, map, layers, ros::Time(), isCompressed));
+    std::string data;
+    {
+      std::ifstream file(path, std::ios::binary);
+      data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // Truncated file.
+    {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      file.write(data.data(), data.size() - 10);
+    }
+    EXPECT_FALSE(MapFile::load(path, loadedMap, initialTime));
+
+    // Wrong magic.
+    {
+      std::string invalidData = data;
+      invalidData[0] = 'X';
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      file.write(invalidData.data(), invalidData.size());
+    }
+    EXPECT_FALSE(MapFile::load(path, loadedMap, initialTime));
+  }
+  std::remove(path.c_str());
+}
@@ -0,0 +1,92 @@
+/*
+ * PerformanceStatisticsTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/PerformanceStatistics.hpp"
+
+// gtest
+#include <gtest/gtest.h>
+
+// Boost
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+
+using namespace elevation_mapping;
+
+TEST(LatencyHistogram, Summary)
+{
+  LatencyHistogram histogram;
+  EXPECT_EQ(0u, histogram.getSummary().count);
+
+  // 90 durations of 10 us, 9 of 1 ms and 1 of 100 ms.
+  for (int i = 0; i < 90; ++i) histogram.add(10e-6);
+  for (int i = 0; i < 9; ++i) histogram.add(1e-3);
+  histogram.add(0.1);
+  const LatencyHistogram::Summary summary = histogram.getSummary();
+  EXPECT_EQ(100u, summary.count);
+  EXPECT_NEAR((90 * 10e-6 + 9 * 1e-3 + 0.1) / 100.0, summary.mean, 1e-9);
+  EXPECT_NEAR(0.1, summary.max, 1e-9);
+  // Percentiles are the upper limits of the bins: 10 us is in [8, 16) us, 1 ms in [512, 1024) us.
+  EXPECT_NEAR(16e-6, summary.percentile50, 1e-12);
+  EXPECT_NEAR(16e-6, summary.percentile90, 1e-12);
+  EXPECT_NEAR(1024e-6, summary.percentile99, 1e-12);
+  EXPECT_EQ(90u, histogram.getBinCount(4));
+
+  histogram.reset();
+  EXPECT_EQ(0u, histogram.getSummary().count);
+  EXPECT_EQ(0.0, histogram.getSummary().max);
+}
+
+TEST(LatencyHistogram, LongDurations)
+{
+  LatencyHistogram histogram;
+  histogram.add(100.0);
+  histogram.add(-1.0);
+  EXPECT_EQ(1u, histogram.getBinCount(LatencyHistogram::numberOfBins - 1));
+  EXPECT_EQ(1u, histogram.getBinCount(0));
+  EXPECT_NEAR(100.0, histogram.getSummary().percentile99, 1e-9);
+}
+
+TEST(PerformanceStatistics, ConcurrentRecording)
+{
+  PerformanceStatistics statistics;
+  boost::thread_group threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.create_thread([&statistics]() {
+      for (int i = 0; i < 1000; ++i) {
+        statistics.addDuration(PerformanceStatistics::Stage::Add, 1e-4);
+        statistics.increment(PerformanceStatistics::Counter::AddedPoints, 10);
+      }
+    });
+  }
+  threads.join_all();
+  EXPECT_EQ(4000u, statistics.getHistogram(PerformanceStatistics::Stage::Add).getSummary().count);
+  EXPECT_EQ(40000u, statistics.getCounter(PerformanceStatistics::Counter::AddedPoints));
+  EXPECT_EQ(0u, statistics.getHistogram(PerformanceStatistics::Stage::Fusion).getSummary().count);
+  EXPECT_NE(std::string::npos, statistics.toString().find("add: count 4000"));
+  EXPECT_NE(std::string::npos, statistics.toString().find("added_points: 40000"));
+}
+
+TEST(ScopedTimer, Recording)
+{
+  PerformanceStatistics statistics;
+  {
+    ScopedTimer timer(&statistics, PerformanceStatistics::Stage::Fusion);
+  }
+  ScopedTimer stoppedTimer(&statistics, PerformanceStatistics::Stage::Fusion);
+  EXPECT_GE(stoppedTimer.stop(), 0.0);
+  EXPECT_EQ(0.0, stoppedTimer.stop());
+  EXPECT_EQ(2u, statistics.getHistogram(PerformanceStatistics::Stage::Fusion).getSummary().count);
+
+  boost::mutex mutex;
+  boost::mutex::scoped_lock lock(mutex, boost::defer_lock);
+  ScopedTimer::lock(&statistics, PerformanceStatistics::Stage::RawMapLockWait, lock);
+  EXPECT_TRUE(lock.owns_lock());
+  EXPECT_EQ(1u, statistics.getHistogram(PerformanceStatistics::Stage::RawMapLockWait).getSummary().count);
+
+  // Without statistics, nothing is recorded.
+  ScopedTimer timerWithoutStatistics(nullptr, PerformanceStatistics::Stage::Add);
+  EXPECT_EQ(0.0, timerWithoutStatistics.stop());
+}
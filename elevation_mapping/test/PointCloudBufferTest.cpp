@@ -0,0 +1,207 @@
+/*
+ * PointCloudBufferTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/PointCloudBuffer.hpp"
+
+// PCL
+#include <pcl_conversions/pcl_conversions.h>
+
+// gtest
+#include <gtest/gtest.h>
+
+// STL
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace elevation_mapping;
+
+namespace {
+
+template<typename PointType>
+pcl::PointCloud<PointType> createOrganizedPointCloud(const uint32_t width, const uint32_t height)
+{
+  pcl::PointCloud<PointType> pointCloud(width, height);
+  pointCloud.header.frame_id = "sensor";
+  pointCloud.header.stamp = 1234567890123;
+  pointCloud.is_dense = false;
+  for (uint32_t i = 0; i < pointCloud.size(); ++i) {
+    PointType& point = pointCloud[i];
+    point.x = 0.01 * i;
+    point.y = -0.02 * i;
+    point.z = 1.0 + 0.001 * i;
+    if (i % 7 == 0) point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN();
+  }
+  return pointCloud;
+}
+
+void expectEqualCoordinates(const float expected, const float actual)
+{
+  if (std::isnan(expected)) {
+    EXPECT_TRUE(std::isnan(actual));
+  } else {
+    EXPECT_EQ(expected, actual);
+  }
+}
+
+}
+
+TEST(PointCloudBuffer, XYZI)
+{
+  pcl::PointCloud<pcl::PointXYZI> pointCloud = createOrganizedPointCloud<pcl::PointXYZI>(16, 12);
+  sensor_msgs::PointCloud2 message;
+  pcl::toROSMsg(pointCloud, message);
+
+  PointCloudBuffer buffer;
+  ASSERT_TRUE(buffer.fromMessage(message));
+  EXPECT_EQ(16u, buffer.getWidth());
+  EXPECT_EQ(12u, buffer.getHeight());
+  EXPECT_TRUE(buffer.isOrganized());
+  EXPECT_FALSE(buffer.hasColor());
+  EXPECT_EQ("sensor", buffer.getFrameId());
+  EXPECT_EQ(message.header.stamp, buffer.getTimeStamp());
+  ASSERT_EQ(pointCloud.size(), buffer.size());
+  for (size_t i = 0; i < pointCloud.size(); ++i) {
+    expectEqualCoordinates(pointCloud[i].x, buffer.getX()[i]);
+    expectEqualCoordinates(pointCloud[i].y, buffer.getY()[i]);
+    expectEqualCoordinates(pointCloud[i].z, buffer.getZ()[i]);
+  }
+}
+
+TEST(PointCloudBuffer, XYZRGBEqualsPclConversion)
+{
+  pcl::PointCloud<pcl::PointXYZRGB> pointCloud = createOrganizedPointCloud<pcl::PointXYZRGB>(10, 5);
+  for (size_t i = 0; i < pointCloud.size(); ++i) {
+    pointCloud[i].r = i % 256;
+    pointCloud[i].g = (3 * i) % 256;
+    pointCloud[i].b = (7 * i) % 256;
+  }
+  sensor_msgs::PointCloud2 message;
+  pcl::toROSMsg(pointCloud, message);
+  pcl::PointCloud<pcl::PointXYZRGB> expectedPointCloud;
+  pcl::fromROSMsg(message, expectedPointCloud);
+
+  PointCloudBuffer buffer;
+  ASSERT_TRUE(buffer.fromMessage(message));
+  EXPECT_TRUE(buffer.hasColor());
+  ASSERT_EQ(expectedPointCloud.size(), buffer.size());
+  for (size_t i = 0; i < expectedPointCloud.size(); ++i) {
+    expectEqualCoordinates(expectedPointCloud[i].x, buffer.getX()[i]);
+    expectEqualCoordinates(expectedPointCloud[i].y, buffer.getY()[i]);
+    expectEqualCoordinates(expectedPointCloud[i].z, buffer.getZ()[i]);
+    EXPECT_EQ(expectedPointCloud[i].rgba, buffer.getRgba()[i]);
+  }
+}
+
+TEST(PointCloudBuffer, PaddedLayout)
+{
+  // Fields in non-standard order with padding at the end of each point and row.
+  sensor_msgs::PointCloud2 message;
+  message.width = 3;
+  message.height = 2;
+  message.point_step = 20;
+  message.row_step = 64;
+  message.is_bigendian = false;
+  const std::vector<std::string> names({"z", "intensity", "x", "y"});
+  for (size_t i = 0; i < names.size(); ++i) {
+    sensor_msgs::PointField field;
+    field.name = names[i];
+    field.offset = 4 * i;
+    field.datatype = sensor_msgs::PointField::FLOAT32;
+    field.count = 1;
+    message.fields.push_back(field);
+  }
+  message.data.resize(message.row_step * message.height, 0);
+  for (uint32_t row = 0; row < message.height; ++row) {
+    for (uint32_t column = 0; column < message.width; ++column) {
+      const float values[4] = {3.0f * column, 100.0f, 1.0f * row, 2.0f * column};
+      std::memcpy(&message.data[row * message.row_step + column * message.point_step], values, sizeof(values));
+    }
+  }
+
+  PointCloudBuffer buffer;
+  ASSERT_TRUE(buffer.fromMessage(message));
+  ASSERT_EQ(6u, buffer.size());
+  for (uint32_t row = 0; row < message.height; ++row) {
+    for (uint32_t column = 0; column < message.width; ++column) {
+      const size_t i = row * message.width + column;
+      EXPECT_EQ(1.0f * row, buffer.getX()[i]);
+      EXPECT_EQ(2.0f * column, buffer.getY()[i]);
+      EXPECT_EQ(3.0f * column, buffer.getZ()[i]);
+    }
+  }
+}
+
+TEST(PointCloudBuffer, UnsupportedLayout)
+{
+  sensor_msgs::PointCloud2 message;
+  pcl::toROSMsg(createOrganizedPointCloud<pcl::PointXYZ>(4, 4), message);
+  PointCloudBuffer buffer;
+
+  sensor_msgs::PointCloud2 messageWithoutZ(message);
+  messageWithoutZ.fields.pop_back();
+  EXPECT_FALSE(buffer.fromMessage(messageWithoutZ));
+
+  sensor_msgs::PointCloud2 messageWithDoubles(message);
+  messageWithDoubles.fields[0].datatype = sensor_msgs::PointField::FLOAT64;
+  EXPECT_FALSE(buffer.fromMessage(messageWithDoubles));
+
+  sensor_msgs::PointCloud2 messageTooShort(message);
+  messageTooShort.data.resize(message.data.size() - 1);
+  EXPECT_FALSE(buffer.fromMessage(messageTooShort));
+}
+
+TEST(PointCloudBuffer, Subsample)
+{
+  PointCloudBuffer buffer;
+  buffer.fromPointCloud(createOrganizedPointCloud<pcl::PointXYZRGB>(7, 5));
+  PointCloudBuffer subsampledBuffer;
+  subsampledBuffer.subsample(buffer, 3);
+  ASSERT_EQ(3u, subsampledBuffer.getWidth());
+  ASSERT_EQ(2u, subsampledBuffer.getHeight());
+  EXPECT_EQ(buffer.getFrameId(), subsampledBuffer.getFrameId());
+  EXPECT_EQ(buffer.getTimeStamp(), subsampledBuffer.getTimeStamp());
+  for (uint32_t row = 0; row < subsampledBuffer.getHeight(); ++row) {
+    for (uint32_t column = 0; column < subsampledBuffer.getWidth(); ++column) {
+      const size_t i = row * subsampledBuffer.getWidth() + column;
+      const size_t j = 3 * row * buffer.getWidth() + 3 * column;
+      expectEqualCoordinates(buffer.getX()[j], subsampledBuffer.getX()[i]);
+      expectEqualCoordinates(buffer.getY()[j], subsampledBuffer.getY()[i]);
+      expectEqualCoordinates(buffer.getZ()[j], subsampledBuffer.getZ()[i]);
+      EXPECT_EQ(buffer.getRgba()[j], subsampledBuffer.getRgba()[i]);
+    }
+  }
+}
+
+TEST(PointCloudBuffer, Decimate)
+{
+  pcl::PointCloud<pcl::PointXYZRGB> pointCloud(5, 3);
+  for (uint32_t i = 0; i < pointCloud.size(); ++i) {
+    pointCloud[i].x = i;
+    pointCloud[i].y = 2.0 * i;
+    pointCloud[i].z = 1.0;
+    pointCloud[i].r = i;
+  }
+  // First block with one invalid point, last block of the first row without valid points.
+  pointCloud[0].z = std::numeric_limits<float>::quiet_NaN();
+  pointCloud[4].x = pointCloud[9].x = std::numeric_limits<float>::quiet_NaN();
+  PointCloudBuffer buffer;
+  buffer.fromPointCloud(pointCloud);
+  PointCloudBuffer decimatedBuffer;
+  decimatedBuffer.decimate(buffer, 2);
+
+  ASSERT_EQ(3u, decimatedBuffer.getWidth());
+  ASSERT_EQ(2u, decimatedBuffer.getHeight());
+  EXPECT_FLOAT_EQ((1.0 + 5.0 + 6.0) / 3.0, decimatedBuffer.getX()[0]);
+  EXPECT_FLOAT_EQ(2.0 * (1.0 + 5.0 + 6.0) / 3.0, decimatedBuffer.getY()[0]);
+  EXPECT_FLOAT_EQ(1.0, decimatedBuffer.getZ()[0]);
+  EXPECT_EQ(pointCloud[1].rgba, decimatedBuffer.getRgba()[0]);
+  EXPECT_FLOAT_EQ((2.0 + 3.0 + 7.0 + 8.0) / 4.0, decimatedBuffer.getX()[1]);
+  EXPECT_TRUE(std::isnan(decimatedBuffer.getX()[2]));
+  // Partial blocks at the border.
+  EXPECT_FLOAT_EQ((10.0 + 11.0) / 2.0, decimatedBuffer.getX()[3]);
+  EXPECT_FLOAT_EQ(14.0, decimatedBuffer.getX()[5]);
+}
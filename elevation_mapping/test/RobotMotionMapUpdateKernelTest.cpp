@@ -0,0 +1,165 @@
+/*
+ * RobotMotionMapUpdateKernelTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/RobotMotionMapUpdateKernel.hpp"
+#include "elevation_mapping/ElevationMapFunctors.hpp"
+#include "elevation_mapping/TileMask.hpp"
+
+// Eigen
+#include <Eigen/Geometry>
+
+// gtest
+#include <gtest/gtest.h>
+
+// STL
+#include <cmath>
+#include <limits>
+
+using namespace elevation_mapping;
+using namespace grid_map;
+
+namespace {
+
+Eigen::Matrix3d getSkewMatrix(const Eigen::Vector3d& vector)
+{
+  Eigen::Matrix3d matrix;
+  matrix << 0.0, -vector.z(), vector.y(), vector.z(), 0.0, -vector.x(), -vector.y(), vector.x(), 0.0;
+  return matrix;
+}
+
+GridMap createMap()
+{
+  GridMap map({"elevation", "variance", "horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy"});
+  map.setGeometry(Length(2.0, 1.5), 0.1, Position(0.3, -0.2));
+  map.move(Position(0.55, 0.05)); // Non-zero buffer start index.
+  for (int j = 0; j < map.getSize()(1); ++j) {
+    for (int i = 0; i < map.getSize()(0); ++i) {
+      const Index index(i, j);
+      map.at("elevation", index) = (i + j) % 7 == 0 ? NAN : 0.1 * i - 0.05 * j;
+      map.at("variance", index) = 0.001 * (1 + (i * j) % 5);
+      map.at("horizontal_variance_x", index) = 0.002 * (1 + i % 3);
+      map.at("horizontal_variance_y", index) = 0.003 * (1 + j % 4);
+      map.at("horizontal_variance_xy", index) = 0.0001 * ((i + 2 * j) % 3);
+    }
+  }
+  return map;
+}
+
+}
+
+TEST(RobotMotionMapUpdateKernel, EqualsPerCellUpdate)
+{
+  const Eigen::Vector3f translationVarianceUpdate(0.01, 0.02, 0.005);
+  const double yawVariance = 0.003;
+  const Eigen::Vector3d positionRobotToMap(-0.4, 0.7, -0.5);
+  const Eigen::Matrix3d rotation = Eigen::AngleAxisd(0.4, Eigen::Vector3d(0.1, -0.2, 1.0).normalized()).toRotationMatrix();
+  const float minVariance = 0.0001, maxVariance = 0.05, minHorizontalVariance = 0.001, maxHorizontalVariance = 0.5;
+
+  GridMap map = createMap();
+  GridMap expectedMap = map;
+
+  // Reference: Rotation Jacobian and variance update per cell.
+  Eigen::Matrix3d rotationCovariance(Eigen::Matrix3d::Zero());
+  rotationCovariance(2, 2) = yawVariance;
+  const float infinity = std::numeric_limits<float>::infinity();
+  for (int j = 0; j < map.getSize()(1); ++j) {
+    for (int i = 0; i < map.getSize()(0); ++i) {
+      const Index index(i, j);
+      Eigen::Vector3f update(infinity, infinity, infinity);
+      float updateXY = infinity;
+      Position3 cellPosition;
+      if (expectedMap.getPosition3("elevation", index, cellPosition)) {
+        const Eigen::Matrix3d rotationJacobian = -getSkewMatrix(positionRobotToMap + cellPosition) * rotation;
+        const Eigen::Matrix2f rotationVarianceUpdate = (rotationJacobian * rotationCovariance
+            * rotationJacobian.transpose()).topLeftCorner<2, 2>().cast<float>();
+        update = translationVarianceUpdate;
+        update.x() += rotationVarianceUpdate(0, 0);
+        update.y() += rotationVarianceUpdate(1, 1);
+        updateXY = rotationVarianceUpdate(0, 1);
+      }
+      expectedMap.at("variance", index) += update.z();
+      expectedMap.at("horizontal_variance_x", index) += update.x();
+      expectedMap.at("horizontal_variance_y", index) += update.y();
+      expectedMap.at("horizontal_variance_xy", index) += updateXY;
+    }
+  }
+  expectedMap.get("variance") = expectedMap.get("variance").unaryExpr(
+      VarianceClampOperator<float>(minVariance, maxVariance));
+  for (const auto& layer : {"horizontal_variance_x", "horizontal_variance_y"}) {
+    expectedMap.get(layer) = expectedMap.get(layer).unaryExpr(
+        VarianceClampOperator<float>(minHorizontalVariance, maxHorizontalVariance));
+  }
+
+  RobotMotionMapUpdateKernel kernel;
+  kernel.setUpdate(translationVarianceUpdate, yawVariance, positionRobotToMap, rotation.col(2));
+  EXPECT_FALSE(kernel.isZero());
+  kernel.apply(map, minVariance, maxVariance, minHorizontalVariance, maxHorizontalVariance);
+
+  for (const auto& layer : {"variance", "horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy"}) {
+    for (int j = 0; j < map.getSize()(1); ++j) {
+      for (int i = 0; i < map.getSize()(0); ++i) {
+        const float expected = expectedMap.at(layer, Index(i, j));
+        const float actual = map.at(layer, Index(i, j));
+        if (std::isinf(expected)) {
+          EXPECT_TRUE(std::isinf(actual)) << layer << " (" << i << ", " << j << ")";
+        } else {
+          EXPECT_NEAR(expected, actual, 1e-6 * std::abs(expected)) << layer << " (" << i << ", " << j << ")";
+        }
+      }
+    }
+  }
+}
+
+TEST(RobotMotionMapUpdateKernel, ZeroUpdate)
+{
+  RobotMotionMapUpdateKernel kernel;
+  EXPECT_TRUE(kernel.isZero());
+  kernel.setUpdate(Eigen::Vector3f::Zero(), 0.0, Eigen::Vector3d(1.0, 2.0, 3.0), Eigen::Vector3d::UnitZ());
+  EXPECT_TRUE(kernel.isZero());
+
+  GridMap map = createMap();
+  const GridMap originalMap = map;
+  kernel.apply(map, 0.0, 1.0, 0.0, 1.0);
+  for (int j = 0; j < map.getSize()(1); ++j) {
+    for (int i = 0; i < map.getSize()(0); ++i) {
+      const Index index(i, j);
+      if (std::isnan(originalMap.at("elevation", index))) {
+        EXPECT_TRUE(std::isinf(map.at("variance", index)));
+      } else {
+        EXPECT_EQ(originalMap.at("variance", index), map.at("variance", index));
+        EXPECT_EQ(originalMap.at("horizontal_variance_x", index), map.at("horizontal_variance_x", index));
+        EXPECT_EQ(originalMap.at("horizontal_variance_xy", index), map.at("horizontal_variance_xy", index));
+      }
+    }
+  }
+}
+
+TEST(RobotMotionMapUpdateKernel, ActiveTilesEqualFullUpdate)
+{
+  RobotMotionMapUpdateKernel kernel;
+  kernel.setUpdate(Eigen::Vector3f(0.01, 0.02, 0.005), 0.003, Eigen::Vector3d(-0.4, 0.7, -0.5),
+                   Eigen::Vector3d(0.1, -0.2, 1.0).normalized());
+  GridMap map = createMap();
+  GridMap mapWithActiveTiles = map;
+  TileMask activeTiles(4);
+  activeTiles.setSize(map.getSize());
+  activeTiles.reset();
+  activeTiles.markCell(Index(2, 3));
+  activeTiles.markCell(Index(19, 14));
+  kernel.apply(map, 0.0001, 0.05, 0.001, 0.5);
+  kernel.apply(mapWithActiveTiles, 0.0001, 0.05, 0.001, 0.5, &activeTiles);
+
+  const GridMap originalMap = createMap();
+  for (const auto& layer : {"variance", "horizontal_variance_x", "horizontal_variance_y", "horizontal_variance_xy"}) {
+    for (int j = 0; j < map.getSize()(1); ++j) {
+      for (int i = 0; i < map.getSize()(0); ++i) {
+        const Index index(i, j);
+        const float expected = activeTiles.isCellMarked(index) ? map.at(layer, index) : originalMap.at(layer, index);
+        EXPECT_EQ(expected, mapWithActiveTiles.at(layer, index)) << layer << " (" << i << ", " << j << ")";
+      }
+    }
+  }
+}
@@ -0,0 +1,121 @@
+/*
+ * RobotPoseHistoryTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/RobotPoseHistory.hpp"
+
+// gtest
+#include <gtest/gtest.h>
+
+// Boost
+#include <boost/thread.hpp>
+
+// STL
+#include <atomic>
+#include <cmath>
+
+using namespace elevation_mapping;
+
+namespace {
+
+RobotPoseHistory::Entry createEntry(const double time)
+{
+  RobotPoseHistory::Entry entry;
+  entry.time.fromSec(time);
+  entry.position = Eigen::Vector3d(time, 2.0 * time, 0.0);
+  entry.orientation = Eigen::Quaterniond(Eigen::AngleAxisd(0.1 * time, Eigen::Vector3d::UnitZ()));
+  entry.covariance = time * Eigen::Matrix<double, 6, 6>::Identity();
+  return entry;
+}
+
+ros::Time createTime(const double time)
+{
+  ros::Time rosTime;
+  rosTime.fromSec(time);
+  return rosTime;
+}
+
+}
+
+TEST(RobotPoseHistory, EntryBeforeTime)
+{
+  RobotPoseHistory history(10);
+  RobotPoseHistory::Entry entry;
+  EXPECT_FALSE(history.getEntryBeforeTime(createTime(1.0), entry));
+
+  for (int i = 1; i <= 5; ++i) EXPECT_TRUE(history.add(createEntry(i)));
+  EXPECT_FALSE(history.add(createEntry(4.5)));
+  EXPECT_EQ(5u, history.size());
+  EXPECT_DOUBLE_EQ(5.0, history.getLatestTime().toSec());
+
+  EXPECT_FALSE(history.getEntryBeforeTime(createTime(0.5), entry));
+  ASSERT_TRUE(history.getEntryBeforeTime(createTime(1.0), entry));
+  EXPECT_DOUBLE_EQ(1.0, entry.time.toSec());
+  ASSERT_TRUE(history.getEntryBeforeTime(createTime(3.7), entry));
+  EXPECT_DOUBLE_EQ(3.0, entry.time.toSec());
+  EXPECT_DOUBLE_EQ(3.0, entry.position.x());
+  ASSERT_TRUE(history.getEntryBeforeTime(createTime(10.0), entry));
+  EXPECT_DOUBLE_EQ(5.0, entry.time.toSec());
+}
+
+TEST(RobotPoseHistory, WrapAround)
+{
+  RobotPoseHistory history(4);
+  for (int i = 1; i <= 10; ++i) history.add(createEntry(i));
+  EXPECT_EQ(4u, history.size());
+  RobotPoseHistory::Entry entry;
+  // Only the poses 7 to 10 are kept.
+  EXPECT_FALSE(history.getEntryBeforeTime(createTime(6.5), entry));
+  ASSERT_TRUE(history.getEntryBeforeTime(createTime(7.0), entry));
+  EXPECT_DOUBLE_EQ(7.0, entry.time.toSec());
+  ASSERT_TRUE(history.getEntryBeforeTime(createTime(9.9), entry));
+  EXPECT_DOUBLE_EQ(9.0, entry.time.toSec());
+}
+
+TEST(RobotPoseHistory, Interpolation)
+{
+  RobotPoseHistory history(10);
+  history.add(createEntry(1.0));
+  history.add(createEntry(2.0));
+  RobotPoseHistory::Entry entry;
+  ASSERT_TRUE(history.getEntryAtTime(createTime(1.25), entry));
+  const RobotPoseHistory::Entry expectedEntry = createEntry(1.25);
+  EXPECT_DOUBLE_EQ(1.25, entry.time.toSec());
+  EXPECT_TRUE(entry.position.isApprox(expectedEntry.position));
+  EXPECT_TRUE(entry.orientation.isApprox(expectedEntry.orientation));
+  EXPECT_TRUE(entry.covariance.isApprox(expectedEntry.covariance));
+
+  // No extrapolation after the latest pose.
+  ASSERT_TRUE(history.getEntryAtTime(createTime(3.0), entry));
+  EXPECT_DOUBLE_EQ(2.0, entry.time.toSec());
+}
+
+TEST(RobotPoseHistory, ConcurrentReaders)
+{
+  // The readers must always see consistent poses while the writer wraps around the history.
+  RobotPoseHistory history(16);
+  history.add(createEntry(0.0));
+  std::atomic<bool> isWriting(true);
+  std::atomic<int> numberOfInconsistentPoses(0);
+  boost::thread_group readers;
+  for (int r = 0; r < 3; ++r) {
+    readers.create_thread([&]() {
+      RobotPoseHistory::Entry entry;
+      while (isWriting) {
+        const ros::Time latestTime = history.getLatestTime();
+        if (!history.getEntryBeforeTime(latestTime, entry)) continue;
+        const double time = entry.position.x();
+        if (entry.position.y() != 2.0 * time || entry.covariance(5, 5) != time) ++numberOfInconsistentPoses;
+      }
+    });
+  }
+  boost::thread writer([&]() {
+    for (int i = 1; i <= 20000; ++i) history.add(createEntry(0.001 * i));
+    isWriting = false;
+  });
+  writer.join();
+  readers.join_all();
+  EXPECT_EQ(0, numberOfInconsistentPoses);
+}
@@ -0,0 +1,63 @@
+/*
+ * SensorModelParameters.hpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#pragma once
+
+#include "elevation_mapping/sensor_processors/StructuredLightSensorProcessor.hpp"
+#include "elevation_mapping/sensor_processors/StereoSensorProcessor.hpp"
+#include "elevation_mapping/sensor_processors/LaserSensorProcessor.hpp"
+#include "elevation_mapping/sensor_processors/PerfectSensorProcessor.hpp"
+
+namespace elevation_mapping {
+
+// Sensor model parameters for the tests and the benchmarks (instead of ROS parameters),
+// taken from the configurations in config/sensor_processors.
+
+//! Structured light sensor model parameters (realsense_ZR300.yaml).
+inline void setSensorModelParameters(StructuredLightSensorProcessor& sensorProcessor)
+{
+  StructuredLightSensorProcessor::Parameters parameters;
+  parameters.cutoffMinDepth = 0.35;
+  parameters.cutoffMaxDepth = 3.0;
+  parameters.normalFactorA = 0.00241809;
+  parameters.normalFactorB = 0.00662547;
+  parameters.normalFactorC = 0.77199589;
+  parameters.normalFactorD = 0.0;
+  parameters.normalFactorE = 1.0;
+  parameters.lateralFactor = 0.00220941;
+  sensorProcessor.setParameters(parameters);
+}
+
+//! Stereo sensor model parameters (aslam.yaml).
+inline void setSensorModelParameters(StereoSensorProcessor& sensorProcessor)
+{
+  StereoSensorProcessor::Parameters parameters;
+  parameters.p1 = 0.03287;
+  parameters.p2 = -0.0001276;
+  parameters.p3 = 0.4850;
+  parameters.p4 = 399.1046;
+  parameters.p5 = 0.000006735;
+  parameters.lateralFactor = 0.00220941;
+  parameters.depthToDisparityFactor = 47.3;
+  sensorProcessor.setParameters(parameters);
+}
+
+//! Laser sensor model parameters (hokuyo_utm-30lx.yaml).
+inline void setSensorModelParameters(LaserSensorProcessor& sensorProcessor)
+{
+  LaserSensorProcessor::Parameters parameters;
+  parameters.minRadius = 0.018;
+  parameters.beamAngle = 0.0006;
+  parameters.beamConstant = 0.0015;
+  sensorProcessor.setParameters(parameters);
+}
+
+//! The perfect sensor has no sensor model parameters.
+inline void setSensorModelParameters(PerfectSensorProcessor& /*sensorProcessor*/)
+{
+}
+
+} /* namespace elevation_mapping */
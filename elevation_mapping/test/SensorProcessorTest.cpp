@@ -0,0 +1,282 @@
+/*
+ * SensorProcessorTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "SensorModelParameters.hpp"
+
+// ROS
+#include <ros/ros.h>
+#include <tf/tf.h>
+#include <tf_conversions/tf_eigen.h>
+
+// gtest
+#include <gtest/gtest.h>
+
+// STL
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace elevation_mapping;
+
+namespace {
+
+/*!
+ * Sensor processor with test frames and parameters (instead of ROS parameters).
+ */
+template<typename Processor>
+class TestSensorProcessor : public Processor
+{
+ public:
+  explicit TestSensorProcessor(tf::Transformer& transformer, const bool enableSinglePassProcessing)
+      : Processor(transformer)
+  {
+    this->mapFrameId_ = "map";
+    this->robotBaseFrameId_ = "base";
+    this->sensorFrameId_ = "sensor";
+    this->enableSinglePassProcessing_ = enableSinglePassProcessing;
+    setSensorModelParameters(*this);
+  }
+
+  void setHeightLimits(const double lowerThreshold, const double upperThreshold)
+  {
+    this->ignorePointsLowerThreshold_ = lowerThreshold;
+    this->ignorePointsUpperThreshold_ = upperThreshold;
+  }
+
+  //! Simulates a message on /tf_static with the transformations (parent and child frame id).
+  void setStaticTransforms(const std::vector<std::pair<std::string, std::string>>& frameIds)
+  {
+    std::vector<geometry_msgs::TransformStamped> transforms;
+    for (const auto& parentAndChildFrameId : frameIds) {
+      geometry_msgs::TransformStamped transform;
+      transform.header.frame_id = parentAndChildFrameId.first;
+      transform.child_frame_id = parentAndChildFrameId.second;
+      transforms.push_back(transform);
+    }
+    this->addStaticTransformations(transforms);
+  }
+
+  const Eigen::Affine3d& getTransformationBaseToMap() const
+  {
+    return this->transformationBaseToMap_;
+  }
+};
+
+void setTransform(tf::Transformer& transformer, const Eigen::Affine3d& transformation, const ros::Time& time,
+                  const std::string& parentFrameId, const std::string& childFrameId)
+{
+  tf::Transform transform;
+  tf::transformEigenToTF(transformation, transform);
+  transformer.setTransform(tf::StampedTransform(transform, time, parentFrameId, childFrameId));
+}
+
+//! Organized point cloud in a camera frame (rigidly attached to the sensor), with NaN points.
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr createPointCloud(const ros::Time& time)
+{
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<float> lateral(-1.0, 1.0);
+  std::uniform_real_distribution<float> depth(0.1, 4.0);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointCloud(new pcl::PointCloud<pcl::PointXYZRGB>(64, 48));
+  pointCloud->header.frame_id = "camera";
+  pointCloud->header.stamp = time.toNSec() / 1000;
+  pointCloud->is_dense = false;
+  for (size_t i = 0; i < pointCloud->size(); ++i) {
+    auto& point = pointCloud->points[i];
+    point.x = lateral(generator);
+    point.y = lateral(generator);
+    point.z = depth(generator);
+    point.r = i % 256;
+    point.g = 100;
+    point.b = 200;
+    if (i % 11 == 0) point.y = std::numeric_limits<float>::quiet_NaN();
+  }
+  return pointCloud;
+}
+
+}
+
+template<typename Processor>
+class SensorProcessorTest : public ::testing::Test
+{
+ protected:
+  SensorProcessorTest()
+      : transformer_(true, ros::Duration(10.0)),
+        time_(1000.0)
+  {
+    const Eigen::Affine3d transformationBaseToMap = Eigen::Translation3d(0.5, -0.2, 0.5)
+        * Eigen::AngleAxisd(0.3, Eigen::Vector3d::UnitZ());
+    const Eigen::Affine3d transformationSensorToBase = Eigen::Translation3d(0.2, 0.0, 0.3)
+        * Eigen::AngleAxisd(M_PI / 6.0, Eigen::Vector3d::UnitY())
+        * Eigen::AngleAxisd(-M_PI / 2.0, Eigen::Vector3d::UnitZ()) * Eigen::AngleAxisd(-M_PI / 2.0, Eigen::Vector3d::UnitX());
+    const Eigen::Affine3d transformationCameraToSensor = Eigen::Translation3d(0.01, 0.02, 0.0)
+        * Eigen::AngleAxisd(0.05, Eigen::Vector3d::UnitY());
+    setTransform(transformer_, transformationBaseToMap, time_, "map", "base");
+    setTransform(transformer_, transformationSensorToBase, time_, "base", "sensor");
+    setTransform(transformer_, transformationCameraToSensor, time_, "sensor", "camera");
+    robotPoseCovariance_ = 1e-4 * Eigen::Matrix<double, 6, 6>::Identity();
+    robotPoseCovariance_(5, 5) = 4e-4;
+  }
+
+  tf::Transformer transformer_;
+  ros::Time time_;
+  Eigen::Matrix<double, 6, 6> robotPoseCovariance_;
+};
+
+typedef ::testing::Types<StructuredLightSensorProcessor, StereoSensorProcessor, LaserSensorProcessor,
+    PerfectSensorProcessor> SensorProcessorTypes;
+TYPED_TEST_CASE(SensorProcessorTest, SensorProcessorTypes);
+
+TYPED_TEST(SensorProcessorTest, SinglePassEqualsStepwise)
+{
+  const auto pointCloud = createPointCloud(this->time_);
+
+  TestSensorProcessor<TypeParam> stepwiseProcessor(this->transformer_, false);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr expectedPointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  Eigen::VectorXf expectedVariances;
+  ASSERT_TRUE(stepwiseProcessor.process(pointCloud, this->robotPoseCovariance_, expectedPointCloud, expectedVariances));
+  ASSERT_GT(expectedPointCloud->size(), 100u);
+  ASSERT_LT(expectedPointCloud->size(), pointCloud->size());
+
+  TestSensorProcessor<TypeParam> singlePassProcessor(this->transformer_, true);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr outputPointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  Eigen::VectorXf variances;
+  PointCloudBuffer buffer;
+  buffer.fromPointCloud(*pointCloud);
+  ASSERT_TRUE(singlePassProcessor.process(buffer, this->robotPoseCovariance_, outputPointCloud, variances));
+
+  EXPECT_EQ("map", outputPointCloud->header.frame_id);
+  ASSERT_EQ(expectedPointCloud->size(), outputPointCloud->size());
+  ASSERT_EQ(expectedVariances.size(), variances.size());
+  for (size_t i = 0; i < outputPointCloud->size(); ++i) {
+    const auto& expectedPoint = expectedPointCloud->points[i];
+    const auto& point = outputPointCloud->points[i];
+    EXPECT_NEAR(expectedPoint.x, point.x, 1e-5);
+    EXPECT_NEAR(expectedPoint.y, point.y, 1e-5);
+    EXPECT_NEAR(expectedPoint.z, point.z, 1e-5);
+    EXPECT_EQ(expectedPoint.rgba, point.rgba);
+    EXPECT_NEAR(expectedVariances(i), variances(i), 1e-4 * std::abs(expectedVariances(i)) + 1e-10);
+  }
+}
+
+TYPED_TEST(SensorProcessorTest, HeightLimits)
+{
+  const auto pointCloud = createPointCloud(this->time_);
+  const double lowerThreshold = -0.6, upperThreshold = 0.4, baseHeight = 0.5;
+
+  TestSensorProcessor<TypeParam> stepwiseProcessor(this->transformer_, false);
+  stepwiseProcessor.setHeightLimits(lowerThreshold, upperThreshold);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr expectedPointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  Eigen::VectorXf expectedVariances;
+  ASSERT_TRUE(stepwiseProcessor.process(pointCloud, this->robotPoseCovariance_, expectedPointCloud, expectedVariances));
+
+  TestSensorProcessor<TypeParam> singlePassProcessor(this->transformer_, true);
+  singlePassProcessor.setHeightLimits(lowerThreshold, upperThreshold);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr outputPointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  Eigen::VectorXf variances;
+  ASSERT_TRUE(singlePassProcessor.process(pointCloud, this->robotPoseCovariance_, outputPointCloud, variances));
+
+  ASSERT_GT(outputPointCloud->size(), 0u);
+  EXPECT_EQ(expectedPointCloud->size(), outputPointCloud->size());
+  EXPECT_EQ(outputPointCloud->size(), static_cast<size_t>(variances.size()));
+  for (const auto& point : outputPointCloud->points) {
+    EXPECT_LE(baseHeight + lowerThreshold, point.z + 1e-6);
+    EXPECT_GE(baseHeight + upperThreshold, point.z - 1e-6);
+  }
+}
+
+typedef SensorProcessorTest<StructuredLightSensorProcessor> StructuredLightSensorProcessorTest;
+
+TEST_F(StructuredLightSensorProcessorTest, IntegerNormalExponents)
+{
+  const auto pointCloud = createPointCloud(time_);
+  for (const double exponent : {0.0, 1.0, 2.0, 3.0}) {
+    SCOPED_TRACE(exponent);
+    TestSensorProcessor<StructuredLightSensorProcessor> stepwiseProcessor(transformer_, false);
+    TestSensorProcessor<StructuredLightSensorProcessor> singlePassProcessor(transformer_, true);
+    StructuredLightSensorProcessor::Parameters parameters = stepwiseProcessor.getParameters();
+    parameters.normalFactorD = 0.01;
+    parameters.normalFactorE = exponent;
+    stepwiseProcessor.setParameters(parameters);
+    singlePassProcessor.setParameters(parameters);
+
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr expectedPointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+    Eigen::VectorXf expectedVariances;
+    ASSERT_TRUE(stepwiseProcessor.process(pointCloud, robotPoseCovariance_, expectedPointCloud, expectedVariances));
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr outputPointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+    Eigen::VectorXf variances;
+    ASSERT_TRUE(singlePassProcessor.process(pointCloud, robotPoseCovariance_, outputPointCloud, variances));
+
+    ASSERT_EQ(expectedVariances.size(), variances.size());
+    for (int i = 0; i < variances.size(); ++i) {
+      EXPECT_NEAR(expectedVariances(i), variances(i), 1e-4 * std::abs(expectedVariances(i)) + 1e-10);
+    }
+  }
+}
+
+typedef SensorProcessorTest<StereoSensorProcessor> StereoSensorProcessorTest;
+
+TEST_F(StereoSensorProcessorTest, PixelStride)
+{
+  // Only the pixels on the stride are valid, such that the subsampled point cloud has the same points.
+  const auto pointCloud = createPointCloud(time_);
+  for (uint32_t v = 0; v < pointCloud->height; ++v) {
+    for (uint32_t u = 0; u < pointCloud->width; ++u) {
+      if (u % 2 != 0 || v % 2 != 0) pointCloud->at(u, v).x = std::numeric_limits<float>::quiet_NaN();
+    }
+  }
+
+  TestSensorProcessor<StereoSensorProcessor> stepwiseProcessor(transformer_, false);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr expectedPointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  Eigen::VectorXf expectedVariances;
+  ASSERT_TRUE(stepwiseProcessor.process(pointCloud, robotPoseCovariance_, expectedPointCloud, expectedVariances));
+
+  TestSensorProcessor<StereoSensorProcessor> singlePassProcessor(transformer_, true);
+  StereoSensorProcessor::Parameters parameters = singlePassProcessor.getParameters();
+  parameters.pixelStride = 2;
+  singlePassProcessor.setParameters(parameters);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr outputPointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  Eigen::VectorXf variances;
+  ASSERT_TRUE(singlePassProcessor.process(pointCloud, robotPoseCovariance_, outputPointCloud, variances));
+
+  ASSERT_GT(outputPointCloud->size(), 0u);
+  ASSERT_EQ(expectedPointCloud->size(), outputPointCloud->size());
+  for (size_t i = 0; i < outputPointCloud->size(); ++i) {
+    EXPECT_NEAR(expectedPointCloud->points[i].z, outputPointCloud->points[i].z, 1e-5);
+    EXPECT_NEAR(expectedVariances(i), variances(i), 1e-4 * std::abs(expectedVariances(i)) + 1e-10);
+  }
+}
+
+typedef SensorProcessorTest<PerfectSensorProcessor> PerfectSensorProcessorTest;
+
+TEST_F(PerfectSensorProcessorTest, StaticTransformationCache)
+{
+  TestSensorProcessor<PerfectSensorProcessor> processor(transformer_, true);
+  processor.setStaticTransforms({{"base", "sensor"}, {"sensor", "camera"}});
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr outputPointCloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  Eigen::VectorXf variances;
+  ASSERT_TRUE(processor.process(createPointCloud(time_), robotPoseCovariance_, outputPointCloud, variances));
+  EXPECT_NEAR(0.5, processor.getTransformationBaseToMap().translation().z(), 1e-6);
+
+  // Move the sensor up on the base, without an update of the static transformations.
+  const ros::Time time = time_ + ros::Duration(1.0);
+  for (const auto& frameIds : std::vector<std::pair<std::string, std::string>>({{"map", "base"}, {"base", "sensor"}, {"sensor", "camera"}})) {
+    tf::StampedTransform transform;
+    transformer_.lookupTransform(frameIds.first, frameIds.second, time_, transform);
+    transform.stamp_ = time;
+    if (frameIds.second == "sensor") transform.setOrigin(transform.getOrigin() + tf::Vector3(0.0, 0.0, 0.1));
+    transformer_.setTransform(transform);
+  }
+
+  // The cached sensor to base transformation is used until the static transformations change.
+  ASSERT_TRUE(processor.process(createPointCloud(time), robotPoseCovariance_, outputPointCloud, variances));
+  EXPECT_NEAR(0.6, processor.getTransformationBaseToMap().translation().z(), 1e-6);
+  processor.setStaticTransforms({{"base", "sensor"}, {"sensor", "camera"}});
+  ASSERT_TRUE(processor.process(createPointCloud(time), robotPoseCovariance_, outputPointCloud, variances));
+  EXPECT_NEAR(0.5, processor.getTransformationBaseToMap().translation().z(), 1e-6);
+}
@@ -0,0 +1,127 @@
+/*
+ * ThreadPoolTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/ThreadPool.hpp"
+
+// gtest
+#include <gtest/gtest.h>
+
+// Boost
+#include <boost/thread.hpp>
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+using namespace elevation_mapping;
+
+namespace {
+
+//! Processes [0, size) and checks that every index is processed exactly once, in chunks of at most
+//! grainSize indices (of one chunk with a single thread).
+void expectIndicesProcessedOnce(ThreadPool& threadPool, const size_t size, const size_t grainSize)
+{
+  std::vector<std::atomic<int>> counts(size);
+  for (auto& count : counts) count = 0;
+  std::atomic<bool> isChunkValid(true);
+  const size_t maxChunkSize = threadPool.getNumberOfThreads() > 1 ? std::max(grainSize, size_t(1)) : size;
+  threadPool.parallelFor(size, grainSize, [&](size_t begin, size_t end, unsigned int threadIndex) {
+    if (!(begin < end && end <= size && end - begin <= maxChunkSize && threadIndex < threadPool.getNumberOfThreads())) {
+      isChunkValid = false;
+    }
+    for (size_t i = begin; i < end && i < size; ++i) ++counts[i];
+  });
+  EXPECT_TRUE(isChunkValid);
+  for (size_t i = 0; i < size; ++i) ASSERT_EQ(1, counts[i]) << "Index: " << i;
+}
+
+} // namespace
+
+TEST(ThreadPool, EmptyRange)
+{
+  ThreadPool threadPool(4);
+  bool isCalled = false;
+  threadPool.parallelFor(0, 10, [&](size_t, size_t, unsigned int) { isCalled = true; });
+  EXPECT_FALSE(isCalled);
+}
+
+TEST(ThreadPool, SingleThreadRunsInCallingThread)
+{
+  ThreadPool threadPool(1);
+  EXPECT_EQ(1, threadPool.getNumberOfThreads());
+  const boost::thread::id callingThread = boost::this_thread::get_id();
+  std::vector<size_t> chunks;
+  threadPool.parallelFor(100, 10, [&](size_t begin, size_t end, unsigned int threadIndex) {
+    EXPECT_EQ(callingThread, boost::this_thread::get_id());
+    EXPECT_EQ(0, threadIndex);
+    chunks.push_back(begin);
+    chunks.push_back(end);
+  });
+  EXPECT_EQ(std::vector<size_t>({0, 100}), chunks);
+}
+
+TEST(ThreadPool, ProcessesEveryIndexOnce)
+{
+  ThreadPool threadPool(4);
+  EXPECT_EQ(4, threadPool.getNumberOfThreads());
+  expectIndicesProcessedOnce(threadPool, 10007, 7);
+  expectIndicesProcessedOnce(threadPool, 3, 7);
+  expectIndicesProcessedOnce(threadPool, 64, 1);
+  // The grain size is at least one.
+  expectIndicesProcessedOnce(threadPool, 100, 0);
+}
+
+TEST(ThreadPool, UsesWorkerThreads)
+{
+  ThreadPool threadPool(3);
+  std::vector<std::atomic<int>> chunksPerThread(3);
+  for (auto& chunks : chunksPerThread) chunks = 0;
+  std::atomic<int> numberOfWaitingChunks(0);
+  // Each of the first chunks waits for the others, so they must run concurrently.
+  threadPool.parallelFor(3, 1, [&](size_t, size_t, unsigned int threadIndex) {
+    ++chunksPerThread[threadIndex];
+    ++numberOfWaitingChunks;
+    while (numberOfWaitingChunks < 3) boost::this_thread::yield();
+  });
+  for (const auto& chunks : chunksPerThread) EXPECT_EQ(1, chunks);
+}
+
+TEST(ThreadPool, RepeatedJobsAndResize)
+{
+  ThreadPool threadPool(2);
+  for (int i = 0; i < 200; ++i) expectIndicesProcessedOnce(threadPool, 257, 16);
+  threadPool.setNumberOfThreads(5);
+  EXPECT_EQ(5, threadPool.getNumberOfThreads());
+  expectIndicesProcessedOnce(threadPool, 1000, 3);
+  threadPool.setNumberOfThreads(0);
+  EXPECT_EQ(std::max(boost::thread::hardware_concurrency(), 1u), threadPool.getNumberOfThreads());
+  expectIndicesProcessedOnce(threadPool, 1000, 3);
+  threadPool.setNumberOfThreads(1);
+  expectIndicesProcessedOnce(threadPool, 1000, 3);
+}
+
+TEST(ThreadPool, ConcurrentCallsAreSerialized)
+{
+  ThreadPool threadPool(3);
+  // Number of running chunks of each caller, the chunks of the other caller must not run at the same time.
+  std::atomic<int> numberOfRunningChunks[2];
+  for (auto& number : numberOfRunningChunks) number = 0;
+  std::atomic<bool> isOverlapping(false);
+  const auto callParallelFor = [&](const int caller) {
+    for (int i = 0; i < 100; ++i) {
+      threadPool.parallelFor(64, 4, [&](size_t, size_t, unsigned int) {
+        ++numberOfRunningChunks[caller];
+        if (numberOfRunningChunks[1 - caller] > 0) isOverlapping = true;
+        --numberOfRunningChunks[caller];
+      });
+    }
+  };
+  boost::thread otherCaller(callParallelFor, 1);
+  callParallelFor(0);
+  otherCaller.join();
+  EXPECT_FALSE(isOverlapping);
+}
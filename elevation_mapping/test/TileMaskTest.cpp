@@ -0,0 +1,184 @@
+/*
+ * TileMaskTest.cpp
+ *
+ *  Created on: Oct 14, 2026
+ */
+
+#include "elevation_mapping/TileMask.hpp"
+
+// gtest
+#include <gtest/gtest.h>
+
+using namespace elevation_mapping;
+using grid_map::Index;
+using grid_map::Size;
+
+TEST(TileMask, MarkCellAndRegion)
+{
+  TileMask mask(4);
+  mask.setSize(Size(10, 9));
+  EXPECT_TRUE((Size(3, 3) == mask.getNumberOfTiles()).all());
+  EXPECT_TRUE(mask.isAnyMarked());
+  mask.reset();
+  EXPECT_FALSE(mask.isAnyMarked());
+
+  mask.markCell(Index(9, 4));
+  EXPECT_TRUE(mask.isMarked(Index(2, 1)));
+  mask.reset();
+
+  // Region wrapping around the buffer border.
+  mask.markRegion(Index(7, 0), Size(5, 2));
+  for (int tileCol = 0; tileCol < 3; ++tileCol) {
+    for (int tileRow = 0; tileRow < 3; ++tileRow) {
+      const bool isExpected = (tileCol == 0 && (tileRow == 0 || tileRow == 1 || tileRow == 2));
+      EXPECT_EQ(isExpected, mask.isMarked(Index(tileRow, tileCol))) << tileRow << ", " << tileCol;
+    }
+  }
+
+  Index startIndex;
+  Size tileSize;
+  mask.getTileRegion(Index(2, 2), startIndex, tileSize);
+  EXPECT_TRUE((Index(8, 8) == startIndex).all());
+  EXPECT_TRUE((Size(2, 1) == tileSize).all());
+}
+
+TEST(TileMask, DilateWrapsAround)
+{
+  TileMask mask(2);
+  mask.setSize(Size(20, 20));
+  mask.reset();
+  mask.markCell(Index(0, 10));
+  mask.dilate(1);
+
+  // One tile for the radius and one for the buffer border.
+  for (int tileCol = 0; tileCol < 10; ++tileCol) {
+    for (int tileRow = 0; tileRow < 10; ++tileRow) {
+      const bool isExpected = (tileRow <= 2 || tileRow >= 8) && (tileCol >= 3 && tileCol <= 7);
+      EXPECT_EQ(isExpected, mask.isMarked(Index(tileRow, tileCol))) << tileRow << ", " << tileCol;
+    }
+  }
+
+  mask.dilate(100);
+  for (int tileCol = 0; tileCol < 10; ++tileCol) {
+    for (int tileRow = 0; tileRow < 10; ++tileRow) {
+      EXPECT_TRUE(mask.isMarked(Index(tileRow, tileCol)));
+    }
+  }
+}
+
+TEST(TileMask, UnmarkEmptyTiles)
+{
+  TileMask mask(4);
+  mask.setSize(Size(10, 6));
+  grid_map::Matrix layer = grid_map::Matrix::Constant(10, 6, NAN);
+  layer(9, 5) = 1.0;
+  layer(1, 2) = 2.0;
+  mask.unmarkEmptyTiles(layer);
+
+  int numberOfTiles = 0;
+  mask.forEachMarkedTile([&](const Index& startIndex, const Size& size) {
+    ++numberOfTiles;
+    EXPECT_TRUE(mask.isCellMarked(startIndex));
+    EXPECT_TRUE((startIndex == Index(8, 4)).all() || (startIndex == Index(0, 0)).all());
+    if (startIndex(0) == 8) {
+      EXPECT_TRUE((Size(2, 2) == size).all());
+    }
+  });
+  EXPECT_EQ(2, numberOfTiles);
+  EXPECT_FALSE(mask.isCellMarked(Index(5, 5)));
+}
+
+TEST(TileMask, BoundingRegion)
+{
+  TileMask mask(4);
+  mask.setSize(Size(10, 12));
+  mask.reset();
+  Index startIndex;
+  Size size;
+  EXPECT_FALSE(mask.getBoundingRegion(Index(0, 0), startIndex, size));
+
+  mask.markCell(Index(5, 5));
+  ASSERT_TRUE(mask.getBoundingRegion(Index(0, 0), startIndex, size));
+  EXPECT_TRUE((Index(4, 4) == startIndex).all());
+  EXPECT_TRUE((Size(4, 4) == size).all());
+
+  // The tile at the buffer border is split by the buffer start index.
+  mask.markCell(Index(9, 10));
+  ASSERT_TRUE(mask.getBoundingRegion(Index(9, 0), startIndex, size));
+  EXPECT_TRUE((Index(0, 4) == startIndex).all());
+  EXPECT_TRUE((Size(10, 8) == size).all());
+  ASSERT_TRUE(mask.getBoundingRegion(Index(3, 6), startIndex, size));
+  EXPECT_TRUE((Index(1, 0) == startIndex).all());
+  EXPECT_TRUE((Size(6, 12) == size).all());
+}
+
+TEST(TileMask, MarkedRegions)
+{
+  TileMask mask(4);
+  mask.setSize(Size(10, 12));
+  mask.reset();
+  EXPECT_TRUE(mask.getMarkedRegions(Index(0, 0)).empty());
+
+  // Two separate blocks of tiles instead of their bounding region.
+  mask.markRegion(Index(0, 0), Size(8, 4));
+  mask.markCell(Index(9, 9));
+  std::vector<TileMask::Region> regions = mask.getMarkedRegions(Index(0, 0));
+  ASSERT_EQ(2u, regions.size());
+  EXPECT_TRUE((Index(0, 0) == regions[0].startIndex).all());
+  EXPECT_TRUE((Size(8, 4) == regions[0].size).all());
+  EXPECT_TRUE((Index(8, 8) == regions[1].startIndex).all());
+  EXPECT_TRUE((Size(2, 4) == regions[1].size).all());
+
+  // The regions cover exactly the cells of the marked tiles, also if the tiles are split by the
+  // buffer start index.
+  for (const Index& bufferStartIndex : {Index(0, 0), Index(3, 6), Index(9, 11)}) {
+    regions = mask.getMarkedRegions(bufferStartIndex);
+    Eigen::MatrixXi coverage = Eigen::MatrixXi::Zero(10, 12);
+    for (const auto& region : regions) {
+      ASSERT_TRUE((region.startIndex >= 0).all() && (region.startIndex + region.size <= Size(10, 12)).all());
+      for (int col = 0; col < region.size(1); ++col) {
+        for (int row = 0; row < region.size(0); ++row) {
+          const Index index((region.startIndex(0) + row + bufferStartIndex(0)) % 10,
+                            (region.startIndex(1) + col + bufferStartIndex(1)) % 12);
+          ++coverage(index(0), index(1));
+        }
+      }
+    }
+    for (int col = 0; col < 12; ++col) {
+      for (int row = 0; row < 10; ++row) {
+        EXPECT_EQ(mask.isCellMarked(Index(row, col)) ? 1 : 0, coverage(row, col));
+      }
+    }
+  }
+}
+
+TEST(TileMask, UnmarkAndCheckRegion)
+{
+  TileMask mask(4);
+  mask.setSize(Size(10, 9));
+
+  // Only the tiles entirely within the (wrapping) region are unmarked.
+  mask.unmarkRegion(Index(8, 0), Size(6, 5));
+  for (int tileCol = 0; tileCol < 3; ++tileCol) {
+    for (int tileRow = 0; tileRow < 3; ++tileRow) {
+      const bool isExpected = !((tileRow == 0 || tileRow == 2) && tileCol == 0);
+      EXPECT_EQ(isExpected, mask.isMarked(Index(tileRow, tileCol))) << tileRow << ", " << tileCol;
+    }
+  }
+
+  EXPECT_FALSE(mask.isRegionMarked(Index(9, 1), Size(3, 3)));
+  EXPECT_TRUE(mask.isRegionMarked(Index(9, 1), Size(3, 4)));
+  EXPECT_FALSE(mask.isRegionMarked(Index(0, 0), Size(0, 4)));
+  mask.unmarkRegion(Index(3, 2), Size(10, 9));
+  EXPECT_FALSE(mask.isAnyMarked());
+
+  // The region is extended to the tiles, also across the buffer border.
+  Index startIndex(8, 6);
+  Size size(3, 3);
+  mask.extendRegionToTiles(startIndex, size);
+  EXPECT_TRUE((Index(8, 4) == startIndex).all());
+  EXPECT_TRUE((Size(6, 5) == size).all());
+  mask.markRegion(startIndex, size);
+  mask.unmarkRegion(startIndex, size);
+  EXPECT_FALSE(mask.isAnyMarked());
+}
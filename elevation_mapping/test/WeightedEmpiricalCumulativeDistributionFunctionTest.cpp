@@ -7,23 +7,36 @@
  */
 
 #include "elevation_mapping/WeightedEmpiricalCumulativeDistributionFunction.hpp"
+#include "elevation_mapping/FlatWeightedEmpiricalCumulativeDistributionFunction.hpp"
 
 // gtest
 #include <gtest/gtest.h>
 
+// STL
+#include <random>
+
 using namespace elevation_mapping;
 
-TEST(WeightedEmpiricalCumulativeDistributionFunction, Initialization)
+template <typename Distribution>
+class WeightedEmpiricalCumulativeDistributionFunctionTest : public ::testing::Test
 {
-  WeightedEmpiricalCumulativeDistributionFunction<float> wecdf;
+};
+
+typedef ::testing::Types<WeightedEmpiricalCumulativeDistributionFunction<double>,
+    FlatWeightedEmpiricalCumulativeDistributionFunction<double>> Implementations;
+TYPED_TEST_CASE(WeightedEmpiricalCumulativeDistributionFunctionTest, Implementations);
+
+TYPED_TEST(WeightedEmpiricalCumulativeDistributionFunctionTest, Initialization)
+{
+  TypeParam wecdf;
   EXPECT_FALSE(wecdf.compute());
   wecdf.clear();
   EXPECT_FALSE(wecdf.compute());
 }
 
-TEST(WeightedEmpiricalCumulativeDistributionFunction, Trivial)
+TYPED_TEST(WeightedEmpiricalCumulativeDistributionFunctionTest, Trivial)
 {
-  WeightedEmpiricalCumulativeDistributionFunction<double> wecdf;
+  TypeParam wecdf;
   wecdf.add(0.0);
   wecdf.add(1.0);
   EXPECT_TRUE(wecdf.compute());
@@ -37,9 +50,9 @@ TEST(WeightedEmpiricalCumulativeDistributionFunction, Trivial)
   EXPECT_DOUBLE_EQ(1.0, wecdf.quantile(1.1));
 }
 
-TEST(WeightedEmpiricalCumulativeDistributionFunction, LinearEquallySpaced)
+TYPED_TEST(WeightedEmpiricalCumulativeDistributionFunctionTest, LinearEquallySpaced)
 {
-  WeightedEmpiricalCumulativeDistributionFunction<double> wecdf;
+  TypeParam wecdf;
   wecdf.add(0.0);
   wecdf.add(10.0/3.0);
   wecdf.add(20.0/3.0);
@@ -53,9 +66,9 @@ TEST(WeightedEmpiricalCumulativeDistributionFunction, LinearEquallySpaced)
   EXPECT_DOUBLE_EQ(10.0, wecdf.quantile(1.1));
 }
 
-TEST(WeightedEmpiricalCumulativeDistributionFunction, SingleValue)
+TYPED_TEST(WeightedEmpiricalCumulativeDistributionFunctionTest, SingleValue)
 {
-  WeightedEmpiricalCumulativeDistributionFunction<double> wecdf;
+  TypeParam wecdf;
   wecdf.add(3.0);
   wecdf.add(3.0);
   wecdf.add(3.0);
@@ -67,12 +80,54 @@ TEST(WeightedEmpiricalCumulativeDistributionFunction, SingleValue)
   EXPECT_DOUBLE_EQ(3.0, wecdf.quantile(2.0));
 }
 
-TEST(WeightedEmpiricalCumulativeDistributionFunction, SyntheticDataDebug)
+TYPED_TEST(WeightedEmpiricalCumulativeDistributionFunctionTest, SyntheticDataDebug)
 {
-  WeightedEmpiricalCumulativeDistributionFunction<double> wecdf;
+  TypeParam wecdf;
   for (unsigned int i = 0; i < 10; ++i) wecdf.add(1.0);
   wecdf.add(2.0);
   EXPECT_TRUE(wecdf.compute());
   EXPECT_DOUBLE_EQ(1.05, wecdf.quantile(0.05));
   EXPECT_DOUBLE_EQ(1.95, wecdf.quantile(0.95));
 }
+
+TYPED_TEST(WeightedEmpiricalCumulativeDistributionFunctionTest, Reuse)
+{
+  TypeParam wecdf;
+  wecdf.add(5.0);
+  wecdf.add(7.0);
+  EXPECT_TRUE(wecdf.compute());
+  wecdf.clear();
+  EXPECT_FALSE(wecdf.compute());
+  wecdf.add(1.0);
+  wecdf.add(2.0);
+  EXPECT_TRUE(wecdf.compute());
+  EXPECT_DOUBLE_EQ(1.5, wecdf.quantile(0.5));
+}
+
+TEST(FlatWeightedEmpiricalCumulativeDistributionFunction, EqualToMapBasedImplementation)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> valueDistribution(-1.0, 1.0);
+  std::uniform_real_distribution<float> weightDistribution(0.0, 1.0);
+  std::uniform_int_distribution<int> sizeDistribution(1, 200);
+  WeightedEmpiricalCumulativeDistributionFunction<float> reference;
+  FlatWeightedEmpiricalCumulativeDistributionFunction<float> wecdf;
+
+  for (unsigned int i = 0; i < 100; ++i) {
+    reference.clear();
+    wecdf.clear();
+    const int size = sizeDistribution(generator);
+    for (int j = 0; j < size; ++j) {
+      // Round the values to get duplicates.
+      const float value = std::round(valueDistribution(generator) * 20.0f) / 20.0f;
+      const float weight = weightDistribution(generator);
+      reference.add(value, weight);
+      wecdf.add(value, weight);
+    }
+    EXPECT_TRUE(reference.compute());
+    EXPECT_TRUE(wecdf.compute());
+    for (const double probability : {0.0, 0.01, 0.25, 0.5, 0.99, 1.0}) {
+      EXPECT_EQ(reference.quantile(probability), wecdf.quantile(probability));
+    }
+  }
+}
@@ -9,10 +9,15 @@
 // gtest
 #include <gtest/gtest.h>
 
+// ROS
+#include <ros/ros.h>
+
 // Run all the tests that were declared with TEST()
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
   srand((int)time(0));
+  // The tests use the ROS time without a node.
+  ros::Time::init();
   return RUN_ALL_TESTS();
 }